@@ -0,0 +1,224 @@
+%% The Erlang side of the port of the native textured-cube sample (run with
+%% --port): a process owning the port, which sends it one batch of commands
+%% per frame and accounts the replies.
+%%
+%% The port is opened with {packet, 4}; a batch is a header (a sequence
+%% number and flags) followed by the commands built with clear_color/1,
+%% object_count/1 and transforms/2, all little-endian. Every batch is answered
+%% once its frame is rendered, with its status, the number of objects and the
+%% time the native side spent on it. See src/textured-cube/main.c in the
+%% native samples for the layout.
+%%
+%% Up to max_in_flight batches are sent before waiting for their replies;
+%% frame/2,3 blocks its caller while that many are in flight, so producers
+%% faster than the renderer are held back instead of filling the pipe.
+-module(opengl_renderer).
+
+-export([start/1, start/2, stop/1]).
+-export([frame/2, frame/3, sync/1, stats/1, reset_stats/1]).
+-export([clear_color/1, object_count/1, transforms/2]).
+
+-define(CLEAR_COLOR, 1).
+-define(OBJECT_COUNT, 2).
+-define(TRANSFORMS, 3).
+
+-define(NO_DRAW, 16#01).
+
+-define(DEFAULT_MAX_OBJECTS, 16384).
+-define(DEFAULT_MAX_IN_FLIGHT, 2).
+
+-record(stats, {
+    frames = 0 :: non_neg_integer(),
+    rejected = 0 :: non_neg_integer(),
+    bytes = 0 :: non_neg_integer(),
+    objects = 0 :: non_neg_integer(),
+    round_trips = [] :: [integer()],
+    native_time = 0 :: non_neg_integer()
+}).
+
+-record(state, {
+    port :: port(),
+    max_in_flight :: pos_integer(),
+    sequence = 0 :: non_neg_integer(),
+    in_flight = #{} :: #{non_neg_integer() => integer()},
+    syncing = [] :: [{pid(), reference()}],
+    stats = #stats{} :: #stats{}
+}).
+
+%% Start the native program at Executable and the process owning its port.
+%%
+%% Options:
+%% - max_objects: the number of objects the batches can address (16384);
+%% - max_in_flight: the batches sent ahead of their replies (2); 1 measures
+%%   the bare round trip of a batch, more measures the throughput;
+%% - args: additional arguments of the native program.
+start(Executable) ->
+    start(Executable, #{}).
+
+start(Executable, Options) ->
+    Parent = self(),
+    Tag = make_ref(),
+    Pid = spawn(fun() -> init(Parent, Tag, Executable, Options) end),
+    Monitor = monitor(process, Pid),
+    receive
+        {Tag, ok} ->
+            demonitor(Monitor, [flush]),
+            {ok, Pid};
+        {'DOWN', Monitor, process, Pid, Reason} ->
+            {error, Reason}
+    end.
+
+%% Close the port; the native program exits at the end of its input.
+stop(Renderer) ->
+    call(Renderer, stop).
+
+%% Send the commands (iodata) as the batch of the next frame. Returns once
+%% the batch is sent, not rendered.
+frame(Renderer, Commands) ->
+    frame(Renderer, Commands, []).
+
+%% Flags: no_draw, to apply the batch without rendering it.
+frame(Renderer, Commands, Flags) ->
+    call(Renderer, {frame, Commands, encode_flags(Flags)}).
+
+%% Wait for the replies of all the batches sent.
+sync(Renderer) ->
+    call(Renderer, sync).
+
+%% The statistics of the batches answered since the start (or the last
+%% reset), the times in microseconds.
+stats(Renderer) ->
+    call(Renderer, stats).
+
+reset_stats(Renderer) ->
+    call(Renderer, reset_stats).
+
+clear_color({Red, Green, Blue, Alpha}) ->
+    <<?CLEAR_COLOR:8,
+      Red:32/float-little, Green:32/float-little, Blue:32/float-little, Alpha:32/float-little>>.
+
+object_count(Count) ->
+    <<?OBJECT_COUNT:8, Count:32/little>>.
+
+%% The transforms of the objects First, First + 1, and so on, each one a
+%% {{X, Y, Z}, {Qx, Qy, Qz, Qw}, {Sx, Sy, Sz}} tuple (position, rotation
+%% quaternion, scale). The command is a single binary: large ones are
+%% reference-counted, so the process encoding it can send it to the renderer
+%% without it being copied.
+transforms(First, Transforms) ->
+    Count = length(Transforms),
+    <<?TRANSFORMS:8, First:32/little, Count:32/little,
+      << <<(transform(Transform))/binary>> || Transform <- Transforms >>/binary>>.
+
+transform({{X, Y, Z}, {Qx, Qy, Qz, Qw}, {Sx, Sy, Sz}}) ->
+    <<X:32/float-little, Y:32/float-little, Z:32/float-little,
+      Qx:32/float-little, Qy:32/float-little, Qz:32/float-little, Qw:32/float-little,
+      Sx:32/float-little, Sy:32/float-little, Sz:32/float-little>>.
+
+encode_flags(Flags) ->
+    lists:foldl(
+        fun(no_draw, Bits) -> Bits bor ?NO_DRAW end,
+        0,
+        Flags
+    ).
+
+call(Renderer, Request) ->
+    Monitor = monitor(process, Renderer),
+    Renderer ! {call, self(), Monitor, Request},
+    receive
+        {Monitor, Reply} ->
+            demonitor(Monitor, [flush]),
+            Reply;
+        {'DOWN', Monitor, process, Renderer, Reason} ->
+            exit({Reason, {?MODULE, call, [Renderer, Request]}})
+    end.
+
+init(Parent, Tag, Executable, Options) ->
+    MaxObjects = maps:get(max_objects, Options, ?DEFAULT_MAX_OBJECTS),
+    Args = ["--port", "--max-objects", integer_to_list(MaxObjects)] ++ maps:get(args, Options, []),
+    Port = open_port(
+        {spawn_executable, Executable},
+        [{packet, 4}, binary, exit_status, use_stdio, {args, Args}]
+    ),
+    Parent ! {Tag, ok},
+    loop(#state{
+        port = Port,
+        max_in_flight = maps:get(max_in_flight, Options, ?DEFAULT_MAX_IN_FLIGHT)
+    }).
+
+loop(#state{port = Port, max_in_flight = MaxInFlight, in_flight = InFlight} = State) ->
+    Full = map_size(InFlight) >= MaxInFlight,
+    receive
+        {Port, {data, Reply}} ->
+            loop(handle_reply(Reply, State));
+        {Port, {exit_status, Status}} ->
+            exit({exit_status, Status});
+        {call, From, Tag, {frame, Commands, Flags}} when not Full ->
+            loop(send_frame(From, Tag, Commands, Flags, State));
+        {call, From, Tag, sync} ->
+            loop(reply_syncing(State#state{syncing = [{From, Tag} | State#state.syncing]}));
+        {call, From, Tag, stats} ->
+            From ! {Tag, summarize(State#state.stats)},
+            loop(State);
+        {call, From, Tag, reset_stats} ->
+            From ! {Tag, ok},
+            loop(State#state{stats = #stats{}});
+        {call, From, Tag, stop} ->
+            port_close(Port),
+            From ! {Tag, ok}
+    end.
+
+send_frame(From, Tag, Commands, Flags, State) ->
+    #state{port = Port, sequence = Sequence, in_flight = InFlight, stats = Stats} = State,
+    Batch = [<<Sequence:32/little, Flags:8>> | Commands],
+    true = port_command(Port, Batch),
+    Sent = erlang:monotonic_time(microsecond),
+    From ! {Tag, ok},
+    State#state{
+        sequence = (Sequence + 1) band 16#FFFFFFFF,
+        in_flight = InFlight#{Sequence => Sent},
+        stats = Stats#stats{bytes = Stats#stats.bytes + 4 + iolist_size(Batch)}
+    }.
+
+handle_reply(<<Sequence:32/little, Status:8, Objects:32/little, NativeTime:32/little>>, State) ->
+    Received = erlang:monotonic_time(microsecond),
+    #state{in_flight = InFlight, stats = Stats} = State,
+    {Sent, InFlight1} = maps:take(Sequence, InFlight),
+    Stats1 = Stats#stats{
+        frames = Stats#stats.frames + 1,
+        rejected = Stats#stats.rejected + min(Status, 1),
+        objects = Objects,
+        round_trips = [Received - Sent | Stats#stats.round_trips],
+        native_time = Stats#stats.native_time + NativeTime
+    },
+    reply_syncing(State#state{in_flight = InFlight1, stats = Stats1}).
+
+reply_syncing(#state{in_flight = InFlight, syncing = Syncing} = State) when map_size(InFlight) =:= 0 ->
+    [From ! {Tag, ok} || {From, Tag} <- Syncing],
+    State#state{syncing = []};
+reply_syncing(State) ->
+    State.
+
+summarize(#stats{frames = Frames, round_trips = RoundTrips} = Stats) ->
+    Sorted = lists:sort(RoundTrips),
+    #{
+        frames => Frames,
+        rejected => Stats#stats.rejected,
+        bytes => Stats#stats.bytes,
+        objects => Stats#stats.objects,
+        round_trip_avg => average(lists:sum(Sorted), Frames),
+        round_trip_p50 => percentile(Sorted, Frames, 0.50),
+        round_trip_p99 => percentile(Sorted, Frames, 0.99),
+        round_trip_max => percentile(Sorted, Frames, 1.0),
+        native_avg => average(Stats#stats.native_time, Frames)
+    }.
+
+average(_Sum, 0) ->
+    0.0;
+average(Sum, Count) ->
+    Sum / Count.
+
+percentile(_Sorted, 0, _Fraction) ->
+    0;
+percentile(Sorted, Count, Fraction) ->
+    lists:nth(max(1, ceil(Count * Fraction)), Sorted).
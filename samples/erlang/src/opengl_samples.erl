@@ -1,3 +1,118 @@
 -module(opengl_samples).
 
--export([]).
+-export([port_benchmark/1, port_benchmark/2]).
+
+-define(BATCH_SIZES, [1, 16, 256, 4096, 16384]).
+-define(FRAMES, 200).
+
+%% Drive the native textured-cube sample (at Executable) through its port with
+%% batches of increasing sizes, and print the updates per second and the round
+%% trip of the batches for each size.
+%%
+%% The objects of a batch are split between producer processes, each one
+%% owning a contiguous range of them: every frame, they compute and encode the
+%% transforms of their range in parallel, and the batch is the concatenation
+%% of their commands.
+%%
+%% Options:
+%% - batch_sizes: the object counts to measure ([1, 16, 256, 4096, 16384]);
+%% - frames: the batches sent for each size (200);
+%% - producers: the producer processes (one per scheduler);
+%% - max_in_flight: the batches sent ahead of their replies (2);
+%% - draw: false to apply the batches without rendering them, which measures
+%%   the boundary alone (true).
+%%
+%% Returns the measures of every size.
+port_benchmark(Executable) ->
+    port_benchmark(Executable, #{}).
+
+port_benchmark(Executable, Options) ->
+    Sizes = maps:get(batch_sizes, Options, ?BATCH_SIZES),
+    Frames = maps:get(frames, Options, ?FRAMES),
+    Producers = maps:get(producers, Options, erlang:system_info(schedulers_online)),
+    Flags = case maps:get(draw, Options, true) of
+        true -> [];
+        false -> [no_draw]
+    end,
+    {ok, Renderer} = opengl_renderer:start(Executable, #{
+        max_objects => lists:max(Sizes),
+        max_in_flight => maps:get(max_in_flight, Options, 2)
+    }),
+    try
+        io:format("~9s ~12s ~9s ~9s ~10s ~10s ~10s ~10s~n",
+            ["objects", "updates/s", "frames/s", "MiB/s", "rtt avg", "rtt p99", "rtt max", "native"]),
+        [measure(Renderer, Size, Frames, Producers, Flags) || Size <- Sizes]
+    after
+        opengl_renderer:stop(Renderer)
+    end.
+
+measure(Renderer, Objects, Frames, ProducerCount, Flags) ->
+    Producers = start_producers(Objects, min(ProducerCount, Objects)),
+    ok = opengl_renderer:frame(Renderer, [
+        opengl_renderer:clear_color({0.2, 0.3, 0.4, 1.0}),
+        opengl_renderer:object_count(Objects)
+    ], Flags),
+    ok = opengl_renderer:sync(Renderer),
+    ok = opengl_renderer:reset_stats(Renderer),
+
+    Start = erlang:monotonic_time(microsecond),
+    lists:foreach(
+        fun(Frame) ->
+            [Producer ! {produce, Frame, self()} || Producer <- Producers],
+            Commands = [receive {produced, Producer, Command} -> Command end || Producer <- Producers],
+            ok = opengl_renderer:frame(Renderer, Commands, Flags)
+        end,
+        lists:seq(0, Frames - 1)
+    ),
+    ok = opengl_renderer:sync(Renderer),
+    Elapsed = (erlang:monotonic_time(microsecond) - Start) / 1.0e6,
+    [Producer ! stop || Producer <- Producers],
+
+    Stats = opengl_renderer:stats(Renderer),
+    Measure = Stats#{
+        updates_per_second => Objects * Frames / Elapsed,
+        frames_per_second => Frames / Elapsed,
+        bytes_per_second => maps:get(bytes, Stats) / Elapsed
+    },
+    io:format("~9w ~12.1f ~9.1f ~9.2f ~8.3fms ~8.3fms ~8.3fms ~8.3fms~n", [
+        Objects,
+        maps:get(updates_per_second, Measure),
+        maps:get(frames_per_second, Measure),
+        maps:get(bytes_per_second, Measure) / (1024 * 1024),
+        maps:get(round_trip_avg, Stats) / 1000,
+        maps:get(round_trip_p99, Stats) / 1000,
+        maps:get(round_trip_max, Stats) / 1000,
+        maps:get(native_avg, Stats) / 1000
+    ]),
+    Measure.
+
+start_producers(Objects, Count) ->
+    [
+        begin
+            First = Objects * Index div Count,
+            Last = Objects * (Index + 1) div Count,
+            spawn_link(fun() -> producer(First, Last - First, Objects) end)
+        end
+     || Index <- lists:seq(0, Count - 1)
+    ].
+
+producer(First, Count, Objects) ->
+    receive
+        {produce, Frame, From} ->
+            Transforms = [transform(Object, Frame, Objects) || Object <- lists:seq(First, First + Count - 1)],
+            From ! {produced, self(), opengl_renderer:transforms(First, Transforms)},
+            producer(First, Count, Objects);
+        stop ->
+            ok
+    end.
+
+%% The objects are laid out on a grid facing the camera, spinning around
+%% their vertical axis.
+transform(Object, Frame, Objects) ->
+    Side = ceil(math:sqrt(Objects)),
+    Spacing = 6.0 / Side,
+    X = (Object rem Side - (Side - 1) / 2) * Spacing,
+    Y = (Object div Side - (Side - 1) / 2) * Spacing,
+    Scale = 2.5 / Side,
+    Angle = Frame * 0.05 + Object * 0.1,
+    {{X, Y, 0.0}, {0.0, math:sin(Angle / 2), 0.0, math:cos(Angle / 2)}, {Scale, Scale, Scale}}.
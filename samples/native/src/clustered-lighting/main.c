@@ -0,0 +1,969 @@
+//
+// Copyright (c) 2025, Byteplug LLC.
+//
+// This source file is part of a project made by the Erlangsters community and
+// is released under the MIT license. Please refer to the LICENSE.md file that
+// can be found at the root of the project repository.
+//
+// Written by Jonathan De Wachter <jonathan.dewachter@byteplug.io>
+//
+#include <math.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "gl_api.h"
+#include "gl_debug.h"
+#include "gpu_memory.h"
+#include "light_cluster.h"
+#include "matrix.h"
+#include "window.h"
+#include "options.h"
+#include "profiler.h"
+#include "report.h"
+#include "shader.h"
+#include "timer.h"
+
+// Lights a field of cubes with thousands of moving point lights, using
+// clustered forward shading: the view frustum is divided in clusters (tiles
+// across the screen, exponential slices along the depth), every light is
+// listed in the clusters it reaches, and each fragment only loops over the
+// lights of its cluster.
+//
+// The lists are built every frame, either on the CPU (light_cluster.h, with
+// SIMD sphere tests) and uploaded, or on the GPU by a compute shader (OpenGL
+// 4.6 and OpenGL ES 3.1+). The number of lights doubles from run to run, and
+// the time spent building the lists and shading the scene is measured for
+// each of them.
+//
+// The fragment shader reads the lists from integer textures, so OpenGL ES
+// 2.0 cannot shade per cluster; there, the lists are still built on the CPU,
+// but each object is shaded with the first lights of the cluster of its
+// center.
+
+#if defined(OPENGL_VERSION_46) || defined(OPENGL_ES_VERSION_31) || defined(OPENGL_ES_VERSION_32)
+    #define GPU_ASSIGNMENT 1
+#else
+    #define GPU_ASSIGNMENT 0
+#endif
+
+#if SAMPLE_OPENGL_API == SAMPLE_API_GL || SAMPLE_OPENGL_VERSION_MAJOR >= 3
+    #define CLUSTERED_SHADING 1
+#else
+    #define CLUSTERED_SHADING 0
+#endif
+
+#define ATTRIB_POSITION 0
+#define ATTRIB_NORMAL 1
+#define ATTRIB_CENTER 2
+#define ATTRIB_EXTENT 3
+
+#define UNIT_CLUSTER_COUNTS 0
+#define UNIT_CLUSTER_LIGHTS 1
+#define UNIT_LIGHT_POSITIONS 2
+#define UNIT_LIGHT_COLORS 3
+
+#define CUBE_SPACING 3.0f
+#define NEAR_PLANE 0.5f
+
+#define FIRST_LIGHT_COUNT 256
+#define MAX_LIGHT_COUNT 65536
+
+// Rows of the light and index textures (textures are rarely allowed more
+// than 16384 texels per side).
+#define LIGHT_TEXTURE_WIDTH 256
+#define INDEX_TEXTURE_WIDTH 1024
+
+#define ASSIGN_GROUP_SIZE 64
+
+// Lights per object on OpenGL ES 2.0.
+#define MAX_OBJECT_LIGHTS 8
+
+#define STRINGIFY(x) #x
+#define TO_STRING(x) STRINGIFY(x)
+
+static const char* shaderDefines =
+    "#define MAX_CLUSTER_LIGHTS " TO_STRING(LIGHT_CLUSTER_MAX_LIGHTS) "\n"
+    "#define LIGHT_TEXTURE_WIDTH " TO_STRING(LIGHT_TEXTURE_WIDTH) "\n"
+    "#define INDEX_TEXTURE_WIDTH " TO_STRING(INDEX_TEXTURE_WIDTH) "\n"
+    "#define ASSIGN_GROUP_SIZE " TO_STRING(ASSIGN_GROUP_SIZE) "\n"
+    "#define MAX_OBJECT_LIGHTS " TO_STRING(MAX_OBJECT_LIGHTS) "\n";
+
+// Lighting is done in view space.
+static const char* vertexSource =
+    "ATTRIBUTE vec3 vertPosition;\n"
+    "ATTRIBUTE vec3 vertNormal;\n"
+    "ATTRIBUTE vec4 instCenter;\n"
+    "ATTRIBUTE vec4 instExtent;\n"
+    "VARYING_OUT vec3 fragPosition;\n"
+    "VARYING_OUT vec3 fragNormal;\n"
+    "VARYING_OUT vec3 fragAlbedo;\n"
+    "uniform mat4 mView;\n"
+    "uniform mat4 mProj;\n"
+    "void main() {\n"
+    "    vec4 position = mView * vec4(instCenter.xyz + vertPosition * instExtent.xyz, 1.0);\n"
+    "    fragPosition = position.xyz;\n"
+    "    fragNormal = (mView * vec4(vertNormal, 0.0)).xyz;\n"
+    "    fragAlbedo = vec3(0.8, 0.78, 0.74) * instCenter.w;\n"
+    "    gl_Position = mProj * position;\n"
+    "}\n";
+
+// The cluster of a fragment is found from its window position and its
+// depth, the same way light_cluster_find() does. The list indices go past
+// what mediump integers hold.
+static const char* fragmentSource =
+    "#ifdef SHADER_HAS_INTEGERS\n"
+    "precision highp float;\n"
+    "precision highp int;\n"
+    "#endif\n"
+    "VARYING_IN vec3 fragPosition;\n"
+    "VARYING_IN vec3 fragNormal;\n"
+    "VARYING_IN vec3 fragAlbedo;\n"
+    "#ifdef SHADER_HAS_INTEGERS\n"
+    "uniform highp usampler2D clusterCounts;\n"
+    "uniform highp usampler2D clusterLights;\n"
+    "uniform highp sampler2D lightPositions;\n"
+    "uniform highp sampler2D lightColors;\n"
+    "uniform ivec3 clusterGrid;\n"
+    "uniform vec2 sliceParams;\n"
+    "uniform vec2 viewportSize;\n"
+    "#else\n"
+    "uniform vec4 objectLightPositions[MAX_OBJECT_LIGHTS];\n"
+    "uniform vec3 objectLightColors[MAX_OBJECT_LIGHTS];\n"
+    "uniform int objectLightCount;\n"
+    "#endif\n"
+    "\n"
+    "vec3 shade(vec3 normal, vec4 light, vec3 color) {\n"
+    "    vec3 toLight = light.xyz - fragPosition;\n"
+    "    float distance = length(toLight);\n"
+    "    float falloff = max(1.0 - distance / light.w, 0.0);\n"
+    "    float diffuse = max(dot(normal, toLight / max(distance, 0.001)), 0.0);\n"
+    "    return color * (diffuse * falloff * falloff);\n"
+    "}\n"
+    "\n"
+    "void main() {\n"
+    "    vec3 normal = normalize(fragNormal);\n"
+    "    vec3 light = vec3(0.04);\n"
+    "#ifdef SHADER_HAS_INTEGERS\n"
+    "    ivec2 tile = clamp(ivec2(gl_FragCoord.xy / viewportSize * vec2(clusterGrid.xy)), ivec2(0), clusterGrid.xy - 1);\n"
+    "    int slice = clamp(int(floor(log(-fragPosition.z / sliceParams.x) * sliceParams.y)), 0, clusterGrid.z - 1);\n"
+    "    int cluster = tile.x + clusterGrid.x * (tile.y + clusterGrid.y * slice);\n"
+    "    int count = int(texelFetch(clusterCounts, ivec2(tile.x, tile.y + clusterGrid.y * slice), 0).r);\n"
+    "    for (int i = 0; i < count; i++) {\n"
+    "        int slot = cluster * MAX_CLUSTER_LIGHTS + i;\n"
+    "        int index = int(texelFetch(clusterLights, ivec2(slot % INDEX_TEXTURE_WIDTH, slot / INDEX_TEXTURE_WIDTH), 0).r);\n"
+    "        ivec2 texel = ivec2(index % LIGHT_TEXTURE_WIDTH, index / LIGHT_TEXTURE_WIDTH);\n"
+    "        light += shade(normal, texelFetch(lightPositions, texel, 0), texelFetch(lightColors, texel, 0).rgb);\n"
+    "    }\n"
+    "#else\n"
+    "    for (int i = 0; i < MAX_OBJECT_LIGHTS; i++) {\n"
+    "        if (i >= objectLightCount) {\n"
+    "            break;\n"
+    "        }\n"
+    "        light += shade(normal, objectLightPositions[i], objectLightColors[i]);\n"
+    "    }\n"
+    "#endif\n"
+    "    FRAG_COLOR = vec4(fragAlbedo * light, 1.0);\n"
+    "}\n";
+
+static const char* attributes[] = { "vertPosition", "vertNormal", "instCenter", "instExtent", NULL };
+
+#if GPU_ASSIGNMENT
+// One invocation per cluster, which tests the lights against its box. The
+// lights are read in batches into shared memory, one per invocation of the
+// group, so each of them is fetched once per group rather than once per
+// cluster. The lists come out in the order of the lights, as on the CPU.
+static const char* assignSource =
+    "layout(local_size_x = ASSIGN_GROUP_SIZE) in;\n"
+    "layout(r32ui, binding = 0) writeonly uniform highp uimage2D clusterCounts;\n"
+    "layout(r32ui, binding = 1) writeonly uniform highp uimage2D clusterLights;\n"
+    "uniform sampler2D lightPositions;\n"
+    "uniform ivec3 clusterGrid;\n"
+    "uniform vec4 frustum;\n"
+    "uniform int lightCount;\n"
+    "shared vec4 lights[ASSIGN_GROUP_SIZE];\n"
+    "\n"
+    "void main() {\n"
+    "    int cluster = int(gl_GlobalInvocationID.x);\n"
+    "    int clusterCount = clusterGrid.x * clusterGrid.y * clusterGrid.z;\n"
+    "    int x = cluster % clusterGrid.x;\n"
+    "    int y = cluster / clusterGrid.x % clusterGrid.y;\n"
+    "    int z = cluster / (clusterGrid.x * clusterGrid.y);\n"
+    "\n"
+    "    float d0 = frustum.x * pow(frustum.y / frustum.x, float(z) / float(clusterGrid.z));\n"
+    "    float d1 = frustum.x * pow(frustum.y / frustum.x, float(z + 1) / float(clusterGrid.z));\n"
+    "    vec2 low = (vec2(x, y) / vec2(clusterGrid.xy) * 2.0 - 1.0) * frustum.zw;\n"
+    "    vec2 high = (vec2(x + 1, y + 1) / vec2(clusterGrid.xy) * 2.0 - 1.0) * frustum.zw;\n"
+    "    vec3 boxMin = vec3(min(low * d0, low * d1), -d1);\n"
+    "    vec3 boxMax = vec3(max(high * d0, high * d1), -d0);\n"
+    "\n"
+    "    int count = 0;\n"
+    "    for (int first = 0; first < lightCount; first += ASSIGN_GROUP_SIZE) {\n"
+    "        int index = first + int(gl_LocalInvocationIndex);\n"
+    "        if (index < lightCount) {\n"
+    "            ivec2 texel = ivec2(index % LIGHT_TEXTURE_WIDTH, index / LIGHT_TEXTURE_WIDTH);\n"
+    "            lights[gl_LocalInvocationIndex] = texelFetch(lightPositions, texel, 0);\n"
+    "        }\n"
+    "        barrier();\n"
+    "\n"
+    "        int batch = cluster < clusterCount ? min(ASSIGN_GROUP_SIZE, lightCount - first) : 0;\n"
+    "        for (int i = 0; i < batch && count < MAX_CLUSTER_LIGHTS; i++) {\n"
+    "            vec4 light = lights[i];\n"
+    "            vec3 outside = max(max(boxMin - light.xyz, light.xyz - boxMax), 0.0);\n"
+    "            if (dot(outside, outside) <= light.w * light.w) {\n"
+    "                int slot = cluster * MAX_CLUSTER_LIGHTS + count;\n"
+    "                imageStore(clusterLights, ivec2(slot % INDEX_TEXTURE_WIDTH, slot / INDEX_TEXTURE_WIDTH), uvec4(first + i));\n"
+    "                count++;\n"
+    "            }\n"
+    "        }\n"
+    "        barrier();\n"
+    "    }\n"
+    "\n"
+    "    if (cluster < clusterCount) {\n"
+    "        imageStore(clusterCounts, ivec2(x, y + clusterGrid.y * z), uvec4(count));\n"
+    "    }\n"
+    "}\n";
+#endif
+
+typedef enum {
+    ASSIGN_CPU,
+    ASSIGN_GPU,
+    ASSIGN_COUNT
+} assign_mode;
+
+static const char* modeNames[ASSIGN_COUNT] = { "cpu", "gpu" };
+
+// An axis-aligned box, with its shade in the w component of the center. It
+// is also the layout of the instance buffer.
+typedef struct {
+    float center[4];
+    float extent[4];
+} instance;
+
+// A light turns around its own point of the field.
+typedef struct {
+    float center[3];
+    float orbit;
+    float speed;
+    float phase;
+} light_path;
+
+typedef struct {
+    int width;
+    int height;
+    float extent;  // Size of the field of cubes.
+    float far;
+    mat4 proj;
+
+    int instanceCount;
+    instance* instances;
+
+    int lightCapacity;
+    light_path* paths;
+    float* lights;       // Position in view space and radius, 4 per light.
+    float* lightColors;  // 4 per light.
+
+    light_cluster_grid grid;
+
+    GLuint drawProgram;
+    GLuint vbo;
+    GLuint ebo;
+    #if CLUSTERED_SHADING
+        GLuint instanceBuffer;
+        GLuint vao;
+        GLuint clusterCounts;
+        GLuint clusterLights;
+        GLuint lightPositions;
+        GLuint lightColorTexture;
+        int indexRows;
+    #else
+        GLint objectLightPositions;
+        GLint objectLightColors;
+        GLint objectLightCount;
+    #endif
+    #if GPU_ASSIGNMENT
+        GLuint assignProgram;
+    #endif
+} scene;
+
+typedef struct {
+    long long frames;
+    double seconds;
+    double assignSeconds;
+    double shadeSeconds;
+    double listed;   // Entries of the lists (CPU assignment only).
+    double dropped;  // Lights that did not fit in a list (CPU assignment only).
+} run_stats;
+
+static float randomFloat(unsigned int* state) {
+    *state = *state * 1664525u + 1013904223u;
+    return (float)(*state >> 8) / 16777216.0f;
+}
+
+static void addBox(scene* scene, float x, float y, float z, float extentX, float extentY, float extentZ, float shade) {
+    instance* box = &scene->instances[scene->instanceCount++];
+    box->center[0] = x;
+    box->center[1] = y;
+    box->center[2] = z;
+    box->center[3] = shade;
+    box->extent[0] = extentX;
+    box->extent[1] = extentY;
+    box->extent[2] = extentZ;
+    box->extent[3] = 0.0f;
+}
+
+// A floor with a grid x grid field of cubes of various heights on it, and
+// the lights scattered above it.
+static int buildScene(scene* scene, int grid, int lightCapacity) {
+    const float pi = 3.14159265358979323846f;
+    scene->instances = malloc((size_t)(1 + grid * grid) * sizeof(instance));
+    scene->paths = malloc((size_t)lightCapacity * sizeof(light_path));
+    scene->lights = malloc((size_t)lightCapacity * 4 * sizeof(float));
+    scene->lightColors = malloc((size_t)lightCapacity * 4 * sizeof(float));
+    if (!scene->instances || !scene->paths || !scene->lights || !scene->lightColors) {
+        return -1;
+    }
+    scene->lightCapacity = lightCapacity;
+    scene->extent = (float)grid * CUBE_SPACING;
+    scene->instanceCount = 0;
+
+    unsigned int state = 12345u;
+    float half = scene->extent * 0.5f;
+    addBox(scene, 0.0f, -0.05f, 0.0f, half + CUBE_SPACING, 0.05f, half + CUBE_SPACING, 0.7f);
+    for (int z = 0; z < grid; z++) {
+        for (int x = 0; x < grid; x++) {
+            float size = 0.4f + randomFloat(&state) * 0.5f;
+            float height = 0.3f + randomFloat(&state) * 1.5f;
+            float shade = 0.5f + randomFloat(&state) * 0.5f;
+            addBox(scene, -half + ((float)x + 0.5f) * CUBE_SPACING, height, -half + ((float)z + 0.5f) * CUBE_SPACING,
+                size, height, size, shade);
+        }
+    }
+
+    for (int i = 0; i < lightCapacity; i++) {
+        light_path* path = &scene->paths[i];
+        path->center[0] = (randomFloat(&state) - 0.5f) * scene->extent;
+        path->center[1] = 0.3f + randomFloat(&state) * 2.5f;
+        path->center[2] = (randomFloat(&state) - 0.5f) * scene->extent;
+        path->orbit = 0.5f + randomFloat(&state) * 2.0f;
+        path->speed = (randomFloat(&state) - 0.5f) * 2.0f;
+        path->phase = randomFloat(&state) * 2.0f * pi;
+        scene->lights[i * 4 + 3] = 1.5f + randomFloat(&state) * 1.5f;
+
+        float* color = &scene->lightColors[i * 4];
+        color[0] = 0.2f + randomFloat(&state) * 0.8f;
+        color[1] = 0.2f + randomFloat(&state) * 0.8f;
+        color[2] = 0.2f + randomFloat(&state) * 0.8f;
+        color[3] = 1.0f;
+    }
+
+    return 0;
+}
+
+// A unit cube (from -1 to 1) with a normal per face, wound counter-clockwise.
+static void buildCube(float vertices[24 * 6], unsigned short indices[36]) {
+    int vertex = 0;
+    int index = 0;
+    for (int axis = 0; axis < 3; axis++) {
+        for (int side = 0; side < 2; side++) {
+            float sign = side == 0 ? 1.0f : -1.0f;
+            int u = side == 0 ? (axis + 1) % 3 : (axis + 2) % 3;
+            int v = side == 0 ? (axis + 2) % 3 : (axis + 1) % 3;
+            static const float corners[4][2] = { { -1, -1 }, { 1, -1 }, { 1, 1 }, { -1, 1 } };
+
+            for (int i = 0; i < 4; i++) {
+                float* out = &vertices[(vertex + i) * 6];
+                memset(out, 0, 6 * sizeof(float));
+                out[axis] = sign;
+                out[u] = corners[i][0];
+                out[v] = corners[i][1];
+                out[3 + axis] = sign;
+            }
+
+            static const int quad[6] = { 0, 1, 2, 0, 2, 3 };
+            for (int i = 0; i < 6; i++) {
+                indices[index++] = (unsigned short)(vertex + quad[i]);
+            }
+            vertex += 4;
+        }
+    }
+}
+
+static GLuint createBuffer(GLenum target, size_t size, const void* data, GLenum usage, const char* label) {
+    GLuint buffer;
+    glGenBuffers(1, &buffer);
+    glBindBuffer(target, buffer);
+    GL_CHECK(glBufferData(target, size, data, usage));
+    gpu_memory_track(GPU_MEMORY_BUFFER, buffer, size);
+    gl_debug_label(GL_BUFFER, buffer, label);
+    return buffer;
+}
+
+#if CLUSTERED_SHADING
+// A texture only read with texelFetch(). The compute shader writes the lists
+// through image units, which need immutable storage on OpenGL ES.
+static GLuint createDataTexture(GLenum internalFormat, GLenum format, GLenum type, int width, int height,
+                                const char* label) {
+    GLuint texture;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    #if GPU_ASSIGNMENT
+        (void)format;
+        GL_CHECK(glTexStorage2D(GL_TEXTURE_2D, 1, internalFormat, width, height));
+    #else
+        GL_CHECK(glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, format, type, NULL));
+    #endif
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    gpu_memory_track(GPU_MEMORY_TEXTURE, texture, gpu_memory_texture_size(format, type, width, height, 1, 1));
+    gl_debug_label(GL_TEXTURE, texture, label);
+    return texture;
+}
+
+static void deleteDataTexture(GLuint texture) {
+    gpu_memory_untrack(GPU_MEMORY_TEXTURE, texture);
+    glDeleteTextures(1, &texture);
+}
+
+static void createClusterTextures(scene* scene) {
+    light_cluster_grid* grid = &scene->grid;
+    int lightRows = (scene->lightCapacity + LIGHT_TEXTURE_WIDTH - 1) / LIGHT_TEXTURE_WIDTH;
+    size_t slots = (size_t)light_cluster_count(grid) * LIGHT_CLUSTER_MAX_LIGHTS;
+    scene->indexRows = (int)((slots + INDEX_TEXTURE_WIDTH - 1) / INDEX_TEXTURE_WIDTH);
+
+    scene->clusterCounts = createDataTexture(GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT,
+        grid->tilesX, grid->tilesY * grid->slices, "Cluster light counts");
+    scene->clusterLights = createDataTexture(GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT,
+        INDEX_TEXTURE_WIDTH, scene->indexRows, "Cluster light lists");
+    scene->lightPositions = createDataTexture(GL_RGBA32F, GL_RGBA, GL_FLOAT,
+        LIGHT_TEXTURE_WIDTH, lightRows, "Light positions");
+    scene->lightColorTexture = createDataTexture(GL_RGBA32F, GL_RGBA, GL_FLOAT,
+        LIGHT_TEXTURE_WIDTH, lightRows, "Light colors");
+
+    // The colors never change; the last row is only partly filled.
+    int fullRows = scene->lightCapacity / LIGHT_TEXTURE_WIDTH;
+    int rest = scene->lightCapacity % LIGHT_TEXTURE_WIDTH;
+    if (fullRows > 0) {
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, LIGHT_TEXTURE_WIDTH, fullRows, GL_RGBA, GL_FLOAT, scene->lightColors);
+    }
+    if (rest > 0) {
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, fullRows, rest, 1, GL_RGBA, GL_FLOAT,
+            &scene->lightColors[(size_t)fullRows * LIGHT_TEXTURE_WIDTH * 4]);
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+static void bindClusterTextures(scene* scene) {
+    glActiveTexture(GL_TEXTURE0 + UNIT_CLUSTER_COUNTS);
+    glBindTexture(GL_TEXTURE_2D, scene->clusterCounts);
+    glActiveTexture(GL_TEXTURE0 + UNIT_CLUSTER_LIGHTS);
+    glBindTexture(GL_TEXTURE_2D, scene->clusterLights);
+    glActiveTexture(GL_TEXTURE0 + UNIT_LIGHT_POSITIONS);
+    glBindTexture(GL_TEXTURE_2D, scene->lightPositions);
+    glActiveTexture(GL_TEXTURE0 + UNIT_LIGHT_COLORS);
+    glBindTexture(GL_TEXTURE_2D, scene->lightColorTexture);
+    glActiveTexture(GL_TEXTURE0);
+}
+#endif
+
+static void setupVertexArrays(scene* scene) {
+    glBindBuffer(GL_ARRAY_BUFFER, scene->vbo);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, scene->ebo);
+    glVertexAttribPointer(ATTRIB_POSITION, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), 0);
+    glVertexAttribPointer(ATTRIB_NORMAL, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(3 * sizeof(float)));
+    glEnableVertexAttribArray(ATTRIB_POSITION);
+    glEnableVertexAttribArray(ATTRIB_NORMAL);
+
+    #if CLUSTERED_SHADING
+        glBindBuffer(GL_ARRAY_BUFFER, scene->instanceBuffer);
+        glVertexAttribPointer(ATTRIB_CENTER, 4, GL_FLOAT, GL_FALSE, sizeof(instance), (void*)offsetof(instance, center));
+        glVertexAttribPointer(ATTRIB_EXTENT, 4, GL_FLOAT, GL_FALSE, sizeof(instance), (void*)offsetof(instance, extent));
+        glVertexAttribDivisor(ATTRIB_CENTER, 1);
+        glVertexAttribDivisor(ATTRIB_EXTENT, 1);
+        glEnableVertexAttribArray(ATTRIB_CENTER);
+        glEnableVertexAttribArray(ATTRIB_EXTENT);
+    #endif
+}
+
+// The uniforms that do not change from frame to frame.
+static void setupPrograms(scene* scene) {
+    light_cluster_grid* grid = &scene->grid;
+    GLuint program = scene->drawProgram;
+    glUseProgram(program);
+    glUniformMatrix4fv(glGetUniformLocation(program, "mProj"), 1, GL_FALSE, scene->proj);
+    #if CLUSTERED_SHADING
+        glUniform1i(glGetUniformLocation(program, "clusterCounts"), UNIT_CLUSTER_COUNTS);
+        glUniform1i(glGetUniformLocation(program, "clusterLights"), UNIT_CLUSTER_LIGHTS);
+        glUniform1i(glGetUniformLocation(program, "lightPositions"), UNIT_LIGHT_POSITIONS);
+        glUniform1i(glGetUniformLocation(program, "lightColors"), UNIT_LIGHT_COLORS);
+        glUniform3i(glGetUniformLocation(program, "clusterGrid"), grid->tilesX, grid->tilesY, grid->slices);
+        glUniform2f(glGetUniformLocation(program, "sliceParams"), grid->near, grid->sliceScale);
+        glUniform2f(glGetUniformLocation(program, "viewportSize"), (float)scene->width, (float)scene->height);
+    #else
+        (void)grid;
+        scene->objectLightPositions = glGetUniformLocation(program, "objectLightPositions");
+        scene->objectLightColors = glGetUniformLocation(program, "objectLightColors");
+        scene->objectLightCount = glGetUniformLocation(program, "objectLightCount");
+    #endif
+
+    #if GPU_ASSIGNMENT
+        program = scene->assignProgram;
+        glUseProgram(program);
+        glUniform1i(glGetUniformLocation(program, "lightPositions"), UNIT_LIGHT_POSITIONS);
+        glUniform3i(glGetUniformLocation(program, "clusterGrid"), grid->tilesX, grid->tilesY, grid->slices);
+        glUniform4f(glGetUniformLocation(program, "frustum"), grid->near, grid->far, grid->tanHalfX, grid->tanHalfY);
+    #endif
+    glUseProgram(0);
+}
+
+static int createScene(scene* scene, int grid, int lightCapacity, int tilesX, int tilesY, int slices) {
+    const float pi = 3.14159265358979323846f;
+    if (buildScene(scene, grid, lightCapacity) != 0) {
+        fprintf(stderr, "Failed to allocate the scene\n");
+        return -1;
+    }
+
+    float fovy = 60.0f * pi / 180.0f;
+    float aspect = (float)scene->width / (float)scene->height;
+    scene->far = scene->extent * 1.5f;
+    mat4_perspective(scene->proj, fovy, aspect, NEAR_PLANE, scene->far);
+
+    // The light lists of all the clusters are rows of the index texture, and
+    // the counts have a row per tile row and slice: both must fit the
+    // texture size of the driver.
+    GLint maxTextureSize = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxTextureSize);
+    size_t slots = (size_t)tilesX * tilesY * slices * LIGHT_CLUSTER_MAX_LIGHTS;
+    size_t indexRows = (slots + INDEX_TEXTURE_WIDTH - 1) / INDEX_TEXTURE_WIDTH;
+    if (indexRows > (size_t)maxTextureSize || tilesY * slices > maxTextureSize) {
+        fprintf(stderr, "%dx%dx%d clusters need textures of %zu rows, more than the %d supported\n",
+            tilesX, tilesY, slices, indexRows > (size_t)(tilesY * slices) ? indexRows : (size_t)(tilesY * slices),
+            maxTextureSize);
+        return -1;
+    }
+    if (light_cluster_init(&scene->grid, tilesX, tilesY, slices, fovy, aspect, NEAR_PLANE, scene->far) != 0) {
+        fprintf(stderr, "Failed to allocate the clusters\n");
+        return -1;
+    }
+
+    // The programs compile while the buffers and textures are created.
+    shader_program programs[] = {
+        { .label = "Draw program", .defines = shaderDefines, .vertex = vertexSource, .fragment = fragmentSource,
+          .attributes = attributes },
+        #if GPU_ASSIGNMENT
+            { .label = "Light assignment program", .defines = shaderDefines, .compute = assignSource }
+        #endif
+    };
+    int programCount = (int)(sizeof(programs) / sizeof(programs[0]));
+    shader_submit(programs, programCount);
+
+    float vertices[24 * 6];
+    unsigned short indices[36];
+    buildCube(vertices, indices);
+
+    scene->vbo = createBuffer(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW, "Cube vertices");
+    scene->ebo = createBuffer(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW, "Cube indices");
+
+    #if CLUSTERED_SHADING
+        scene->instanceBuffer = createBuffer(GL_ARRAY_BUFFER, (size_t)scene->instanceCount * sizeof(instance),
+            scene->instances, GL_STATIC_DRAW, "Instances");
+        glGenVertexArrays(1, &scene->vao);
+        glBindVertexArray(scene->vao);
+        setupVertexArrays(scene);
+        glBindVertexArray(0);
+
+        createClusterTextures(scene);
+    #else
+        setupVertexArrays(scene);
+    #endif
+
+    int failures = shader_finish(programs, programCount);
+    scene->drawProgram = programs[0].program;
+    #if GPU_ASSIGNMENT
+        scene->assignProgram = programs[1].program;
+    #endif
+    if (failures > 0) {
+        return -1;
+    }
+    setupPrograms(scene);
+
+    glEnable(GL_DEPTH_TEST);
+    glEnable(GL_CULL_FACE);
+    glFrontFace(GL_CCW);
+    glCullFace(GL_BACK);
+
+    return 0;
+}
+
+static void deleteScene(scene* scene) {
+    gpu_memory_untrack(GPU_MEMORY_BUFFER, scene->vbo);
+    gpu_memory_untrack(GPU_MEMORY_BUFFER, scene->ebo);
+    glDeleteBuffers(1, &scene->vbo);
+    glDeleteBuffers(1, &scene->ebo);
+    #if CLUSTERED_SHADING
+        gpu_memory_untrack(GPU_MEMORY_BUFFER, scene->instanceBuffer);
+        glDeleteBuffers(1, &scene->instanceBuffer);
+        glDeleteVertexArrays(1, &scene->vao);
+        deleteDataTexture(scene->clusterCounts);
+        deleteDataTexture(scene->clusterLights);
+        deleteDataTexture(scene->lightPositions);
+        deleteDataTexture(scene->lightColorTexture);
+    #endif
+    #if GPU_ASSIGNMENT
+        glDeleteProgram(scene->assignProgram);
+    #endif
+    glDeleteProgram(scene->drawProgram);
+
+    light_cluster_destroy(&scene->grid);
+    free(scene->instances);
+    free(scene->paths);
+    free(scene->lights);
+    free(scene->lightColors);
+}
+
+// Move the lights along their paths and bring them in view space.
+static void moveLights(scene* scene, int lightCount, float time, const mat4 view) {
+    for (int i = 0; i < lightCount; i++) {
+        const light_path* path = &scene->paths[i];
+        float angle = path->phase + time * path->speed;
+        float x = path->center[0] + cosf(angle) * path->orbit;
+        float y = path->center[1];
+        float z = path->center[2] + sinf(angle) * path->orbit;
+        float* light = &scene->lights[i * 4];
+        light[0] = view[0] * x + view[4] * y + view[8] * z + view[12];
+        light[1] = view[1] * x + view[5] * y + view[9] * z + view[13];
+        light[2] = view[2] * x + view[6] * y + view[10] * z + view[14];
+    }
+}
+
+#if CLUSTERED_SHADING
+// Upload rows of 4-component float texels, the last one only partly filled.
+static void uploadRows(GLuint texture, int width, const float* data, int count) {
+    int fullRows = count / width;
+    int rest = count % width;
+    glBindTexture(GL_TEXTURE_2D, texture);
+    if (fullRows > 0) {
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, fullRows, GL_RGBA, GL_FLOAT, data);
+    }
+    if (rest > 0) {
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, fullRows, rest, 1, GL_RGBA, GL_FLOAT, &data[(size_t)fullRows * width * 4]);
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+// The lists are uploaded whole: their slots are fixed, so the unused ones
+// are sent as well.
+static void uploadLists(scene* scene) {
+    light_cluster_grid* grid = &scene->grid;
+    glBindTexture(GL_TEXTURE_2D, scene->clusterCounts);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, grid->tilesX, grid->tilesY * grid->slices,
+        GL_RED_INTEGER, GL_UNSIGNED_INT, grid->counts);
+
+    size_t slots = (size_t)light_cluster_count(grid) * LIGHT_CLUSTER_MAX_LIGHTS;
+    int fullRows = (int)(slots / INDEX_TEXTURE_WIDTH);
+    int rest = (int)(slots % INDEX_TEXTURE_WIDTH);
+    glBindTexture(GL_TEXTURE_2D, scene->clusterLights);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, INDEX_TEXTURE_WIDTH, fullRows, GL_RED_INTEGER, GL_UNSIGNED_INT,
+        grid->indices);
+    if (rest > 0) {
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, fullRows, rest, 1, GL_RED_INTEGER, GL_UNSIGNED_INT,
+            &grid->indices[(size_t)fullRows * INDEX_TEXTURE_WIDTH]);
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+#endif
+
+static void assignLights(scene* scene, assign_mode mode, int lightCount, run_stats* stats) {
+    #if CLUSTERED_SHADING
+        uploadRows(scene->lightPositions, LIGHT_TEXTURE_WIDTH, scene->lights, lightCount);
+    #endif
+
+    #if GPU_ASSIGNMENT
+        if (mode == ASSIGN_GPU) {
+            PROFILE_GPU_ZONE_BEGIN("assign_lights");
+            gl_debug_push_group("Assign lights");
+            glUseProgram(scene->assignProgram);
+            glUniform1i(glGetUniformLocation(scene->assignProgram, "lightCount"), lightCount);
+            bindClusterTextures(scene);
+            glBindImageTexture(0, scene->clusterCounts, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32UI);
+            glBindImageTexture(1, scene->clusterLights, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32UI);
+            int groups = (light_cluster_count(&scene->grid) + ASSIGN_GROUP_SIZE - 1) / ASSIGN_GROUP_SIZE;
+            GL_CHECK(glDispatchCompute((GLuint)groups, 1, 1));
+            glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+            glUseProgram(0);
+            gl_debug_pop_group();
+            PROFILE_GPU_ZONE_END();
+            return;
+        }
+    #else
+        (void)mode;
+    #endif
+
+    PROFILE_ZONE_BEGIN("assign_lights");
+    light_cluster_assign(&scene->grid, scene->lights, lightCount);
+    PROFILE_ZONE_END();
+
+    unsigned long long listed = 0;
+    int clusterCount = light_cluster_count(&scene->grid);
+    for (int i = 0; i < clusterCount; i++) {
+        listed += scene->grid.counts[i];
+    }
+    stats->listed += (double)listed;
+    stats->dropped += (double)scene->grid.dropped;
+
+    #if CLUSTERED_SHADING
+        uploadLists(scene);
+    #endif
+}
+
+#if !CLUSTERED_SHADING
+// Shade each object with the first lights listed in the cluster of its
+// center.
+static void setObjectLights(scene* scene, const instance* object, const mat4 view) {
+    const float* c = object->center;
+    float center[3] = {
+        view[0] * c[0] + view[4] * c[1] + view[8] * c[2] + view[12],
+        view[1] * c[0] + view[5] * c[1] + view[9] * c[2] + view[13],
+        view[2] * c[0] + view[6] * c[1] + view[10] * c[2] + view[14]
+    };
+
+    float positions[MAX_OBJECT_LIGHTS * 4];
+    float colors[MAX_OBJECT_LIGHTS * 3];
+    int count = 0;
+    int cluster = light_cluster_find(&scene->grid, center);
+    if (cluster >= 0) {
+        const unsigned int* list = &scene->grid.indices[(size_t)cluster * LIGHT_CLUSTER_MAX_LIGHTS];
+        int listed = (int)scene->grid.counts[cluster];
+        for (; count < listed && count < MAX_OBJECT_LIGHTS; count++) {
+            memcpy(&positions[count * 4], &scene->lights[list[count] * 4], 4 * sizeof(float));
+            memcpy(&colors[count * 3], &scene->lightColors[list[count] * 4], 3 * sizeof(float));
+        }
+    }
+
+    if (count > 0) {
+        glUniform4fv(scene->objectLightPositions, count, positions);
+        glUniform3fv(scene->objectLightColors, count, colors);
+    }
+    glUniform1i(scene->objectLightCount, count);
+}
+#endif
+
+static void drawScene(scene* scene, const mat4 view) {
+    glViewport(0, 0, scene->width, scene->height);
+    glClearColor(0.02f, 0.02f, 0.03f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    PROFILE_GPU_ZONE_BEGIN("shade");
+    gl_debug_push_group("Shade");
+    glUseProgram(scene->drawProgram);
+    glUniformMatrix4fv(glGetUniformLocation(scene->drawProgram, "mView"), 1, GL_FALSE, view);
+    #if CLUSTERED_SHADING
+        bindClusterTextures(scene);
+        glBindVertexArray(scene->vao);
+        GL_CHECK(glDrawElementsInstanced(GL_TRIANGLES, 36, GL_UNSIGNED_SHORT, 0, scene->instanceCount));
+        glBindVertexArray(0);
+    #else
+        for (int i = 0; i < scene->instanceCount; i++) {
+            setObjectLights(scene, &scene->instances[i], view);
+            glVertexAttrib4fv(ATTRIB_CENTER, scene->instances[i].center);
+            glVertexAttrib4fv(ATTRIB_EXTENT, scene->instances[i].extent);
+            glDrawElements(GL_TRIANGLES, 36, GL_UNSIGNED_SHORT, 0);
+        }
+    #endif
+    gl_debug_pop_group();
+    PROFILE_GPU_ZONE_END();
+}
+
+// Render frames with the given number of lights for a while, the camera
+// circling above the field. The GPU is waited for after the lists are built
+// and after the scene is shaded, so each part is timed on its own.
+static void runMode(scene* scene, assign_mode mode, int lightCount, double duration, GLFWwindow* window,
+                    EGLDisplay display, EGLSurface surface, run_stats* stats) {
+    memset(stats, 0, sizeof(run_stats));
+    float radius = scene->extent * 0.55f;
+    float height = scene->extent * 0.3f;
+    mat4 view;
+
+    double start = timer_now();
+    double end = start + duration;
+    while (timer_now() < end && !(window && glfwWindowShouldClose(window))) {
+        PROFILE_ZONE_BEGIN("frame");
+        PROFILE_GPU_ZONE_BEGIN("frame");
+        gl_debug_push_group(modeNames[mode]);
+
+        double frameStart = timer_now();
+        float time = (float)(frameStart - start);
+        float angle = time * 0.2f;
+        mat4_look_at(view,
+            sinf(angle) * radius, height, cosf(angle) * radius,
+            0, 0, 0,
+            0, 1, 0
+        );
+
+        moveLights(scene, lightCount, time, view);
+        assignLights(scene, mode, lightCount, stats);
+        glFinish();
+        double assigned = timer_now();
+
+        drawScene(scene, view);
+        glFinish();
+        double shaded = timer_now();
+        stats->assignSeconds += assigned - frameStart;
+        stats->shadeSeconds += shaded - assigned;
+
+        gl_debug_pop_group();
+        PROFILE_GPU_ZONE_END();
+        PROFILE_ZONE_BEGIN("eglSwapBuffers");
+        eglSwapBuffers(display, surface);
+        PROFILE_ZONE_END();
+        glFinish();
+        profiler_gpu_collect();
+        PROFILE_ZONE_END();
+        stats->frames++;
+
+        if (window) {
+            glfwPollEvents();
+        }
+    }
+    stats->seconds = timer_now() - start;
+}
+
+int main(int argc, char** argv) {
+    int grid = option_int(argc, argv, "--grid", 24);
+    int maxLights = option_int(argc, argv, "--lights", 4096);
+    int tilesX = option_int(argc, argv, "--tiles", 16);
+    int slices = option_int(argc, argv, "--slices", 24);
+    int width = option_int(argc, argv, "--width", 640);
+    int height = option_int(argc, argv, "--height", 480);
+    double duration = option_double(argc, argv, "--seconds", 1.0);
+    int useWindow = option_flag(argc, argv, "--window");
+    const char* reportPath = option_string(argc, argv, "--json", NULL);
+    const char* tracePath = option_string(argc, argv, "--trace", NULL);
+
+    if (grid < 1 || grid > 128) {
+        fprintf(stderr, "The grid size must be between 1 and 128\n");
+        return -1;
+    }
+    if (maxLights < 1 || maxLights > MAX_LIGHT_COUNT) {
+        fprintf(stderr, "The number of lights must be between 1 and %d\n", MAX_LIGHT_COUNT);
+        return -1;
+    }
+    if (tilesX < 1 || tilesX > 64 || slices < 1 || slices > 64) {
+        fprintf(stderr, "The number of tiles and slices must be between 1 and 64\n");
+        return -1;
+    }
+    if (width < 1 || height < 1) {
+        fprintf(stderr, "The width and the height must be positive\n");
+        return -1;
+    }
+
+    // Square tiles, as far as the height allows.
+    int tilesY = (int)((float)tilesX * (float)height / (float)width + 0.5f);
+    tilesY = tilesY < 1 ? 1 : tilesY > 64 ? 64 : tilesY;
+
+    PROFILE_THREAD_NAME("main");
+
+    GLFWwindow* window = NULL;
+    EGLDisplay display;
+    EGLConfig config;
+    EGLContext context;
+    EGLSurface surface;
+    if (useWindow) {
+        if (initializeWindow(&window, &display, &context, &surface, width, height, "Erlangsters - Clustered Lighting") != 0) {
+            return -1;
+        }
+    } else if (initializeHeadless(&display, &config, &context, &surface, width, height) != 0) {
+        return -1;
+    }
+    gl_debug_install();
+    profiler_gpu_init();
+
+    static scene scene;
+    scene.width = width;
+    scene.height = height;
+    if (createScene(&scene, grid, maxLights, tilesX, tilesY, slices) != 0) {
+        return -1;
+    }
+
+    int clusterCount = light_cluster_count(&scene.grid);
+    printf("Lighting %d objects with up to %d lights at %dx%d in %dx%dx%d clusters (%s sphere tests, %s)\n",
+        scene.instanceCount, maxLights, width, height, tilesX, tilesY, slices, light_cluster_isa(),
+        GPU_ASSIGNMENT ? "CPU and GPU assignment" : "CPU assignment, compute shaders are not available");
+    if (!CLUSTERED_SHADING) {
+        printf("OpenGL ES 2.0: each object is shaded with up to %d lights of the cluster of its center\n",
+            MAX_OBJECT_LIGHTS);
+    }
+
+    report* report = report_open(reportPath);
+    report_string(report, "sample", "clustered-lighting");
+    report_integer(report, "objects", scene.instanceCount);
+    report_integer(report, "width", width);
+    report_integer(report, "height", height);
+    report_integer(report, "clusters", clusterCount);
+    report_integer(report, "max_lights_per_cluster", LIGHT_CLUSTER_MAX_LIGHTS);
+    report_string(report, "isa", light_cluster_isa());
+    report_integer(report, "clustered_shading", CLUSTERED_SHADING);
+    report_begin_array(report, "runs");
+
+    int modeCount = GPU_ASSIGNMENT ? ASSIGN_COUNT : ASSIGN_GPU;
+    int lightCount = maxLights < FIRST_LIGHT_COUNT ? maxLights : FIRST_LIGHT_COUNT;
+    int stopped = 0;
+    while (!stopped) {
+        for (int mode = 0; mode < modeCount && !stopped; mode++) {
+            run_stats stats;
+            runMode(&scene, (assign_mode)mode, lightCount, duration, window, display, surface, &stats);
+            if (stats.frames == 0) {
+                stopped = 1;
+                break;
+            }
+
+            double frames = (double)stats.frames;
+            double fps = frames / stats.seconds;
+            double assignMilliseconds = stats.assignSeconds * 1000.0 / frames;
+            double shadeMilliseconds = stats.shadeSeconds * 1000.0 / frames;
+            report_begin_object(report, NULL);
+            report_integer(report, "lights", lightCount);
+            report_string(report, "assignment", modeNames[mode]);
+            report_integer(report, "frames", stats.frames);
+            report_number(report, "frames_per_second", fps);
+            report_number(report, "assign_milliseconds_per_frame", assignMilliseconds);
+            report_number(report, "shade_milliseconds_per_frame", shadeMilliseconds);
+            if (mode == ASSIGN_CPU) {
+                double perCluster = stats.listed / (frames * (double)clusterCount);
+                double dropped = stats.dropped / frames;
+                printf("%6d lights  %s  assign: %7.3f ms  shade: %7.3f ms  lights/cluster: %6.2f  dropped: %8.1f  %7.1f frames/s\n",
+                    lightCount, modeNames[mode], assignMilliseconds, shadeMilliseconds, perCluster, dropped, fps);
+                report_number(report, "lights_per_cluster", perCluster);
+                report_number(report, "dropped_per_frame", dropped);
+            } else {
+                printf("%6d lights  %s  assign: %7.3f ms  shade: %7.3f ms  %44.1f frames/s\n",
+                    lightCount, modeNames[mode], assignMilliseconds, shadeMilliseconds, fps);
+            }
+            report_end_object(report);
+        }
+
+        if (lightCount == maxLights) {
+            break;
+        }
+        lightCount = lightCount * 2 < maxLights ? lightCount * 2 : maxLights;
+    }
+
+    report_end_array(report);
+    gpu_memory_print();
+    gpu_memory_report(report);
+    report_close(report);
+
+    deleteScene(&scene);
+    gl_debug_summary();
+    profiler_gpu_shutdown();
+    if (tracePath) {
+        profiler_write_trace(tracePath);
+    }
+    if (window) {
+        terminateWindow(window);
+    } else {
+        terminateHeadless(display, context, surface);
+    }
+
+    return 0;
+}
@@ -0,0 +1,50 @@
+//
+// Copyright (c) 2025, Byteplug LLC.
+//
+// This source file is part of a project made by the Erlangsters community and
+// is released under the MIT license. Please refer to the LICENSE.md file that
+// can be found at the root of the project repository.
+//
+// Written by Jonathan De Wachter <jonathan.dewachter@byteplug.io>
+//
+#include "arena.h"
+#include <stdint.h>
+#include <stdlib.h>
+
+int arena_init(arena* arena, size_t capacity) {
+    arena->base = malloc(capacity);
+    arena->capacity = arena->base ? capacity : 0;
+    arena->offset = 0;
+    arena->peak = 0;
+    return arena->base ? 0 : -1;
+}
+
+void arena_destroy(arena* arena) {
+    free(arena->base);
+    arena->base = NULL;
+    arena->capacity = 0;
+    arena->offset = 0;
+}
+
+void* arena_alloc(arena* arena, size_t size, size_t alignment) {
+    if (alignment == 0) {
+        alignment = _Alignof(max_align_t);
+    }
+
+    uintptr_t address = (uintptr_t)arena->base + arena->offset;
+    size_t padding = (size_t)(-address & (alignment - 1));
+    if (padding > arena->capacity - arena->offset || size > arena->capacity - arena->offset - padding) {
+        return NULL;
+    }
+
+    void* memory = arena->base + arena->offset + padding;
+    arena->offset += padding + size;
+    if (arena->offset > arena->peak) {
+        arena->peak = arena->offset;
+    }
+    return memory;
+}
+
+void arena_reset(arena* arena) {
+    arena->offset = 0;
+}
@@ -0,0 +1,36 @@
+//
+// Copyright (c) 2025, Byteplug LLC.
+//
+// This source file is part of a project made by the Erlangsters community and
+// is released under the MIT license. Please refer to the LICENSE.md file that
+// can be found at the root of the project repository.
+//
+// Written by Jonathan De Wachter <jonathan.dewachter@byteplug.io>
+//
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+// Linear allocator for transient CPU-side data (texture staging, vertex data
+// built before an upload, etc.). The memory is reserved once; allocating only
+// bumps an offset and everything is released at once with arena_reset(),
+// typically at the start of every frame.
+//
+// An arena is not thread-safe; give each thread its own.
+typedef struct {
+    unsigned char* base;
+    size_t capacity;
+    size_t offset;
+    size_t peak;
+} arena;
+
+int arena_init(arena* arena, size_t capacity);
+void arena_destroy(arena* arena);
+
+// Returns NULL when the arena is exhausted. The alignment must be a power of
+// two (0 means the alignment of max_align_t).
+void* arena_alloc(arena* arena, size_t size, size_t alignment);
+void arena_reset(arena* arena);
+
+#endif // ARENA_H
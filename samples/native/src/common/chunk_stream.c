@@ -0,0 +1,528 @@
+//
+// Copyright (c) 2025, Byteplug LLC.
+//
+// This source file is part of a project made by the Erlangsters community and
+// is released under the MIT license. Please refer to the LICENSE.md file that
+// can be found at the root of the project repository.
+//
+// Written by Jonathan De Wachter <jonathan.dewachter@byteplug.io>
+//
+#include "chunk_stream.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "mapped_file.h"
+#include "profiler.h"
+#include "thread.h"
+
+#define PACK_VERSION 1u
+
+// The chunks start on a cache line, in the pack and in the staging buffers.
+#define PACK_ALIGNMENT 64
+
+static const char packMagic[4] = { 'C', 'H', 'N', 'K' };
+
+typedef struct {
+    char magic[4];  // Written last, so an unfinished pack is never valid.
+    uint32_t version;
+    uint32_t count;
+    uint32_t reserved;
+    uint64_t key;
+} pack_header;
+
+typedef struct {
+    uint64_t offset;
+    uint64_t size;
+    uint32_t checksum;
+    uint32_t reserved;
+} pack_entry;
+
+struct chunk_pack_writer {
+    FILE* file;
+    char* path;
+    pack_header header;
+    pack_entry* entries;
+    int added;
+    uint64_t offset;
+    int failed;
+};
+
+typedef enum {
+    CHUNK_UNLOADED,
+    CHUNK_QUEUED,
+    CHUNK_LOADING,
+    CHUNK_STAGED,
+    CHUNK_RESIDENT,
+    CHUNK_CORRUPTED
+} chunk_state;
+
+typedef struct {
+    chunk_state state;
+    int staging;          // Buffer holding the chunk while it is staged.
+    int rank;             // In the chunks wanted by the current update, or -1.
+    long long lastUsed;   // Last update that wanted the chunk.
+    size_t residentBytes;
+    int newer;            // Neighbours in the list of the resident chunks,
+    int older;            // from the most recently used (-1 at the ends).
+} chunk_info;
+
+struct chunk_stream {
+    chunk_stream_config config;
+    mapped_file file;
+    const pack_entry* entries;
+    int count;
+    chunk_info* chunks;
+    long long update;
+
+    unsigned char* staging;
+    size_t stagingStride;
+    int* uploading;
+    int* released;
+
+    // Shared with the loaders. The state of a chunk is changed by the
+    // loaders (from queued to staged) under the mutex, and by the updates
+    // otherwise.
+    mutex_t mutex;
+    cond_t wake;
+    int quit;
+    int* requests;  // Nearest first, replaced by every update.
+    int requestCount;
+    int requestNext;
+    int* freeStaging;
+    int freeStagingCount;
+    int* staged;
+    int stagedCount;
+
+    thread_t loaders[CHUNK_STREAM_MAX_LOADERS];
+    int loaderCount;
+
+    int newest;
+    int oldest;
+    size_t residentBytes;
+    int residentCount;
+};
+
+// FNV-1a. It reads every byte of the chunk, which is also what pages it in.
+static uint32_t checksum(const unsigned char* data, size_t size) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < size; i++) {
+        hash = (hash ^ data[i]) * 16777619u;
+    }
+    return hash;
+}
+
+static uint64_t alignOffset(uint64_t offset) {
+    return (offset + PACK_ALIGNMENT - 1) / PACK_ALIGNMENT * PACK_ALIGNMENT;
+}
+
+chunk_pack_writer* chunk_pack_create(const char* path, int count, unsigned long long key) {
+    if (count < 1) {
+        return NULL;
+    }
+    chunk_pack_writer* writer = calloc(1, sizeof(chunk_pack_writer));
+    if (!writer) {
+        return NULL;
+    }
+    size_t pathLength = strlen(path);
+    writer->path = malloc(pathLength + 1);
+    writer->entries = calloc((size_t)count, sizeof(pack_entry));
+    writer->file = fopen(path, "wb");
+    if (!writer->path || !writer->entries || !writer->file) {
+        if (writer->file) {
+            fclose(writer->file);
+            remove(path);
+        }
+        free(writer->path);
+        free(writer->entries);
+        free(writer);
+        return NULL;
+    }
+    memcpy(writer->path, path, pathLength + 1);
+    writer->header.version = PACK_VERSION;
+    writer->header.count = (uint32_t)count;
+    writer->header.key = key;
+
+    // Room for the header and the table, written when the pack is finished.
+    if (fwrite(&writer->header, sizeof(pack_header), 1, writer->file) != 1 ||
+        fwrite(writer->entries, sizeof(pack_entry), (size_t)count, writer->file) != (size_t)count) {
+        writer->failed = 1;
+    }
+    writer->offset = sizeof(pack_header) + (uint64_t)count * sizeof(pack_entry);
+    return writer;
+}
+
+int chunk_pack_add(chunk_pack_writer* writer, const void* data, size_t size) {
+    if (writer->failed || writer->added == (int)writer->header.count) {
+        writer->failed = 1;
+        return -1;
+    }
+    static const unsigned char padding[PACK_ALIGNMENT] = { 0 };
+    uint64_t offset = alignOffset(writer->offset);
+    size_t paddingSize = (size_t)(offset - writer->offset);
+    if ((paddingSize > 0 && fwrite(padding, 1, paddingSize, writer->file) != paddingSize) ||
+        fwrite(data, 1, size, writer->file) != size) {
+        writer->failed = 1;
+        return -1;
+    }
+    pack_entry* entry = &writer->entries[writer->added++];
+    entry->offset = offset;
+    entry->size = size;
+    entry->checksum = checksum(data, size);
+    writer->offset = offset + size;
+    return 0;
+}
+
+int chunk_pack_finish(chunk_pack_writer* writer) {
+    int failed = writer->failed || writer->added != (int)writer->header.count;
+    if (!failed) {
+        memcpy(writer->header.magic, packMagic, sizeof(packMagic));
+        failed = fseek(writer->file, 0, SEEK_SET) != 0 ||
+            fwrite(&writer->header, sizeof(pack_header), 1, writer->file) != 1 ||
+            fwrite(writer->entries, sizeof(pack_entry), (size_t)writer->added, writer->file) != (size_t)writer->added;
+    }
+    if (fclose(writer->file) != 0) {
+        failed = 1;
+    }
+    if (failed) {
+        remove(writer->path);
+    }
+    free(writer->path);
+    free(writer->entries);
+    free(writer);
+    return failed ? -1 : 0;
+}
+
+static void loaderMain(void* arg) {
+    chunk_stream* stream = arg;
+    PROFILE_THREAD_NAME("chunk loader");
+
+    mutex_lock(&stream->mutex);
+    for (;;) {
+        while (!stream->quit && (stream->requestNext == stream->requestCount || stream->freeStagingCount == 0)) {
+            cond_wait(&stream->wake, &stream->mutex);
+        }
+        if (stream->quit) {
+            break;
+        }
+        int chunk = stream->requests[stream->requestNext++];
+        int staging = stream->freeStaging[--stream->freeStagingCount];
+        stream->chunks[chunk].state = CHUNK_LOADING;
+        mutex_unlock(&stream->mutex);
+
+        PROFILE_ZONE_BEGIN("load chunk");
+        const pack_entry* entry = &stream->entries[chunk];
+        unsigned char* buffer = stream->staging + (size_t)staging * stream->stagingStride;
+        memcpy(buffer, stream->file.data + entry->offset, (size_t)entry->size);
+        int valid = checksum(buffer, (size_t)entry->size) == entry->checksum;
+        PROFILE_ZONE_END();
+
+        mutex_lock(&stream->mutex);
+        chunk_info* info = &stream->chunks[chunk];
+        if (valid) {
+            info->state = CHUNK_STAGED;
+            info->staging = staging;
+            stream->staged[stream->stagedCount++] = chunk;
+        } else {
+            // Not requested again.
+            fprintf(stderr, "Chunk %d of %s is corrupted\n", chunk, stream->config.path);
+            info->state = CHUNK_CORRUPTED;
+            stream->freeStaging[stream->freeStagingCount++] = staging;
+        }
+    }
+    mutex_unlock(&stream->mutex);
+}
+
+static int validatePack(const mapped_file* file, unsigned long long key) {
+    if (file->size < sizeof(pack_header)) {
+        return -1;
+    }
+    const pack_header* header = (const pack_header*)file->data;
+    if (memcmp(header->magic, packMagic, sizeof(packMagic)) != 0 || header->version != PACK_VERSION ||
+        header->key != key || header->count == 0) {
+        return -1;
+    }
+    if (sizeof(pack_header) + (uint64_t)header->count * sizeof(pack_entry) > file->size) {
+        return -1;
+    }
+    const pack_entry* entries = (const pack_entry*)(file->data + sizeof(pack_header));
+    for (uint32_t i = 0; i < header->count; i++) {
+        if (entries[i].offset > file->size || entries[i].size > file->size - entries[i].offset) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static void freeStream(chunk_stream* stream) {
+    mapped_file_close(&stream->file);
+    free(stream->chunks);
+    free(stream->staging);
+    free(stream->uploading);
+    free(stream->released);
+    free(stream->requests);
+    free(stream->freeStaging);
+    free(stream->staged);
+    cond_destroy(&stream->wake);
+    mutex_destroy(&stream->mutex);
+    free(stream);
+}
+
+static void stopLoaders(chunk_stream* stream) {
+    mutex_lock(&stream->mutex);
+    stream->quit = 1;
+    cond_broadcast(&stream->wake);
+    mutex_unlock(&stream->mutex);
+
+    for (int i = 0; i < stream->loaderCount; i++) {
+        thread_join(stream->loaders[i]);
+    }
+}
+
+chunk_stream* chunk_stream_open(const chunk_stream_config* config) {
+    chunk_stream* stream = calloc(1, sizeof(chunk_stream));
+    if (!stream) {
+        return NULL;
+    }
+    mutex_init(&stream->mutex);
+    cond_init(&stream->wake);
+    stream->config = *config;
+    if (stream->config.loaderCount < 1) {
+        stream->config.loaderCount = 1;
+    }
+    if (stream->config.loaderCount > CHUNK_STREAM_MAX_LOADERS) {
+        stream->config.loaderCount = CHUNK_STREAM_MAX_LOADERS;
+    }
+    if (stream->config.stagingCount < 1) {
+        stream->config.stagingCount = 1;
+    }
+    stream->newest = -1;
+    stream->oldest = -1;
+
+    if (mapped_file_open(&stream->file, config->path) != 0 || validatePack(&stream->file, config->key) != 0) {
+        freeStream(stream);
+        return NULL;
+    }
+    const pack_header* header = (const pack_header*)stream->file.data;
+    stream->count = (int)header->count;
+    stream->entries = (const pack_entry*)(stream->file.data + sizeof(pack_header));
+
+    size_t largest = 0;
+    for (int i = 0; i < stream->count; i++) {
+        if (stream->entries[i].size > largest) {
+            largest = (size_t)stream->entries[i].size;
+        }
+    }
+    int stagingCount = stream->config.stagingCount;
+    stream->stagingStride = (size_t)alignOffset(largest > 0 ? largest : 1);
+    stream->staging = malloc(stream->stagingStride * (size_t)stagingCount);
+    stream->chunks = calloc((size_t)stream->count, sizeof(chunk_info));
+    stream->requests = malloc((size_t)stream->count * sizeof(int));
+    stream->uploading = malloc((size_t)stagingCount * sizeof(int));
+    stream->released = malloc((size_t)stagingCount * sizeof(int));
+    stream->freeStaging = malloc((size_t)stagingCount * sizeof(int));
+    stream->staged = malloc((size_t)stagingCount * sizeof(int));
+    if (!stream->staging || !stream->chunks || !stream->requests || !stream->uploading || !stream->released ||
+        !stream->freeStaging || !stream->staged) {
+        freeStream(stream);
+        return NULL;
+    }
+    for (int i = 0; i < stream->count; i++) {
+        stream->chunks[i].rank = -1;
+        stream->chunks[i].newer = -1;
+        stream->chunks[i].older = -1;
+    }
+    for (int i = 0; i < stagingCount; i++) {
+        stream->freeStaging[i] = stagingCount - 1 - i;
+    }
+    stream->freeStagingCount = stagingCount;
+
+    for (int i = 0; i < stream->config.loaderCount; i++) {
+        if (thread_create(&stream->loaders[i], loaderMain, stream) != 0) {
+            stopLoaders(stream);
+            freeStream(stream);
+            return NULL;
+        }
+        stream->loaderCount++;
+    }
+    return stream;
+}
+
+static void unlinkResident(chunk_stream* stream, int chunk) {
+    chunk_info* info = &stream->chunks[chunk];
+    if (info->newer >= 0) {
+        stream->chunks[info->newer].older = info->older;
+    } else {
+        stream->newest = info->older;
+    }
+    if (info->older >= 0) {
+        stream->chunks[info->older].newer = info->newer;
+    } else {
+        stream->oldest = info->newer;
+    }
+    info->newer = -1;
+    info->older = -1;
+}
+
+static void linkNewest(chunk_stream* stream, int chunk) {
+    chunk_info* info = &stream->chunks[chunk];
+    info->newer = -1;
+    info->older = stream->newest;
+    if (stream->newest >= 0) {
+        stream->chunks[stream->newest].newer = chunk;
+    } else {
+        stream->oldest = chunk;
+    }
+    stream->newest = chunk;
+}
+
+static void evict(chunk_stream* stream, int chunk) {
+    chunk_info* info = &stream->chunks[chunk];
+    unlinkResident(stream, chunk);
+    info->state = CHUNK_UNLOADED;
+    stream->residentBytes -= info->residentBytes;
+    stream->residentCount--;
+    info->residentBytes = 0;
+    stream->config.evict(stream->config.arg, chunk);
+}
+
+void chunk_stream_close(chunk_stream* stream) {
+    stopLoaders(stream);
+    while (stream->newest >= 0) {
+        evict(stream, stream->newest);
+    }
+    freeStream(stream);
+}
+
+int chunk_stream_count(const chunk_stream* stream) {
+    return stream->count;
+}
+
+int chunk_stream_is_resident(const chunk_stream* stream, int chunk) {
+    return stream->chunks[chunk].state == CHUNK_RESIDENT;
+}
+
+// Evict the least recently used chunks until size more bytes fit under the
+// cap. Returns 0 when only chunks wanted by the current update are left.
+static int makeRoom(chunk_stream* stream, size_t size, chunk_stream_stats* stats) {
+    size_t cap = stream->config.residentCap;
+    if (cap == 0) {
+        return 1;
+    }
+    while (stream->residentBytes + size > cap) {
+        int victim = stream->oldest;
+        if (victim < 0 || stream->chunks[victim].lastUsed == stream->update) {
+            return 0;
+        }
+        evict(stream, victim);
+        stats->evictions++;
+    }
+    return 1;
+}
+
+void chunk_stream_update(chunk_stream* stream, const int* wanted, int wantedCount, chunk_stream_stats* stats) {
+    PROFILE_ZONE_BEGIN("chunk stream update");
+    memset(stats, 0, sizeof(chunk_stream_stats));
+    stream->update++;
+
+    mutex_lock(&stream->mutex);
+
+    // The requests of the previous update the loaders have not started are
+    // replaced, so they always work on what the camera needs now.
+    for (int r = stream->requestNext; r < stream->requestCount; r++) {
+        stream->chunks[stream->requests[r]].state = CHUNK_UNLOADED;
+    }
+    stream->requestCount = 0;
+    stream->requestNext = 0;
+    for (int i = 0; i < wantedCount; i++) {
+        int chunk = wanted[i];
+        chunk_info* info = &stream->chunks[chunk];
+        info->rank = i;
+        info->lastUsed = stream->update;
+        if (info->state == CHUNK_RESIDENT) {
+            unlinkResident(stream, chunk);
+            linkNewest(stream, chunk);
+        } else if (info->state == CHUNK_UNLOADED) {
+            info->state = CHUNK_QUEUED;
+            stream->requests[stream->requestCount++] = chunk;
+        }
+    }
+    if (stream->requestCount > 0) {
+        cond_broadcast(&stream->wake);
+    }
+
+    int uploadingCount = stream->stagedCount;
+    memcpy(stream->uploading, stream->staged, (size_t)uploadingCount * sizeof(int));
+    stream->stagedCount = 0;
+    mutex_unlock(&stream->mutex);
+
+    // Nearest first (insertion sort, there are a few staged chunks at most);
+    // the chunks not wanted anymore come first and are dropped.
+    int* uploading = stream->uploading;
+    for (int i = 1; i < uploadingCount; i++) {
+        int chunk = uploading[i];
+        int j = i;
+        while (j > 0 && stream->chunks[uploading[j - 1]].rank > stream->chunks[chunk].rank) {
+            uploading[j] = uploading[j - 1];
+            j--;
+        }
+        uploading[j] = chunk;
+    }
+
+    int releasedCount = 0;
+    int keptCount = 0;
+    size_t budget = stream->config.uploadBudget;
+    for (int i = 0; i < uploadingCount; i++) {
+        int chunk = uploading[i];
+        chunk_info* info = &stream->chunks[chunk];
+        if (info->rank < 0) {
+            info->state = CHUNK_UNLOADED;
+            stream->released[releasedCount++] = info->staging;
+            continue;
+        }
+
+        // The first upload of an update is always allowed, so a chunk larger
+        // than the budget does not block the stream.
+        size_t size = (size_t)stream->entries[chunk].size;
+        if ((budget > 0 && stats->uploadedBytes > 0 && stats->uploadedBytes + size > budget) ||
+            !makeRoom(stream, size, stats)) {
+            uploading[keptCount++] = chunk;
+            continue;
+        }
+
+        PROFILE_ZONE_BEGIN("upload chunk");
+        const unsigned char* data = stream->staging + (size_t)info->staging * stream->stagingStride;
+        info->residentBytes = stream->config.upload(stream->config.arg, chunk, data, size);
+        PROFILE_ZONE_END();
+        info->state = CHUNK_RESIDENT;
+        stream->released[releasedCount++] = info->staging;
+        linkNewest(stream, chunk);
+        stream->residentBytes += info->residentBytes;
+        stream->residentCount++;
+        stats->uploadedBytes += size;
+        stats->uploads++;
+    }
+
+    mutex_lock(&stream->mutex);
+    for (int i = 0; i < keptCount; i++) {
+        stream->staged[stream->stagedCount++] = uploading[i];
+    }
+    for (int i = 0; i < releasedCount; i++) {
+        stream->freeStaging[stream->freeStagingCount++] = stream->released[i];
+    }
+    if (releasedCount > 0) {
+        cond_broadcast(&stream->wake);
+    }
+    for (int i = 0; i < wantedCount; i++) {
+        chunk_info* info = &stream->chunks[wanted[i]];
+        if (info->state != CHUNK_RESIDENT) {
+            stats->missing++;
+        }
+        info->rank = -1;
+    }
+    mutex_unlock(&stream->mutex);
+
+    stats->residentBytes = stream->residentBytes;
+    stats->residentCount = stream->residentCount;
+    PROFILE_ZONE_END();
+}
@@ -0,0 +1,95 @@
+//
+// Copyright (c) 2025, Byteplug LLC.
+//
+// This source file is part of a project made by the Erlangsters community and
+// is released under the MIT license. Please refer to the LICENSE.md file that
+// can be found at the root of the project repository.
+//
+// Written by Jonathan De Wachter <jonathan.dewachter@byteplug.io>
+//
+#ifndef CHUNK_STREAM_H
+#define CHUNK_STREAM_H
+
+#include <stddef.h>
+
+// Streaming of the chunks of a world too large to stay in GPU memory.
+//
+// The chunks are stored in a pack file: a header, a table of their offsets,
+// sizes and checksums, and their data one after the other. The pack is
+// memory-mapped, and loader threads copy the chunks requested into staging
+// buffers (which is when their pages are read from the disk) and verify
+// their checksum.
+//
+// Every frame, the thread owning the GL context tells the stream which
+// chunks it wants, nearest first, with chunk_stream_update(). The chunks
+// wanted that are not resident are requested from the loaders, the staged
+// ones are uploaded (nearest first) until the upload budget of the frame is
+// spent, and the least recently used chunks are evicted when the resident
+// ones would exceed the memory cap. The chunks wanted by the frame are never
+// evicted by it, so a cap too small for a frame leaves some of them missing.
+//
+// The uploads and the evictions are done by callbacks of the sample, which
+// own the GL objects of the chunks.
+#define CHUNK_STREAM_MAX_LOADERS 8
+
+typedef struct chunk_pack_writer chunk_pack_writer;
+typedef struct chunk_stream chunk_stream;
+
+// Create a pack of count chunks at path. The key identifies the content (the
+// parameters it was generated from): opening the pack with another key
+// fails, so stale packs are regenerated. Returns NULL when the file cannot
+// be created.
+chunk_pack_writer* chunk_pack_create(const char* path, int count, unsigned long long key);
+
+// Append the next chunk. Returns -1 on a write error.
+int chunk_pack_add(chunk_pack_writer* writer, const void* data, size_t size);
+
+// Write the table and close the pack. A pack with fewer chunks than declared,
+// or that failed to be written, is removed. Returns -1 in that case.
+int chunk_pack_finish(chunk_pack_writer* writer);
+
+// Make a chunk resident from its data (which is only valid during the call),
+// and return the GPU memory it takes, in bytes.
+typedef size_t (*chunk_upload_func)(void* arg, int chunk, const void* data, size_t size);
+typedef void (*chunk_evict_func)(void* arg, int chunk);
+
+typedef struct {
+    const char* path;
+    unsigned long long key;
+    int loaderCount;
+    int stagingCount;     // Chunks loaded but not uploaded yet, at most.
+    size_t uploadBudget;  // Bytes per update; 0 is unlimited.
+    size_t residentCap;   // Bytes; 0 is unlimited.
+    chunk_upload_func upload;
+    chunk_evict_func evict;
+    void* arg;
+} chunk_stream_config;
+
+// The work of an update, and the state after it.
+typedef struct {
+    size_t uploadedBytes;
+    int uploads;
+    int evictions;
+    int missing;  // Wanted and not resident.
+    size_t residentBytes;
+    int residentCount;
+} chunk_stream_stats;
+
+// Map the pack and start the loaders. Returns NULL when the pack is missing,
+// invalid or was created with another key, or when the loaders cannot be
+// started.
+chunk_stream* chunk_stream_open(const chunk_stream_config* config);
+
+// Stop the loaders and evict every resident chunk (so the GL context must be
+// current).
+void chunk_stream_close(chunk_stream* stream);
+
+int chunk_stream_count(const chunk_stream* stream);
+
+// Request, upload and evict for the chunks wanted by the frame (wanted[0]
+// being the one that matters most).
+void chunk_stream_update(chunk_stream* stream, const int* wanted, int wantedCount, chunk_stream_stats* stats);
+
+int chunk_stream_is_resident(const chunk_stream* stream, int chunk);
+
+#endif // CHUNK_STREAM_H
@@ -0,0 +1,242 @@
+//
+// Copyright (c) 2025, Byteplug LLC.
+//
+// This source file is part of a project made by the Erlangsters community and
+// is released under the MIT license. Please refer to the LICENSE.md file that
+// can be found at the root of the project repository.
+//
+// Written by Jonathan De Wachter <jonathan.dewachter@byteplug.io>
+//
+#include "frame_pacing.h"
+#include <math.h>
+#include <string.h>
+#include "profiler.h"
+#include "timer.h"
+
+int frame_swap_mode_parse(const char* name, frame_swap_mode* mode) {
+    if (strcmp(name, "0") == 0) {
+        *mode = FRAME_SWAP_IMMEDIATE;
+    } else if (strcmp(name, "1") == 0) {
+        *mode = FRAME_SWAP_VSYNC;
+    } else if (strcmp(name, "adaptive") == 0) {
+        *mode = FRAME_SWAP_ADAPTIVE;
+    } else {
+        return -1;
+    }
+    return 0;
+}
+
+const char* frame_swap_mode_name(frame_swap_mode mode) {
+    switch (mode) {
+        case FRAME_SWAP_IMMEDIATE:
+            return "0";
+        case FRAME_SWAP_VSYNC:
+            return "1";
+        default:
+            return "adaptive";
+    }
+}
+
+static void setSwapInterval(frame_pacer* pacer, int interval) {
+    if (interval != pacer->swapInterval) {
+        eglSwapInterval(pacer->display, interval);
+        pacer->swapInterval = interval;
+    }
+}
+
+// The presentation times are only used when the surface can report the one
+// of the display.
+static void loadFrameTimestamps(frame_pacer* pacer) {
+    const char* extensions = eglQueryString(pacer->display, EGL_EXTENSIONS);
+    if (!extensions || strstr(extensions, "EGL_ANDROID_get_frame_timestamps") == NULL) {
+        return;
+    }
+    PFNEGLGETFRAMETIMESTAMPSUPPORTEDANDROIDPROC isSupported =
+        (PFNEGLGETFRAMETIMESTAMPSUPPORTEDANDROIDPROC)eglGetProcAddress("eglGetFrameTimestampSupportedANDROID");
+    PFNEGLGETNEXTFRAMEIDANDROIDPROC getNextFrameId =
+        (PFNEGLGETNEXTFRAMEIDANDROIDPROC)eglGetProcAddress("eglGetNextFrameIdANDROID");
+    PFNEGLGETFRAMETIMESTAMPSANDROIDPROC getFrameTimestamps =
+        (PFNEGLGETFRAMETIMESTAMPSANDROIDPROC)eglGetProcAddress("eglGetFrameTimestampsANDROID");
+    if (!isSupported || !getNextFrameId || !getFrameTimestamps ||
+        !isSupported(pacer->display, pacer->surface, EGL_DISPLAY_PRESENT_TIME_ANDROID) ||
+        !eglSurfaceAttrib(pacer->display, pacer->surface, EGL_TIMESTAMPS_ANDROID, EGL_TRUE)) {
+        return;
+    }
+    pacer->getNextFrameId = getNextFrameId;
+    pacer->getFrameTimestamps = getFrameTimestamps;
+}
+
+void frame_pacer_init(frame_pacer* pacer, EGLDisplay display, EGLSurface surface, frame_swap_mode swapMode,
+                      double targetRate, double refreshRate, const char* logPath) {
+    memset(pacer, 0, sizeof(frame_pacer));
+    pacer->display = display;
+    pacer->surface = surface;
+    pacer->swapMode = swapMode;
+    pacer->swapInterval = -1;
+    setSwapInterval(pacer, swapMode == FRAME_SWAP_IMMEDIATE ? 0 : 1);
+    pacer->targetInterval = targetRate > 0.0 ? 1.0 / targetRate : 0.0;
+    pacer->refreshInterval = 1.0 / (refreshRate > 0.0 ? refreshRate : 60.0);
+    loadFrameTimestamps(pacer);
+
+    if (logPath) {
+        pacer->log = fopen(logPath, "w");
+        if (pacer->log) {
+            fprintf(pacer->log, "frame,start_ms,latency_ms,interval_ms\n");
+        } else {
+            fprintf(stderr, "Failed to open %s\n", logPath);
+        }
+    }
+}
+
+void frame_pacer_destroy(frame_pacer* pacer) {
+    if (pacer->log) {
+        fclose(pacer->log);
+        pacer->log = NULL;
+    }
+}
+
+void frame_pacer_begin(frame_pacer* pacer) {
+    double interval = pacer->targetInterval;
+    if (interval > 0.0) {
+        PROFILE_ZONE_BEGIN("frame limiter");
+        double now = timer_now();
+        // A frame late by a whole interval restarts the schedule, instead of
+        // the next frames being rushed to catch up.
+        if (pacer->deadline == 0.0 || now > pacer->deadline + interval) {
+            pacer->deadline = now;
+        } else {
+            timer_sleep_until(pacer->deadline);
+        }
+        pacer->deadline += interval;
+        PROFILE_ZONE_END();
+    }
+    pacer->frameStart = timer_now();
+    if (pacer->origin == 0.0) {
+        pacer->origin = pacer->frameStart;
+    }
+}
+
+// A frame whose presentation is known.
+static void record(frame_pacer* pacer, double start, double present) {
+    pacer->lastLatency = present - start;
+    pacer->latencySum += pacer->lastLatency;
+    if (pacer->lastLatency > pacer->latencyMax) {
+        pacer->latencyMax = pacer->lastLatency;
+    }
+
+    int missed = 0;
+    if (pacer->frames > 0) {
+        pacer->lastInterval = present - pacer->previousPresent;
+        pacer->intervalSum += pacer->lastInterval;
+        pacer->intervalSquareSum += pacer->lastInterval * pacer->lastInterval;
+        pacer->intervals++;
+
+        // Frames without a limit nor a refresh to wait for have no interval
+        // to miss.
+        double expected = pacer->targetInterval;
+        if (pacer->swapMode != FRAME_SWAP_IMMEDIATE && pacer->refreshInterval > expected) {
+            expected = pacer->refreshInterval;
+        }
+        missed = expected > 0.0 && pacer->lastInterval > FRAME_PACER_MISSED * expected;
+        pacer->missed += missed;
+    }
+    pacer->previousPresent = present;
+    pacer->frames++;
+
+    if (pacer->swapMode == FRAME_SWAP_ADAPTIVE) {
+        setSwapInterval(pacer, missed ? 0 : 1);
+    }
+
+    if (pacer->log) {
+        fprintf(pacer->log, "%lld,%.3f,%.3f,", pacer->frames - 1, (start - pacer->origin) * 1000.0,
+            pacer->lastLatency * 1000.0);
+        if (pacer->frames > 1) {
+            fprintf(pacer->log, "%.3f", pacer->lastInterval * 1000.0);
+        }
+        fputc('\n', pacer->log);
+    }
+}
+
+// Account the oldest frames whose presentation time was reported, in order.
+static void collectPresentTimes(frame_pacer* pacer) {
+    const EGLint names[] = { EGL_DISPLAY_PRESENT_TIME_ANDROID };
+    while (pacer->pendingCount > 0) {
+        int first = pacer->pendingFirst;
+        EGLnsecsANDROID present;
+        if (!pacer->getFrameTimestamps(pacer->display, pacer->surface, pacer->pending[first].id, 1, names,
+                &present) || present == EGL_TIMESTAMP_INVALID_ANDROID) {
+            pacer->lost++;
+        } else if (present == EGL_TIMESTAMP_PENDING_ANDROID) {
+            break;
+        } else {
+            // On the monotonic clock, like timer_now().
+            record(pacer, pacer->pending[first].start, (double)present * 1e-9);
+        }
+        pacer->pendingFirst = (first + 1) % FRAME_PACER_PENDING;
+        pacer->pendingCount--;
+    }
+}
+
+void frame_pacer_present(frame_pacer* pacer) {
+    EGLuint64KHR frameId;
+    int tracked = pacer->getNextFrameId && pacer->getNextFrameId(pacer->display, pacer->surface, &frameId);
+
+    PROFILE_ZONE_BEGIN("eglSwapBuffers");
+    eglSwapBuffers(pacer->display, pacer->surface);
+    PROFILE_ZONE_END();
+    double returned = timer_now();
+
+    if (!tracked) {
+        record(pacer, pacer->frameStart, returned);
+        return;
+    }
+    if (pacer->pendingCount == FRAME_PACER_PENDING) {
+        pacer->pendingFirst = (pacer->pendingFirst + 1) % FRAME_PACER_PENDING;
+        pacer->pendingCount--;
+        pacer->lost++;
+    }
+    int last = (pacer->pendingFirst + pacer->pendingCount) % FRAME_PACER_PENDING;
+    pacer->pending[last].id = frameId;
+    pacer->pending[last].start = pacer->frameStart;
+    pacer->pendingCount++;
+    collectPresentTimes(pacer);
+}
+
+int frame_pacer_has_present_times(const frame_pacer* pacer) {
+    return pacer->getFrameTimestamps != NULL;
+}
+
+double frame_pacer_average_latency(const frame_pacer* pacer) {
+    return pacer->frames > 0 ? pacer->latencySum * 1000.0 / (double)pacer->frames : 0.0;
+}
+
+double frame_pacer_average_interval(const frame_pacer* pacer) {
+    return pacer->intervals > 0 ? pacer->intervalSum * 1000.0 / (double)pacer->intervals : 0.0;
+}
+
+double frame_pacer_jitter(const frame_pacer* pacer) {
+    if (pacer->intervals < 2) {
+        return 0.0;
+    }
+    double count = (double)pacer->intervals;
+    double mean = pacer->intervalSum / count;
+    double variance = pacer->intervalSquareSum / count - mean * mean;
+    return variance > 0.0 ? sqrt(variance) * 1000.0 : 0.0;
+}
+
+void frame_pacer_print(const frame_pacer* pacer) {
+    printf("Frame pacing: swap interval %s, ", frame_swap_mode_name(pacer->swapMode));
+    if (pacer->targetInterval > 0.0) {
+        printf("limited to %.1f frames/s\n", 1.0 / pacer->targetInterval);
+    } else {
+        printf("no frame rate limit\n");
+    }
+    printf("  %lld frames, interval %.2f ms (jitter %.2f ms, %lld missed)\n",
+        pacer->frames, frame_pacer_average_interval(pacer), frame_pacer_jitter(pacer), pacer->missed);
+    printf("  latency %.2f ms (max %.2f ms), from the %s\n", frame_pacer_average_latency(pacer),
+        pacer->latencyMax * 1000.0,
+        frame_pacer_has_present_times(pacer) ? "display present times" : "return of eglSwapBuffers()");
+    if (pacer->lost > 0) {
+        printf("  %lld frames without a present time\n", pacer->lost);
+    }
+}
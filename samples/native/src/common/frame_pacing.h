@@ -0,0 +1,110 @@
+//
+// Copyright (c) 2025, Byteplug LLC.
+//
+// This source file is part of a project made by the Erlangsters community and
+// is released under the MIT license. Please refer to the LICENSE.md file that
+// can be found at the root of the project repository.
+//
+// Written by Jonathan De Wachter <jonathan.dewachter@byteplug.io>
+//
+#ifndef FRAME_PACING_H
+#define FRAME_PACING_H
+
+#include <stdio.h>
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+// Paces the frames of an interactive loop, for even frame intervals rather
+// than the highest frame rate:
+//
+// - the swap interval is set explicitly, to 0, 1, or "adaptive": 1, except
+//   right after a frame that missed its refresh, which is presented without
+//   waiting for the next one (a tear instead of a stutter);
+// - an optional frame rate limit, slept at the start of the frame (so the
+//   frame samples its inputs as late as possible) with timer_sleep_until(),
+//   whose last 0.2 ms (2 ms on Windows) are a spin rather than a sleep;
+// - the latency from the start of every frame on the CPU to its
+//   presentation, and the jitter of the intervals between presentations.
+//
+// The presentation times come from EGL_ANDROID_get_frame_timestamps when the
+// display exposes it, a few frames late. Otherwise the time eglSwapBuffers()
+// returns is used, which is when the frame was queued (and, once the queue is
+// full with a swap interval of 1, roughly when the previous one was shown).
+#define FRAME_PACER_PENDING 8
+
+// Presentations more than this many frame intervals apart count as missed.
+#define FRAME_PACER_MISSED 1.5
+
+typedef enum {
+    FRAME_SWAP_IMMEDIATE,
+    FRAME_SWAP_VSYNC,
+    FRAME_SWAP_ADAPTIVE
+} frame_swap_mode;
+
+typedef struct {
+    EGLDisplay display;
+    EGLSurface surface;
+    frame_swap_mode swapMode;
+    int swapInterval;        // Currently set on the surface.
+    double targetInterval;   // Seconds between frames, 0 without a limit.
+    double refreshInterval;  // Of the display.
+    double deadline;         // Start of the next frame, with a limit.
+    double frameStart;
+    double origin;           // Start of the first frame.
+
+    // Frames presented whose presentation time is not known yet.
+    PFNEGLGETNEXTFRAMEIDANDROIDPROC getNextFrameId;
+    PFNEGLGETFRAMETIMESTAMPSANDROIDPROC getFrameTimestamps;
+    struct {
+        EGLuint64KHR id;
+        double start;
+    } pending[FRAME_PACER_PENDING];
+    int pendingFirst;
+    int pendingCount;
+
+    // Of the frames whose presentation is known.
+    long long frames;
+    long long missed;
+    long long lost;  // Whose presentation time was never reported.
+    double lastLatency;
+    double lastInterval;
+    double previousPresent;
+    double latencySum;
+    double latencyMax;
+    double intervalSum;
+    double intervalSquareSum;
+    long long intervals;
+
+    FILE* log;
+} frame_pacer;
+
+// Parse "0", "1" or "adaptive". Returns -1 for anything else.
+int frame_swap_mode_parse(const char* name, frame_swap_mode* mode);
+const char* frame_swap_mode_name(frame_swap_mode mode);
+
+// Start pacing the frames of the surface (current on the calling thread), at
+// most targetRate frames per second (0 for no limit), for a display
+// refreshing refreshRate times per second (0 when unknown, taken as 60).
+// With a log path, every frame presented is written to it as a line of CSV.
+void frame_pacer_init(frame_pacer* pacer, EGLDisplay display, EGLSurface surface, frame_swap_mode swapMode,
+                      double targetRate, double refreshRate, const char* logPath);
+void frame_pacer_destroy(frame_pacer* pacer);
+
+// Wait for the start of the frame, when the frame rate is limited.
+void frame_pacer_begin(frame_pacer* pacer);
+
+// Swap the buffers, then account the frames whose presentation became known.
+void frame_pacer_present(frame_pacer* pacer);
+
+// Whether the presentation times come from the display.
+int frame_pacer_has_present_times(const frame_pacer* pacer);
+
+// Averages in milliseconds; the jitter is the standard deviation of the
+// intervals between presentations.
+double frame_pacer_average_latency(const frame_pacer* pacer);
+double frame_pacer_average_interval(const frame_pacer* pacer);
+double frame_pacer_jitter(const frame_pacer* pacer);
+
+void frame_pacer_print(const frame_pacer* pacer);
+
+#endif // FRAME_PACING_H
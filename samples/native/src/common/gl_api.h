@@ -55,8 +55,12 @@
     #include <GL/glext.h>
 #elif SAMPLE_OPENGL_VERSION_MAJOR == 2
     #include <GLES2/gl2.h>
-#else
+#elif SAMPLE_OPENGL_VERSION_MINOR == 0
     #include <GLES3/gl3.h>
+#elif SAMPLE_OPENGL_VERSION_MINOR == 1
+    #include <GLES3/gl31.h>
+#else
+    #include <GLES3/gl32.h>
 #endif
 
 #endif // GL_API_H
\ No newline at end of file
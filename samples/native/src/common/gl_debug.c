@@ -0,0 +1,219 @@
+//
+// Copyright (c) 2025, Byteplug LLC.
+//
+// This source file is part of a project made by the Erlangsters community and
+// is released under the MIT license. Please refer to the LICENSE.md file that
+// can be found at the root of the project repository.
+//
+// Written by Jonathan De Wachter <jonathan.dewachter@byteplug.io>
+//
+#include "gl_debug.h"
+
+#if defined(SAMPLE_GL_DEBUG)
+
+#include "gl_extensions.h"
+#include <stdatomic.h>
+#include <stdio.h>
+
+#ifndef GL_DEBUG_OUTPUT
+    #define GL_DEBUG_OUTPUT 0x92E0
+#endif
+#ifndef GL_DEBUG_OUTPUT_SYNCHRONOUS
+    #define GL_DEBUG_OUTPUT_SYNCHRONOUS 0x8242
+#endif
+#ifndef GL_DEBUG_SOURCE_APPLICATION
+    #define GL_DEBUG_SOURCE_APPLICATION 0x824A
+#endif
+
+#define DEBUG_SOURCE_API 0x8246
+#define DEBUG_SOURCE_WINDOW_SYSTEM 0x8247
+#define DEBUG_SOURCE_SHADER_COMPILER 0x8248
+#define DEBUG_SOURCE_THIRD_PARTY 0x8249
+#define DEBUG_SOURCE_APPLICATION 0x824A
+
+#define DEBUG_TYPE_ERROR 0x824C
+#define DEBUG_TYPE_DEPRECATED_BEHAVIOR 0x824D
+#define DEBUG_TYPE_UNDEFINED_BEHAVIOR 0x824E
+#define DEBUG_TYPE_PORTABILITY 0x824F
+#define DEBUG_TYPE_PERFORMANCE 0x8250
+#define DEBUG_TYPE_MARKER 0x8268
+#define DEBUG_TYPE_PUSH_GROUP 0x8269
+#define DEBUG_TYPE_POP_GROUP 0x826A
+
+#define DEBUG_SEVERITY_HIGH 0x9146
+#define DEBUG_SEVERITY_MEDIUM 0x9147
+#define DEBUG_SEVERITY_LOW 0x9148
+#define DEBUG_SEVERITY_NOTIFICATION 0x826B
+
+// Messages beyond that count are only tallied, not printed.
+#define MAX_PRINTED_MESSAGES 200
+
+typedef void (SAMPLE_GL_APIENTRY *debug_proc)(GLenum source, GLenum type, GLuint id,
+    GLenum severity, GLsizei length, const GLchar* message, const void* userParam);
+typedef void (SAMPLE_GL_APIENTRY *debug_message_callback_proc)(debug_proc callback, const void* userParam);
+typedef void (SAMPLE_GL_APIENTRY *object_label_proc)(GLenum identifier, GLuint name, GLsizei length, const GLchar* label);
+typedef void (SAMPLE_GL_APIENTRY *push_debug_group_proc)(GLenum source, GLuint id, GLsizei length, const GLchar* message);
+typedef void (SAMPLE_GL_APIENTRY *pop_debug_group_proc)(void);
+
+static debug_message_callback_proc debugMessageCallback;
+static object_label_proc objectLabel;
+static push_debug_group_proc pushDebugGroup;
+static pop_debug_group_proc popDebugGroup;
+
+static atomic_int messageCount;
+static atomic_int errorCount;
+static atomic_int performanceCount;
+static atomic_int otherCount;
+
+static const char* source_name(GLenum source) {
+    switch (source) {
+        case DEBUG_SOURCE_API: return "api";
+        case DEBUG_SOURCE_WINDOW_SYSTEM: return "window-system";
+        case DEBUG_SOURCE_SHADER_COMPILER: return "shader-compiler";
+        case DEBUG_SOURCE_THIRD_PARTY: return "third-party";
+        case DEBUG_SOURCE_APPLICATION: return "application";
+        default: return "other";
+    }
+}
+
+static const char* type_name(GLenum type) {
+    switch (type) {
+        case DEBUG_TYPE_ERROR: return "error";
+        case DEBUG_TYPE_DEPRECATED_BEHAVIOR: return "deprecated";
+        case DEBUG_TYPE_UNDEFINED_BEHAVIOR: return "undefined-behavior";
+        case DEBUG_TYPE_PORTABILITY: return "portability";
+        case DEBUG_TYPE_PERFORMANCE: return "performance";
+        case DEBUG_TYPE_MARKER: return "marker";
+        case DEBUG_TYPE_PUSH_GROUP: return "push-group";
+        case DEBUG_TYPE_POP_GROUP: return "pop-group";
+        default: return "other";
+    }
+}
+
+static const char* severity_name(GLenum severity) {
+    switch (severity) {
+        case DEBUG_SEVERITY_HIGH: return "high";
+        case DEBUG_SEVERITY_MEDIUM: return "medium";
+        case DEBUG_SEVERITY_LOW: return "low";
+        case DEBUG_SEVERITY_NOTIFICATION: return "notification";
+        default: return "unknown";
+    }
+}
+
+static const char* error_name(GLenum error) {
+    switch (error) {
+        case GL_INVALID_ENUM: return "GL_INVALID_ENUM";
+        case GL_INVALID_VALUE: return "GL_INVALID_VALUE";
+        case GL_INVALID_OPERATION: return "GL_INVALID_OPERATION";
+        case GL_INVALID_FRAMEBUFFER_OPERATION: return "GL_INVALID_FRAMEBUFFER_OPERATION";
+        case GL_OUT_OF_MEMORY: return "GL_OUT_OF_MEMORY";
+        default: return "unknown error";
+    }
+}
+
+static void SAMPLE_GL_APIENTRY debug_callback(GLenum source, GLenum type, GLuint id,
+    GLenum severity, GLsizei length, const GLchar* message, const void* userParam)
+{
+    (void)length;
+    (void)userParam;
+
+    // Our own debug groups are echoed back by the driver; they are only
+    // useful in capture tools.
+    if (type == DEBUG_TYPE_PUSH_GROUP || type == DEBUG_TYPE_POP_GROUP) {
+        return;
+    }
+
+    if (type == DEBUG_TYPE_ERROR) {
+        atomic_fetch_add(&errorCount, 1);
+    } else if (type == DEBUG_TYPE_PERFORMANCE) {
+        atomic_fetch_add(&performanceCount, 1);
+    } else {
+        atomic_fetch_add(&otherCount, 1);
+    }
+
+    if (atomic_fetch_add(&messageCount, 1) >= MAX_PRINTED_MESSAGES) {
+        return;
+    }
+
+    fprintf(stderr, "GL [%s] [%s] [%s] (%u): %s\n",
+        type_name(type), severity_name(severity), source_name(source), id, message);
+}
+
+int gl_debug_install(void) {
+    // KHR_debug is core in OpenGL 4.3+ and OpenGL ES 3.2; for the other
+    // versions the extension exposes the same functions, with a KHR suffix
+    // on OpenGL ES.
+    #if SAMPLE_OPENGL_API == SAMPLE_API_GL
+        int core = SAMPLE_OPENGL_VERSION_MAJOR > 4 ||
+            (SAMPLE_OPENGL_VERSION_MAJOR == 4 && SAMPLE_OPENGL_VERSION_MINOR >= 3);
+        const char* suffix = "";
+    #else
+        int core = SAMPLE_OPENGL_VERSION_MAJOR == 3 && SAMPLE_OPENGL_VERSION_MINOR >= 2;
+        const char* suffix = core ? "" : "KHR";
+    #endif
+
+    if (!core && !gl_has_extension("GL_KHR_debug")) {
+        fprintf(stderr, "KHR_debug is not available; only glGetError() checks are enabled\n");
+        return -1;
+    }
+
+    char name[64];
+    snprintf(name, sizeof(name), "glDebugMessageCallback%s", suffix);
+    debugMessageCallback = (debug_message_callback_proc)gl_get_proc_address(name);
+    snprintf(name, sizeof(name), "glObjectLabel%s", suffix);
+    objectLabel = (object_label_proc)gl_get_proc_address(name);
+    snprintf(name, sizeof(name), "glPushDebugGroup%s", suffix);
+    pushDebugGroup = (push_debug_group_proc)gl_get_proc_address(name);
+    snprintf(name, sizeof(name), "glPopDebugGroup%s", suffix);
+    popDebugGroup = (pop_debug_group_proc)gl_get_proc_address(name);
+
+    if (!debugMessageCallback) {
+        fprintf(stderr, "Failed to load glDebugMessageCallback%s\n", suffix);
+        return -1;
+    }
+
+    // Synchronous output reports messages from within the offending call,
+    // which makes them attributable in a debugger.
+    glEnable(GL_DEBUG_OUTPUT);
+    glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+    debugMessageCallback(debug_callback, NULL);
+
+    // Discard errors raised before the callback was installed.
+    while (glGetError() != GL_NO_ERROR) {
+    }
+
+    return 0;
+}
+
+void gl_debug_check_error(const char* call, const char* file, int line) {
+    GLenum error;
+    while ((error = glGetError()) != GL_NO_ERROR) {
+        atomic_fetch_add(&errorCount, 1);
+        fprintf(stderr, "%s:%d: %s failed with %s (0x%04x)\n", file, line, call, error_name(error), error);
+    }
+}
+
+void gl_debug_label(GLenum identifier, GLuint name, const char* label) {
+    if (objectLabel) {
+        objectLabel(identifier, name, -1, label);
+    }
+}
+
+void gl_debug_push_group(const char* name) {
+    if (pushDebugGroup) {
+        pushDebugGroup(GL_DEBUG_SOURCE_APPLICATION, 0, -1, name);
+    }
+}
+
+void gl_debug_pop_group(void) {
+    if (popDebugGroup) {
+        popDebugGroup();
+    }
+}
+
+void gl_debug_summary(void) {
+    printf("GL debug: %d errors, %d performance warnings, %d other messages\n",
+        atomic_load(&errorCount), atomic_load(&performanceCount), atomic_load(&otherCount));
+}
+
+#endif // SAMPLE_GL_DEBUG
@@ -0,0 +1,71 @@
+//
+// Copyright (c) 2025, Byteplug LLC.
+//
+// This source file is part of a project made by the Erlangsters community and
+// is released under the MIT license. Please refer to the LICENSE.md file that
+// can be found at the root of the project repository.
+//
+// Written by Jonathan De Wachter <jonathan.dewachter@byteplug.io>
+//
+#ifndef GL_DEBUG_H
+#define GL_DEBUG_H
+
+#include "gl_api.h"
+
+// GL debug and validation layer. It is enabled when SAMPLE_GL_DEBUG is
+// defined (Debug builds, or -DSAMPLE_GL_DEBUG=ON) and otherwise compiles down
+// to the raw GL calls with no code left behind.
+//
+// When enabled, GL_CHECK() reports glGetError() failures after the wrapped
+// call, and gl_debug_install() hooks a KHR_debug message callback into the
+// current context (core in OpenGL 4.3+ and OpenGL ES 3.2, GL_KHR_debug
+// otherwise). Driver performance warnings (implicit synchronizations, shader
+// recompiles, slow paths) are reported through that callback. Object labels
+// and debug groups make the messages, and captures in tools such as RenderDoc,
+// easier to read.
+
+#ifndef GL_BUFFER
+    #define GL_BUFFER 0x82E0
+#endif
+#ifndef GL_SHADER
+    #define GL_SHADER 0x82E1
+#endif
+#ifndef GL_PROGRAM
+    #define GL_PROGRAM 0x82E2
+#endif
+#ifndef GL_QUERY
+    #define GL_QUERY 0x82E3
+#endif
+#ifndef GL_VERTEX_ARRAY
+    #define GL_VERTEX_ARRAY 0x8074
+#endif
+
+#if defined(SAMPLE_GL_DEBUG)
+    #define GL_CHECK(call) \
+        do { \
+            call; \
+            gl_debug_check_error(#call, __FILE__, __LINE__); \
+        } while (0)
+
+    // Install the message callback on the current context. Returns 0 when
+    // KHR_debug is available, -1 otherwise (GL_CHECK() still works).
+    int gl_debug_install(void);
+
+    void gl_debug_check_error(const char* call, const char* file, int line);
+    void gl_debug_label(GLenum identifier, GLuint name, const char* label);
+    void gl_debug_push_group(const char* name);
+    void gl_debug_pop_group(void);
+
+    // Print how many messages of each type were received.
+    void gl_debug_summary(void);
+#else
+    #define GL_CHECK(call) call
+    static inline int gl_debug_install(void) { return -1; }
+    #define gl_debug_check_error(call, file, line) ((void)0)
+    #define gl_debug_label(identifier, name, label) ((void)(label))
+    #define gl_debug_push_group(name) ((void)(name))
+    #define gl_debug_pop_group() ((void)0)
+    #define gl_debug_summary() ((void)0)
+#endif
+
+#endif // GL_DEBUG_H
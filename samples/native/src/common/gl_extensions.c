@@ -0,0 +1,47 @@
+//
+// Copyright (c) 2025, Byteplug LLC.
+//
+// This source file is part of a project made by the Erlangsters community and
+// is released under the MIT license. Please refer to the LICENSE.md file that
+// can be found at the root of the project repository.
+//
+// Written by Jonathan De Wachter <jonathan.dewachter@byteplug.io>
+//
+#include "gl_extensions.h"
+#include <EGL/egl.h>
+#include <string.h>
+
+int gl_has_extension(const char* name) {
+#if SAMPLE_OPENGL_API == SAMPLE_API_GL || SAMPLE_OPENGL_VERSION_MAJOR >= 3
+    // Core profiles no longer accept GL_EXTENSIONS with glGetString().
+    GLint count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+    for (GLint i = 0; i < count; i++) {
+        const char* extension = (const char*)glGetStringi(GL_EXTENSIONS, (GLuint)i);
+        if (extension && strcmp(extension, name) == 0) {
+            return 1;
+        }
+    }
+    return 0;
+#else
+    const char* extensions = (const char*)glGetString(GL_EXTENSIONS);
+    if (!extensions) {
+        return 0;
+    }
+
+    // Match whole, space-separated names only.
+    size_t length = strlen(name);
+    for (const char* match = strstr(extensions, name); match; match = strstr(match + length, name)) {
+        int starts = match == extensions || match[-1] == ' ';
+        int ends = match[length] == ' ' || match[length] == '\0';
+        if (starts && ends) {
+            return 1;
+        }
+    }
+    return 0;
+#endif
+}
+
+void* gl_get_proc_address(const char* name) {
+    return (void*)eglGetProcAddress(name);
+}
@@ -0,0 +1,34 @@
+//
+// Copyright (c) 2025, Byteplug LLC.
+//
+// This source file is part of a project made by the Erlangsters community and
+// is released under the MIT license. Please refer to the LICENSE.md file that
+// can be found at the root of the project repository.
+//
+// Written by Jonathan De Wachter <jonathan.dewachter@byteplug.io>
+//
+#ifndef GL_EXTENSIONS_H
+#define GL_EXTENSIONS_H
+
+#include "gl_api.h"
+
+// Calling convention of the GL entry points, for the function pointers we
+// load at runtime. Desktop and ES headers name it differently.
+#if defined(GL_APIENTRY)
+    #define SAMPLE_GL_APIENTRY GL_APIENTRY
+#elif defined(APIENTRY)
+    #define SAMPLE_GL_APIENTRY APIENTRY
+#else
+    #define SAMPLE_GL_APIENTRY
+#endif
+
+// Whether the current context exposes the given extension. The extension
+// list is queried each time, so avoid calling it in hot paths.
+int gl_has_extension(const char* name);
+
+// Resolve an entry point that is not guaranteed by the headers of the
+// targeted version (extensions, or newer core functions). Returns NULL when
+// the entry point is not available.
+void* gl_get_proc_address(const char* name);
+
+#endif // GL_EXTENSIONS_H
@@ -0,0 +1,305 @@
+//
+// Copyright (c) 2025, Byteplug LLC.
+//
+// This source file is part of a project made by the Erlangsters community and
+// is released under the MIT license. Please refer to the LICENSE.md file that
+// can be found at the root of the project repository.
+//
+// Written by Jonathan De Wachter <jonathan.dewachter@byteplug.io>
+//
+#include "gpu_memory.h"
+#include "gl_extensions.h"
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define GPU_MEMORY_INFO_DEDICATED_VIDMEM_NVX 0x9047
+#define GPU_MEMORY_INFO_TOTAL_AVAILABLE_MEMORY_NVX 0x9048
+#define GPU_MEMORY_INFO_CURRENT_AVAILABLE_VIDMEM_NVX 0x9049
+#define GPU_MEMORY_INFO_EVICTED_MEMORY_NVX 0x904B
+#define TEXTURE_FREE_MEMORY_ATI 0x87FC
+
+// Open addressing table of the tracked objects, keyed by kind and name.
+typedef struct {
+    GLuint name;
+    int kind;
+    size_t bytes;
+} tracked_object;
+
+static atomic_flag tableLock = ATOMIC_FLAG_INIT;
+static tracked_object* table;
+static size_t tableCapacity;
+static size_t tableCount;
+
+static atomic_size_t currentBytes[GPU_MEMORY_KIND_COUNT];
+static atomic_size_t peakBytes[GPU_MEMORY_KIND_COUNT];
+static atomic_size_t totalCurrentBytes;
+static atomic_size_t totalPeakBytes;
+
+static const char* kindNames[GPU_MEMORY_KIND_COUNT] = {
+    "buffers",
+    "textures",
+    "renderbuffers"
+};
+
+static void lock_table(void) {
+    while (atomic_flag_test_and_set_explicit(&tableLock, memory_order_acquire)) {
+    }
+}
+
+static void unlock_table(void) {
+    atomic_flag_clear_explicit(&tableLock, memory_order_release);
+}
+
+static size_t hash_object(int kind, GLuint name) {
+    return ((size_t)name * 2654435761u) ^ (size_t)kind;
+}
+
+// Return the slot of the object, or the empty slot where it would go. Name 0
+// is never a valid GL object, so it marks empty slots.
+static tracked_object* find_slot(tracked_object* entries, size_t capacity, int kind, GLuint name) {
+    size_t index = hash_object(kind, name) & (capacity - 1);
+    while (entries[index].name != 0 && (entries[index].name != name || entries[index].kind != kind)) {
+        index = (index + 1) & (capacity - 1);
+    }
+    return &entries[index];
+}
+
+static int grow_table(void) {
+    size_t capacity = tableCapacity ? tableCapacity * 2 : 256;
+    tracked_object* entries = calloc(capacity, sizeof(tracked_object));
+    if (!entries) {
+        return -1;
+    }
+
+    for (size_t i = 0; i < tableCapacity; i++) {
+        if (table[i].name != 0) {
+            *find_slot(entries, capacity, table[i].kind, table[i].name) = table[i];
+        }
+    }
+
+    free(table);
+    table = entries;
+    tableCapacity = capacity;
+    return 0;
+}
+
+static void update_peak(atomic_size_t* peak, size_t value) {
+    size_t previous = atomic_load(peak);
+    while (value > previous && !atomic_compare_exchange_weak(peak, &previous, value)) {
+    }
+}
+
+static void apply_delta(gpu_memory_kind kind, size_t added, size_t removed) {
+    size_t current = atomic_fetch_add(&currentBytes[kind], added) + added;
+    atomic_fetch_sub(&currentBytes[kind], removed);
+    update_peak(&peakBytes[kind], current - removed);
+
+    size_t total = atomic_fetch_add(&totalCurrentBytes, added) + added;
+    atomic_fetch_sub(&totalCurrentBytes, removed);
+    update_peak(&totalPeakBytes, total - removed);
+}
+
+void gpu_memory_track(gpu_memory_kind kind, GLuint name, size_t bytes) {
+    if (name == 0 || kind >= GPU_MEMORY_KIND_COUNT) {
+        return;
+    }
+
+    lock_table();
+
+    // Keep the load factor under one half.
+    if ((tableCount + 1) * 2 > tableCapacity && grow_table() != 0) {
+        unlock_table();
+        return;
+    }
+
+    tracked_object* slot = find_slot(table, tableCapacity, kind, name);
+    size_t previous = slot->name != 0 ? slot->bytes : 0;
+    if (slot->name == 0) {
+        tableCount++;
+    }
+    slot->name = name;
+    slot->kind = kind;
+    slot->bytes = bytes;
+
+    unlock_table();
+
+    apply_delta(kind, bytes, previous);
+}
+
+void gpu_memory_untrack(gpu_memory_kind kind, GLuint name) {
+    if (name == 0 || kind >= GPU_MEMORY_KIND_COUNT || tableCapacity == 0) {
+        return;
+    }
+
+    lock_table();
+
+    tracked_object* slot = find_slot(table, tableCapacity, kind, name);
+    if (slot->name == 0) {
+        unlock_table();
+        return;
+    }
+    size_t bytes = slot->bytes;
+
+    // Backward shift deletion keeps the probe sequences intact.
+    size_t hole = (size_t)(slot - table);
+    size_t index = hole;
+    for (;;) {
+        index = (index + 1) & (tableCapacity - 1);
+        if (table[index].name == 0) {
+            break;
+        }
+        size_t home = hash_object(table[index].kind, table[index].name) & (tableCapacity - 1);
+        int movable = hole <= index ? (home <= hole || home > index) : (home <= hole && home > index);
+        if (movable) {
+            table[hole] = table[index];
+            hole = index;
+        }
+    }
+    table[hole].name = 0;
+    tableCount--;
+
+    unlock_table();
+
+    atomic_fetch_sub(&currentBytes[kind], bytes);
+    atomic_fetch_sub(&totalCurrentBytes, bytes);
+}
+
+size_t gpu_memory_current(gpu_memory_kind kind) {
+    return kind < GPU_MEMORY_KIND_COUNT ? atomic_load(&currentBytes[kind]) : 0;
+}
+
+size_t gpu_memory_peak(gpu_memory_kind kind) {
+    return kind < GPU_MEMORY_KIND_COUNT ? atomic_load(&peakBytes[kind]) : 0;
+}
+
+size_t gpu_memory_total_current(void) {
+    return atomic_load(&totalCurrentBytes);
+}
+
+size_t gpu_memory_total_peak(void) {
+    return atomic_load(&totalPeakBytes);
+}
+
+static size_t bytes_per_pixel(GLenum format, GLenum type) {
+    size_t components;
+    switch (format) {
+        case GL_RGBA: components = 4; break;
+        case GL_RGB: components = 3; break;
+        case GL_LUMINANCE_ALPHA: components = 2; break;
+        #if defined(GL_RG)
+            case GL_RG: components = 2; break;
+        #endif
+        #if defined(GL_RED)
+            case GL_RED: components = 1; break;
+        #endif
+        default: components = 1; break;
+    }
+
+    switch (type) {
+        case GL_UNSIGNED_SHORT_5_6_5:
+        case GL_UNSIGNED_SHORT_4_4_4_4:
+        case GL_UNSIGNED_SHORT_5_5_5_1:
+            return 2;
+        case GL_UNSIGNED_SHORT:
+        case GL_SHORT:
+        #if defined(GL_HALF_FLOAT)
+            case GL_HALF_FLOAT:
+        #endif
+            return components * 2;
+        case GL_UNSIGNED_INT:
+        case GL_INT:
+        case GL_FLOAT:
+            return components * 4;
+        default:
+            return components;
+    }
+}
+
+size_t gpu_memory_texture_size(GLenum format, GLenum type, int width, int height, int layers, int levels) {
+    size_t pixel = bytes_per_pixel(format, type);
+    size_t total = 0;
+    for (int level = 0; level < (levels > 0 ? levels : 1); level++) {
+        total += (size_t)width * (size_t)height * (size_t)layers * pixel;
+        width = width > 1 ? width / 2 : 1;
+        height = height > 1 ? height / 2 : 1;
+    }
+    return total;
+}
+
+int gpu_memory_query_driver(gpu_memory_driver_info* info) {
+    info->source = NULL;
+    info->dedicatedKb = -1;
+    info->totalAvailableKb = -1;
+    info->currentAvailableKb = -1;
+    info->evictedKb = -1;
+
+    if (gl_has_extension("GL_NVX_gpu_memory_info")) {
+        GLint value = 0;
+        info->source = "GL_NVX_gpu_memory_info";
+        glGetIntegerv(GPU_MEMORY_INFO_DEDICATED_VIDMEM_NVX, &value);
+        info->dedicatedKb = value;
+        glGetIntegerv(GPU_MEMORY_INFO_TOTAL_AVAILABLE_MEMORY_NVX, &value);
+        info->totalAvailableKb = value;
+        glGetIntegerv(GPU_MEMORY_INFO_CURRENT_AVAILABLE_VIDMEM_NVX, &value);
+        info->currentAvailableKb = value;
+        glGetIntegerv(GPU_MEMORY_INFO_EVICTED_MEMORY_NVX, &value);
+        info->evictedKb = value;
+        return 0;
+    }
+
+    if (gl_has_extension("GL_ATI_meminfo")) {
+        // Each query returns the free pool memory, the largest free block,
+        // and the same for auxiliary memory; only the first is relevant here.
+        GLint values[4] = { 0, 0, 0, 0 };
+        info->source = "GL_ATI_meminfo";
+        glGetIntegerv(TEXTURE_FREE_MEMORY_ATI, values);
+        info->currentAvailableKb = values[0];
+        return 0;
+    }
+
+    return -1;
+}
+
+void gpu_memory_print(void) {
+    printf("GPU memory (current / peak):\n");
+    for (int kind = 0; kind < GPU_MEMORY_KIND_COUNT; kind++) {
+        printf("  %-14s %10.1f KiB / %10.1f KiB\n", kindNames[kind],
+            gpu_memory_current(kind) / 1024.0, gpu_memory_peak(kind) / 1024.0);
+    }
+    printf("  %-14s %10.1f KiB / %10.1f KiB\n", "total",
+        gpu_memory_total_current() / 1024.0, gpu_memory_total_peak() / 1024.0);
+
+    gpu_memory_driver_info info;
+    if (gpu_memory_query_driver(&info) == 0) {
+        printf("  driver (%s): %lld KiB available", info.source, info.currentAvailableKb);
+        if (info.totalAvailableKb >= 0) {
+            printf(" of %lld KiB", info.totalAvailableKb);
+        }
+        printf("\n");
+    }
+}
+
+void gpu_memory_report(report* report) {
+    report_begin_object(report, "gpu_memory");
+    for (int kind = 0; kind < GPU_MEMORY_KIND_COUNT; kind++) {
+        report_begin_object(report, kindNames[kind]);
+        report_integer(report, "current_bytes", (long long)gpu_memory_current(kind));
+        report_integer(report, "peak_bytes", (long long)gpu_memory_peak(kind));
+        report_end_object(report);
+    }
+    report_integer(report, "current_bytes", (long long)gpu_memory_total_current());
+    report_integer(report, "peak_bytes", (long long)gpu_memory_total_peak());
+
+    gpu_memory_driver_info info;
+    if (report && gpu_memory_query_driver(&info) == 0) {
+        report_begin_object(report, "driver");
+        report_string(report, "source", info.source);
+        report_integer(report, "dedicated_kb", info.dedicatedKb);
+        report_integer(report, "total_available_kb", info.totalAvailableKb);
+        report_integer(report, "current_available_kb", info.currentAvailableKb);
+        report_integer(report, "evicted_kb", info.evictedKb);
+        report_end_object(report);
+    }
+    report_end_object(report);
+}
@@ -0,0 +1,59 @@
+//
+// Copyright (c) 2025, Byteplug LLC.
+//
+// This source file is part of a project made by the Erlangsters community and
+// is released under the MIT license. Please refer to the LICENSE.md file that
+// can be found at the root of the project repository.
+//
+// Written by Jonathan De Wachter <jonathan.dewachter@byteplug.io>
+//
+#ifndef GPU_MEMORY_H
+#define GPU_MEMORY_H
+
+#include <stddef.h>
+#include "gl_api.h"
+#include "report.h"
+
+// Registry of the GPU memory allocated by the samples. GL does not report the
+// size of its objects, so the samples declare it when they allocate storage
+// (gpu_memory_track) and when they delete the object (gpu_memory_untrack).
+// Tracking an object again replaces its previous size, which matches the
+// semantics of glBufferData() and glTexImage2D() on an existing object.
+//
+// The registry can be used from any thread; totals are read without locking.
+typedef enum {
+    GPU_MEMORY_BUFFER,
+    GPU_MEMORY_TEXTURE,
+    GPU_MEMORY_RENDERBUFFER,
+    GPU_MEMORY_KIND_COUNT
+} gpu_memory_kind;
+
+void gpu_memory_track(gpu_memory_kind kind, GLuint name, size_t bytes);
+void gpu_memory_untrack(gpu_memory_kind kind, GLuint name);
+
+size_t gpu_memory_current(gpu_memory_kind kind);
+size_t gpu_memory_peak(gpu_memory_kind kind);
+size_t gpu_memory_total_current(void);
+size_t gpu_memory_total_peak(void);
+
+// Size of a 2D texture (or array) of the given unsized format and type,
+// including the mip chain when levels > 1.
+size_t gpu_memory_texture_size(GLenum format, GLenum type, int width, int height, int layers, int levels);
+
+// Readings of the driver, when GL_NVX_gpu_memory_info or GL_ATI_meminfo is
+// exposed. All values are in kilobytes; -1 means unknown.
+typedef struct {
+    const char* source;
+    long long dedicatedKb;
+    long long totalAvailableKb;
+    long long currentAvailableKb;
+    long long evictedKb;
+} gpu_memory_driver_info;
+
+// Returns 0 and fills the info when the driver reports its memory usage.
+int gpu_memory_query_driver(gpu_memory_driver_info* info);
+
+void gpu_memory_print(void);
+void gpu_memory_report(report* report);
+
+#endif // GPU_MEMORY_H
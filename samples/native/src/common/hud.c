@@ -0,0 +1,456 @@
+//
+// Copyright (c) 2025, Byteplug LLC.
+//
+// This source file is part of a project made by the Erlangsters community and
+// is released under the MIT license. Please refer to the LICENSE.md file that
+// can be found at the root of the project repository.
+//
+// Written by Jonathan De Wachter <jonathan.dewachter@byteplug.io>
+//
+#include "hud.h"
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include "gl_debug.h"
+#include "gpu_memory.h"
+#include "profiler.h"
+#include "shader.h"
+#include "timer.h"
+
+#define ATTRIB_POSITION 0
+#define ATTRIB_TEX_COORD 1
+#define ATTRIB_COLOR 2
+
+// The atlas is a grid of 16 x 6 cells of 6 x 8 pixels: the glyphs of the
+// printable ASCII characters, in the top left 5 x 7 pixels of their cell,
+// then a cell entirely filled, for the other quads.
+#define GLYPH_WIDTH 5
+#define GLYPH_HEIGHT 7
+#define CELL_WIDTH 6
+#define CELL_HEIGHT 8
+#define ATLAS_COLUMNS 16
+#define ATLAS_ROWS 6
+#define ATLAS_WIDTH (ATLAS_COLUMNS * CELL_WIDTH)
+#define ATLAS_HEIGHT (ATLAS_ROWS * CELL_HEIGHT)
+#define FIRST_GLYPH 32
+#define GLYPH_COUNT 95
+#define SOLID_CELL GLYPH_COUNT
+
+// Size of the frame time graph, in pixels of the font; its top is
+// GRAPH_RANGE milliseconds.
+#define GRAPH_HEIGHT 40
+#define GRAPH_RANGE 50.0f
+
+#define MARGIN 4
+
+// The glyphs of the characters 32 to 126, one byte per row from the top, the
+// leftmost pixel in bit 4.
+static const unsigned char glyphs[GLYPH_COUNT][GLYPH_HEIGHT] = {
+    { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },  // ' '
+    { 0x04, 0x04, 0x04, 0x04, 0x04, 0x00, 0x04 },  // '!'
+    { 0x0a, 0x0a, 0x0a, 0x00, 0x00, 0x00, 0x00 },  // '"'
+    { 0x0a, 0x0a, 0x1f, 0x0a, 0x1f, 0x0a, 0x0a },  // '#'
+    { 0x04, 0x0f, 0x14, 0x0e, 0x05, 0x1e, 0x04 },  // '$'
+    { 0x18, 0x19, 0x02, 0x04, 0x08, 0x13, 0x03 },  // '%'
+    { 0x0c, 0x12, 0x14, 0x08, 0x15, 0x12, 0x0d },  // '&'
+    { 0x04, 0x04, 0x08, 0x00, 0x00, 0x00, 0x00 },  // '\''
+    { 0x02, 0x04, 0x08, 0x08, 0x08, 0x04, 0x02 },  // '('
+    { 0x08, 0x04, 0x02, 0x02, 0x02, 0x04, 0x08 },  // ')'
+    { 0x00, 0x04, 0x15, 0x0e, 0x15, 0x04, 0x00 },  // '*'
+    { 0x00, 0x04, 0x04, 0x1f, 0x04, 0x04, 0x00 },  // '+'
+    { 0x00, 0x00, 0x00, 0x00, 0x0c, 0x04, 0x08 },  // ','
+    { 0x00, 0x00, 0x00, 0x1f, 0x00, 0x00, 0x00 },  // '-'
+    { 0x00, 0x00, 0x00, 0x00, 0x00, 0x0c, 0x0c },  // '.'
+    { 0x00, 0x01, 0x02, 0x04, 0x08, 0x10, 0x00 },  // '/'
+    { 0x0e, 0x11, 0x13, 0x15, 0x19, 0x11, 0x0e },  // '0'
+    { 0x04, 0x0c, 0x04, 0x04, 0x04, 0x04, 0x0e },  // '1'
+    { 0x0e, 0x11, 0x01, 0x02, 0x04, 0x08, 0x1f },  // '2'
+    { 0x1f, 0x02, 0x04, 0x02, 0x01, 0x11, 0x0e },  // '3'
+    { 0x02, 0x06, 0x0a, 0x12, 0x1f, 0x02, 0x02 },  // '4'
+    { 0x1f, 0x10, 0x1e, 0x01, 0x01, 0x11, 0x0e },  // '5'
+    { 0x06, 0x08, 0x10, 0x1e, 0x11, 0x11, 0x0e },  // '6'
+    { 0x1f, 0x01, 0x02, 0x04, 0x08, 0x08, 0x08 },  // '7'
+    { 0x0e, 0x11, 0x11, 0x0e, 0x11, 0x11, 0x0e },  // '8'
+    { 0x0e, 0x11, 0x11, 0x0f, 0x01, 0x02, 0x0c },  // '9'
+    { 0x00, 0x0c, 0x0c, 0x00, 0x0c, 0x0c, 0x00 },  // ':'
+    { 0x00, 0x0c, 0x0c, 0x00, 0x0c, 0x04, 0x08 },  // ';'
+    { 0x02, 0x04, 0x08, 0x10, 0x08, 0x04, 0x02 },  // '<'
+    { 0x00, 0x00, 0x1f, 0x00, 0x1f, 0x00, 0x00 },  // '='
+    { 0x08, 0x04, 0x02, 0x01, 0x02, 0x04, 0x08 },  // '>'
+    { 0x0e, 0x11, 0x01, 0x02, 0x04, 0x00, 0x04 },  // '?'
+    { 0x0e, 0x11, 0x01, 0x0d, 0x15, 0x15, 0x0e },  // '@'
+    { 0x0e, 0x11, 0x11, 0x1f, 0x11, 0x11, 0x11 },  // 'A'
+    { 0x1e, 0x11, 0x11, 0x1e, 0x11, 0x11, 0x1e },  // 'B'
+    { 0x0e, 0x11, 0x10, 0x10, 0x10, 0x11, 0x0e },  // 'C'
+    { 0x1c, 0x12, 0x11, 0x11, 0x11, 0x12, 0x1c },  // 'D'
+    { 0x1f, 0x10, 0x10, 0x1e, 0x10, 0x10, 0x1f },  // 'E'
+    { 0x1f, 0x10, 0x10, 0x1e, 0x10, 0x10, 0x10 },  // 'F'
+    { 0x0e, 0x11, 0x10, 0x17, 0x11, 0x11, 0x0f },  // 'G'
+    { 0x11, 0x11, 0x11, 0x1f, 0x11, 0x11, 0x11 },  // 'H'
+    { 0x0e, 0x04, 0x04, 0x04, 0x04, 0x04, 0x0e },  // 'I'
+    { 0x07, 0x02, 0x02, 0x02, 0x02, 0x12, 0x0c },  // 'J'
+    { 0x11, 0x12, 0x14, 0x18, 0x14, 0x12, 0x11 },  // 'K'
+    { 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x1f },  // 'L'
+    { 0x11, 0x1b, 0x15, 0x15, 0x11, 0x11, 0x11 },  // 'M'
+    { 0x11, 0x11, 0x19, 0x15, 0x13, 0x11, 0x11 },  // 'N'
+    { 0x0e, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0e },  // 'O'
+    { 0x1e, 0x11, 0x11, 0x1e, 0x10, 0x10, 0x10 },  // 'P'
+    { 0x0e, 0x11, 0x11, 0x11, 0x15, 0x12, 0x0d },  // 'Q'
+    { 0x1e, 0x11, 0x11, 0x1e, 0x14, 0x12, 0x11 },  // 'R'
+    { 0x0f, 0x10, 0x10, 0x0e, 0x01, 0x01, 0x1e },  // 'S'
+    { 0x1f, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04 },  // 'T'
+    { 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0e },  // 'U'
+    { 0x11, 0x11, 0x11, 0x11, 0x11, 0x0a, 0x04 },  // 'V'
+    { 0x11, 0x11, 0x11, 0x15, 0x15, 0x15, 0x0a },  // 'W'
+    { 0x11, 0x11, 0x0a, 0x04, 0x0a, 0x11, 0x11 },  // 'X'
+    { 0x11, 0x11, 0x11, 0x0a, 0x04, 0x04, 0x04 },  // 'Y'
+    { 0x1f, 0x01, 0x02, 0x04, 0x08, 0x10, 0x1f },  // 'Z'
+    { 0x0e, 0x08, 0x08, 0x08, 0x08, 0x08, 0x0e },  // '['
+    { 0x00, 0x10, 0x08, 0x04, 0x02, 0x01, 0x00 },  // '\\'
+    { 0x0e, 0x02, 0x02, 0x02, 0x02, 0x02, 0x0e },  // ']'
+    { 0x04, 0x0a, 0x11, 0x00, 0x00, 0x00, 0x00 },  // '^'
+    { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x1f },  // '_'
+    { 0x08, 0x04, 0x02, 0x00, 0x00, 0x00, 0x00 },  // '`'
+    { 0x00, 0x00, 0x0e, 0x01, 0x0f, 0x11, 0x0f },  // 'a'
+    { 0x10, 0x10, 0x16, 0x19, 0x11, 0x11, 0x1e },  // 'b'
+    { 0x00, 0x00, 0x0e, 0x10, 0x10, 0x11, 0x0e },  // 'c'
+    { 0x01, 0x01, 0x0d, 0x13, 0x11, 0x11, 0x0f },  // 'd'
+    { 0x00, 0x00, 0x0e, 0x11, 0x1f, 0x10, 0x0e },  // 'e'
+    { 0x06, 0x09, 0x08, 0x1c, 0x08, 0x08, 0x08 },  // 'f'
+    { 0x00, 0x0f, 0x11, 0x11, 0x0f, 0x01, 0x0e },  // 'g'
+    { 0x10, 0x10, 0x16, 0x19, 0x11, 0x11, 0x11 },  // 'h'
+    { 0x04, 0x00, 0x0c, 0x04, 0x04, 0x04, 0x0e },  // 'i'
+    { 0x02, 0x00, 0x06, 0x02, 0x02, 0x12, 0x0c },  // 'j'
+    { 0x10, 0x10, 0x12, 0x14, 0x18, 0x14, 0x12 },  // 'k'
+    { 0x0c, 0x04, 0x04, 0x04, 0x04, 0x04, 0x0e },  // 'l'
+    { 0x00, 0x00, 0x1a, 0x15, 0x15, 0x11, 0x11 },  // 'm'
+    { 0x00, 0x00, 0x16, 0x19, 0x11, 0x11, 0x11 },  // 'n'
+    { 0x00, 0x00, 0x0e, 0x11, 0x11, 0x11, 0x0e },  // 'o'
+    { 0x00, 0x00, 0x1e, 0x11, 0x1e, 0x10, 0x10 },  // 'p'
+    { 0x00, 0x00, 0x0d, 0x13, 0x0f, 0x01, 0x01 },  // 'q'
+    { 0x00, 0x00, 0x16, 0x19, 0x10, 0x10, 0x10 },  // 'r'
+    { 0x00, 0x00, 0x0e, 0x10, 0x0e, 0x01, 0x1e },  // 's'
+    { 0x08, 0x08, 0x1c, 0x08, 0x08, 0x09, 0x06 },  // 't'
+    { 0x00, 0x00, 0x11, 0x11, 0x11, 0x13, 0x0d },  // 'u'
+    { 0x00, 0x00, 0x11, 0x11, 0x11, 0x0a, 0x04 },  // 'v'
+    { 0x00, 0x00, 0x11, 0x11, 0x15, 0x15, 0x0a },  // 'w'
+    { 0x00, 0x00, 0x11, 0x0a, 0x04, 0x0a, 0x11 },  // 'x'
+    { 0x00, 0x00, 0x11, 0x11, 0x0f, 0x01, 0x0e },  // 'y'
+    { 0x00, 0x00, 0x1f, 0x02, 0x04, 0x08, 0x1f },  // 'z'
+    { 0x02, 0x04, 0x04, 0x08, 0x04, 0x04, 0x02 },  // '{'
+    { 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04 },  // '|'
+    { 0x08, 0x04, 0x04, 0x02, 0x04, 0x04, 0x08 },  // '}'
+    { 0x00, 0x00, 0x08, 0x15, 0x02, 0x00, 0x00 },  // '~'
+};
+
+static const char* vertexSource =
+    "ATTRIBUTE vec2 vertPosition;\n"
+    "ATTRIBUTE vec2 vertTexCoord;\n"
+    "ATTRIBUTE vec4 vertColor;\n"
+    "VARYING_OUT vec2 fragTexCoord;\n"
+    "VARYING_OUT vec4 fragColor;\n"
+    "uniform vec2 screenSize;\n"
+    "void main() {\n"
+    "    fragTexCoord = vertTexCoord;\n"
+    "    fragColor = vertColor;\n"
+    "    vec2 position = vertPosition / screenSize * 2.0 - 1.0;\n"
+    "    gl_Position = vec4(position.x, -position.y, 0.0, 1.0);\n"
+    "}\n";
+
+static const char* fragmentSource =
+    "VARYING_IN vec2 fragTexCoord;\n"
+    "VARYING_IN vec4 fragColor;\n"
+    "uniform sampler2D atlas;\n"
+    "void main() {\n"
+    "    FRAG_COLOR = fragColor * texture(atlas, fragTexCoord);\n"
+    "}\n";
+
+static const char* attributes[] = { "vertPosition", "vertTexCoord", "vertColor", NULL };
+
+static const unsigned char white[4] = { 255, 255, 255, 255 };
+static const unsigned char gray[4] = { 170, 170, 170, 255 };
+static const unsigned char panel[4] = { 0, 0, 0, 160 };
+static const unsigned char green[4] = { 80, 220, 90, 255 };
+static const unsigned char yellow[4] = { 240, 200, 60, 255 };
+static const unsigned char red[4] = { 240, 70, 60, 255 };
+static const unsigned char guide[4] = { 255, 255, 255, 70 };
+
+static GLuint createAtlas(void) {
+    static unsigned char pixels[ATLAS_HEIGHT][ATLAS_WIDTH][4];
+    memset(pixels, 0, sizeof(pixels));
+    for (int cell = 0; cell <= GLYPH_COUNT; cell++) {
+        int left = (cell % ATLAS_COLUMNS) * CELL_WIDTH;
+        int top = (cell / ATLAS_COLUMNS) * CELL_HEIGHT;
+        for (int y = 0; y < CELL_HEIGHT; y++) {
+            for (int x = 0; x < CELL_WIDTH; x++) {
+                int set = cell == SOLID_CELL ||
+                    (x < GLYPH_WIDTH && y < GLYPH_HEIGHT && (glyphs[cell][y] >> (GLYPH_WIDTH - 1 - x)) & 1);
+                unsigned char* pixel = pixels[top + y][left + x];
+                pixel[0] = 255;
+                pixel[1] = 255;
+                pixel[2] = 255;
+                pixel[3] = set ? 255 : 0;
+            }
+        }
+    }
+
+    GLuint texture;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    GL_CHECK(glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, ATLAS_WIDTH, ATLAS_HEIGHT, 0, GL_RGBA, GL_UNSIGNED_BYTE,
+        pixels));
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    gpu_memory_track(GPU_MEMORY_TEXTURE, texture,
+        gpu_memory_texture_size(GL_RGBA, GL_UNSIGNED_BYTE, ATLAS_WIDTH, ATLAS_HEIGHT, 1, 1));
+    gl_debug_label(GL_TEXTURE, texture, "HUD font");
+    return texture;
+}
+
+static void setupArrays(hud* hud) {
+    glBindBuffer(GL_ARRAY_BUFFER, hud->buffer);
+    glVertexAttribPointer(ATTRIB_POSITION, 2, GL_FLOAT, GL_FALSE, sizeof(hud_vertex),
+        (void*)offsetof(hud_vertex, position));
+    glVertexAttribPointer(ATTRIB_TEX_COORD, 2, GL_FLOAT, GL_FALSE, sizeof(hud_vertex),
+        (void*)offsetof(hud_vertex, texCoord));
+    glVertexAttribPointer(ATTRIB_COLOR, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(hud_vertex),
+        (void*)offsetof(hud_vertex, color));
+    glEnableVertexAttribArray(ATTRIB_POSITION);
+    glEnableVertexAttribArray(ATTRIB_TEX_COORD);
+    glEnableVertexAttribArray(ATTRIB_COLOR);
+}
+
+int hud_init(hud* hud, int width, int height) {
+    memset(hud, 0, sizeof(*hud));
+    hud->width = width;
+    hud->height = height;
+    hud->scale = height >= 720 ? 2 : 1;
+
+    shader_program program = {
+        .label = "HUD program",
+        .vertex = vertexSource,
+        .fragment = fragmentSource,
+        .attributes = attributes
+    };
+    hud->program = shader_build(&program);
+    if (!hud->program) {
+        return -1;
+    }
+    hud->screenSizeLocation = glGetUniformLocation(hud->program, "screenSize");
+    glUseProgram(hud->program);
+    glUniform1i(glGetUniformLocation(hud->program, "atlas"), 0);
+    glUseProgram(0);
+
+    hud->texture = createAtlas();
+
+    size_t size = sizeof(hud->vertices);
+    glGenBuffers(1, &hud->buffer);
+    glBindBuffer(GL_ARRAY_BUFFER, hud->buffer);
+    GL_CHECK(glBufferData(GL_ARRAY_BUFFER, size, NULL, GL_STREAM_DRAW));
+    gpu_memory_track(GPU_MEMORY_BUFFER, hud->buffer, size);
+    gl_debug_label(GL_BUFFER, hud->buffer, "HUD vertices");
+
+    #if SAMPLE_OPENGL_API == SAMPLE_API_GL || SAMPLE_OPENGL_VERSION_MAJOR >= 3
+        glGenVertexArrays(1, &hud->vao);
+        glBindVertexArray(hud->vao);
+        setupArrays(hud);
+        glBindVertexArray(0);
+    #endif
+    return 0;
+}
+
+void hud_destroy(hud* hud) {
+    gpu_memory_untrack(GPU_MEMORY_TEXTURE, hud->texture);
+    gpu_memory_untrack(GPU_MEMORY_BUFFER, hud->buffer);
+    glDeleteTextures(1, &hud->texture);
+    glDeleteBuffers(1, &hud->buffer);
+    #if SAMPLE_OPENGL_API == SAMPLE_API_GL || SAMPLE_OPENGL_VERSION_MAJOR >= 3
+        glDeleteVertexArrays(1, &hud->vao);
+    #endif
+    glDeleteProgram(hud->program);
+}
+
+void hud_printf(hud* hud, const char* format, ...) {
+    if (hud->lineCount == HUD_MAX_LINES) {
+        return;
+    }
+    va_list arguments;
+    va_start(arguments, format);
+    vsnprintf(hud->lines[hud->lineCount++], HUD_LINE_LENGTH, format, arguments);
+    va_end(arguments);
+}
+
+// Append a quad covering a cell of the atlas (in pixels of the screen).
+static void addQuad(hud* hud, float x0, float y0, float x1, float y1, int cell, const unsigned char color[4]) {
+    if (hud->vertexCount + 6 > HUD_MAX_QUADS * 6) {
+        return;
+    }
+
+    // The filled cell is sampled at its center only.
+    float u0, v0, u1, v1;
+    float left = (float)((cell % ATLAS_COLUMNS) * CELL_WIDTH);
+    float top = (float)((cell / ATLAS_COLUMNS) * CELL_HEIGHT);
+    if (cell == SOLID_CELL) {
+        u0 = u1 = (left + CELL_WIDTH * 0.5f) / ATLAS_WIDTH;
+        v0 = v1 = (top + CELL_HEIGHT * 0.5f) / ATLAS_HEIGHT;
+    } else {
+        u0 = left / ATLAS_WIDTH;
+        v0 = top / ATLAS_HEIGHT;
+        u1 = (left + CELL_WIDTH) / ATLAS_WIDTH;
+        v1 = (top + CELL_HEIGHT) / ATLAS_HEIGHT;
+    }
+
+    const float corners[6][4] = {
+        { x0, y0, u0, v0 }, { x0, y1, u0, v1 }, { x1, y1, u1, v1 },
+        { x0, y0, u0, v0 }, { x1, y1, u1, v1 }, { x1, y0, u1, v0 }
+    };
+    for (int i = 0; i < 6; i++) {
+        hud_vertex* vertex = &hud->vertices[hud->vertexCount++];
+        vertex->position[0] = corners[i][0];
+        vertex->position[1] = corners[i][1];
+        vertex->texCoord[0] = corners[i][2];
+        vertex->texCoord[1] = corners[i][3];
+        memcpy(vertex->color, color, 4);
+    }
+}
+
+static void addRectangle(hud* hud, float x, float y, float width, float height, const unsigned char color[4]) {
+    addQuad(hud, x, y, x + width, y + height, SOLID_CELL, color);
+}
+
+// Append a line of text at (x, y), in pixels of the font from the top left
+// corner of the panel. Returns its width.
+static int addText(hud* hud, int x, int y, const char* text, const unsigned char color[4]) {
+    int s = hud->scale;
+    int column = 0;
+    for (const char* c = text; *c; c++, column++) {
+        int glyph = (unsigned char)*c - FIRST_GLYPH;
+        if (glyph <= 0 || glyph >= GLYPH_COUNT) {
+            continue;  // Spaces, and what the font does not have.
+        }
+        float left = (float)((x + column * CELL_WIDTH) * s);
+        float top = (float)(y * s);
+        addQuad(hud, left, top, left + (float)(CELL_WIDTH * s), top + (float)(CELL_HEIGHT * s), glyph, color);
+    }
+    return column * CELL_WIDTH;
+}
+
+void hud_draw(hud* hud, double frameSeconds, int drawCalls) {
+    PROFILE_ZONE_BEGIN("hud");
+    double start = timer_now();
+    int s = hud->scale;
+
+    hud->history[hud->historyCursor] = (float)(frameSeconds * 1000.0);
+    hud->historyCursor = (hud->historyCursor + 1) % HUD_HISTORY;
+    if (hud->historyCount < HUD_HISTORY) {
+        hud->historyCount++;
+    }
+    float average = 0.0f;
+    float worst = 0.0f;
+    for (int i = 0; i < hud->historyCount; i++) {
+        average += hud->history[i];
+        worst = hud->history[i] > worst ? hud->history[i] : worst;
+    }
+    average /= (float)hud->historyCount;
+
+    char text[5][HUD_LINE_LENGTH];
+    snprintf(text[0], HUD_LINE_LENGTH, "%.1f FPS  %.2f ms (worst %.2f ms)",
+        average > 0.0f ? 1000.0f / average : 0.0f, average, worst);
+    snprintf(text[1], HUD_LINE_LENGTH, "Draw calls: %d", drawCalls);
+    snprintf(text[2], HUD_LINE_LENGTH, "GPU memory: %.1f MiB (peak %.1f MiB)",
+        (double)gpu_memory_total_current() / (1024.0 * 1024.0), (double)gpu_memory_total_peak() / (1024.0 * 1024.0));
+    snprintf(text[3], HUD_LINE_LENGTH, "HUD: %.3f ms", hud->costSeconds * 1000.0);
+
+    // The panel comes first so everything else is blended over it; its size
+    // is known once the text is laid out, so its quad is filled in last.
+    hud->vertexCount = 0;
+    addRectangle(hud, 0.0f, 0.0f, 0.0f, 0.0f, panel);
+
+    int lineHeight = CELL_HEIGHT + 1;
+    int width = HUD_HISTORY * 2;
+    int y = MARGIN;
+    for (int i = 0; i < 4; i++, y += lineHeight) {
+        int lineWidth = addText(hud, MARGIN, y, text[i], i == 0 ? white : gray);
+        width = lineWidth > width ? lineWidth : width;
+    }
+
+    // A bar per frame, the oldest on the left, with guides at 60 and 30
+    // frames per second.
+    y += 2;
+    float bottom = (float)((y + GRAPH_HEIGHT) * s);
+    addRectangle(hud, (float)(MARGIN * s), bottom - 16.7f / GRAPH_RANGE * (float)(GRAPH_HEIGHT * s),
+        (float)(HUD_HISTORY * 2 * s), (float)s, guide);
+    addRectangle(hud, (float)(MARGIN * s), bottom - 33.3f / GRAPH_RANGE * (float)(GRAPH_HEIGHT * s),
+        (float)(HUD_HISTORY * 2 * s), (float)s, guide);
+    for (int i = 0; i < hud->historyCount; i++) {
+        int index = (hud->historyCursor - hud->historyCount + i + HUD_HISTORY) % HUD_HISTORY;
+        float milliseconds = hud->history[index];
+        float height = milliseconds / GRAPH_RANGE;
+        height = (height > 1.0f ? 1.0f : height) * (float)(GRAPH_HEIGHT * s);
+        const unsigned char* color = milliseconds <= 16.7f ? green : milliseconds <= 33.3f ? yellow : red;
+        addRectangle(hud, (float)((MARGIN + (HUD_HISTORY - hud->historyCount + i) * 2) * s), bottom - height,
+            (float)s, height, color);
+    }
+    y += GRAPH_HEIGHT + 3;
+
+    for (int i = 0; i < hud->lineCount; i++, y += lineHeight) {
+        int lineWidth = addText(hud, MARGIN, y, hud->lines[i], white);
+        width = lineWidth > width ? lineWidth : width;
+    }
+    hud->lineCount = 0;
+
+    int count = hud->vertexCount;
+    hud->vertexCount = 0;
+    addRectangle(hud, 0.0f, 0.0f, (float)((width + MARGIN * 2) * s), (float)((y + MARGIN - 1) * s), panel);
+    hud->vertexCount = count;
+
+    PROFILE_GPU_ZONE_BEGIN("hud");
+    gl_debug_push_group("HUD");
+    GLboolean depthTest = glIsEnabled(GL_DEPTH_TEST);
+    GLboolean cullFace = glIsEnabled(GL_CULL_FACE);
+    GLboolean blend = glIsEnabled(GL_BLEND);
+    glDisable(GL_DEPTH_TEST);
+    glDisable(GL_CULL_FACE);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+    glUseProgram(hud->program);
+    glUniform2f(hud->screenSizeLocation, (float)hud->width, (float)hud->height);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, hud->texture);
+    glBindBuffer(GL_ARRAY_BUFFER, hud->buffer);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(hud->vertices), NULL, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, (GLsizeiptr)hud->vertexCount * sizeof(hud_vertex), hud->vertices);
+    #if SAMPLE_OPENGL_API == SAMPLE_API_GL || SAMPLE_OPENGL_VERSION_MAJOR >= 3
+        glBindVertexArray(hud->vao);
+        glDrawArrays(GL_TRIANGLES, 0, hud->vertexCount);
+        glBindVertexArray(0);
+    #else
+        setupArrays(hud);
+        glDrawArrays(GL_TRIANGLES, 0, hud->vertexCount);
+    #endif
+
+    if (depthTest) {
+        glEnable(GL_DEPTH_TEST);
+    }
+    if (cullFace) {
+        glEnable(GL_CULL_FACE);
+    }
+    if (!blend) {
+        glDisable(GL_BLEND);
+    }
+    gl_debug_pop_group();
+    PROFILE_GPU_ZONE_END();
+
+    hud->costSeconds = timer_now() - start;
+    hud->totalCostSeconds += hud->costSeconds;
+    hud->frames++;
+    PROFILE_ZONE_END();
+}
+
+double hud_average_cost(const hud* hud) {
+    return hud->frames > 0 ? hud->totalCostSeconds * 1000.0 / (double)hud->frames : 0.0;
+}
@@ -0,0 +1,83 @@
+//
+// Copyright (c) 2025, Byteplug LLC.
+//
+// This source file is part of a project made by the Erlangsters community and
+// is released under the MIT license. Please refer to the LICENSE.md file that
+// can be found at the root of the project repository.
+//
+// Written by Jonathan De Wachter <jonathan.dewachter@byteplug.io>
+//
+#ifndef HUD_H
+#define HUD_H
+
+#include "gl_api.h"
+
+// On-screen overlay of the frame statistics: the frame rate, a graph of the
+// last HUD_HISTORY frame times, the draw calls, the GPU memory tracked by
+// gpu_memory.h and the time the overlay itself takes, followed by the lines
+// added by the sample with hud_printf().
+//
+// The text is drawn from a 5x7 pixel font baked into an atlas at
+// initialization. Every glyph and every bar of the graph is a quad written to
+// a single streaming vertex buffer, drawn with a single draw call per frame.
+//
+// hud_draw() changes the program, the texture bound to unit 0, the array
+// buffer and the vertex array (the attribute arrays 0 to 2 on OpenGL ES 2.0)
+// and the blend function; the depth test, culling and blending are restored.
+#define HUD_HISTORY 120
+#define HUD_MAX_QUADS 1024
+#define HUD_MAX_LINES 8
+#define HUD_LINE_LENGTH 64
+
+typedef struct {
+    float position[2];  // In pixels, from the top left corner.
+    float texCoord[2];
+    unsigned char color[4];
+} hud_vertex;
+
+typedef struct {
+    int width;  // Of the framebuffer.
+    int height;
+    int scale;  // Pixels of the screen per pixel of the font.
+
+    GLuint program;
+    GLint screenSizeLocation;
+    GLuint texture;
+    GLuint buffer;
+    #if SAMPLE_OPENGL_API == SAMPLE_API_GL || SAMPLE_OPENGL_VERSION_MAJOR >= 3
+        GLuint vao;
+    #endif
+
+    hud_vertex vertices[HUD_MAX_QUADS * 6];
+    int vertexCount;
+
+    float history[HUD_HISTORY];  // Frame times in milliseconds, a ring.
+    int historyCursor;
+    int historyCount;
+
+    char lines[HUD_MAX_LINES][HUD_LINE_LENGTH];
+    int lineCount;
+
+    // Time spent building and submitting the overlay on the CPU.
+    double costSeconds;
+    double totalCostSeconds;
+    long long frames;
+} hud;
+
+// Create the overlay for a framebuffer of width x height pixels. Returns -1
+// when its program cannot be built.
+int hud_init(hud* hud, int width, int height);
+void hud_destroy(hud* hud);
+
+// Add a line of text below the statistics, for the next hud_draw() only.
+void hud_printf(hud* hud, const char* format, ...);
+
+// Record the duration of the frame (the time since the previous one) and
+// draw the overlay, with the number of draw calls of the frame (the one of
+// the overlay excluded).
+void hud_draw(hud* hud, double frameSeconds, int drawCalls);
+
+// Average time spent in hud_draw() on the CPU, in milliseconds.
+double hud_average_cost(const hud* hud);
+
+#endif // HUD_H
@@ -0,0 +1,387 @@
+//
+// Copyright (c) 2025, Byteplug LLC.
+//
+// This source file is part of a project made by the Erlangsters community and
+// is released under the MIT license. Please refer to the LICENSE.md file that
+// can be found at the root of the project repository.
+//
+// Written by Jonathan De Wachter <jonathan.dewachter@byteplug.io>
+//
+#include "job.h"
+#include <stdlib.h>
+#include "profiler.h"
+#include "thread.h"
+
+// Number of rounds a worker spends looking for jobs (yielding in between)
+// before it goes to sleep.
+#define SPIN_ROUNDS 64
+
+#define CACHE_LINE_SIZE 64
+
+struct job {
+    job_func func;
+    job_range_func rangeFunc;
+    void* arg;
+    size_t begin;
+    size_t end;
+    size_t grain;
+    job_counter* counter;
+    job* next;  // In the continuations of a counter.
+};
+
+// The deque of a thread (see "Correct and Efficient Work-Stealing for Weak
+// Memory Models", Lê et al.), with a fixed capacity, and the ring its jobs
+// are allocated from. The owner pushes and takes at the bottom, thieves
+// steal at the top; both ends are on their own cache line.
+typedef struct {
+    atomic_llong top;
+    char padding0[CACHE_LINE_SIZE - sizeof(atomic_llong)];
+    atomic_llong bottom;
+    char padding1[CACHE_LINE_SIZE - sizeof(atomic_llong)];
+    _Atomic(job*) jobs[JOB_MAX_PENDING];
+
+    job pool[JOB_MAX_PENDING];
+    unsigned int poolNext;
+    unsigned int random;  // State of the victim selection.
+} job_queue;
+
+typedef struct {
+    job_system* system;
+    int index;
+} job_worker;
+
+struct job_system {
+    int threadCount;
+    job_queue* queues;
+    thread_t threads[JOB_MAX_THREADS];
+    job_worker workers[JOB_MAX_THREADS];
+
+    // Workers sleep on the condition variable while nothing is queued.
+    atomic_int queued;
+    atomic_int sleeping;
+    atomic_int quit;
+    mutex_t mutex;
+    cond_t wake;
+
+    // Guards the continuations of the counters.
+    mutex_t continuationMutex;
+};
+
+static _Thread_local int threadIndex;
+
+static void execute(job_system* system, job* j);
+
+static job* allocate(job_system* system) {
+    job_queue* queue = &system->queues[threadIndex];
+    job* j = &queue->pool[queue->poolNext++ & (JOB_MAX_PENDING - 1)];
+    j->func = NULL;
+    j->rangeFunc = NULL;
+    j->next = NULL;
+    return j;
+}
+
+static void push(job_system* system, job* j) {
+    job_queue* queue = &system->queues[threadIndex];
+    long long bottom = atomic_load_explicit(&queue->bottom, memory_order_relaxed);
+    long long top = atomic_load_explicit(&queue->top, memory_order_acquire);
+    if (bottom - top >= JOB_MAX_PENDING) {
+        // The deque is full; run the job right away instead.
+        execute(system, j);
+        return;
+    }
+    atomic_store_explicit(&queue->jobs[bottom & (JOB_MAX_PENDING - 1)], j, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    atomic_store_explicit(&queue->bottom, bottom + 1, memory_order_relaxed);
+
+    atomic_fetch_add(&system->queued, 1);
+    if (atomic_load(&system->sleeping) > 0) {
+        mutex_lock(&system->mutex);
+        cond_signal(&system->wake);
+        mutex_unlock(&system->mutex);
+    }
+}
+
+static job* take(job_queue* queue) {
+    long long bottom = atomic_load_explicit(&queue->bottom, memory_order_relaxed) - 1;
+    atomic_store_explicit(&queue->bottom, bottom, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    long long top = atomic_load_explicit(&queue->top, memory_order_relaxed);
+
+    job* j = NULL;
+    if (top <= bottom) {
+        j = atomic_load_explicit(&queue->jobs[bottom & (JOB_MAX_PENDING - 1)], memory_order_relaxed);
+        if (top == bottom) {
+            // Last job; race the thieves for it.
+            if (!atomic_compare_exchange_strong_explicit(&queue->top, &top, top + 1,
+                    memory_order_seq_cst, memory_order_relaxed)) {
+                j = NULL;
+            }
+            atomic_store_explicit(&queue->bottom, bottom + 1, memory_order_relaxed);
+        }
+    } else {
+        atomic_store_explicit(&queue->bottom, bottom + 1, memory_order_relaxed);
+    }
+    return j;
+}
+
+static job* steal(job_queue* queue) {
+    long long top = atomic_load_explicit(&queue->top, memory_order_acquire);
+    atomic_thread_fence(memory_order_seq_cst);
+    long long bottom = atomic_load_explicit(&queue->bottom, memory_order_acquire);
+    if (top >= bottom) {
+        return NULL;
+    }
+
+    job* j = atomic_load_explicit(&queue->jobs[top & (JOB_MAX_PENDING - 1)], memory_order_relaxed);
+    if (!atomic_compare_exchange_strong_explicit(&queue->top, &top, top + 1,
+            memory_order_seq_cst, memory_order_relaxed)) {
+        return NULL;
+    }
+    return j;
+}
+
+// Take a job from the deque of the calling thread, or steal one from the
+// others, starting with a random one.
+static job* find(job_system* system) {
+    job_queue* queue = &system->queues[threadIndex];
+    job* j = take(queue);
+    if (!j && system->threadCount > 1) {
+        queue->random = queue->random * 1664525u + 1013904223u;
+        int victim = (int)((queue->random >> 16) % (unsigned int)system->threadCount);
+        for (int i = 0; i < system->threadCount && !j; i++) {
+            int index = (victim + i) % system->threadCount;
+            if (index != threadIndex) {
+                j = steal(&system->queues[index]);
+            }
+        }
+    }
+    if (j) {
+        atomic_fetch_sub(&system->queued, 1);
+    }
+    return j;
+}
+
+static void finish(job_system* system, job_counter* counter) {
+    if (!counter || atomic_fetch_sub(&counter->value, 1) != 1) {
+        return;
+    }
+
+    mutex_lock(&system->continuationMutex);
+    job* continuations = counter->continuations;
+    counter->continuations = NULL;
+    mutex_unlock(&system->continuationMutex);
+
+    while (continuations) {
+        job* next = continuations->next;
+        push(system, continuations);
+        continuations = next;
+    }
+}
+
+static void execute(job_system* system, job* j) {
+    // The slot of the job is only reused once its ring wraps around, but the
+    // job is copied anyway so that it does not matter.
+    job copy = *j;
+    if (copy.rangeFunc) {
+        // Hand the upper halves to the deque (and the thieves), and keep
+        // splitting the lower half.
+        while (copy.end - copy.begin > copy.grain) {
+            size_t middle = copy.begin + (copy.end - copy.begin) / 2;
+            job* half = allocate(system);
+            *half = copy;
+            half->begin = middle;
+            half->next = NULL;
+            if (copy.counter) {
+                atomic_fetch_add(&copy.counter->value, 1);
+            }
+            push(system, half);
+            copy.end = middle;
+        }
+        copy.rangeFunc(copy.arg, copy.begin, copy.end);
+    } else {
+        copy.func(copy.arg);
+    }
+    finish(system, copy.counter);
+}
+
+static void workerMain(void* arg) {
+    job_worker* worker = arg;
+    job_system* system = worker->system;
+    threadIndex = worker->index;
+    PROFILE_THREAD_NAME("job worker");
+
+    int rounds = 0;
+    while (!atomic_load(&system->quit)) {
+        job* j = find(system);
+        if (j) {
+            execute(system, j);
+            rounds = 0;
+            continue;
+        }
+        if (++rounds < SPIN_ROUNDS) {
+            thread_yield();
+            continue;
+        }
+
+        // A job pushed after sleeping was incremented is signaled, and one
+        // pushed before is seen in queued, so no wake up is missed.
+        mutex_lock(&system->mutex);
+        atomic_fetch_add(&system->sleeping, 1);
+        while (atomic_load(&system->queued) <= 0 && !atomic_load(&system->quit)) {
+            cond_wait(&system->wake, &system->mutex);
+        }
+        atomic_fetch_sub(&system->sleeping, 1);
+        mutex_unlock(&system->mutex);
+        rounds = 0;
+    }
+}
+
+// Stop and join the workers [1, workerEnd).
+static void stopWorkers(job_system* system, int workerEnd) {
+    mutex_lock(&system->mutex);
+    atomic_store(&system->quit, 1);
+    cond_broadcast(&system->wake);
+    mutex_unlock(&system->mutex);
+
+    for (int i = 1; i < workerEnd; i++) {
+        thread_join(system->threads[i]);
+    }
+}
+
+static void freeSystem(job_system* system) {
+    mutex_destroy(&system->continuationMutex);
+    cond_destroy(&system->wake);
+    mutex_destroy(&system->mutex);
+    free(system->queues);
+    free(system);
+}
+
+job_system* job_system_create(int threadCount) {
+    if (threadCount < 1) {
+        threadCount = 1;
+    }
+    if (threadCount > JOB_MAX_THREADS) {
+        threadCount = JOB_MAX_THREADS;
+    }
+
+    job_system* system = calloc(1, sizeof(job_system));
+    if (!system) {
+        return NULL;
+    }
+    system->queues = calloc((size_t)threadCount, sizeof(job_queue));
+    if (!system->queues) {
+        free(system);
+        return NULL;
+    }
+    for (int i = 0; i < threadCount; i++) {
+        system->queues[i].random = (unsigned int)i * 2654435761u + 1u;
+    }
+    mutex_init(&system->mutex);
+    cond_init(&system->wake);
+    mutex_init(&system->continuationMutex);
+
+    // The workers read the number of threads to pick their victims, so it is
+    // set before they start.
+    threadIndex = 0;
+    system->threadCount = threadCount;
+    for (int i = 1; i < threadCount; i++) {
+        system->workers[i].system = system;
+        system->workers[i].index = i;
+        if (thread_create(&system->threads[i], workerMain, &system->workers[i]) != 0) {
+            stopWorkers(system, i);
+            freeSystem(system);
+            return NULL;
+        }
+    }
+
+    return system;
+}
+
+void job_system_destroy(job_system* system) {
+    stopWorkers(system, system->threadCount);
+    freeSystem(system);
+}
+
+int job_system_thread_count(const job_system* system) {
+    return system->threadCount;
+}
+
+int job_thread_index(void) {
+    return threadIndex;
+}
+
+void job_counter_init(job_counter* counter) {
+    atomic_init(&counter->value, 0);
+    counter->continuations = NULL;
+}
+
+void job_run(job_system* system, job_func func, void* arg, job_counter* counter) {
+    job* j = allocate(system);
+    j->func = func;
+    j->arg = arg;
+    j->counter = counter;
+    if (counter) {
+        atomic_fetch_add(&counter->value, 1);
+    }
+    push(system, j);
+}
+
+void job_run_after(job_system* system, job_func func, void* arg, job_counter* dependency, job_counter* counter) {
+    job* j = allocate(system);
+    j->func = func;
+    j->arg = arg;
+    j->counter = counter;
+    if (counter) {
+        atomic_fetch_add(&counter->value, 1);
+    }
+
+    // The dependency reaching zero takes its continuations under the lock,
+    // so the job is either seen there or the dependency is seen at zero.
+    mutex_lock(&system->continuationMutex);
+    if (atomic_load(&dependency->value) > 0) {
+        j->next = dependency->continuations;
+        dependency->continuations = j;
+        j = NULL;
+    }
+    mutex_unlock(&system->continuationMutex);
+
+    if (j) {
+        push(system, j);
+    }
+}
+
+void job_parallel_for(job_system* system, size_t count, size_t grain, job_range_func func, void* arg,
+                      job_counter* counter) {
+    if (count == 0) {
+        return;
+    }
+    if (grain == 0) {
+        grain = count / ((size_t)system->threadCount * 8);
+        if (grain == 0) {
+            grain = 1;
+        }
+    }
+
+    job* j = allocate(system);
+    j->rangeFunc = func;
+    j->arg = arg;
+    j->begin = 0;
+    j->end = count;
+    j->grain = grain;
+    j->counter = counter;
+    if (counter) {
+        atomic_fetch_add(&counter->value, 1);
+    }
+    push(system, j);
+}
+
+void job_wait(job_system* system, job_counter* counter) {
+    while (atomic_load(&counter->value) > 0) {
+        job* j = find(system);
+        if (j) {
+            execute(system, j);
+        } else {
+            thread_yield();
+        }
+    }
+}
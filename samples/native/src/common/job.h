@@ -0,0 +1,76 @@
+//
+// Copyright (c) 2025, Byteplug LLC.
+//
+// This source file is part of a project made by the Erlangsters community and
+// is released under the MIT license. Please refer to the LICENSE.md file that
+// can be found at the root of the project repository.
+//
+// Written by Jonathan De Wachter <jonathan.dewachter@byteplug.io>
+//
+#ifndef JOB_H
+#define JOB_H
+
+#include <stdatomic.h>
+#include <stddef.h>
+
+// Small work-stealing job system for the per-frame CPU work of the samples.
+//
+// Every thread of the system (the thread that created it, and the workers it
+// started) owns a Chase-Lev deque: it pushes and pops jobs at the bottom of
+// its own deque without locks, while idle threads steal from the top of the
+// others'. Workers that find nothing to steal go to sleep until new jobs are
+// pushed.
+//
+// Completion is tracked with counters: running a job increments its counter
+// and finishing it decrements it, so a counter reaches zero when all of its
+// jobs are done. job_wait() runs other jobs while it waits, and
+// job_run_after() holds a job back until a counter reaches zero, which is how
+// the stages of a frame are chained.
+//
+// Jobs can only be run from the threads of the system (the creating thread,
+// or from within jobs). Each thread has a ring of JOB_MAX_PENDING jobs; having
+// more jobs in flight from one thread than that is not supported.
+#define JOB_MAX_THREADS 64
+#define JOB_MAX_PENDING 4096
+
+typedef struct job job;
+typedef struct job_system job_system;
+
+typedef void (*job_func)(void* arg);
+typedef void (*job_range_func)(void* arg, size_t begin, size_t end);
+
+typedef struct {
+    atomic_int value;
+    job* continuations;  // Jobs waiting for the counter to reach zero.
+} job_counter;
+
+// Create a system of threadCount threads, the calling thread included (so
+// threadCount - 1 workers are started). Returns NULL when the memory or the
+// threads cannot be allocated.
+job_system* job_system_create(int threadCount);
+void job_system_destroy(job_system* system);
+int job_system_thread_count(const job_system* system);
+
+// Index of the calling thread in the system (0 for the thread that created
+// it), to index per-thread data from within jobs.
+int job_thread_index(void);
+
+void job_counter_init(job_counter* counter);
+
+// Run func(arg) as a job. The counter may be NULL.
+void job_run(job_system* system, job_func func, void* arg, job_counter* counter);
+
+// Run func(arg) as a job once dependency reaches zero (right away if it
+// already has). The counter is incremented immediately.
+void job_run_after(job_system* system, job_func func, void* arg, job_counter* dependency, job_counter* counter);
+
+// Run func(arg, begin, end) over the sub-ranges of [0, count), no larger
+// than grain (0 picks one from the number of threads). The range is split in
+// halves recursively, so thieves steal large ranges first.
+void job_parallel_for(job_system* system, size_t count, size_t grain, job_range_func func, void* arg,
+                      job_counter* counter);
+
+// Run jobs until the counter reaches zero.
+void job_wait(job_system* system, job_counter* counter);
+
+#endif // JOB_H
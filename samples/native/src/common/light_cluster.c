@@ -0,0 +1,245 @@
+//
+// Copyright (c) 2025, Byteplug LLC.
+//
+// This source file is part of a project made by the Erlangsters community and
+// is released under the MIT license. Please refer to the LICENSE.md file that
+// can be found at the root of the project repository.
+//
+// Written by Jonathan De Wachter <jonathan.dewachter@byteplug.io>
+//
+#include "light_cluster.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define LIGHT_CLUSTER_SSE2
+    #include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+    #define LIGHT_CLUSTER_NEON
+    #include <arm_neon.h>
+#endif
+
+// The clusters are tested 4 at a time along a row of tiles; the last loads
+// of the last row read past the end of the bounds.
+#define BOUNDS_PADDING 3
+
+enum { MIN_X, MIN_Y, MIN_Z, MAX_X, MAX_Y, MAX_Z };
+
+static inline const float* boundsOf(const light_cluster_grid* grid, int axis) {
+    return &grid->bounds[(size_t)axis * (size_t)(light_cluster_count(grid) + BOUNDS_PADDING)];
+}
+
+static int sliceOf(const light_cluster_grid* grid, float depth) {
+    int slice = (int)floorf(logf(depth / grid->near) * grid->sliceScale);
+    return slice < 0 ? 0 : slice >= grid->slices ? grid->slices - 1 : slice;
+}
+
+static int tileOf(float ndc, int tiles) {
+    int tile = (int)floorf((ndc + 1.0f) * 0.5f * (float)tiles);
+    return tile < 0 ? 0 : tile >= tiles ? tiles - 1 : tile;
+}
+
+int light_cluster_init(light_cluster_grid* grid, int tilesX, int tilesY, int slices,
+                       float fovy, float aspect, float near, float far) {
+    memset(grid, 0, sizeof(light_cluster_grid));
+    grid->tilesX = tilesX;
+    grid->tilesY = tilesY;
+    grid->slices = slices;
+    grid->near = near;
+    grid->far = far;
+    grid->tanHalfY = tanf(fovy * 0.5f);
+    grid->tanHalfX = grid->tanHalfY * aspect;
+    grid->sliceScale = (float)slices / logf(far / near);
+
+    size_t count = (size_t)light_cluster_count(grid);
+    grid->bounds = calloc(6 * (count + BOUNDS_PADDING), sizeof(float));
+    grid->counts = calloc(count, sizeof(unsigned int));
+    grid->indices = malloc(count * LIGHT_CLUSTER_MAX_LIGHTS * sizeof(unsigned int));
+    if (!grid->bounds || !grid->counts || !grid->indices) {
+        light_cluster_destroy(grid);
+        return -1;
+    }
+
+    // The sides of a cluster are planes through the eye, so its box spans
+    // the corners of its near and far faces.
+    float* minX = (float*)boundsOf(grid, MIN_X);
+    float* minY = (float*)boundsOf(grid, MIN_Y);
+    float* minZ = (float*)boundsOf(grid, MIN_Z);
+    float* maxX = (float*)boundsOf(grid, MAX_X);
+    float* maxY = (float*)boundsOf(grid, MAX_Y);
+    float* maxZ = (float*)boundsOf(grid, MAX_Z);
+    for (int z = 0; z < slices; z++) {
+        float d0 = near * powf(far / near, (float)z / (float)slices);
+        float d1 = near * powf(far / near, (float)(z + 1) / (float)slices);
+        for (int y = 0; y < tilesY; y++) {
+            float y0 = (-1.0f + 2.0f * (float)y / (float)tilesY) * grid->tanHalfY;
+            float y1 = (-1.0f + 2.0f * (float)(y + 1) / (float)tilesY) * grid->tanHalfY;
+            for (int x = 0; x < tilesX; x++) {
+                float x0 = (-1.0f + 2.0f * (float)x / (float)tilesX) * grid->tanHalfX;
+                float x1 = (-1.0f + 2.0f * (float)(x + 1) / (float)tilesX) * grid->tanHalfX;
+                int cluster = x + tilesX * (y + tilesY * z);
+                minX[cluster] = fminf(x0 * d0, x0 * d1);
+                maxX[cluster] = fmaxf(x1 * d0, x1 * d1);
+                minY[cluster] = fminf(y0 * d0, y0 * d1);
+                maxY[cluster] = fmaxf(y1 * d0, y1 * d1);
+                minZ[cluster] = -d1;
+                maxZ[cluster] = -d0;
+            }
+        }
+    }
+    return 0;
+}
+
+void light_cluster_destroy(light_cluster_grid* grid) {
+    free(grid->bounds);
+    free(grid->counts);
+    free(grid->indices);
+    memset(grid, 0, sizeof(light_cluster_grid));
+}
+
+int light_cluster_find(const light_cluster_grid* grid, const float* position) {
+    float depth = -position[2];
+    if (depth < grid->near || depth > grid->far) {
+        return -1;
+    }
+
+    float ndcX = position[0] / (depth * grid->tanHalfX);
+    float ndcY = position[1] / (depth * grid->tanHalfY);
+    if (ndcX < -1.0f || ndcX > 1.0f || ndcY < -1.0f || ndcY > 1.0f) {
+        return -1;
+    }
+    int x = tileOf(ndcX, grid->tilesX);
+    int y = tileOf(ndcY, grid->tilesY);
+    return x + grid->tilesX * (y + grid->tilesY * sliceOf(grid, depth));
+}
+
+// Each variant tests a sphere against the boxes of the clusters [first,
+// first + 4) and returns a mask of those it touches (bit i for cluster
+// first + i).
+#if defined(LIGHT_CLUSTER_SSE2)
+
+static const char* isaName = "SSE2";
+
+static inline int testClusters(const light_cluster_grid* grid, int first, const float* light) {
+    const __m128 zero = _mm_setzero_ps();
+    __m128 distance = zero;
+    for (int axis = 0; axis < 3; axis++) {
+        __m128 center = _mm_set1_ps(light[axis]);
+        __m128 below = _mm_sub_ps(_mm_loadu_ps(boundsOf(grid, MIN_X + axis) + first), center);
+        __m128 above = _mm_sub_ps(center, _mm_loadu_ps(boundsOf(grid, MAX_X + axis) + first));
+        __m128 outside = _mm_max_ps(_mm_max_ps(below, above), zero);
+        distance = _mm_add_ps(distance, _mm_mul_ps(outside, outside));
+    }
+    return _mm_movemask_ps(_mm_cmple_ps(distance, _mm_set1_ps(light[3] * light[3])));
+}
+
+#elif defined(LIGHT_CLUSTER_NEON)
+
+static const char* isaName = "NEON";
+
+static inline int testClusters(const light_cluster_grid* grid, int first, const float* light) {
+    const float32x4_t zero = vdupq_n_f32(0.0f);
+    float32x4_t distance = zero;
+    for (int axis = 0; axis < 3; axis++) {
+        float32x4_t center = vdupq_n_f32(light[axis]);
+        float32x4_t below = vsubq_f32(vld1q_f32(boundsOf(grid, MIN_X + axis) + first), center);
+        float32x4_t above = vsubq_f32(center, vld1q_f32(boundsOf(grid, MAX_X + axis) + first));
+        float32x4_t outside = vmaxq_f32(vmaxq_f32(below, above), zero);
+        distance = vmlaq_f32(distance, outside, outside);
+    }
+    uint32x4_t inside = vcleq_f32(distance, vdupq_n_f32(light[3] * light[3]));
+    return (int)((vgetq_lane_u32(inside, 0) & 1) | (vgetq_lane_u32(inside, 1) & 2) |
+                 (vgetq_lane_u32(inside, 2) & 4) | (vgetq_lane_u32(inside, 3) & 8));
+}
+
+#else
+
+static const char* isaName = "scalar";
+
+static inline int testClusters(const light_cluster_grid* grid, int first, const float* light) {
+    int mask = 0;
+    for (int i = 0; i < 4; i++) {
+        float distance = 0.0f;
+        for (int axis = 0; axis < 3; axis++) {
+            float below = boundsOf(grid, MIN_X + axis)[first + i] - light[axis];
+            float above = light[axis] - boundsOf(grid, MAX_X + axis)[first + i];
+            float outside = fmaxf(fmaxf(below, above), 0.0f);
+            distance += outside * outside;
+        }
+        if (distance <= light[3] * light[3]) {
+            mask |= 1 << i;
+        }
+    }
+    return mask;
+}
+
+#endif
+
+const char* light_cluster_isa(void) {
+    return isaName;
+}
+
+// Range of tiles covered by the extent [low, high] of a sphere along one
+// axis, between two depths. Returns 0 when it is off the screen.
+static int tileRange(float low, float high, float d0, float d1, float tanHalf, int tiles,
+                     int* first, int* last) {
+    float ndcLow = fminf(low / d0, low / d1) / tanHalf;
+    float ndcHigh = fmaxf(high / d0, high / d1) / tanHalf;
+    if (ndcHigh < -1.0f || ndcLow > 1.0f) {
+        return 0;
+    }
+    *first = tileOf(ndcLow, tiles);
+    *last = tileOf(ndcHigh, tiles);
+    return 1;
+}
+
+void light_cluster_assign(light_cluster_grid* grid, const float* lights, int lightCount) {
+    memset(grid->counts, 0, (size_t)light_cluster_count(grid) * sizeof(unsigned int));
+    grid->dropped = 0;
+
+    // The clusters a light may touch are narrowed down to a block of slices
+    // and tiles first, then its sphere is tested against their boxes.
+    for (int i = 0; i < lightCount; i++) {
+        const float* light = &lights[(size_t)i * 4];
+        float radius = light[3];
+        float d0 = -light[2] - radius;
+        float d1 = -light[2] + radius;
+        if (d1 < grid->near || d0 > grid->far) {
+            continue;
+        }
+        d0 = fmaxf(d0, grid->near);
+        d1 = fminf(d1, grid->far);
+
+        int x0, x1, y0, y1;
+        if (!tileRange(light[0] - radius, light[0] + radius, d0, d1, grid->tanHalfX, grid->tilesX, &x0, &x1) ||
+            !tileRange(light[1] - radius, light[1] + radius, d0, d1, grid->tanHalfY, grid->tilesY, &y0, &y1)) {
+            continue;
+        }
+
+        int z0 = sliceOf(grid, d0);
+        int z1 = sliceOf(grid, d1);
+        for (int z = z0; z <= z1; z++) {
+            for (int y = y0; y <= y1; y++) {
+                int row = grid->tilesX * (y + grid->tilesY * z);
+                for (int x = x0; x <= x1; x += 4) {
+                    int mask = testClusters(grid, row + x, light);
+                    int lanes = x1 - x + 1 < 4 ? x1 - x + 1 : 4;
+                    for (int lane = 0; lane < lanes; lane++) {
+                        if (!(mask & (1 << lane))) {
+                            continue;
+                        }
+                        int cluster = row + x + lane;
+                        unsigned int slot = grid->counts[cluster];
+                        if (slot < LIGHT_CLUSTER_MAX_LIGHTS) {
+                            grid->indices[(size_t)cluster * LIGHT_CLUSTER_MAX_LIGHTS + slot] = (unsigned int)i;
+                            grid->counts[cluster] = slot + 1;
+                        } else {
+                            grid->dropped++;
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,72 @@
+//
+// Copyright (c) 2025, Byteplug LLC.
+//
+// This source file is part of a project made by the Erlangsters community and
+// is released under the MIT license. Please refer to the LICENSE.md file that
+// can be found at the root of the project repository.
+//
+// Written by Jonathan De Wachter <jonathan.dewachter@byteplug.io>
+//
+#ifndef LIGHT_CLUSTER_H
+#define LIGHT_CLUSTER_H
+
+// Clustered light assignment. The view frustum is divided in tiles across the
+// screen and in slices along the depth, and every point light is listed in
+// the clusters its sphere of influence touches, so a fragment only loops over
+// the lights of its own cluster.
+//
+// Slices are spaced exponentially between the near and far planes (slice k
+// starts at near * (far / near)^(k / slices)), which keeps the clusters
+// roughly as deep as they are wide. Everything is in view space, the camera
+// looking down -Z.
+//
+// Cluster (x, y, z) has index x + tilesX * (y + tilesY * z), x and y growing
+// toward the right and the top of the screen as in gl_FragCoord. Its list
+// starts at index * LIGHT_CLUSTER_MAX_LIGHTS in the indices; the lights that
+// do not fit are dropped (and counted).
+#define LIGHT_CLUSTER_MAX_LIGHTS 256
+
+typedef struct {
+    int tilesX;
+    int tilesY;
+    int slices;
+    float near;
+    float far;
+    float tanHalfX;  // Half the extent of the frustum at a depth of one.
+    float tanHalfY;
+    float sliceScale;  // slices / log(far / near)
+
+    // Bounding box of every cluster, as 6 arrays (min x, y, z, then max x,
+    // y, z) of clusterCount floats, plus padding so 4 clusters can always be
+    // loaded at once.
+    float* bounds;
+
+    unsigned int* counts;   // Lights of every cluster.
+    unsigned int* indices;  // LIGHT_CLUSTER_MAX_LIGHTS per cluster.
+    long long dropped;      // Lights that did not fit, in the last assignment.
+} light_cluster_grid;
+
+// Divide a frustum made by mat4_perspective() with the given vertical field
+// of view (in radians) and aspect ratio. Returns -1 when the memory cannot be
+// allocated.
+int light_cluster_init(light_cluster_grid* grid, int tilesX, int tilesY, int slices,
+                       float fovy, float aspect, float near, float far);
+void light_cluster_destroy(light_cluster_grid* grid);
+
+static inline int light_cluster_count(const light_cluster_grid* grid) {
+    return grid->tilesX * grid->tilesY * grid->slices;
+}
+
+// Index of the cluster holding a point in view space, or -1 when it is
+// outside of the frustum.
+int light_cluster_find(const light_cluster_grid* grid, const float* position);
+
+// Build the lists of the clusters. The lights are 4 floats each: their
+// position in view space and the radius of their sphere of influence.
+void light_cluster_assign(light_cluster_grid* grid, const float* lights, int lightCount);
+
+// Name of the instruction set testing the lights against 4 clusters at once
+// ("SSE2", "NEON", or "scalar").
+const char* light_cluster_isa(void);
+
+#endif // LIGHT_CLUSTER_H
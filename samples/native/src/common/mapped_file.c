@@ -0,0 +1,97 @@
+//
+// Copyright (c) 2025, Byteplug LLC.
+//
+// This source file is part of a project made by the Erlangsters community and
+// is released under the MIT license. Please refer to the LICENSE.md file that
+// can be found at the root of the project repository.
+//
+// Written by Jonathan De Wachter <jonathan.dewachter@byteplug.io>
+//
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+    #define _POSIX_C_SOURCE 200809L
+#endif
+
+#include "mapped_file.h"
+
+#if defined(_WIN32)
+    #ifndef WIN32_LEAN_AND_MEAN
+        #define WIN32_LEAN_AND_MEAN
+    #endif
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+int mapped_file_open(mapped_file* file, const char* path) {
+    file->data = NULL;
+    file->size = 0;
+
+#if defined(_WIN32)
+    HANDLE handle = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL | FILE_FLAG_RANDOM_ACCESS, NULL);
+    if (handle == INVALID_HANDLE_VALUE) {
+        return -1;
+    }
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(handle, &size) || size.QuadPart == 0) {
+        CloseHandle(handle);
+        return -1;
+    }
+    HANDLE mapping = CreateFileMappingA(handle, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (!mapping) {
+        CloseHandle(handle);
+        return -1;
+    }
+    void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!data) {
+        CloseHandle(mapping);
+        CloseHandle(handle);
+        return -1;
+    }
+    file->file = handle;
+    file->mapping = mapping;
+    file->data = data;
+    file->size = (size_t)size.QuadPart;
+#else
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return -1;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size == 0) {
+        close(fd);
+        return -1;
+    }
+    void* data = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    // The mapping keeps the file referenced.
+    close(fd);
+    if (data == MAP_FAILED) {
+        return -1;
+    }
+    // The chunks are read in the order the camera needs them, not the order
+    // of the file, so read-ahead would mostly read pages for nothing.
+    posix_madvise(data, (size_t)info.st_size, POSIX_MADV_RANDOM);
+    file->data = data;
+    file->size = (size_t)info.st_size;
+#endif
+
+    return 0;
+}
+
+void mapped_file_close(mapped_file* file) {
+    if (!file->data) {
+        return;
+    }
+#if defined(_WIN32)
+    UnmapViewOfFile(file->data);
+    CloseHandle(file->mapping);
+    CloseHandle(file->file);
+#else
+    munmap((void*)file->data, file->size);
+#endif
+    file->data = NULL;
+    file->size = 0;
+}
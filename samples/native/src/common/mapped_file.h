@@ -0,0 +1,32 @@
+//
+// Copyright (c) 2025, Byteplug LLC.
+//
+// This source file is part of a project made by the Erlangsters community and
+// is released under the MIT license. Please refer to the LICENSE.md file that
+// can be found at the root of the project repository.
+//
+// Written by Jonathan De Wachter <jonathan.dewachter@byteplug.io>
+//
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <stddef.h>
+
+// Read-only mapping of a whole file (mmap() on POSIX, MapViewOfFile() on
+// Windows). Nothing is read when the file is opened: the pages are read from
+// the disk (or the page cache) when they are first touched, by the thread
+// touching them.
+typedef struct {
+    const unsigned char* data;
+    size_t size;
+#if defined(_WIN32)
+    void* file;
+    void* mapping;
+#endif
+} mapped_file;
+
+// Returns -1 when the file cannot be opened or mapped, or is empty.
+int mapped_file_open(mapped_file* file, const char* path);
+void mapped_file_close(mapped_file* file);
+
+#endif // MAPPED_FILE_H
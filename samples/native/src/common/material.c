@@ -0,0 +1,146 @@
+//
+// Copyright (c) 2025, Byteplug LLC.
+//
+// This source file is part of a project made by the Erlangsters community and
+// is released under the MIT license. Please refer to the LICENSE.md file that
+// can be found at the root of the project repository.
+//
+// Written by Jonathan De Wachter <jonathan.dewachter@byteplug.io>
+//
+#include "material.h"
+#include "gl_debug.h"
+#include "gpu_memory.h"
+#include "texture_gen.h"
+#include <stdio.h>
+#include <string.h>
+
+int material_set_init(material_set* set, int width, int height, int capacity, int mipmapped) {
+    memset(set, 0, sizeof(material_set));
+    set->width = width;
+    set->height = height;
+    set->capacity = capacity;
+
+#if MATERIAL_USE_TEXTURE_ARRAY
+    GLint maxLayers = 0;
+    glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &maxLayers);
+    if (capacity > maxLayers) {
+        fprintf(stderr, "Texture arrays are limited to %d layers (%d requested)\n", maxLayers, capacity);
+        return -1;
+    }
+
+    set->target = GL_TEXTURE_2D_ARRAY;
+    set->levels = mipmapped ? texture_gen_mip_levels(width, height) : 1;
+
+    glGenTextures(1, &set->texture);
+    GL_CHECK(glBindTexture(GL_TEXTURE_2D_ARRAY, set->texture));
+    for (int level = 0; level < set->levels; level++) {
+        int levelWidth = width >> level > 0 ? width >> level : 1;
+        int levelHeight = height >> level > 0 ? height >> level : 1;
+        GL_CHECK(glTexImage3D(GL_TEXTURE_2D_ARRAY, level, GL_RGBA8, levelWidth, levelHeight, capacity,
+            0, GL_RGBA, GL_UNSIGNED_BYTE, NULL));
+    }
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, set->levels - 1);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, mipmapped ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+
+    gpu_memory_track(GPU_MEMORY_TEXTURE, set->texture,
+        gpu_memory_texture_size(GL_RGBA, GL_UNSIGNED_BYTE, width, height, capacity, set->levels));
+#else
+    (void)mipmapped;
+
+    // Lay the tiles out in a grid as square as possible.
+    int columns = 1;
+    while (columns * columns < capacity) {
+        columns++;
+    }
+    int rows = (capacity + columns - 1) / columns;
+
+    GLint maxSize = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxSize);
+    if (columns * width > maxSize || rows * height > maxSize) {
+        fprintf(stderr, "An atlas of %dx%d pixels exceeds the maximum texture size (%d)\n",
+            columns * width, rows * height, maxSize);
+        return -1;
+    }
+
+    set->target = GL_TEXTURE_2D;
+    set->levels = 1;
+    set->columns = columns;
+    set->atlasWidth = columns * width;
+    set->atlasHeight = rows * height;
+
+    // Non power of two textures are allowed without mipmaps and with
+    // GL_CLAMP_TO_EDGE.
+    glGenTextures(1, &set->texture);
+    GL_CHECK(glBindTexture(GL_TEXTURE_2D, set->texture));
+    GL_CHECK(glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, set->atlasWidth, set->atlasHeight,
+        0, GL_RGBA, GL_UNSIGNED_BYTE, NULL));
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    gpu_memory_track(GPU_MEMORY_TEXTURE, set->texture,
+        gpu_memory_texture_size(GL_RGBA, GL_UNSIGNED_BYTE, set->atlasWidth, set->atlasHeight, 1, 1));
+#endif
+
+    gl_debug_label(GL_TEXTURE, set->texture, "Material set");
+    return 0;
+}
+
+void material_set_destroy(material_set* set) {
+    gpu_memory_untrack(GPU_MEMORY_TEXTURE, set->texture);
+    glDeleteTextures(1, &set->texture);
+    set->texture = 0;
+    set->count = 0;
+}
+
+int material_set_add(material_set* set, const unsigned char* pixels) {
+    if (set->count >= set->capacity) {
+        return -1;
+    }
+    int material = set->count++;
+
+    glBindTexture(set->target, set->texture);
+#if MATERIAL_USE_TEXTURE_ARRAY
+    for (int level = 0; level < set->levels; level++) {
+        int levelWidth = set->width >> level > 0 ? set->width >> level : 1;
+        int levelHeight = set->height >> level > 0 ? set->height >> level : 1;
+        GL_CHECK(glTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, material, levelWidth, levelHeight, 1,
+            GL_RGBA, GL_UNSIGNED_BYTE, pixels + texture_gen_mip_offset(set->width, set->height, level)));
+    }
+#else
+    int x = (material % set->columns) * set->width;
+    int y = (material / set->columns) * set->height;
+    GL_CHECK(glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, set->width, set->height, GL_RGBA, GL_UNSIGNED_BYTE, pixels));
+#endif
+
+    return material;
+}
+
+void material_set_uv_transform(const material_set* set, int material, float transform[4]) {
+#if MATERIAL_USE_TEXTURE_ARRAY
+    (void)set;
+    (void)material;
+    transform[0] = 1.0f;
+    transform[1] = 1.0f;
+    transform[2] = 0.0f;
+    transform[3] = 0.0f;
+#else
+    // Map [0, 1] to the centers of the first and last texels of the tile, so
+    // bilinear filtering never samples the neighboring tiles.
+    int x = (material % set->columns) * set->width;
+    int y = (material / set->columns) * set->height;
+    transform[0] = (float)(set->width - 1) / (float)set->atlasWidth;
+    transform[1] = (float)(set->height - 1) / (float)set->atlasHeight;
+    transform[2] = ((float)x + 0.5f) / (float)set->atlasWidth;
+    transform[3] = ((float)y + 0.5f) / (float)set->atlasHeight;
+#endif
+}
+
+void material_set_bind(const material_set* set, int unit) {
+    glActiveTexture(GL_TEXTURE0 + unit);
+    glBindTexture(set->target, set->texture);
+}
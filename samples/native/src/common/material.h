@@ -0,0 +1,61 @@
+//
+// Copyright (c) 2025, Byteplug LLC.
+//
+// This source file is part of a project made by the Erlangsters community and
+// is released under the MIT license. Please refer to the LICENSE.md file that
+// can be found at the root of the project repository.
+//
+// Written by Jonathan De Wachter <jonathan.dewachter@byteplug.io>
+//
+#ifndef MATERIAL_H
+#define MATERIAL_H
+
+#include "gl_api.h"
+
+// A set of same-size material textures packed into a single texture object,
+// so objects with different materials can be drawn without rebinding
+// textures in between (and, with instancing, in a single draw call).
+//
+// On OpenGL and OpenGL ES 3.0+, the materials are the layers of a
+// GL_TEXTURE_2D_ARRAY and shaders select them with the layer index (the
+// third texture coordinate). OpenGL ES 2.0 has no texture arrays, so the
+// materials are the tiles of an atlas instead and shaders remap their
+// texture coordinates with material_set_uv_transform(); atlases have no mip
+// chain, since the tiles would bleed into each other.
+#if SAMPLE_OPENGL_API == SAMPLE_API_GL || SAMPLE_OPENGL_VERSION_MAJOR >= 3
+    #define MATERIAL_USE_TEXTURE_ARRAY 1
+#else
+    #define MATERIAL_USE_TEXTURE_ARRAY 0
+#endif
+
+typedef struct {
+    GLuint texture;
+    GLenum target;
+    int width;
+    int height;
+    int levels;
+    int capacity;
+    int count;
+    int columns;
+    int atlasWidth;
+    int atlasHeight;
+} material_set;
+
+// Create a set with room for capacity materials of width x height pixels,
+// with full mip chains when mipmapped is set (texture arrays only). Returns
+// -1 when the capacity exceeds the limits of the implementation.
+int material_set_init(material_set* set, int width, int height, int capacity, int mipmapped);
+void material_set_destroy(material_set* set);
+
+// Add a material from RGBA8 pixels, followed by its mip chain laid out as
+// in texture_gen.h when the set is mipmapped. Returns the index of the
+// material (its layer in a texture array), or -1 when the set is full.
+int material_set_add(material_set* set, const unsigned char* pixels);
+
+// Transform to apply to the texture coordinates of a material, as
+// uv * transform.xy + transform.zw. It is the identity for texture arrays.
+void material_set_uv_transform(const material_set* set, int material, float transform[4]);
+
+void material_set_bind(const material_set* set, int unit);
+
+#endif // MATERIAL_H
@@ -59,9 +59,10 @@ void mat4_look_at(mat4 m, float eyeX, float eyeY, float eyeZ,
     float uy = rz * fx - rx * fz;
     float uz = rx * fy - ry * fx;
 
-    m[0] = rx; m[4] = ux; m[8] = -fx; m[12] = 0.0f;
-    m[1] = ry; m[5] = uy; m[9] = -fy; m[13] = 0.0f;
-    m[2] = rz; m[6] = uz; m[10] = -fz; m[14] = 0.0f;
+    // The rows of the rotation are the camera axes.
+    m[0] = rx; m[4] = ry; m[8] = rz; m[12] = 0.0f;
+    m[1] = ux; m[5] = uy; m[9] = uz; m[13] = 0.0f;
+    m[2] = -fx; m[6] = -fy; m[10] = -fz; m[14] = 0.0f;
     m[3] = 0.0f; m[7] = 0.0f; m[11] = 0.0f; m[15] = 1.0f;
 
     // Translate the eye position
@@ -114,3 +115,77 @@ void mat4_rotate_x(mat4 result, const mat4 m, float angle) {
     result[12] = m[12]; result[13] = m[13];
     result[14] = m[14]; result[15] = m[15];
 }
+
+// Multiply two matrices
+void mat4_multiply(mat4 result, const mat4 a, const mat4 b) {
+    mat4 m;
+    for (int column = 0; column < 4; column++) {
+        for (int row = 0; row < 4; row++) {
+            m[column * 4 + row] =
+                a[0 * 4 + row] * b[column * 4 + 0] +
+                a[1 * 4 + row] * b[column * 4 + 1] +
+                a[2 * 4 + row] * b[column * 4 + 2] +
+                a[3 * 4 + row] * b[column * 4 + 3];
+        }
+    }
+    for (int i = 0; i < 16; i++) {
+        result[i] = m[i];
+    }
+}
+
+// Compose a translation, a rotation and a scale
+void mat4_from_trs(mat4 m, const float translation[3], const quat rotation, const float scale[3]) {
+    float x = rotation[0], y = rotation[1], z = rotation[2], w = rotation[3];
+    float xx = x * x, yy = y * y, zz = z * z;
+    float xy = x * y, xz = x * z, yz = y * z;
+    float wx = w * x, wy = w * y, wz = w * z;
+
+    m[0] = (1.0f - 2.0f * (yy + zz)) * scale[0];
+    m[1] = 2.0f * (xy + wz) * scale[0];
+    m[2] = 2.0f * (xz - wy) * scale[0];
+    m[3] = 0.0f;
+
+    m[4] = 2.0f * (xy - wz) * scale[1];
+    m[5] = (1.0f - 2.0f * (xx + zz)) * scale[1];
+    m[6] = 2.0f * (yz + wx) * scale[1];
+    m[7] = 0.0f;
+
+    m[8] = 2.0f * (xz + wy) * scale[2];
+    m[9] = 2.0f * (yz - wx) * scale[2];
+    m[10] = (1.0f - 2.0f * (xx + yy)) * scale[2];
+    m[11] = 0.0f;
+
+    m[12] = translation[0];
+    m[13] = translation[1];
+    m[14] = translation[2];
+    m[15] = 1.0f;
+}
+
+// Initialize quaternion to identity
+void quat_identity(quat q) {
+    q[0] = 0.0f;
+    q[1] = 0.0f;
+    q[2] = 0.0f;
+    q[3] = 1.0f;
+}
+
+// Create a rotation around an axis
+void quat_from_axis_angle(quat q, float x, float y, float z, float angle) {
+    float s = sinf(angle * 0.5f);
+    q[0] = x * s;
+    q[1] = y * s;
+    q[2] = z * s;
+    q[3] = cosf(angle * 0.5f);
+}
+
+// Multiply two quaternions
+void quat_multiply(quat result, const quat a, const quat b) {
+    float x = a[3] * b[0] + a[0] * b[3] + a[1] * b[2] - a[2] * b[1];
+    float y = a[3] * b[1] - a[0] * b[2] + a[1] * b[3] + a[2] * b[0];
+    float z = a[3] * b[2] + a[0] * b[1] - a[1] * b[0] + a[2] * b[3];
+    float w = a[3] * b[3] - a[0] * b[0] - a[1] * b[1] - a[2] * b[2];
+    result[0] = x;
+    result[1] = y;
+    result[2] = z;
+    result[3] = w;
+}
@@ -12,6 +12,9 @@
 
 typedef float mat4[16];
 
+// Unit quaternions, stored as x, y, z, w.
+typedef float quat[4];
+
 void mat4_identity(mat4 m);
 void mat4_perspective(mat4 m, float fovy, float aspect, float near, float far);
 
@@ -22,4 +25,19 @@ void mat4_look_at(mat4 m, float eyeX, float eyeY, float eyeZ,
 void mat4_rotate_y(mat4 result, const mat4 m, float angle);
 void mat4_rotate_x(mat4 result, const mat4 m, float angle);
 
+// Compute a * b; result may alias either operand.
+void mat4_multiply(mat4 result, const mat4 a, const mat4 b);
+
+// Compose translation * rotation * scale.
+void mat4_from_trs(mat4 m, const float translation[3], const quat rotation, const float scale[3]);
+
+void quat_identity(quat q);
+
+// Rotation of angle radians around a unit axis.
+void quat_from_axis_angle(quat q, float x, float y, float z, float angle);
+
+// Compute a * b, the rotation b followed by a; result may alias either
+// operand.
+void quat_multiply(quat result, const quat a, const quat b);
+
 #endif // MATRIX_H
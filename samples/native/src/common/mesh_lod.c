@@ -0,0 +1,435 @@
+//
+// Copyright (c) 2025, Byteplug LLC.
+//
+// This source file is part of a project made by the Erlangsters community and
+// is released under the MIT license. Please refer to the LICENSE.md file that
+// can be found at the root of the project repository.
+//
+// Written by Jonathan De Wachter <jonathan.dewachter@byteplug.io>
+//
+#include "mesh_lod.h"
+#include <float.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Symmetric 4x4 matrix of the quadric: the sum of the squared distances to
+// a set of planes, weighted by the areas of their triangles, as a function of
+// the position. The weight is the total area.
+typedef struct {
+    double a00, a01, a02, a11, a12, a22;
+    double b0, b1, b2;
+    double c;
+    double weight;
+} quadric;
+
+typedef struct {
+    unsigned short from;
+    unsigned short to;
+    float cost;
+} collapse;
+
+typedef struct {
+    quadric* quadrics;
+    unsigned int* edgeKeys;
+    collapse* collapses;
+    unsigned int* adjacencyOffsets;
+    unsigned int* adjacency;
+    unsigned short* remap;
+    unsigned char* locked;
+    unsigned char* touched;
+} simplifier;
+
+static const float* vertexPosition(const float* positions, size_t stride, unsigned int vertex) {
+    return positions + (size_t)vertex * stride;
+}
+
+static void quadricAddPlane(quadric* q, double nx, double ny, double nz, double d, double weight) {
+    q->a00 += weight * nx * nx;
+    q->a01 += weight * nx * ny;
+    q->a02 += weight * nx * nz;
+    q->a11 += weight * ny * ny;
+    q->a12 += weight * ny * nz;
+    q->a22 += weight * nz * nz;
+    q->b0 += weight * nx * d;
+    q->b1 += weight * ny * d;
+    q->b2 += weight * nz * d;
+    q->c += weight * d * d;
+    q->weight += weight;
+}
+
+static void quadricAdd(quadric* q, const quadric* other) {
+    q->a00 += other->a00;
+    q->a01 += other->a01;
+    q->a02 += other->a02;
+    q->a11 += other->a11;
+    q->a12 += other->a12;
+    q->a22 += other->a22;
+    q->b0 += other->b0;
+    q->b1 += other->b1;
+    q->b2 += other->b2;
+    q->c += other->c;
+    q->weight += other->weight;
+}
+
+// Error of the sum of two quadrics at a position: the mean squared distance
+// to their planes.
+static double quadricError(const quadric* q, const quadric* r, const float* p) {
+    double x = p[0];
+    double y = p[1];
+    double z = p[2];
+    double error =
+        (q->a00 + r->a00) * x * x + (q->a11 + r->a11) * y * y + (q->a22 + r->a22) * z * z +
+        2.0 * ((q->a01 + r->a01) * x * y + (q->a02 + r->a02) * x * z + (q->a12 + r->a12) * y * z) +
+        2.0 * ((q->b0 + r->b0) * x + (q->b1 + r->b1) * y + (q->b2 + r->b2) * z) +
+        (q->c + r->c);
+    double weight = q->weight + r->weight;
+    return error > 0.0 && weight > 0.0 ? error / weight : 0.0;
+}
+
+static void triangleNormal(const float* a, const float* b, const float* c, double normal[3]) {
+    double ex = b[0] - a[0], ey = b[1] - a[1], ez = b[2] - a[2];
+    double fx = c[0] - a[0], fy = c[1] - a[1], fz = c[2] - a[2];
+    normal[0] = ey * fz - ez * fy;
+    normal[1] = ez * fx - ex * fz;
+    normal[2] = ex * fy - ey * fx;
+}
+
+static int compareKeys(const void* a, const void* b) {
+    unsigned int x = *(const unsigned int*)a;
+    unsigned int y = *(const unsigned int*)b;
+    return x < y ? -1 : x > y;
+}
+
+static int compareCollapses(const void* a, const void* b) {
+    float x = ((const collapse*)a)->cost;
+    float y = ((const collapse*)b)->cost;
+    return x < y ? -1 : x > y;
+}
+
+// Sorted keys (lower vertex in the high bits) of the edges of the triangles,
+// with duplicates; returns their number.
+static size_t collectEdges(unsigned int* keys, const unsigned short* indices, size_t indexCount) {
+    size_t count = 0;
+    for (size_t i = 0; i < indexCount; i += 3) {
+        for (int e = 0; e < 3; e++) {
+            unsigned int a = indices[i + e];
+            unsigned int b = indices[i + (e + 1) % 3];
+            keys[count++] = a < b ? (a << 16) | b : (b << 16) | a;
+        }
+    }
+    qsort(keys, count, sizeof(unsigned int), compareKeys);
+    return count;
+}
+
+// Vertex to triangle adjacency, in compressed rows.
+static void buildAdjacency(simplifier* s, const unsigned short* indices, size_t indexCount, size_t vertexCount) {
+    memset(s->adjacencyOffsets, 0, (vertexCount + 1) * sizeof(unsigned int));
+    for (size_t i = 0; i < indexCount; i++) {
+        s->adjacencyOffsets[indices[i] + 1]++;
+    }
+    for (size_t v = 0; v < vertexCount; v++) {
+        s->adjacencyOffsets[v + 1] += s->adjacencyOffsets[v];
+    }
+    for (size_t i = 0; i < indexCount; i++) {
+        s->adjacency[s->adjacencyOffsets[indices[i]]++] = (unsigned int)(i / 3);
+    }
+    // Shift the offsets back to the start of each row.
+    for (size_t v = vertexCount; v > 0; v--) {
+        s->adjacencyOffsets[v] = s->adjacencyOffsets[v - 1];
+    }
+    s->adjacencyOffsets[0] = 0;
+}
+
+// A collapse is rejected when it turns a remaining triangle over (or nearly
+// so), which would fold the surface onto itself.
+static int collapseFlips(const simplifier* s, const unsigned short* indices, const float* positions, size_t stride,
+                         unsigned int from, unsigned int to) {
+    for (unsigned int i = s->adjacencyOffsets[from]; i < s->adjacencyOffsets[from + 1]; i++) {
+        const unsigned short* triangle = &indices[(size_t)s->adjacency[i] * 3];
+        if (triangle[0] == to || triangle[1] == to || triangle[2] == to) {
+            continue;
+        }
+
+        const float* corners[3];
+        const float* moved[3];
+        for (int k = 0; k < 3; k++) {
+            corners[k] = vertexPosition(positions, stride, triangle[k]);
+            moved[k] = triangle[k] == from ? vertexPosition(positions, stride, to) : corners[k];
+        }
+
+        double before[3], after[3];
+        triangleNormal(corners[0], corners[1], corners[2], before);
+        triangleNormal(moved[0], moved[1], moved[2], after);
+        double dot = before[0] * after[0] + before[1] * after[1] + before[2] * after[2];
+        double lengths = sqrt((before[0] * before[0] + before[1] * before[1] + before[2] * before[2]) *
+                              (after[0] * after[0] + after[1] * after[1] + after[2] * after[2]));
+        if (dot <= 0.25 * lengths) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static void freeSimplifier(simplifier* s) {
+    free(s->quadrics);
+    free(s->edgeKeys);
+    free(s->collapses);
+    free(s->adjacencyOffsets);
+    free(s->adjacency);
+    free(s->remap);
+    free(s->locked);
+    free(s->touched);
+}
+
+size_t mesh_simplify(unsigned short* destination, const unsigned short* indices, size_t indexCount,
+                     const float* positions, size_t vertexCount, size_t stride,
+                     size_t targetIndexCount, float* error) {
+    memmove(destination, indices, indexCount * sizeof(unsigned short));
+    if (error) {
+        *error = 0.0f;
+    }
+
+    simplifier s;
+    s.quadrics = calloc(vertexCount, sizeof(quadric));
+    s.edgeKeys = malloc(indexCount * sizeof(unsigned int));
+    s.collapses = malloc(indexCount * sizeof(collapse));
+    s.adjacencyOffsets = malloc((vertexCount + 1) * sizeof(unsigned int));
+    s.adjacency = malloc(indexCount * sizeof(unsigned int));
+    s.remap = malloc(vertexCount * sizeof(unsigned short));
+    s.locked = calloc(vertexCount, 1);
+    s.touched = malloc(vertexCount);
+    if (!s.quadrics || !s.edgeKeys || !s.collapses || !s.adjacencyOffsets ||
+        !s.adjacency || !s.remap || !s.locked || !s.touched) {
+        freeSimplifier(&s);
+        return indexCount;
+    }
+
+    // The quadric of a vertex measures the distance to the planes of the
+    // triangles around it. The error of a collapse is a mean over the merged
+    // triangles, so it estimates the distance to the original surface rather
+    // than bounding it.
+    for (size_t i = 0; i < indexCount; i += 3) {
+        const float* a = vertexPosition(positions, stride, destination[i]);
+        const float* b = vertexPosition(positions, stride, destination[i + 1]);
+        const float* c = vertexPosition(positions, stride, destination[i + 2]);
+        double normal[3];
+        triangleNormal(a, b, c, normal);
+        double length = sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+        if (length == 0.0) {
+            continue;
+        }
+        double nx = normal[0] / length, ny = normal[1] / length, nz = normal[2] / length;
+        double d = -(nx * a[0] + ny * a[1] + nz * a[2]);
+        for (int k = 0; k < 3; k++) {
+            quadricAddPlane(&s.quadrics[destination[i + k]], nx, ny, nz, d, length * 0.5);
+        }
+    }
+
+    // Edges that do not have exactly two triangles are on a border (or are
+    // non-manifold); their vertices stay in place.
+    size_t keyCount = collectEdges(s.edgeKeys, destination, indexCount);
+    for (size_t i = 0; i < keyCount;) {
+        size_t j = i + 1;
+        while (j < keyCount && s.edgeKeys[j] == s.edgeKeys[i]) {
+            j++;
+        }
+        if (j - i != 2) {
+            s.locked[s.edgeKeys[i] >> 16] = 1;
+            s.locked[s.edgeKeys[i] & 0xffff] = 1;
+        }
+        i = j;
+    }
+
+    for (size_t v = 0; v < vertexCount; v++) {
+        s.remap[v] = (unsigned short)v;
+    }
+
+    // Every pass sorts the candidate collapses by cost and applies the
+    // cheapest ones, never touching a vertex (or the triangles around it)
+    // twice, so the costs and the flip checks of a pass remain valid.
+    double maxCost = 0.0;
+    while (indexCount > targetIndexCount) {
+        buildAdjacency(&s, destination, indexCount, vertexCount);
+
+        keyCount = collectEdges(s.edgeKeys, destination, indexCount);
+        size_t collapseCount = 0;
+        for (size_t i = 0; i < keyCount; i++) {
+            if (i > 0 && s.edgeKeys[i] == s.edgeKeys[i - 1]) {
+                continue;
+            }
+            unsigned int a = s.edgeKeys[i] >> 16;
+            unsigned int b = s.edgeKeys[i] & 0xffff;
+            const quadric* qa = &s.quadrics[a];
+            const quadric* qb = &s.quadrics[b];
+            double costAB = s.locked[a] ? DBL_MAX : quadricError(qa, qb, vertexPosition(positions, stride, b));
+            double costBA = s.locked[b] ? DBL_MAX : quadricError(qa, qb, vertexPosition(positions, stride, a));
+            if (costAB == DBL_MAX && costBA == DBL_MAX) {
+                continue;
+            }
+
+            collapse* c = &s.collapses[collapseCount++];
+            c->from = (unsigned short)(costAB <= costBA ? a : b);
+            c->to = (unsigned short)(costAB <= costBA ? b : a);
+            c->cost = (float)(costAB <= costBA ? costAB : costBA);
+        }
+        qsort(s.collapses, collapseCount, sizeof(collapse), compareCollapses);
+
+        memset(s.touched, 0, vertexCount);
+        size_t trianglesToRemove = (indexCount - targetIndexCount + 2) / 3;
+        size_t removed = 0;
+        size_t applied = 0;
+        for (size_t i = 0; i < collapseCount && removed < trianglesToRemove; i++) {
+            const collapse* c = &s.collapses[i];
+            if (s.touched[c->from] || s.touched[c->to]) {
+                continue;
+            }
+            if (collapseFlips(&s, destination, positions, stride, c->from, c->to)) {
+                continue;
+            }
+
+            for (unsigned int k = s.adjacencyOffsets[c->from]; k < s.adjacencyOffsets[c->from + 1]; k++) {
+                const unsigned short* triangle = &destination[(size_t)s.adjacency[k] * 3];
+                if (triangle[0] == c->to || triangle[1] == c->to || triangle[2] == c->to) {
+                    removed++;
+                }
+                s.touched[triangle[0]] = 1;
+                s.touched[triangle[1]] = 1;
+                s.touched[triangle[2]] = 1;
+            }
+            s.touched[c->to] = 1;
+
+            s.remap[c->from] = c->to;
+            quadricAdd(&s.quadrics[c->to], &s.quadrics[c->from]);
+            if (c->cost > maxCost) {
+                maxCost = c->cost;
+            }
+            applied++;
+        }
+        if (applied == 0) {
+            break;
+        }
+
+        // Remap the indices and drop the triangles that collapsed.
+        size_t count = 0;
+        for (size_t i = 0; i < indexCount; i += 3) {
+            unsigned short a = s.remap[destination[i]];
+            unsigned short b = s.remap[destination[i + 1]];
+            unsigned short c = s.remap[destination[i + 2]];
+            if (a != b && b != c && a != c) {
+                destination[count++] = a;
+                destination[count++] = b;
+                destination[count++] = c;
+            }
+        }
+        indexCount = count;
+
+        for (size_t v = 0; v < vertexCount; v++) {
+            s.remap[v] = (unsigned short)v;
+        }
+    }
+
+    if (error) {
+        *error = (float)sqrt(maxCost);
+    }
+    freeSimplifier(&s);
+    return indexCount;
+}
+
+int mesh_lod_build(mesh_lod_chain* chain, const unsigned short* indices, size_t indexCount,
+                   const float* positions, size_t vertexCount, size_t stride, int maxLevels) {
+    memset(chain, 0, sizeof(mesh_lod_chain));
+    if (maxLevels > MESH_LOD_MAX_LEVELS) {
+        maxLevels = MESH_LOD_MAX_LEVELS;
+    }
+
+    // Every level has at most 3/4 of the indices of the previous one, so the
+    // chain takes at most four times the size of the mesh. The levels are
+    // simplified in a scratch buffer, which needs room for the whole mesh.
+    chain->indices = malloc(indexCount * 4 * sizeof(unsigned short));
+    unsigned short* scratch = malloc(indexCount * sizeof(unsigned short));
+    if (!chain->indices || !scratch) {
+        free(chain->indices);
+        free(scratch);
+        chain->indices = NULL;
+        return -1;
+    }
+
+    memcpy(chain->indices, indices, indexCount * sizeof(unsigned short));
+    chain->levels[0].indexOffset = 0;
+    chain->levels[0].indexCount = indexCount;
+    chain->levels[0].error = 0.0f;
+    chain->levelCount = 1;
+    chain->indexCount = indexCount;
+
+    // Every level is simplified from the original mesh, so the errors are
+    // measured against the original surface.
+    while (chain->levelCount < maxLevels) {
+        const mesh_lod_level* previous = &chain->levels[chain->levelCount - 1];
+        size_t target = previous->indexCount / 6 * 3;
+        if (target < 3) {
+            break;
+        }
+
+        mesh_lod_level* level = &chain->levels[chain->levelCount];
+        level->indexOffset = chain->indexCount;
+        level->indexCount = mesh_simplify(scratch, indices, indexCount,
+            positions, vertexCount, stride, target, &level->error);
+
+        // Stop when the mesh can no longer be halved (most remaining
+        // collapses would fold it).
+        if (level->indexCount == 0 || level->indexCount > previous->indexCount * 3 / 4) {
+            break;
+        }
+        if (level->error < previous->error) {
+            level->error = previous->error;
+        }
+        memcpy(chain->indices + level->indexOffset, scratch, level->indexCount * sizeof(unsigned short));
+        chain->indexCount += level->indexCount;
+        chain->levelCount++;
+    }
+    free(scratch);
+
+    return 0;
+}
+
+void mesh_lod_destroy(mesh_lod_chain* chain) {
+    free(chain->indices);
+    memset(chain, 0, sizeof(mesh_lod_chain));
+}
+
+float mesh_lod_projection_scale(float fovy, int viewportHeight) {
+    return (float)viewportHeight / (2.0f * tanf(fovy * 0.5f));
+}
+
+float mesh_lod_screen_error(const mesh_lod_chain* chain, int level, float distance, float scale,
+                            float projectionScale) {
+    // Objects closer than this are drawn at full detail anyway.
+    const float minDistance = 1e-3f;
+    if (distance < minDistance) {
+        distance = minDistance;
+    }
+    return chain->levels[level].error * scale * projectionScale / distance;
+}
+
+int mesh_lod_select(const mesh_lod_chain* chain, int current, float distance, float scale,
+                    float projectionScale, float threshold, float hysteresis) {
+    int level = current;
+    if (level < 0) {
+        level = 0;
+    }
+    if (level >= chain->levelCount) {
+        level = chain->levelCount - 1;
+    }
+
+    while (level + 1 < chain->levelCount &&
+           mesh_lod_screen_error(chain, level + 1, distance, scale, projectionScale) <= threshold * (1.0f - hysteresis)) {
+        level++;
+    }
+    while (level > 0 &&
+           mesh_lod_screen_error(chain, level, distance, scale, projectionScale) > threshold * (1.0f + hysteresis)) {
+        level--;
+    }
+
+    return level;
+}
@@ -0,0 +1,76 @@
+//
+// Copyright (c) 2025, Byteplug LLC.
+//
+// This source file is part of a project made by the Erlangsters community and
+// is released under the MIT license. Please refer to the LICENSE.md file that
+// can be found at the root of the project repository.
+//
+// Written by Jonathan De Wachter <jonathan.dewachter@byteplug.io>
+//
+#ifndef MESH_LOD_H
+#define MESH_LOD_H
+
+#include <stddef.h>
+
+// Levels of detail of an indexed triangle mesh. The levels are index buffers
+// into the vertex buffer of the original mesh, so a single vertex buffer
+// serves all of them and switching levels only changes the range of indices
+// that is drawn.
+//
+// Meshes are simplified by edge collapses ordered by quadric error metrics
+// (Garland & Heckbert); a vertex is always collapsed onto one of its
+// neighbors, so no vertex is created or moved. Vertices on open borders are
+// kept in place. Indices are 16 bits, as everywhere in the samples, so meshes
+// are limited to 65536 vertices.
+#define MESH_LOD_MAX_LEVELS 8
+
+typedef struct {
+    size_t indexOffset;
+    size_t indexCount;
+    float error;  // Estimated distance to the original surface, in mesh units.
+} mesh_lod_level;
+
+typedef struct {
+    unsigned short* indices;  // All the levels, one after the other.
+    size_t indexCount;
+    int levelCount;
+    mesh_lod_level levels[MESH_LOD_MAX_LEVELS];
+} mesh_lod_chain;
+
+// Simplify a mesh down to at most targetIndexCount indices (or as close as
+// the collapses allow) into destination, which must have room for
+// indexCount indices. The positions are 3 floats every stride floats.
+// Returns the number of indices written; error receives the geometric error
+// of the result, when not NULL.
+size_t mesh_simplify(unsigned short* destination, const unsigned short* indices, size_t indexCount,
+                     const float* positions, size_t vertexCount, size_t stride,
+                     size_t targetIndexCount, float* error);
+
+// Build a chain of up to maxLevels levels, the first one being the mesh
+// itself and every following one having about half the triangles of the
+// previous one. The chain stops early when a mesh can no longer be
+// simplified. Returns -1 when the memory cannot be allocated.
+int mesh_lod_build(mesh_lod_chain* chain, const unsigned short* indices, size_t indexCount,
+                   const float* positions, size_t vertexCount, size_t stride, int maxLevels);
+void mesh_lod_destroy(mesh_lod_chain* chain);
+
+// Size in pixels of one unit at a distance of one unit, for a projection
+// made by mat4_perspective() with the given vertical field of view (in
+// radians) and a viewport of the given height.
+float mesh_lod_projection_scale(float fovy, int viewportHeight);
+
+// Size in pixels of the error of a level, for a mesh drawn with the given
+// scale at the given distance from the eye.
+float mesh_lod_screen_error(const mesh_lod_chain* chain, int level, float distance, float scale,
+                            float projectionScale);
+
+// Pick the coarsest level whose screen error stays under threshold pixels.
+// To avoid popping back and forth around the threshold, the current level is
+// kept as long as its error is within threshold * (1 +/- hysteresis): a
+// coarser level is only picked once its error falls under
+// threshold * (1 - hysteresis), and a finer one once the error of the
+// current level exceeds threshold * (1 + hysteresis).
+int mesh_lod_select(const mesh_lod_chain* chain, int current, float distance, float scale,
+                    float projectionScale, float threshold, float hysteresis);
+
+#endif // MESH_LOD_H
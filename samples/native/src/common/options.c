@@ -0,0 +1,57 @@
+//
+// Copyright (c) 2025, Byteplug LLC.
+//
+// This source file is part of a project made by the Erlangsters community and
+// is released under the MIT license. Please refer to the LICENSE.md file that
+// can be found at the root of the project repository.
+//
+// Written by Jonathan De Wachter <jonathan.dewachter@byteplug.io>
+//
+#include "options.h"
+#include <stdlib.h>
+#include <string.h>
+
+static const char* find_option_value(int argc, char** argv, const char* name) {
+    for (int i = 1; i < argc - 1; i++) {
+        if (strcmp(argv[i], name) == 0) {
+            return argv[i + 1];
+        }
+    }
+    return NULL;
+}
+
+int option_flag(int argc, char** argv, const char* name) {
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], name) == 0) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+int option_int(int argc, char** argv, const char* name, int fallback) {
+    const char* value = find_option_value(argc, argv, name);
+    if (!value) {
+        return fallback;
+    }
+
+    char* end;
+    long result = strtol(value, &end, 10);
+    return (end != value && *end == '\0') ? (int)result : fallback;
+}
+
+double option_double(int argc, char** argv, const char* name, double fallback) {
+    const char* value = find_option_value(argc, argv, name);
+    if (!value) {
+        return fallback;
+    }
+
+    char* end;
+    double result = strtod(value, &end);
+    return (end != value && *end == '\0') ? result : fallback;
+}
+
+const char* option_string(int argc, char** argv, const char* name, const char* fallback) {
+    const char* value = find_option_value(argc, argv, name);
+    return value ? value : fallback;
+}
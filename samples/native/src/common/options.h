@@ -0,0 +1,21 @@
+//
+// Copyright (c) 2025, Byteplug LLC.
+//
+// This source file is part of a project made by the Erlangsters community and
+// is released under the MIT license. Please refer to the LICENSE.md file that
+// can be found at the root of the project repository.
+//
+// Written by Jonathan De Wachter <jonathan.dewachter@byteplug.io>
+//
+#ifndef OPTIONS_H
+#define OPTIONS_H
+
+// Minimal command-line lookup for the samples. Options are written as
+// "--name value" (or just "--name" for flags) and looked up by name; the
+// fallback is returned when the option is absent or malformed.
+int option_flag(int argc, char** argv, const char* name);
+int option_int(int argc, char** argv, const char* name, int fallback);
+double option_double(int argc, char** argv, const char* name, double fallback);
+const char* option_string(int argc, char** argv, const char* name, const char* fallback);
+
+#endif // OPTIONS_H
@@ -0,0 +1,172 @@
+//
+// Copyright (c) 2025, Byteplug LLC.
+//
+// This source file is part of a project made by the Erlangsters community and
+// is released under the MIT license. Please refer to the LICENSE.md file that
+// can be found at the root of the project repository.
+//
+// Written by Jonathan De Wachter <jonathan.dewachter@byteplug.io>
+//
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+    #define _POSIX_C_SOURCE 200809L
+#endif
+
+#include "port.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(_WIN32)
+    #include <fcntl.h>
+    #include <io.h>
+
+    #define dup _dup
+    #define dup2 _dup2
+    #define close _close
+    #define fileno _fileno
+    typedef int io_size;
+#else
+    #include <errno.h>
+    #include <signal.h>
+    #include <unistd.h>
+
+    typedef ssize_t io_size;
+#endif
+
+// Smaller packets are written with their header in a single write.
+#define SMALL_PACKET 256
+
+static int readAll(int fd, unsigned char* data, size_t size) {
+    size_t done = 0;
+    while (done < size) {
+        #if defined(_WIN32)
+            io_size count = _read(fd, data + done, (unsigned int)(size - done));
+        #else
+            io_size count = read(fd, data + done, size - done);
+            if (count < 0 && errno == EINTR) {
+                continue;
+            }
+        #endif
+        if (count <= 0) {
+            // The end of the input is only clean between two packets.
+            return count == 0 && done == 0 ? 0 : -1;
+        }
+        done += (size_t)count;
+    }
+    return 1;
+}
+
+static int writeAll(int fd, const unsigned char* data, size_t size) {
+    size_t done = 0;
+    while (done < size) {
+        #if defined(_WIN32)
+            io_size count = _write(fd, data + done, (unsigned int)(size - done));
+        #else
+            io_size count = write(fd, data + done, size - done);
+            if (count < 0 && errno == EINTR) {
+                continue;
+            }
+        #endif
+        if (count <= 0) {
+            return -1;
+        }
+        done += (size_t)count;
+    }
+    return 0;
+}
+
+int port_open(port* port) {
+    memset(port, 0, sizeof(*port));
+
+    fflush(stdout);
+    port->input = fileno(stdin);
+    port->output = dup(fileno(stdout));
+    if (port->output < 0 || dup2(fileno(stderr), fileno(stdout)) < 0) {
+        if (port->output >= 0) {
+            close(port->output);
+        }
+        return -1;
+    }
+
+    #if defined(_WIN32)
+        _setmode(port->input, _O_BINARY);
+        _setmode(port->output, _O_BINARY);
+    #else
+        // A port closed by the other end fails the next write instead of
+        // killing the process.
+        signal(SIGPIPE, SIG_IGN);
+    #endif
+    return 0;
+}
+
+void port_close(port* port) {
+    fflush(stdout);
+    if (port->output >= 0) {
+        dup2(port->output, fileno(stdout));
+        close(port->output);
+        port->output = -1;
+    }
+    free(port->buffer);
+    port->buffer = NULL;
+    port->capacity = 0;
+}
+
+int port_read(port* port, const unsigned char** data, size_t* size) {
+    unsigned char header[4];
+    int result = readAll(port->input, header, sizeof(header));
+    if (result <= 0) {
+        return result;
+    }
+    size_t length = ((size_t)header[0] << 24) | ((size_t)header[1] << 16) | ((size_t)header[2] << 8) | header[3];
+    if (length > PORT_MAX_PACKET) {
+        fprintf(stderr, "Packet of %zu bytes larger than %d bytes\n", length, PORT_MAX_PACKET);
+        return -1;
+    }
+
+    // The buffer only grows, so a steady stream of batches stops allocating
+    // after the largest one.
+    if (length > port->capacity) {
+        size_t capacity = port->capacity > 0 ? port->capacity : 4096;
+        while (capacity < length) {
+            capacity *= 2;
+        }
+        unsigned char* buffer = realloc(port->buffer, capacity);
+        if (!buffer) {
+            return -1;
+        }
+        port->buffer = buffer;
+        port->capacity = capacity;
+    }
+    if (length > 0 && readAll(port->input, port->buffer, length) != 1) {
+        return -1;
+    }
+
+    port->packetsRead++;
+    port->bytesRead += sizeof(header) + length;
+    *data = port->buffer;
+    *size = length;
+    return 1;
+}
+
+int port_write(port* port, const void* data, size_t size) {
+    if (size > PORT_MAX_PACKET) {
+        return -1;
+    }
+    unsigned char packet[4 + SMALL_PACKET];
+    packet[0] = (unsigned char)(size >> 24);
+    packet[1] = (unsigned char)(size >> 16);
+    packet[2] = (unsigned char)(size >> 8);
+    packet[3] = (unsigned char)size;
+    if (size <= SMALL_PACKET) {
+        memcpy(packet + 4, data, size);
+        if (writeAll(port->output, packet, 4 + size) != 0) {
+            return -1;
+        }
+    } else if (writeAll(port->output, packet, 4) != 0 || writeAll(port->output, data, size) != 0) {
+        return -1;
+    }
+
+    port->packetsWritten++;
+    port->bytesWritten += 4 + size;
+    return 0;
+}
@@ -0,0 +1,51 @@
+//
+// Copyright (c) 2025, Byteplug LLC.
+//
+// This source file is part of a project made by the Erlangsters community and
+// is released under the MIT license. Please refer to the LICENSE.md file that
+// can be found at the root of the project repository.
+//
+// Written by Jonathan De Wachter <jonathan.dewachter@byteplug.io>
+//
+#ifndef PORT_H
+#define PORT_H
+
+#include <stddef.h>
+
+// The native side of an Erlang port opened with {packet, 4}: the packets are
+// read from the standard input and written to the standard output, each one
+// preceded by its size as a 4-byte big-endian integer.
+//
+// The standard output belongs to the packets once the port is open; it is
+// redirected to the standard error, so whatever the sample (and the common
+// modules) print ends up in the log of the port instead of corrupting the
+// protocol.
+#define PORT_MAX_PACKET (64 * 1024 * 1024)
+
+typedef struct {
+    int input;
+    int output;  // The original standard output.
+    unsigned char* buffer;
+    size_t capacity;
+    unsigned long long packetsRead;
+    unsigned long long bytesRead;
+    unsigned long long packetsWritten;
+    unsigned long long bytesWritten;
+} port;
+
+// Returns -1 when the standard output cannot be taken over.
+int port_open(port* port);
+
+// Give the standard output back.
+void port_close(port* port);
+
+// Read the next packet, which stays valid until the next read. Returns 1 with
+// a packet, 0 when the other end closed the port, and -1 on a read error or
+// a packet larger than PORT_MAX_PACKET.
+int port_read(port* port, const unsigned char** data, size_t* size);
+
+// Returns -1 on a write error (including the other end having closed the
+// port).
+int port_write(port* port, const void* data, size_t size);
+
+#endif // PORT_H
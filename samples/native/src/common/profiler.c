@@ -0,0 +1,396 @@
+//
+// Copyright (c) 2025, Byteplug LLC.
+//
+// This source file is part of a project made by the Erlangsters community and
+// is released under the MIT license. Please refer to the LICENSE.md file that
+// can be found at the root of the project repository.
+//
+// Written by Jonathan De Wachter <jonathan.dewachter@byteplug.io>
+//
+#include "profiler.h"
+
+#if defined(SAMPLE_PROFILER)
+
+#include "gl_extensions.h"
+#include "timer.h"
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define PROFILER_RING_CAPACITY 65536
+#define PROFILER_MAX_DEPTH 64
+#define PROFILER_GPU_ZONES 256
+
+#ifndef GL_TIMESTAMP
+    #define GL_TIMESTAMP 0x8E28
+#endif
+#ifndef GL_QUERY_RESULT
+    #define GL_QUERY_RESULT 0x8866
+#endif
+#ifndef GL_QUERY_RESULT_AVAILABLE
+    #define GL_QUERY_RESULT_AVAILABLE 0x8867
+#endif
+#ifndef GL_GPU_DISJOINT_EXT
+    #define GL_GPU_DISJOINT_EXT 0x8FBB
+#endif
+
+typedef struct {
+    const char* name;
+    double begin;
+    double end;
+} profiler_event;
+
+typedef struct profiler_thread {
+    struct profiler_thread* next;
+    int id;
+    char name[32];
+    atomic_int retired;  // Its thread exited, so another one can take it.
+
+    // Number of events ever written; the ring holds the most recent ones.
+    atomic_uint_fast64_t head;
+    profiler_event events[PROFILER_RING_CAPACITY];
+
+    int depth;
+    const char* openNames[PROFILER_MAX_DEPTH];
+    double openBegins[PROFILER_MAX_DEPTH];
+} profiler_thread;
+
+static _Atomic(profiler_thread*) threads;
+static atomic_int nextThreadId;
+static _Thread_local profiler_thread* currentThread;
+
+static void name_thread(profiler_thread* thread, const char* name) {
+    if (name) {
+        snprintf(thread->name, sizeof(thread->name), "%s", name);
+    } else {
+        snprintf(thread->name, sizeof(thread->name), "thread %d", thread->id);
+    }
+}
+
+static profiler_thread* register_thread(const char* name) {
+    // The ring of a thread that exited is taken over (with the events it
+    // holds), so the rings are as many as the threads alive at once rather
+    // than every thread ever started.
+    for (profiler_thread* thread = atomic_load(&threads); thread; thread = thread->next) {
+        int expected = 1;
+        if (atomic_compare_exchange_strong(&thread->retired, &expected, 0)) {
+            thread->depth = 0;
+            name_thread(thread, name);
+            return thread;
+        }
+    }
+
+    profiler_thread* thread = calloc(1, sizeof(profiler_thread));
+    if (!thread) {
+        return NULL;
+    }
+
+    thread->id = atomic_fetch_add(&nextThreadId, 1);
+    name_thread(thread, name);
+
+    // Lock-free push onto the list of threads.
+    profiler_thread* head = atomic_load(&threads);
+    do {
+        thread->next = head;
+    } while (!atomic_compare_exchange_weak(&threads, &head, thread));
+
+    return thread;
+}
+
+static profiler_thread* current_thread(void) {
+    if (!currentThread) {
+        currentThread = register_thread(NULL);
+    }
+    return currentThread;
+}
+
+static void write_event(profiler_thread* thread, const char* name, double begin, double end) {
+    uint_fast64_t head = atomic_load_explicit(&thread->head, memory_order_relaxed);
+    profiler_event* event = &thread->events[head % PROFILER_RING_CAPACITY];
+    event->name = name;
+    event->begin = begin;
+    event->end = end;
+    atomic_store_explicit(&thread->head, head + 1, memory_order_release);
+}
+
+void profiler_zone_begin(const char* name) {
+    profiler_thread* thread = current_thread();
+    if (!thread) {
+        return;
+    }
+
+    // Zones nested deeper than the stack are counted but not recorded.
+    if (thread->depth < PROFILER_MAX_DEPTH) {
+        thread->openNames[thread->depth] = name;
+        thread->openBegins[thread->depth] = timer_now();
+    }
+    thread->depth++;
+}
+
+void profiler_zone_end(void) {
+    double end = timer_now();
+    profiler_thread* thread = currentThread;
+    if (!thread || thread->depth == 0) {
+        return;
+    }
+
+    thread->depth--;
+    if (thread->depth < PROFILER_MAX_DEPTH) {
+        write_event(thread, thread->openNames[thread->depth], thread->openBegins[thread->depth], end);
+    }
+}
+
+void profiler_thread_exit(void) {
+    if (currentThread) {
+        atomic_store(&currentThread->retired, 1);
+        currentThread = NULL;
+    }
+}
+
+void profiler_thread_name(const char* name) {
+    profiler_thread* thread = current_thread();
+    if (thread) {
+        snprintf(thread->name, sizeof(thread->name), "%s", name);
+    }
+}
+
+// GPU timestamps.
+
+typedef void (SAMPLE_GL_APIENTRY *gen_queries_proc)(GLsizei n, GLuint* ids);
+typedef void (SAMPLE_GL_APIENTRY *delete_queries_proc)(GLsizei n, const GLuint* ids);
+typedef void (SAMPLE_GL_APIENTRY *query_counter_proc)(GLuint id, GLenum target);
+typedef void (SAMPLE_GL_APIENTRY *get_query_objectiv_proc)(GLuint id, GLenum pname, GLint* params);
+typedef void (SAMPLE_GL_APIENTRY *get_query_objectui64v_proc)(GLuint id, GLenum pname, uint64_t* params);
+typedef void (SAMPLE_GL_APIENTRY *get_integer64v_proc)(GLenum pname, int64_t* data);
+
+static struct {
+    int ready;
+    gen_queries_proc genQueries;
+    delete_queries_proc deleteQueries;
+    query_counter_proc queryCounter;
+    get_query_objectiv_proc getQueryObjectiv;
+    get_query_objectui64v_proc getQueryObjectui64v;
+    get_integer64v_proc getInteger64v;
+
+    // Maps GPU timestamps (nanoseconds) to the timer_now() timeline.
+    double offset;
+
+    // Pairs of begin/end queries, used as a ring from tail to head.
+    GLuint queries[PROFILER_GPU_ZONES * 2];
+    const char* names[PROFILER_GPU_ZONES];
+    int closed[PROFILER_GPU_ZONES];
+    unsigned head;
+    unsigned tail;
+
+    int depth;
+    int open[PROFILER_MAX_DEPTH];
+
+    profiler_thread* timeline;
+} gpu;
+
+static void calibrate_gpu(void) {
+    // GL_TIMESTAMP read with glGetInteger64v is the time at which all the
+    // previous commands have reached the GPU, without waiting for them.
+    int64_t gpuNow = 0;
+    gpu.getInteger64v(GL_TIMESTAMP, &gpuNow);
+    double cpuNow = timer_now();
+    gpu.offset = cpuNow - (double)gpuNow * 1e-9;
+}
+
+int profiler_gpu_init(void) {
+    #if SAMPLE_OPENGL_API == SAMPLE_API_GL
+        const char* suffix = "";
+    #else
+        if (!gl_has_extension("GL_EXT_disjoint_timer_query")) {
+            fprintf(stderr, "GL_EXT_disjoint_timer_query is not available; GPU zones are disabled\n");
+            return -1;
+        }
+        const char* suffix = "EXT";
+    #endif
+
+    char name[64];
+    snprintf(name, sizeof(name), "glGenQueries%s", suffix);
+    gpu.genQueries = (gen_queries_proc)gl_get_proc_address(name);
+    snprintf(name, sizeof(name), "glDeleteQueries%s", suffix);
+    gpu.deleteQueries = (delete_queries_proc)gl_get_proc_address(name);
+    snprintf(name, sizeof(name), "glQueryCounter%s", suffix);
+    gpu.queryCounter = (query_counter_proc)gl_get_proc_address(name);
+    snprintf(name, sizeof(name), "glGetQueryObjectiv%s", suffix);
+    gpu.getQueryObjectiv = (get_query_objectiv_proc)gl_get_proc_address(name);
+    snprintf(name, sizeof(name), "glGetQueryObjectui64v%s", suffix);
+    gpu.getQueryObjectui64v = (get_query_objectui64v_proc)gl_get_proc_address(name);
+
+    // Core since OpenGL 3.2 and OpenGL ES 3.0; the extension only adds the
+    // EXT variant for OpenGL ES 2.0.
+    gpu.getInteger64v = (get_integer64v_proc)gl_get_proc_address("glGetInteger64v");
+    if (!gpu.getInteger64v) {
+        gpu.getInteger64v = (get_integer64v_proc)gl_get_proc_address("glGetInteger64vEXT");
+    }
+
+    if (!gpu.genQueries || !gpu.deleteQueries || !gpu.queryCounter ||
+        !gpu.getQueryObjectiv || !gpu.getQueryObjectui64v || !gpu.getInteger64v) {
+        fprintf(stderr, "Failed to load the timer query entry points; GPU zones are disabled\n");
+        return -1;
+    }
+
+    gpu.genQueries(PROFILER_GPU_ZONES * 2, gpu.queries);
+    gpu.head = 0;
+    gpu.tail = 0;
+    gpu.depth = 0;
+
+    gpu.timeline = register_thread("GPU");
+    if (!gpu.timeline) {
+        gpu.deleteQueries(PROFILER_GPU_ZONES * 2, gpu.queries);
+        return -1;
+    }
+
+    calibrate_gpu();
+    gpu.ready = 1;
+
+    return 0;
+}
+
+void profiler_gpu_zone_begin(const char* name) {
+    int zone = -1;
+    if (gpu.ready && gpu.head - gpu.tail < PROFILER_GPU_ZONES) {
+        zone = (int)(gpu.head++ % PROFILER_GPU_ZONES);
+        gpu.names[zone] = name;
+        gpu.closed[zone] = 0;
+        gpu.queryCounter(gpu.queries[zone * 2], GL_TIMESTAMP);
+    }
+
+    // Zones dropped because the ring is full are still pushed, so the
+    // matching end is ignored.
+    if (gpu.depth < PROFILER_MAX_DEPTH) {
+        gpu.open[gpu.depth] = zone;
+    }
+    gpu.depth++;
+}
+
+void profiler_gpu_zone_end(void) {
+    if (gpu.depth == 0) {
+        return;
+    }
+
+    gpu.depth--;
+    if (gpu.depth < PROFILER_MAX_DEPTH && gpu.open[gpu.depth] >= 0) {
+        int zone = gpu.open[gpu.depth];
+        gpu.queryCounter(gpu.queries[zone * 2 + 1], GL_TIMESTAMP);
+        gpu.closed[zone] = 1;
+    }
+}
+
+void profiler_gpu_collect(void) {
+    if (!gpu.ready) {
+        return;
+    }
+
+    // A disjoint event (frequency change, context switch, ...) invalidates
+    // the timestamps of every query in flight.
+    #if SAMPLE_OPENGL_API == SAMPLE_API_GLES
+        GLint disjoint = 0;
+        glGetIntegerv(GL_GPU_DISJOINT_EXT, &disjoint);
+    #else
+        GLint disjoint = 0;
+    #endif
+
+    // Zones complete in order, so stop at the first one not yet available.
+    while (gpu.tail != gpu.head) {
+        int zone = (int)(gpu.tail % PROFILER_GPU_ZONES);
+        if (!gpu.closed[zone]) {
+            break;
+        }
+
+        GLint available = 0;
+        gpu.getQueryObjectiv(gpu.queries[zone * 2 + 1], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available) {
+            break;
+        }
+
+        uint64_t begin = 0, end = 0;
+        gpu.getQueryObjectui64v(gpu.queries[zone * 2], GL_QUERY_RESULT, &begin);
+        gpu.getQueryObjectui64v(gpu.queries[zone * 2 + 1], GL_QUERY_RESULT, &end);
+        gpu.tail++;
+
+        if (!disjoint) {
+            write_event(gpu.timeline, gpu.names[zone],
+                (double)begin * 1e-9 + gpu.offset,
+                (double)end * 1e-9 + gpu.offset);
+        }
+    }
+
+    if (disjoint) {
+        calibrate_gpu();
+    }
+}
+
+void profiler_gpu_shutdown(void) {
+    if (gpu.ready) {
+        gpu.deleteQueries(PROFILER_GPU_ZONES * 2, gpu.queries);
+        gpu.ready = 0;
+    }
+}
+
+// Trace export.
+
+static void write_json_string(FILE* file, const char* value) {
+    fputc('"', file);
+    for (const char* c = value; *c; c++) {
+        if (*c == '"' || *c == '\\') {
+            fputc('\\', file);
+        }
+        fputc(*c, file);
+    }
+    fputc('"', file);
+}
+
+int profiler_write_trace(const char* path) {
+    FILE* file = fopen(path, "w");
+    if (!file) {
+        fprintf(stderr, "Failed to open trace file '%s'\n", path);
+        return -1;
+    }
+
+    // Timestamps are written in microseconds relative to the earliest event.
+    double origin = -1.0;
+    for (profiler_thread* thread = atomic_load(&threads); thread; thread = thread->next) {
+        uint_fast64_t head = atomic_load_explicit(&thread->head, memory_order_acquire);
+        uint_fast64_t first = head > PROFILER_RING_CAPACITY ? head - PROFILER_RING_CAPACITY : 0;
+        for (uint_fast64_t i = first; i < head; i++) {
+            double begin = thread->events[i % PROFILER_RING_CAPACITY].begin;
+            if (origin < 0.0 || begin < origin) {
+                origin = begin;
+            }
+        }
+    }
+
+    int separator = 0;
+    fputs("{\"traceEvents\":[\n", file);
+    for (profiler_thread* thread = atomic_load(&threads); thread; thread = thread->next) {
+        fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":",
+            separator ? ",\n" : "", thread->id);
+        write_json_string(file, thread->name);
+        fputs("}}", file);
+        separator = 1;
+
+        uint_fast64_t head = atomic_load_explicit(&thread->head, memory_order_acquire);
+        uint_fast64_t first = head > PROFILER_RING_CAPACITY ? head - PROFILER_RING_CAPACITY : 0;
+        for (uint_fast64_t i = first; i < head; i++) {
+            const profiler_event* event = &thread->events[i % PROFILER_RING_CAPACITY];
+            fputs(",\n{\"name\":", file);
+            write_json_string(file, event->name);
+            fprintf(file, ",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+                thread->id,
+                (event->begin - origin) * 1e6,
+                (event->end - event->begin) * 1e6);
+        }
+    }
+    fputs("\n]}\n", file);
+
+    fclose(file);
+    return 0;
+}
+
+#endif // SAMPLE_PROFILER
@@ -0,0 +1,71 @@
+//
+// Copyright (c) 2025, Byteplug LLC.
+//
+// This source file is part of a project made by the Erlangsters community and
+// is released under the MIT license. Please refer to the LICENSE.md file that
+// can be found at the root of the project repository.
+//
+// Written by Jonathan De Wachter <jonathan.dewachter@byteplug.io>
+//
+#ifndef PROFILER_H
+#define PROFILER_H
+
+// Scoped CPU and GPU instrumentation zones, exported as a Chrome trace_event
+// JSON file (open it with chrome://tracing or https://ui.perfetto.dev).
+//
+// The profiler is compiled in when SAMPLE_PROFILER is defined (the default,
+// see the CMake option of the same name); otherwise every macro below expands
+// to nothing.
+//
+// CPU zones are recorded into a per-thread ring buffer that only its own
+// thread writes to, so recording takes no lock; a zone costs two clock reads
+// and one event write. When a ring wraps, the oldest events are overwritten.
+// Zones must be closed in the reverse order they were opened, and their names
+// must be string literals (only the pointer is stored). The ring of a thread
+// started with thread_create() is handed to the next thread once it exits, so
+// a row of the trace can hold the zones of several short-lived threads.
+//
+// GPU zones use timestamp queries (core in OpenGL 3.3, GL_EXT_disjoint_timer_query
+// on OpenGL ES) and belong to the context that was current when
+// profiler_gpu_init() was called. Results are read back without stalling by
+// profiler_gpu_collect(), typically once per frame after the swap.
+
+#if defined(SAMPLE_PROFILER)
+    #define PROFILE_ZONE_BEGIN(name) profiler_zone_begin(name)
+    #define PROFILE_ZONE_END() profiler_zone_end()
+    #define PROFILE_GPU_ZONE_BEGIN(name) profiler_gpu_zone_begin(name)
+    #define PROFILE_GPU_ZONE_END() profiler_gpu_zone_end()
+    #define PROFILE_THREAD_NAME(name) profiler_thread_name(name)
+
+    void profiler_zone_begin(const char* name);
+    void profiler_zone_end(void);
+    void profiler_thread_name(const char* name);
+
+    // Give the ring of the calling thread back, when it is about to exit.
+    void profiler_thread_exit(void);
+
+    // Returns 0 when GPU timestamps are available on the current context.
+    int profiler_gpu_init(void);
+    void profiler_gpu_zone_begin(const char* name);
+    void profiler_gpu_zone_end(void);
+    void profiler_gpu_collect(void);
+    void profiler_gpu_shutdown(void);
+
+    // Write every recorded zone to a trace file. Other threads should have
+    // stopped recording by then.
+    int profiler_write_trace(const char* path);
+#else
+    #define PROFILE_ZONE_BEGIN(name) ((void)0)
+    #define PROFILE_ZONE_END() ((void)0)
+    #define PROFILE_GPU_ZONE_BEGIN(name) ((void)0)
+    #define PROFILE_GPU_ZONE_END() ((void)0)
+    #define PROFILE_THREAD_NAME(name) ((void)0)
+
+    #define profiler_thread_exit() ((void)0)
+    static inline int profiler_gpu_init(void) { return -1; }
+    #define profiler_gpu_collect() ((void)0)
+    #define profiler_gpu_shutdown() ((void)0)
+    static inline int profiler_write_trace(const char* path) { (void)path; return -1; }
+#endif
+
+#endif // PROFILER_H
@@ -0,0 +1,370 @@
+//
+// Copyright (c) 2025, Byteplug LLC.
+//
+// This source file is part of a project made by the Erlangsters community and
+// is released under the MIT license. Please refer to the LICENSE.md file that
+// can be found at the root of the project repository.
+//
+// Written by Jonathan De Wachter <jonathan.dewachter@byteplug.io>
+//
+#include "render_graph.h"
+#include <stdio.h>
+#include <string.h>
+#include "gl_debug.h"
+#include "gl_extensions.h"
+#include "gpu_memory.h"
+
+// Attachments of the default framebuffer, for glInvalidateFramebuffer()
+// (GL_COLOR_EXT, GL_DEPTH_EXT and GL_STENCIL_EXT of the OpenGL ES 2.0
+// extension have the same values).
+#define DEFAULT_COLOR 0x1800
+#define DEFAULT_DEPTH 0x1801
+#define DEFAULT_STENCIL 0x1802
+
+#if SAMPLE_OPENGL_API == SAMPLE_API_GL || SAMPLE_OPENGL_VERSION_MAJOR >= 3
+    #define DEPTH_FORMAT GL_DEPTH_COMPONENT24
+    #define DEPTH_BYTES 4
+#else
+    #define DEPTH_FORMAT GL_DEPTH_COMPONENT16
+    #define DEPTH_BYTES 2
+#endif
+
+typedef void (SAMPLE_GL_APIENTRY *invalidate_framebuffer_func)(GLenum target, GLsizei count, const GLenum* attachments);
+
+// -1 until the entry point was looked up.
+static int canInvalidate = -1;
+static invalidate_framebuffer_func invalidateFramebuffer = NULL;
+
+// glInvalidateFramebuffer() is core in OpenGL ES 3.0 and OpenGL 4.3; the
+// older versions may have it as an extension.
+static void detectInvalidate(void) {
+    #if (SAMPLE_OPENGL_API == SAMPLE_API_GLES && SAMPLE_OPENGL_VERSION_MAJOR >= 3) || defined(OPENGL_VERSION_46)
+        invalidateFramebuffer = glInvalidateFramebuffer;
+    #elif SAMPLE_OPENGL_API == SAMPLE_API_GL
+        if (gl_has_extension("GL_ARB_invalidate_subdata")) {
+            invalidateFramebuffer = (invalidate_framebuffer_func)gl_get_proc_address("glInvalidateFramebuffer");
+        }
+    #else
+        if (gl_has_extension("GL_EXT_discard_framebuffer")) {
+            invalidateFramebuffer = (invalidate_framebuffer_func)gl_get_proc_address("glDiscardFramebufferEXT");
+        }
+    #endif
+    canInvalidate = invalidateFramebuffer != NULL;
+}
+
+int render_graph_can_invalidate(void) {
+    if (canInvalidate < 0) {
+        detectInvalidate();
+    }
+    return canInvalidate;
+}
+
+void render_graph_init(render_graph* graph, int width, int height) {
+    memset(graph, 0, sizeof(render_graph));
+    graph->width = width;
+    graph->height = height;
+}
+
+static void deleteFramebuffers(render_graph* graph) {
+    for (int i = 0; i < graph->passCount; i++) {
+        if (graph->passes[i].framebuffer) {
+            glDeleteFramebuffers(1, &graph->passes[i].framebuffer);
+            graph->passes[i].framebuffer = 0;
+        }
+    }
+}
+
+static void deleteEntry(render_pool_entry* entry) {
+    if (entry->isDepth) {
+        gpu_memory_untrack(GPU_MEMORY_RENDERBUFFER, entry->name);
+        glDeleteRenderbuffers(1, &entry->name);
+    } else {
+        gpu_memory_untrack(GPU_MEMORY_TEXTURE, entry->name);
+        glDeleteTextures(1, &entry->name);
+    }
+}
+
+void render_graph_destroy(render_graph* graph) {
+    deleteFramebuffers(graph);
+    for (int i = 0; i < graph->poolCount; i++) {
+        deleteEntry(&graph->pool[i]);
+    }
+    memset(graph, 0, sizeof(render_graph));
+}
+
+void render_graph_reset(render_graph* graph, int width, int height) {
+    deleteFramebuffers(graph);
+    graph->width = width;
+    graph->height = height;
+    graph->targetCount = 0;
+    graph->passCount = 0;
+}
+
+int render_graph_target(render_graph* graph, const render_target_desc* desc) {
+    if (graph->targetCount == RENDER_GRAPH_MAX_TARGETS) {
+        return -1;
+    }
+    render_target* target = &graph->targets[graph->targetCount];
+    memset(target, 0, sizeof(render_target));
+    target->desc = *desc;
+    return graph->targetCount++;
+}
+
+int render_graph_pass(render_graph* graph, const char* name, int output, const int* inputs, int inputCount,
+                      render_pass_func execute, void* data) {
+    if (graph->passCount == RENDER_GRAPH_MAX_PASSES || inputCount > RENDER_GRAPH_MAX_INPUTS) {
+        return -1;
+    }
+    render_pass* pass = &graph->passes[graph->passCount];
+    memset(pass, 0, sizeof(render_pass));
+    pass->name = name;
+    pass->output = output;
+    for (int i = 0; i < inputCount; i++) {
+        pass->inputs[i] = inputs[i];
+    }
+    pass->inputCount = inputCount;
+    pass->execute = execute;
+    pass->data = data;
+    return graph->passCount++;
+}
+
+static size_t entrySize(int isDepth, const render_target_desc* desc) {
+    if (isDepth) {
+        return (size_t)desc->width * (size_t)desc->height * DEPTH_BYTES;
+    }
+    return gpu_memory_texture_size(desc->format, desc->type, desc->width, desc->height, 1, 1);
+}
+
+// Find an entry of the pool for a target (or its depth buffer) used from
+// pass first to pass last: one left over from a previous compilation, or,
+// when aliasing, one whose last user runs before first. Otherwise a new one
+// is created. Returns -1 when the pool is full.
+static int acquire(render_graph* graph, int* taken, int isDepth, const render_target_desc* desc, int first, int last) {
+    for (int i = 0; i < graph->poolCount; i++) {
+        render_pool_entry* entry = &graph->pool[i];
+        if (entry->isDepth != isDepth || entry->width != desc->width || entry->height != desc->height) {
+            continue;
+        }
+        if (!isDepth && (entry->internalFormat != desc->internalFormat || entry->format != desc->format ||
+                         entry->type != desc->type)) {
+            continue;
+        }
+        if (!taken[i] || ((graph->flags & RENDER_GRAPH_ALIAS) && entry->freeAfter < first)) {
+            taken[i] = 1;
+            entry->freeAfter = last;
+            return i;
+        }
+    }
+
+    if (graph->poolCount == RENDER_GRAPH_MAX_TARGETS * 2) {
+        return -1;
+    }
+    int index = graph->poolCount++;
+    render_pool_entry* entry = &graph->pool[index];
+    entry->isDepth = isDepth;
+    entry->width = desc->width;
+    entry->height = desc->height;
+    entry->internalFormat = desc->internalFormat;
+    entry->format = desc->format;
+    entry->type = desc->type;
+    entry->bytes = entrySize(isDepth, desc);
+    entry->freeAfter = last;
+    taken[index] = 1;
+
+    char label[64];
+    snprintf(label, sizeof(label), "Render target %dx%d%s", desc->width, desc->height, isDepth ? " (depth)" : "");
+    if (isDepth) {
+        glGenRenderbuffers(1, &entry->name);
+        glBindRenderbuffer(GL_RENDERBUFFER, entry->name);
+        GL_CHECK(glRenderbufferStorage(GL_RENDERBUFFER, DEPTH_FORMAT, desc->width, desc->height));
+        glBindRenderbuffer(GL_RENDERBUFFER, 0);
+        gpu_memory_track(GPU_MEMORY_RENDERBUFFER, entry->name, entry->bytes);
+        gl_debug_label(GL_RENDERBUFFER, entry->name, label);
+    } else {
+        glGenTextures(1, &entry->name);
+        glBindTexture(GL_TEXTURE_2D, entry->name);
+        GL_CHECK(glTexImage2D(GL_TEXTURE_2D, 0, (GLint)desc->internalFormat, desc->width, desc->height, 0,
+            desc->format, desc->type, NULL));
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glBindTexture(GL_TEXTURE_2D, 0);
+        gpu_memory_track(GPU_MEMORY_TEXTURE, entry->name, entry->bytes);
+        gl_debug_label(GL_TEXTURE, entry->name, label);
+    }
+    return index;
+}
+
+// Delete the entries the compiled graph does not use, and move the others
+// down.
+static void trimPool(render_graph* graph, const int* taken) {
+    int remap[RENDER_GRAPH_MAX_TARGETS * 2];
+    int count = 0;
+    for (int i = 0; i < graph->poolCount; i++) {
+        if (taken[i]) {
+            remap[i] = count;
+            graph->pool[count++] = graph->pool[i];
+        } else {
+            deleteEntry(&graph->pool[i]);
+            remap[i] = -1;
+        }
+    }
+    graph->poolCount = count;
+
+    for (int i = 0; i < graph->targetCount; i++) {
+        render_target* target = &graph->targets[i];
+        if (target->texture >= 0) {
+            target->texture = remap[target->texture];
+        }
+        if (target->depth >= 0) {
+            target->depth = remap[target->depth];
+        }
+    }
+}
+
+static void use(render_graph* graph, int target, int pass) {
+    render_target* t = &graph->targets[target];
+    if (t->firstPass < 0) {
+        t->firstPass = pass;
+    }
+    t->lastPass = pass;
+}
+
+int render_graph_compile(render_graph* graph, int flags) {
+    if (canInvalidate < 0) {
+        detectInvalidate();
+    }
+    graph->flags = flags;
+    deleteFramebuffers(graph);
+
+    // The life of every target, and of its depth buffer (which only its
+    // writers use, from the first to the last).
+    for (int i = 0; i < graph->targetCount; i++) {
+        graph->targets[i].firstPass = -1;
+        graph->targets[i].lastPass = -1;
+        graph->targets[i].firstWrite = -1;
+        graph->targets[i].lastWrite = -1;
+        graph->targets[i].texture = -1;
+        graph->targets[i].depth = -1;
+    }
+    graph->backbufferFirstWrite = -1;
+    for (int p = 0; p < graph->passCount; p++) {
+        const render_pass* pass = &graph->passes[p];
+        for (int i = 0; i < pass->inputCount; i++) {
+            use(graph, pass->inputs[i], p);
+        }
+        if (pass->output >= 0) {
+            render_target* target = &graph->targets[pass->output];
+            use(graph, pass->output, p);
+            if (target->firstWrite < 0) {
+                target->firstWrite = p;
+            }
+            target->lastWrite = p;
+        } else if (graph->backbufferFirstWrite < 0) {
+            graph->backbufferFirstWrite = p;
+        }
+    }
+
+    // Hand out the pool in the order the targets come to life, so a target
+    // gets the entry of one that died before it.
+    int taken[RENDER_GRAPH_MAX_TARGETS * 2] = { 0 };
+    graph->declaredBytes = 0;
+    for (int p = 0; p < graph->passCount; p++) {
+        for (int i = 0; i < graph->targetCount; i++) {
+            render_target* target = &graph->targets[i];
+            if (target->firstPass != p) {
+                continue;
+            }
+            target->texture = acquire(graph, taken, 0, &target->desc, target->firstPass, target->lastPass);
+            graph->declaredBytes += entrySize(0, &target->desc);
+            if (target->desc.depth && target->firstWrite >= 0) {
+                target->depth = acquire(graph, taken, 1, &target->desc, target->firstWrite, target->lastWrite);
+                graph->declaredBytes += entrySize(1, &target->desc);
+            }
+            if (target->texture < 0 || (target->desc.depth && target->firstWrite >= 0 && target->depth < 0)) {
+                fprintf(stderr, "The render target pool is full\n");
+                return -1;
+            }
+        }
+    }
+    trimPool(graph, taken);
+
+    graph->textureCount = graph->poolCount;
+    graph->bytes = 0;
+    for (int i = 0; i < graph->poolCount; i++) {
+        graph->bytes += graph->pool[i].bytes;
+    }
+
+    for (int p = 0; p < graph->passCount; p++) {
+        render_pass* pass = &graph->passes[p];
+        if (pass->output < 0) {
+            continue;
+        }
+        const render_target* target = &graph->targets[pass->output];
+        glGenFramebuffers(1, &pass->framebuffer);
+        glBindFramebuffer(GL_FRAMEBUFFER, pass->framebuffer);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, graph->pool[target->texture].name, 0);
+        if (target->depth >= 0) {
+            glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, graph->pool[target->depth].name);
+        }
+        GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        if (status != GL_FRAMEBUFFER_COMPLETE) {
+            fprintf(stderr, "The framebuffer of the %s pass is incomplete (0x%04X)\n", pass->name, status);
+            return -1;
+        }
+        gl_debug_label(GL_FRAMEBUFFER, pass->framebuffer, pass->name);
+    }
+
+    return 0;
+}
+
+GLuint render_graph_texture(const render_graph* graph, int target) {
+    int entry = graph->targets[target].texture;
+    return entry >= 0 ? graph->pool[entry].name : 0;
+}
+
+void render_graph_execute(render_graph* graph) {
+    int invalidate = (graph->flags & RENDER_GRAPH_INVALIDATE) && invalidateFramebuffer;
+    for (int p = 0; p < graph->passCount; p++) {
+        const render_pass* pass = &graph->passes[p];
+        const render_target* target = pass->output >= 0 ? &graph->targets[pass->output] : NULL;
+        gl_debug_push_group(pass->name);
+
+        glBindFramebuffer(GL_FRAMEBUFFER, pass->framebuffer);
+        if (target) {
+            glViewport(0, 0, target->desc.width, target->desc.height);
+        } else {
+            glViewport(0, 0, graph->width, graph->height);
+        }
+        // Only the first writer overwrites the whole output; the next ones
+        // draw over it.
+        int firstWrite = target ? target->firstWrite == p : graph->backbufferFirstWrite == p;
+        if (invalidate && firstWrite) {
+            static const GLenum targetAttachments[2] = { GL_COLOR_ATTACHMENT0, GL_DEPTH_ATTACHMENT };
+            static const GLenum defaultAttachments[3] = { DEFAULT_COLOR, DEFAULT_DEPTH, DEFAULT_STENCIL };
+            if (target) {
+                invalidateFramebuffer(GL_FRAMEBUFFER, target->depth >= 0 ? 2 : 1, targetAttachments);
+            } else {
+                invalidateFramebuffer(GL_FRAMEBUFFER, 3, defaultAttachments);
+            }
+        }
+
+        for (int i = 0; i < pass->inputCount; i++) {
+            glActiveTexture(GL_TEXTURE0 + i);
+            glBindTexture(GL_TEXTURE_2D, render_graph_texture(graph, pass->inputs[i]));
+        }
+        glActiveTexture(GL_TEXTURE0);
+
+        pass->execute(pass->data);
+
+        // Nothing reads a depth buffer once its last writer is done.
+        if (invalidate && target && target->depth >= 0 && target->lastWrite == p) {
+            static const GLenum depthAttachment = GL_DEPTH_ATTACHMENT;
+            invalidateFramebuffer(GL_FRAMEBUFFER, 1, &depthAttachment);
+        }
+        gl_debug_pop_group();
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
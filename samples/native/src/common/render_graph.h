@@ -0,0 +1,147 @@
+//
+// Copyright (c) 2025, Byteplug LLC.
+//
+// This source file is part of a project made by the Erlangsters community and
+// is released under the MIT license. Please refer to the LICENSE.md file that
+// can be found at the root of the project repository.
+//
+// Written by Jonathan De Wachter <jonathan.dewachter@byteplug.io>
+//
+#ifndef RENDER_GRAPH_H
+#define RENDER_GRAPH_H
+
+#include <stddef.h>
+#include "gl_api.h"
+
+// A small render graph, for chains of full-screen passes.
+//
+// Render targets and the passes reading and writing them are declared, then
+// the graph is compiled: every target lives from the first to the last pass
+// using it, and targets of the same size and format whose lives do not
+// overlap share a texture (they alias). Textures and depth buffers come from
+// a pool kept by the graph across compilations, so compiling the graph again
+// (after a resize, or to change the chain) only creates what is missing and
+// deletes what is no longer used.
+//
+// The first pass writing a target overwrites all of it (or clears it first),
+// so before it runs, the driver is told that the previous contents of the
+// target can be thrown away; later passes writing the same target draw over
+// what the previous ones left. The depth buffer is thrown away once the last
+// writer is done (glInvalidateFramebuffer, or glDiscardFramebufferEXT on
+// OpenGL ES 2.0). Tiled GPUs then neither load
+// the tiles from memory at the start of a pass nor store the depth at its
+// end.
+#define RENDER_GRAPH_MAX_TARGETS 32
+#define RENDER_GRAPH_MAX_PASSES 32
+#define RENDER_GRAPH_MAX_INPUTS 4
+
+// The default framebuffer, as the output of a pass.
+#define RENDER_GRAPH_BACKBUFFER -1
+
+// Compilation flags.
+#define RENDER_GRAPH_ALIAS 1
+#define RENDER_GRAPH_INVALIDATE 2
+
+typedef struct {
+    const char* name;
+    int width;
+    int height;
+    // As given to glTexImage2D() (the internal format is the format on
+    // OpenGL ES 2.0).
+    GLenum internalFormat;
+    GLenum format;
+    GLenum type;
+    int depth;  // Whether the pass writing it gets a depth buffer.
+} render_target_desc;
+
+// Called with the output bound and its inputs bound to the texture units 0,
+// 1, ... in the order they were declared.
+typedef void (*render_pass_func)(void* data);
+
+typedef struct {
+    const char* name;
+    int output;
+    int inputs[RENDER_GRAPH_MAX_INPUTS];
+    int inputCount;
+    render_pass_func execute;
+    void* data;
+    GLuint framebuffer;
+} render_pass;
+
+typedef struct {
+    render_target_desc desc;
+    int firstPass;   // -1 when no pass uses it.
+    int lastPass;
+    int firstWrite;  // First pass writing it.
+    int lastWrite;   // Last pass writing it.
+    int texture;     // Index in the pool.
+    int depth;       // Index in the pool of its depth buffer, or -1.
+} render_target;
+
+// A texture, or a depth renderbuffer, of the pool.
+typedef struct {
+    int isDepth;
+    int width;
+    int height;
+    GLenum internalFormat;
+    GLenum format;
+    GLenum type;
+    GLuint name;
+    size_t bytes;
+    int freeAfter;  // Last pass using it in the compiled graph, -1 if unused.
+} render_pool_entry;
+
+typedef struct {
+    int width;  // Size of the default framebuffer.
+    int height;
+    int flags;
+
+    render_target targets[RENDER_GRAPH_MAX_TARGETS];
+    int targetCount;
+    render_pass passes[RENDER_GRAPH_MAX_PASSES];
+    int passCount;
+
+    render_pool_entry pool[RENDER_GRAPH_MAX_TARGETS * 2];
+    int poolCount;
+
+    // Filled by render_graph_compile().
+    int textureCount;      // Textures and depth buffers used.
+    size_t bytes;          // Their size.
+    size_t declaredBytes;  // The size they would have without aliasing.
+    int backbufferFirstWrite;
+} render_graph;
+
+// The default framebuffer is width x height.
+void render_graph_init(render_graph* graph, int width, int height);
+
+// Delete the pool and the framebuffers.
+void render_graph_destroy(render_graph* graph);
+
+// Forget the targets and passes (the pool is kept), to declare them again.
+void render_graph_reset(render_graph* graph, int width, int height);
+
+// Declare a target. Returns its index, or -1 when there are too many.
+int render_graph_target(render_graph* graph, const render_target_desc* desc);
+
+// Declare a pass writing output (a target, or RENDER_GRAPH_BACKBUFFER) and
+// reading inputs. Passes run in the order they are declared. Returns its
+// index, or -1 when there are too many.
+int render_graph_pass(render_graph* graph, const char* name, int output, const int* inputs, int inputCount,
+                      render_pass_func execute, void* data);
+
+// Assign the textures and create the framebuffers, with RENDER_GRAPH_ALIAS
+// and RENDER_GRAPH_INVALIDATE as flags. Returns -1 when a framebuffer is
+// incomplete.
+int render_graph_compile(render_graph* graph, int flags);
+
+// Run the passes.
+void render_graph_execute(render_graph* graph);
+
+// The texture of a target in the compiled graph.
+GLuint render_graph_texture(const render_graph* graph, int target);
+
+// Whether the driver can discard the contents of framebuffers (needs a
+// current context).
+int render_graph_can_invalidate(void);
+
+#endif // RENDER_GRAPH_H
@@ -0,0 +1,166 @@
+//
+// Copyright (c) 2025, Byteplug LLC.
+//
+// This source file is part of a project made by the Erlangsters community and
+// is released under the MIT license. Please refer to the LICENSE.md file that
+// can be found at the root of the project repository.
+//
+// Written by Jonathan De Wachter <jonathan.dewachter@byteplug.io>
+//
+#include "report.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+#define REPORT_MAX_DEPTH 32
+
+struct report {
+    FILE* file;
+    int depth;
+    int hasItems[REPORT_MAX_DEPTH];
+};
+
+static void write_string(FILE* file, const char* value) {
+    fputc('"', file);
+    for (const char* c = value; *c; c++) {
+        switch (*c) {
+            case '"': fputs("\\\"", file); break;
+            case '\\': fputs("\\\\", file); break;
+            case '\n': fputs("\\n", file); break;
+            case '\t': fputs("\\t", file); break;
+            default:
+                if ((unsigned char)*c < 0x20) {
+                    fprintf(file, "\\u%04x", (unsigned char)*c);
+                } else {
+                    fputc(*c, file);
+                }
+        }
+    }
+    fputc('"', file);
+}
+
+static void write_prefix(report* report, const char* key) {
+    if (report->hasItems[report->depth]) {
+        fputc(',', report->file);
+    }
+    report->hasItems[report->depth] = 1;
+
+    fputc('\n', report->file);
+    for (int i = 0; i <= report->depth; i++) {
+        fputs("  ", report->file);
+    }
+
+    if (key) {
+        write_string(report->file, key);
+        fputs(": ", report->file);
+    }
+}
+
+static void open_scope(report* report, const char* key, char bracket) {
+    write_prefix(report, key);
+    fputc(bracket, report->file);
+
+    if (report->depth + 1 < REPORT_MAX_DEPTH) {
+        report->depth++;
+        report->hasItems[report->depth] = 0;
+    }
+}
+
+static void close_scope(report* report, char bracket) {
+    int hadItems = report->hasItems[report->depth];
+    if (report->depth > 0) {
+        report->depth--;
+    }
+
+    if (hadItems) {
+        fputc('\n', report->file);
+        for (int i = 0; i <= report->depth; i++) {
+            fputs("  ", report->file);
+        }
+    }
+    fputc(bracket, report->file);
+}
+
+report* report_open(const char* path) {
+    if (!path) {
+        return NULL;
+    }
+
+    FILE* file = fopen(path, "w");
+    if (!file) {
+        fprintf(stderr, "Failed to open report file '%s'\n", path);
+        return NULL;
+    }
+
+    report* result = calloc(1, sizeof(report));
+    if (!result) {
+        fclose(file);
+        return NULL;
+    }
+
+    result->file = file;
+    fputc('{', file);
+
+    return result;
+}
+
+void report_close(report* report) {
+    if (!report) {
+        return;
+    }
+
+    while (report->depth > 0) {
+        close_scope(report, '}');
+    }
+    if (report->hasItems[0]) {
+        fputc('\n', report->file);
+    }
+    fputs("}\n", report->file);
+
+    fclose(report->file);
+    free(report);
+}
+
+void report_begin_object(report* report, const char* key) {
+    if (report) {
+        open_scope(report, key, '{');
+    }
+}
+
+void report_end_object(report* report) {
+    if (report) {
+        close_scope(report, '}');
+    }
+}
+
+void report_begin_array(report* report, const char* key) {
+    if (report) {
+        open_scope(report, key, '[');
+    }
+}
+
+void report_end_array(report* report) {
+    if (report) {
+        close_scope(report, ']');
+    }
+}
+
+void report_number(report* report, const char* key, double value) {
+    if (report) {
+        write_prefix(report, key);
+        fprintf(report->file, "%.6g", value);
+    }
+}
+
+void report_integer(report* report, const char* key, long long value) {
+    if (report) {
+        write_prefix(report, key);
+        fprintf(report->file, "%lld", value);
+    }
+}
+
+void report_string(report* report, const char* key, const char* value) {
+    if (report) {
+        write_prefix(report, key);
+        write_string(report->file, value ? value : "");
+    }
+}
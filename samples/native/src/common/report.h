@@ -0,0 +1,33 @@
+//
+// Copyright (c) 2025, Byteplug LLC.
+//
+// This source file is part of a project made by the Erlangsters community and
+// is released under the MIT license. Please refer to the LICENSE.md file that
+// can be found at the root of the project repository.
+//
+// Written by Jonathan De Wachter <jonathan.dewachter@byteplug.io>
+//
+#ifndef REPORT_H
+#define REPORT_H
+
+// Streaming JSON writer for the benchmark results of the samples. The root
+// object is opened by report_open() and closed by report_close(). Keys are
+// required inside objects and must be NULL inside arrays.
+//
+// All functions accept a NULL report and do nothing, so the samples can call
+// them unconditionally whether or not a report file was requested.
+typedef struct report report;
+
+report* report_open(const char* path);
+void report_close(report* report);
+
+void report_begin_object(report* report, const char* key);
+void report_end_object(report* report);
+void report_begin_array(report* report, const char* key);
+void report_end_array(report* report);
+
+void report_number(report* report, const char* key, double value);
+void report_integer(report* report, const char* key, long long value);
+void report_string(report* report, const char* key, const char* value);
+
+#endif // REPORT_H
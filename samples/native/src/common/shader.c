@@ -0,0 +1,253 @@
+//
+// Copyright (c) 2025, Byteplug LLC.
+//
+// This source file is part of a project made by the Erlangsters community and
+// is released under the MIT license. Please refer to the LICENSE.md file that
+// can be found at the root of the project repository.
+//
+// Written by Jonathan De Wachter <jonathan.dewachter@byteplug.io>
+//
+#include "shader.h"
+#include <stdio.h>
+#include "gl_debug.h"
+#include "gl_extensions.h"
+
+// From GL_KHR_parallel_shader_compile (same value as the ARB extension).
+#define SHADER_COMPLETION_STATUS 0x91B1
+
+#if defined(OPENGL_VERSION_46) || defined(OPENGL_ES_VERSION_31) || defined(OPENGL_ES_VERSION_32)
+    #define SHADER_COMPUTE 1
+#else
+    #define SHADER_COMPUTE 0
+#endif
+
+#if defined(OPENGL_VERSION_33)
+    #define VERSION_LINE "#version 330 core\n"
+#elif defined(OPENGL_VERSION_41)
+    #define VERSION_LINE "#version 410 core\n"
+#elif defined(OPENGL_VERSION_46)
+    #define VERSION_LINE "#version 460 core\n"
+#elif defined(OPENGL_ES_VERSION_20)
+    #define VERSION_LINE "#version 100\n"
+#elif defined(OPENGL_ES_VERSION_30)
+    #define VERSION_LINE "#version 300 es\n"
+#elif defined(OPENGL_ES_VERSION_31)
+    #define VERSION_LINE "#version 310 es\n"
+#elif defined(OPENGL_ES_VERSION_32)
+    #define VERSION_LINE "#version 320 es\n"
+#else
+    #error "Unsupported OpenGL version."
+#endif
+
+#if defined(OPENGL_ES_VERSION_20)
+    #define FEATURES ""
+    #define VERTEX_KEYWORDS \
+        "#define ATTRIBUTE attribute\n" \
+        "#define VARYING_OUT varying\n"
+    #define FRAGMENT_KEYWORDS \
+        "#define VARYING_IN varying\n" \
+        "#define FRAG_COLOR gl_FragColor\n" \
+        "#define texture texture2D\n"
+#else
+    #define FEATURES \
+        "#define SHADER_HAS_INTEGERS 1\n" \
+        "#define SHADER_HAS_INSTANCING 1\n" \
+        "#define SHADER_HAS_TEXTURE_ARRAYS 1\n"
+    #define VERTEX_KEYWORDS \
+        "#define ATTRIBUTE in\n" \
+        "#define VARYING_OUT out\n"
+    #define FRAGMENT_KEYWORDS \
+        "#define VARYING_IN in\n" \
+        "out vec4 shaderFragColor;\n" \
+        "#define FRAG_COLOR shaderFragColor\n"
+#endif
+
+#if SHADER_COMPUTE
+    #define COMPUTE_FEATURES "#define SHADER_HAS_COMPUTE 1\n"
+#else
+    #define COMPUTE_FEATURES ""
+#endif
+
+// Vertex and compute shaders get full precision, fragment shaders the
+// precision the samples always used.
+#if SAMPLE_OPENGL_API == SAMPLE_API_GL
+    #define VERTEX_PRECISION ""
+    #define FRAGMENT_PRECISION ""
+    #define COMPUTE_PRECISION ""
+#elif SAMPLE_OPENGL_VERSION_MAJOR == 2
+    #define VERTEX_PRECISION "precision highp float;\n"
+    #define FRAGMENT_PRECISION "precision mediump float;\n"
+    #define COMPUTE_PRECISION ""
+#else
+    #define VERTEX_PRECISION "precision highp float;\n"
+    #define FRAGMENT_PRECISION \
+        "precision mediump float;\n" \
+        "precision mediump sampler2DArray;\n"
+    #define COMPUTE_PRECISION \
+        "precision highp float;\n" \
+        "precision highp int;\n" \
+        "precision highp sampler2D;\n" \
+        "precision highp image2D;\n"
+#endif
+
+// The defines of the program go between the version line and the rest of
+// the prelude, so they may hold #extension directives.
+static const char* versionLine = VERSION_LINE;
+static const char* vertexPrelude = FEATURES COMPUTE_FEATURES VERTEX_PRECISION VERTEX_KEYWORDS;
+static const char* fragmentPrelude = FEATURES COMPUTE_FEATURES FRAGMENT_PRECISION FRAGMENT_KEYWORDS;
+#if SHADER_COMPUTE
+static const char* computePrelude = FEATURES COMPUTE_FEATURES COMPUTE_PRECISION;
+#endif
+
+typedef void (SAMPLE_GL_APIENTRY *max_shader_compiler_threads_func)(GLuint count);
+
+// -1 until the extensions were looked up.
+static int parallelCompile = -1;
+
+static void detectParallelCompile(void) {
+    max_shader_compiler_threads_func maxShaderCompilerThreads = NULL;
+    if (gl_has_extension("GL_KHR_parallel_shader_compile")) {
+        maxShaderCompilerThreads = (max_shader_compiler_threads_func)gl_get_proc_address("glMaxShaderCompilerThreadsKHR");
+    } else if (gl_has_extension("GL_ARB_parallel_shader_compile")) {
+        maxShaderCompilerThreads = (max_shader_compiler_threads_func)gl_get_proc_address("glMaxShaderCompilerThreadsARB");
+    }
+
+    // Let the driver use as many threads as it wants.
+    parallelCompile = maxShaderCompilerThreads != NULL;
+    if (maxShaderCompilerThreads) {
+        maxShaderCompilerThreads(0xFFFFFFFFu);
+    }
+}
+
+// The line numbers of the body are restored, so the compilation errors
+// point at the source that was written.
+static GLuint compile(GLenum type, const char* prelude, const char* defines, const char* body) {
+    const char* sources[5] = { versionLine, defines ? defines : "", prelude, "#line 1\n", body };
+    GLuint shader = glCreateShader(type);
+    glShaderSource(shader, 5, sources, NULL);
+    glCompileShader(shader);
+    return shader;
+}
+
+int shader_parallel_compile(void) {
+    return parallelCompile > 0;
+}
+
+void shader_submit(shader_program* programs, int count) {
+    if (parallelCompile < 0) {
+        detectParallelCompile();
+    }
+
+    for (int i = 0; i < count; i++) {
+        shader_program* p = &programs[i];
+        p->shaders[0] = 0;
+        p->shaders[1] = 0;
+        if (p->compute) {
+            #if SHADER_COMPUTE
+                p->shaders[0] = compile(GL_COMPUTE_SHADER, computePrelude, p->defines, p->compute);
+            #endif
+        } else {
+            p->shaders[0] = compile(GL_VERTEX_SHADER, vertexPrelude, p->defines, p->vertex);
+            p->shaders[1] = compile(GL_FRAGMENT_SHADER, fragmentPrelude, p->defines, p->fragment);
+        }
+    }
+
+    // The programs are linked right away; linking waits for the shaders in
+    // the background too.
+    for (int i = 0; i < count; i++) {
+        shader_program* p = &programs[i];
+        p->program = glCreateProgram();
+        for (int j = 0; j < 2; j++) {
+            if (p->shaders[j]) {
+                glAttachShader(p->program, p->shaders[j]);
+            }
+        }
+        for (GLuint location = 0; p->attributes && p->attributes[location]; location++) {
+            glBindAttribLocation(p->program, location, p->attributes[location]);
+        }
+        glLinkProgram(p->program);
+    }
+}
+
+int shader_pending(const shader_program* programs, int count) {
+    if (parallelCompile <= 0) {
+        return 0;
+    }
+
+    int pending = 0;
+    for (int i = 0; i < count; i++) {
+        GLint complete = GL_TRUE;
+        glGetProgramiv(programs[i].program, SHADER_COMPLETION_STATUS, &complete);
+        if (!complete) {
+            pending++;
+        }
+    }
+    return pending;
+}
+
+// Print the log of a shader that failed to compile. Returns whether it
+// compiled.
+static int checkShader(const shader_program* p, GLuint shader) {
+    GLint success;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+    if (success) {
+        return 1;
+    }
+
+    GLint type;
+    glGetShaderiv(shader, GL_SHADER_TYPE, &type);
+    const char* stage = type == GL_VERTEX_SHADER ? "vertex" : type == GL_FRAGMENT_SHADER ? "fragment" : "compute";
+    GLchar infoLog[1024];
+    glGetShaderInfoLog(shader, sizeof(infoLog), NULL, infoLog);
+    printf("%s: %s shader compilation failed: %s\n", p->label, stage, infoLog);
+    return 0;
+}
+
+int shader_finish(shader_program* programs, int count) {
+    int failures = 0;
+    for (int i = 0; i < count; i++) {
+        shader_program* p = &programs[i];
+        GLint success = GL_FALSE;
+        if (p->shaders[0]) {
+            glGetProgramiv(p->program, GL_LINK_STATUS, &success);
+        } else {
+            printf("%s: compute shaders are not supported\n", p->label);
+        }
+
+        if (!success && p->shaders[0]) {
+            int compiled = 1;
+            for (int j = 0; j < 2; j++) {
+                if (p->shaders[j] && !checkShader(p, p->shaders[j])) {
+                    compiled = 0;
+                }
+            }
+            if (compiled) {
+                GLchar infoLog[1024];
+                glGetProgramInfoLog(p->program, sizeof(infoLog), NULL, infoLog);
+                printf("%s: program linking failed: %s\n", p->label, infoLog);
+            }
+        }
+
+        // The shaders are only flagged for deletion while attached.
+        for (int j = 0; j < 2; j++) {
+            if (p->shaders[j]) {
+                glDeleteShader(p->shaders[j]);
+                p->shaders[j] = 0;
+            }
+        }
+        if (success) {
+            gl_debug_label(GL_PROGRAM, p->program, p->label);
+        } else {
+            glDeleteProgram(p->program);
+            p->program = 0;
+            failures++;
+        }
+    }
+    return failures;
+}
+
+GLuint shader_build(shader_program* program) {
+    shader_submit(program, 1);
+    shader_finish(program, 1);
+    return program->program;
+}
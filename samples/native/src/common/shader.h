@@ -0,0 +1,79 @@
+//
+// Copyright (c) 2025, Byteplug LLC.
+//
+// This source file is part of a project made by the Erlangsters community and
+// is released under the MIT license. Please refer to the LICENSE.md file that
+// can be found at the root of the project repository.
+//
+// Written by Jonathan De Wachter <jonathan.dewachter@byteplug.io>
+//
+#ifndef SHADER_H
+#define SHADER_H
+
+#include "gl_api.h"
+
+// Single-source shaders, compiled in batches.
+//
+// A shader is written once and specialised for the targeted API and version
+// when it is compiled: a prelude gives it its #version line, its default
+// precisions (OpenGL ES), and macros hiding the differences between GLSL ES
+// 1.00 and the later versions.
+//
+// - ATTRIBUTE: a vertex input ("in", or "attribute"), at the location of its
+//   name in the attributes of the program;
+// - VARYING_OUT and VARYING_IN: a vertex output and a fragment input ("out"
+//   and "in", or "varying");
+// - FRAG_COLOR: the color output of a fragment shader;
+// - texture(): sampling a 2D texture (texture2D() on OpenGL ES 2.0).
+//
+// The features beyond GLSL ES 1.00 are advertised with SHADER_HAS_INTEGERS
+// (integer operations, texelFetch()), SHADER_HAS_INSTANCING (gl_InstanceID),
+// SHADER_HAS_TEXTURE_ARRAYS and SHADER_HAS_COMPUTE, next to the GL_ES and
+// __VERSION__ macros of GLSL. The variants of a shader are told apart with
+// the defines of their program, tested with #ifdef (GLSL ES 3.00 rejects
+// undefined macros in #if).
+//
+// Programs are built in batches: every shader of the batch is compiled and
+// every program linked before any status is queried, so drivers exposing
+// GL_KHR_parallel_shader_compile (or GL_ARB_parallel_shader_compile) work on
+// all of them at once, on their own threads, while the caller does something
+// else. Other drivers compile synchronously, or on their own.
+typedef struct {
+    const char* label;
+    // Lines inserted after the #version line of every stage, usually
+    // "#define NAME value\n" (may be NULL).
+    const char* defines;
+    const char* vertex;
+    const char* fragment;
+    // A compute program has no vertex and fragment shaders.
+    const char* compute;
+    // Names of the vertex inputs, bound to locations 0, 1, ... in order
+    // (NULL terminated, may be NULL).
+    const char* const* attributes;
+
+    // The program once shader_finish() returned (0 if it failed).
+    GLuint program;
+    GLuint shaders[2];
+} shader_program;
+
+// Whether the driver compiles the shaders in parallel, in the background
+// (only known after the first submission).
+int shader_parallel_compile(void);
+
+// Start compiling and linking the programs.
+void shader_submit(shader_program* programs, int count);
+
+// Number of submitted programs that are not finished yet, without blocking
+// when the driver compiles in parallel (0 otherwise, as the status queries
+// of shader_finish() would block anyway).
+int shader_pending(const shader_program* programs, int count);
+
+// Wait for the submitted programs, and print the log of the shaders and
+// programs that failed, which are deleted. Returns the number of failures.
+int shader_finish(shader_program* programs, int count);
+
+// Build a single program, synchronously. Returns the program, or 0 if it
+// failed.
+GLuint shader_build(shader_program* program);
+
+#endif // SHADER_H
@@ -0,0 +1,260 @@
+//
+// Copyright (c) 2025, Byteplug LLC.
+//
+// This source file is part of a project made by the Erlangsters community and
+// is released under the MIT license. Please refer to the LICENSE.md file that
+// can be found at the root of the project repository.
+//
+// Written by Jonathan De Wachter <jonathan.dewachter@byteplug.io>
+//
+#include "skinning.h"
+#include <math.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define SKINNING_SSE2
+    #include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+    #define SKINNING_NEON
+    #include <arm_neon.h>
+#endif
+
+// Each variant of skinLinear() blends the 4 columns of the matrices of the
+// influences, then transforms the position and the normal by the blend.
+// Each variant of blendDualQuat() sums the dual quaternions of the
+// influences, flipping those in the other hemisphere than the first one (q
+// and -q are the same rotation, but their sum is not).
+#if defined(SKINNING_SSE2)
+
+static const char* isaName = "SSE2";
+
+static inline __m128 splat(__m128 v, int lane) {
+    switch (lane) {
+        case 0: return _mm_shuffle_ps(v, v, _MM_SHUFFLE(0, 0, 0, 0));
+        case 1: return _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 1, 1, 1));
+        default: return _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 2, 2, 2));
+    }
+}
+
+static inline void skinLinear(const skin_vertex* vertex, const float* palette, float* output) {
+    __m128 c0 = _mm_setzero_ps();
+    __m128 c1 = c0;
+    __m128 c2 = c0;
+    __m128 c3 = c0;
+    for (int k = 0; k < SKIN_MAX_INFLUENCES && vertex->weights[k] > 0.0f; k++) {
+        const float* m = palette + (size_t)vertex->bones[k] * 16;
+        __m128 weight = _mm_set1_ps(vertex->weights[k]);
+        c0 = _mm_add_ps(c0, _mm_mul_ps(weight, _mm_loadu_ps(m)));
+        c1 = _mm_add_ps(c1, _mm_mul_ps(weight, _mm_loadu_ps(m + 4)));
+        c2 = _mm_add_ps(c2, _mm_mul_ps(weight, _mm_loadu_ps(m + 8)));
+        c3 = _mm_add_ps(c3, _mm_mul_ps(weight, _mm_loadu_ps(m + 12)));
+    }
+
+    __m128 p = _mm_loadu_ps(vertex->position);
+    __m128 n = _mm_loadu_ps(vertex->normal);
+    __m128 position = _mm_add_ps(_mm_add_ps(_mm_mul_ps(c0, splat(p, 0)), _mm_mul_ps(c1, splat(p, 1))),
+                                 _mm_add_ps(_mm_mul_ps(c2, splat(p, 2)), c3));
+    __m128 normal = _mm_add_ps(_mm_add_ps(_mm_mul_ps(c0, splat(n, 0)), _mm_mul_ps(c1, splat(n, 1))),
+                               _mm_mul_ps(c2, splat(n, 2)));
+
+    // The fourth lane of the position is overwritten by the normal.
+    _mm_storeu_ps(output, position);
+    _mm_storel_pi((__m64*)(output + 3), normal);
+    _mm_store_ss(output + 5, splat(normal, 2));
+}
+
+static inline void blendDualQuat(const skin_vertex* vertex, const float* palette, float real[4], float dual[4]) {
+    const float* pivot = palette + (size_t)vertex->bones[0] * 8;
+    __m128 sumReal = _mm_setzero_ps();
+    __m128 sumDual = sumReal;
+    for (int k = 0; k < SKIN_MAX_INFLUENCES && vertex->weights[k] > 0.0f; k++) {
+        const float* q = palette + (size_t)vertex->bones[k] * 8;
+        float side = pivot[0] * q[0] + pivot[1] * q[1] + pivot[2] * q[2] + pivot[3] * q[3];
+        __m128 weight = _mm_set1_ps(side < 0.0f ? -vertex->weights[k] : vertex->weights[k]);
+        sumReal = _mm_add_ps(sumReal, _mm_mul_ps(weight, _mm_loadu_ps(q)));
+        sumDual = _mm_add_ps(sumDual, _mm_mul_ps(weight, _mm_loadu_ps(q + 4)));
+    }
+    _mm_storeu_ps(real, sumReal);
+    _mm_storeu_ps(dual, sumDual);
+}
+
+#elif defined(SKINNING_NEON)
+
+static const char* isaName = "NEON";
+
+static inline void skinLinear(const skin_vertex* vertex, const float* palette, float* output) {
+    float32x4_t c0 = vdupq_n_f32(0.0f);
+    float32x4_t c1 = c0;
+    float32x4_t c2 = c0;
+    float32x4_t c3 = c0;
+    for (int k = 0; k < SKIN_MAX_INFLUENCES && vertex->weights[k] > 0.0f; k++) {
+        const float* m = palette + (size_t)vertex->bones[k] * 16;
+        float weight = vertex->weights[k];
+        c0 = vmlaq_n_f32(c0, vld1q_f32(m), weight);
+        c1 = vmlaq_n_f32(c1, vld1q_f32(m + 4), weight);
+        c2 = vmlaq_n_f32(c2, vld1q_f32(m + 8), weight);
+        c3 = vmlaq_n_f32(c3, vld1q_f32(m + 12), weight);
+    }
+
+    const float* p = vertex->position;
+    const float* n = vertex->normal;
+    float32x4_t position = vmlaq_n_f32(vmlaq_n_f32(vmlaq_n_f32(c3, c0, p[0]), c1, p[1]), c2, p[2]);
+    float32x4_t normal = vmlaq_n_f32(vmlaq_n_f32(vmulq_n_f32(c0, n[0]), c1, n[1]), c2, n[2]);
+
+    // The fourth lane of the position is overwritten by the normal.
+    vst1q_f32(output, position);
+    vst1_f32(output + 3, vget_low_f32(normal));
+    output[5] = vgetq_lane_f32(normal, 2);
+}
+
+static inline void blendDualQuat(const skin_vertex* vertex, const float* palette, float real[4], float dual[4]) {
+    const float* pivot = palette + (size_t)vertex->bones[0] * 8;
+    float32x4_t sumReal = vdupq_n_f32(0.0f);
+    float32x4_t sumDual = sumReal;
+    for (int k = 0; k < SKIN_MAX_INFLUENCES && vertex->weights[k] > 0.0f; k++) {
+        const float* q = palette + (size_t)vertex->bones[k] * 8;
+        float side = pivot[0] * q[0] + pivot[1] * q[1] + pivot[2] * q[2] + pivot[3] * q[3];
+        float weight = side < 0.0f ? -vertex->weights[k] : vertex->weights[k];
+        sumReal = vmlaq_n_f32(sumReal, vld1q_f32(q), weight);
+        sumDual = vmlaq_n_f32(sumDual, vld1q_f32(q + 4), weight);
+    }
+    vst1q_f32(real, sumReal);
+    vst1q_f32(dual, sumDual);
+}
+
+#else
+
+static const char* isaName = "scalar";
+
+static inline void skinLinear(const skin_vertex* vertex, const float* palette, float* output) {
+    float blend[16] = { 0 };
+    for (int k = 0; k < SKIN_MAX_INFLUENCES && vertex->weights[k] > 0.0f; k++) {
+        const float* m = palette + (size_t)vertex->bones[k] * 16;
+        for (int i = 0; i < 16; i++) {
+            blend[i] += vertex->weights[k] * m[i];
+        }
+    }
+
+    const float* p = vertex->position;
+    const float* n = vertex->normal;
+    for (int i = 0; i < 3; i++) {
+        output[i] = blend[i] * p[0] + blend[4 + i] * p[1] + blend[8 + i] * p[2] + blend[12 + i];
+        output[3 + i] = blend[i] * n[0] + blend[4 + i] * n[1] + blend[8 + i] * n[2];
+    }
+}
+
+static inline void blendDualQuat(const skin_vertex* vertex, const float* palette, float real[4], float dual[4]) {
+    const float* pivot = palette + (size_t)vertex->bones[0] * 8;
+    for (int i = 0; i < 4; i++) {
+        real[i] = 0.0f;
+        dual[i] = 0.0f;
+    }
+    for (int k = 0; k < SKIN_MAX_INFLUENCES && vertex->weights[k] > 0.0f; k++) {
+        const float* q = palette + (size_t)vertex->bones[k] * 8;
+        float side = pivot[0] * q[0] + pivot[1] * q[1] + pivot[2] * q[2] + pivot[3] * q[3];
+        float weight = side < 0.0f ? -vertex->weights[k] : vertex->weights[k];
+        for (int i = 0; i < 4; i++) {
+            real[i] += weight * q[i];
+            dual[i] += weight * q[4 + i];
+        }
+    }
+}
+
+#endif
+
+const char* skin_isa(void) {
+    return isaName;
+}
+
+void skin_linear(const skin_vertex* vertices, size_t count, const float* palette, float* output) {
+    for (size_t i = 0; i < count; i++) {
+        skinLinear(&vertices[i], palette, output + i * 6);
+    }
+}
+
+static inline void cross(float result[3], const float* a, const float* b) {
+    result[0] = a[1] * b[2] - a[2] * b[1];
+    result[1] = a[2] * b[0] - a[0] * b[2];
+    result[2] = a[0] * b[1] - a[1] * b[0];
+}
+
+// Rotate v by the unit quaternion q, as v + 2 q.xyz x (q.xyz x v + q.w v).
+static inline void rotate(float result[3], const float q[4], const float* v) {
+    float t[3], u[3];
+    cross(t, q, v);
+    for (int i = 0; i < 3; i++) {
+        t[i] += q[3] * v[i];
+    }
+    cross(u, q, t);
+    for (int i = 0; i < 3; i++) {
+        result[i] = v[i] + 2.0f * u[i];
+    }
+}
+
+void skin_dual_quat(const skin_vertex* vertices, size_t count, const float* palette, float* output) {
+    for (size_t i = 0; i < count; i++) {
+        const skin_vertex* vertex = &vertices[i];
+        float real[4], dual[4];
+        blendDualQuat(vertex, palette, real, dual);
+
+        float scale = 1.0f / sqrtf(real[0] * real[0] + real[1] * real[1] + real[2] * real[2] + real[3] * real[3]);
+        for (int k = 0; k < 4; k++) {
+            real[k] *= scale;
+            dual[k] *= scale;
+        }
+
+        // The translation is 2 dual conjugate(real).
+        float translation[3];
+        cross(translation, real, dual);
+        for (int k = 0; k < 3; k++) {
+            translation[k] = 2.0f * (translation[k] + real[3] * dual[k] - dual[3] * real[k]);
+        }
+
+        float* out = output + i * 6;
+        rotate(out, real, vertex->position);
+        rotate(out + 3, real, vertex->normal);
+        for (int k = 0; k < 3; k++) {
+            out[k] += translation[k];
+        }
+    }
+}
+
+void skin_dual_quat_from_matrix(float dualQuat[8], const mat4 m) {
+    // The rotation, from the largest of its components.
+    float* q = dualQuat;
+    float trace = m[0] + m[5] + m[10];
+    if (trace > 0.0f) {
+        float s = 0.5f / sqrtf(trace + 1.0f);
+        q[0] = (m[6] - m[9]) * s;
+        q[1] = (m[8] - m[2]) * s;
+        q[2] = (m[1] - m[4]) * s;
+        q[3] = 0.25f / s;
+    } else if (m[0] > m[5] && m[0] > m[10]) {
+        float s = 2.0f * sqrtf(1.0f + m[0] - m[5] - m[10]);
+        q[0] = 0.25f * s;
+        q[1] = (m[4] + m[1]) / s;
+        q[2] = (m[8] + m[2]) / s;
+        q[3] = (m[6] - m[9]) / s;
+    } else if (m[5] > m[10]) {
+        float s = 2.0f * sqrtf(1.0f + m[5] - m[0] - m[10]);
+        q[0] = (m[4] + m[1]) / s;
+        q[1] = 0.25f * s;
+        q[2] = (m[9] + m[6]) / s;
+        q[3] = (m[8] - m[2]) / s;
+    } else {
+        float s = 2.0f * sqrtf(1.0f + m[10] - m[0] - m[5]);
+        q[0] = (m[8] + m[2]) / s;
+        q[1] = (m[9] + m[6]) / s;
+        q[2] = 0.25f * s;
+        q[3] = (m[1] - m[4]) / s;
+    }
+
+    // The dual part is translation real / 2, the translation being a pure
+    // quaternion.
+    const float* t = &m[12];
+    float* d = dualQuat + 4;
+    cross(d, t, q);
+    for (int i = 0; i < 3; i++) {
+        d[i] = 0.5f * (q[3] * t[i] + d[i]);
+    }
+    d[3] = -0.5f * (t[0] * q[0] + t[1] * q[1] + t[2] * q[2]);
+}
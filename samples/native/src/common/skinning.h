@@ -0,0 +1,60 @@
+//
+// Copyright (c) 2025, Byteplug LLC.
+//
+// This source file is part of a project made by the Erlangsters community and
+// is released under the MIT license. Please refer to the LICENSE.md file that
+// can be found at the root of the project repository.
+//
+// Written by Jonathan De Wachter <jonathan.dewachter@byteplug.io>
+//
+#ifndef SKINNING_H
+#define SKINNING_H
+
+#include <stddef.h>
+#include "matrix.h"
+
+// Skinning on the CPU, for when the vertex shader cannot do it (or to
+// compare with it). Every vertex is bound to up to SKIN_MAX_INFLUENCES bones
+// of a palette, and deformed by the blend of their transforms:
+//
+// - linear blend skinning blends the matrices of the bones (each one being
+//   the transform of the bone times the inverse of its bind pose), which
+//   makes joints bent far collapse a little ("candy wrapper");
+// - dual quaternion skinning blends rigid transforms stored as unit dual
+//   quaternions instead, which keeps the volume but only works with rotations
+//   and translations.
+//
+// The matrices of a palette are mat4 (16 floats each), and its dual
+// quaternions are 8 floats each: the rotation (x, y, z, w) and then the dual
+// part. The blending is done with SSE2 or NEON when they are available.
+#define SKIN_MAX_INFLUENCES 4
+
+// A vertex in its bind pose. It is also the layout of the vertex buffers of
+// the shaders doing the skinning (the bones are unsigned bytes, read as
+// floats).
+typedef struct {
+    float position[4];  // w is 1.
+    float normal[4];    // w is 0.
+    // Sorted by decreasing weight, the weights summing to 1 (unused
+    // influences have a weight of 0).
+    float weights[SKIN_MAX_INFLUENCES];
+    unsigned char bones[SKIN_MAX_INFLUENCES];
+} skin_vertex;
+
+// Deform count vertices with a palette of matrices, writing their position
+// and their normal (6 floats per vertex) to output. The normals are not
+// normalized.
+void skin_linear(const skin_vertex* vertices, size_t count, const float* palette, float* output);
+
+// Same with a palette of dual quaternions. The normals come out normalized.
+void skin_dual_quat(const skin_vertex* vertices, size_t count, const float* palette, float* output);
+
+// Convert a rigid transform (a rotation then a translation) to a unit dual
+// quaternion.
+void skin_dual_quat_from_matrix(float dualQuat[8], const mat4 m);
+
+// Name of the instruction set blending the influences ("SSE2", "NEON", or
+// "scalar").
+const char* skin_isa(void);
+
+#endif // SKINNING_H
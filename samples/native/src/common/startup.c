@@ -0,0 +1,128 @@
+//
+// Copyright (c) 2025, Byteplug LLC.
+//
+// This source file is part of a project made by the Erlangsters community and
+// is released under the MIT license. Please refer to the LICENSE.md file that
+// can be found at the root of the project repository.
+//
+// Written by Jonathan De Wachter <jonathan.dewachter@byteplug.io>
+//
+#include "startup.h"
+#include "timer.h"
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define STARTUP_MAX_PHASES 64
+
+typedef struct {
+    const char* name;
+    double begin;
+    double end;
+    int thread;
+} startup_phase;
+
+static double origin;
+static startup_phase phases[STARTUP_MAX_PHASES];
+static atomic_int phaseCount;
+static atomic_int threadCount;
+
+// Small sequential identifier of the calling thread; the thread that calls
+// startup_begin() is thread 0.
+static _Thread_local int threadIndex = -1;
+
+static int current_thread(void) {
+    if (threadIndex < 0) {
+        threadIndex = atomic_fetch_add(&threadCount, 1);
+    }
+    return threadIndex;
+}
+
+void startup_begin(void) {
+    origin = timer_now();
+    current_thread();
+}
+
+int startup_phase_begin(const char* name) {
+    int phase = atomic_fetch_add(&phaseCount, 1);
+    if (phase >= STARTUP_MAX_PHASES) {
+        return -1;
+    }
+
+    phases[phase].name = name;
+    phases[phase].thread = current_thread();
+    phases[phase].end = 0.0;
+    phases[phase].begin = timer_now() - origin;
+
+    return phase;
+}
+
+void startup_phase_end(int phase) {
+    if (phase >= 0 && phase < STARTUP_MAX_PHASES) {
+        phases[phase].end = timer_now() - origin;
+    }
+}
+
+double startup_elapsed(void) {
+    return timer_now() - origin;
+}
+
+static int compare_phases(const void* a, const void* b) {
+    const startup_phase* left = a;
+    const startup_phase* right = b;
+    return (left->begin > right->begin) - (left->begin < right->begin);
+}
+
+// Copy of the finished phases, ordered by start time.
+static int sorted_phases(startup_phase* sorted) {
+    int count = atomic_load(&phaseCount);
+    if (count > STARTUP_MAX_PHASES) {
+        count = STARTUP_MAX_PHASES;
+    }
+
+    int finished = 0;
+    for (int i = 0; i < count; i++) {
+        if (phases[i].end > 0.0) {
+            sorted[finished++] = phases[i];
+        }
+    }
+    qsort(sorted, finished, sizeof(startup_phase), compare_phases);
+
+    return finished;
+}
+
+void startup_print(void) {
+    startup_phase sorted[STARTUP_MAX_PHASES];
+    int count = sorted_phases(sorted);
+
+    double last = 0.0;
+    printf("Startup phases (ms):\n");
+    printf("  %9s %9s  %-6s %s\n", "start", "duration", "thread", "phase");
+    for (int i = 0; i < count; i++) {
+        printf("  %9.3f %9.3f  %-6d %s\n",
+            sorted[i].begin * 1000.0,
+            (sorted[i].end - sorted[i].begin) * 1000.0,
+            sorted[i].thread,
+            sorted[i].name);
+        if (sorted[i].end > last) {
+            last = sorted[i].end;
+        }
+    }
+    printf("  total: %.3f ms\n", last * 1000.0);
+}
+
+void startup_report(report* report) {
+    startup_phase sorted[STARTUP_MAX_PHASES];
+    int count = sorted_phases(sorted);
+
+    report_begin_array(report, "startup");
+    for (int i = 0; i < count; i++) {
+        report_begin_object(report, NULL);
+        report_string(report, "phase", sorted[i].name);
+        report_integer(report, "thread", sorted[i].thread);
+        report_number(report, "start_ms", sorted[i].begin * 1000.0);
+        report_number(report, "duration_ms", (sorted[i].end - sorted[i].begin) * 1000.0);
+        report_end_object(report);
+    }
+    report_end_array(report);
+}
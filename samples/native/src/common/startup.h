@@ -0,0 +1,34 @@
+//
+// Copyright (c) 2025, Byteplug LLC.
+//
+// This source file is part of a project made by the Erlangsters community and
+// is released under the MIT license. Please refer to the LICENSE.md file that
+// can be found at the root of the project repository.
+//
+// Written by Jonathan De Wachter <jonathan.dewachter@byteplug.io>
+//
+#ifndef STARTUP_H
+#define STARTUP_H
+
+#include "report.h"
+
+// Timestamped phases of the startup of a sample, from the top of main() to
+// the first presented frame. Phases may overlap and can be recorded from any
+// thread; each one remembers the thread it ran on.
+//
+// startup_begin() sets the origin of the timeline and should be the first
+// call of main().
+void startup_begin(void);
+
+// Open a phase and return its handle (or -1 when the phase table is full,
+// which startup_phase_end() silently ignores).
+int startup_phase_begin(const char* name);
+void startup_phase_end(int phase);
+
+// Time elapsed since startup_begin(), in seconds.
+double startup_elapsed(void);
+
+void startup_print(void);
+void startup_report(report* report);
+
+#endif // STARTUP_H
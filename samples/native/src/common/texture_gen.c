@@ -0,0 +1,503 @@
+//
+// Copyright (c) 2025, Byteplug LLC.
+//
+// This source file is part of a project made by the Erlangsters community and
+// is released under the MIT license. Please refer to the LICENSE.md file that
+// can be found at the root of the project repository.
+//
+// Written by Jonathan De Wachter <jonathan.dewachter@byteplug.io>
+//
+#include "texture_gen.h"
+#include "profiler.h"
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define TEXTURE_GEN_SSE2
+    #include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+    #define TEXTURE_GEN_NEON
+    #include <arm_neon.h>
+#endif
+
+// A job of fewer rows than this costs more than it saves.
+#define TEXTURE_GEN_MIN_ROWS_PER_JOB 16
+
+// Noise is a hash of the pixel coordinates; a row starts from a hash of y and
+// every pixel adds a constant to it, so the SIMD path only needs additions.
+#define NOISE_ROW_STEP 0x9E3779B9u
+#define NOISE_COLUMN_STEP 0x85EBCA6Bu
+
+// Pattern parameters derived once from the description.
+typedef struct {
+    int width;
+    int height;
+    int cells;
+    uint32_t color0;
+    uint32_t color1;
+    float base[4];
+    float delta[4];
+    float stepX;
+    float stepY;
+    uint32_t seed;
+} pattern_params;
+
+static void prepare_params(const texture_desc* desc, pattern_params* params) {
+    params->width = desc->width;
+    params->height = desc->height;
+    params->cells = desc->cells > 0 ? desc->cells : 1;
+    memcpy(&params->color0, desc->color0, 4);
+    memcpy(&params->color1, desc->color1, 4);
+    for (int c = 0; c < 4; c++) {
+        params->base[c] = (float)desc->color0[c];
+        params->delta[c] = (float)desc->color1[c] - (float)desc->color0[c];
+    }
+
+    // The gradient goes from color0 in the top-left corner to color1 in the
+    // bottom-right one.
+    params->stepX = desc->width > 1 ? 0.5f / (float)(desc->width - 1) : 0.0f;
+    params->stepY = desc->height > 1 ? 0.5f / (float)(desc->height - 1) : 0.0f;
+    params->seed = desc->seed;
+}
+
+static uint32_t noise_hash(uint32_t h) {
+    h ^= h << 13;
+    h ^= h >> 17;
+    h ^= h << 5;
+    h ^= h << 13;
+    h ^= h >> 17;
+    h ^= h << 5;
+    return h;
+}
+
+static uint32_t noise_row_start(const pattern_params* params, int y) {
+    return params->seed ^ ((uint32_t)y * NOISE_ROW_STEP);
+}
+
+static float noise_weight(uint32_t h) {
+    return (float)(noise_hash(h) >> 24) * (1.0f / 255.0f);
+}
+
+static void lerp_pixel(unsigned char* out, const pattern_params* params, float t) {
+    for (int c = 0; c < 4; c++) {
+        out[c] = (unsigned char)(int)(params->base[c] + params->delta[c] * t + 0.5f);
+    }
+}
+
+// Index of the first column (or row) of a checker cell, such that the pixel
+// x belongs to the cell x * cells / size.
+static int cell_start(int cell, int cells, int size) {
+    return (int)(((long long)cell * size + cells - 1) / cells);
+}
+
+static int cell_index(int x, int cells, int size) {
+    return (int)((long long)x * cells / size);
+}
+
+#if defined(TEXTURE_GEN_SSE2)
+
+static const char* isaName = "SSE2";
+
+// Interpolate 4 pixels, t holding the weight of each of them.
+static inline __m128i lerp_pixels(__m128 base, __m128 delta, __m128 t) {
+    const __m128 half = _mm_set1_ps(0.5f);
+    __m128i p0 = _mm_cvttps_epi32(_mm_add_ps(_mm_add_ps(base, _mm_mul_ps(delta, _mm_shuffle_ps(t, t, 0x00))), half));
+    __m128i p1 = _mm_cvttps_epi32(_mm_add_ps(_mm_add_ps(base, _mm_mul_ps(delta, _mm_shuffle_ps(t, t, 0x55))), half));
+    __m128i p2 = _mm_cvttps_epi32(_mm_add_ps(_mm_add_ps(base, _mm_mul_ps(delta, _mm_shuffle_ps(t, t, 0xAA))), half));
+    __m128i p3 = _mm_cvttps_epi32(_mm_add_ps(_mm_add_ps(base, _mm_mul_ps(delta, _mm_shuffle_ps(t, t, 0xFF))), half));
+    return _mm_packus_epi16(_mm_packs_epi32(p0, p1), _mm_packs_epi32(p2, p3));
+}
+
+static int fill_span(unsigned char* out, int count, uint32_t pixel) {
+    __m128i value = _mm_set1_epi32((int)pixel);
+    int x = 0;
+    for (; x + 4 <= count; x += 4) {
+        _mm_storeu_si128((__m128i*)(out + x * 4), value);
+    }
+    return x;
+}
+
+static int gradient_span(unsigned char* row, const pattern_params* params, int y) {
+    __m128 base = _mm_loadu_ps(params->base);
+    __m128 delta = _mm_loadu_ps(params->delta);
+    __m128 stepX = _mm_set1_ps(params->stepX);
+    __m128 rowT = _mm_set1_ps((float)y * params->stepY);
+    __m128 columns = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
+    const __m128 four = _mm_set1_ps(4.0f);
+
+    int x = 0;
+    for (; x + 4 <= params->width; x += 4) {
+        __m128 t = _mm_add_ps(_mm_mul_ps(columns, stepX), rowT);
+        _mm_storeu_si128((__m128i*)(row + x * 4), lerp_pixels(base, delta, t));
+        columns = _mm_add_ps(columns, four);
+    }
+    return x;
+}
+
+static int noise_span(unsigned char* row, const pattern_params* params, int y) {
+    __m128 base = _mm_loadu_ps(params->base);
+    __m128 delta = _mm_loadu_ps(params->delta);
+    const __m128 scale = _mm_set1_ps(1.0f / 255.0f);
+    uint32_t start = noise_row_start(params, y);
+    __m128i h = _mm_add_epi32(_mm_set1_epi32((int)start), _mm_setr_epi32(
+        0, (int)NOISE_COLUMN_STEP, (int)(2u * NOISE_COLUMN_STEP), (int)(3u * NOISE_COLUMN_STEP)));
+    const __m128i step = _mm_set1_epi32((int)(4u * NOISE_COLUMN_STEP));
+
+    int x = 0;
+    for (; x + 4 <= params->width; x += 4) {
+        __m128i m = h;
+        for (int round = 0; round < 2; round++) {
+            m = _mm_xor_si128(m, _mm_slli_epi32(m, 13));
+            m = _mm_xor_si128(m, _mm_srli_epi32(m, 17));
+            m = _mm_xor_si128(m, _mm_slli_epi32(m, 5));
+        }
+        __m128 t = _mm_mul_ps(_mm_cvtepi32_ps(_mm_srli_epi32(m, 24)), scale);
+        _mm_storeu_si128((__m128i*)(row + x * 4), lerp_pixels(base, delta, t));
+        h = _mm_add_epi32(h, step);
+    }
+    return x;
+}
+
+// Average 2x2 blocks of the source rows r0 and r1 into 4 pixels at a time.
+static int downsample_span(unsigned char* out, const unsigned char* r0, const unsigned char* r1,
+                           int srcWidth, int dstWidth) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i two = _mm_set1_epi16(2);
+
+    int x = 0;
+    for (; x + 4 <= dstWidth && 2 * x + 8 <= srcWidth; x += 4) {
+        __m128i a0 = _mm_loadu_si128((const __m128i*)(r0 + x * 8));
+        __m128i a1 = _mm_loadu_si128((const __m128i*)(r0 + x * 8 + 16));
+        __m128i b0 = _mm_loadu_si128((const __m128i*)(r1 + x * 8));
+        __m128i b1 = _mm_loadu_si128((const __m128i*)(r1 + x * 8 + 16));
+
+        // Vertical sums of the source pixels, two per register.
+        __m128i s01 = _mm_add_epi16(_mm_unpacklo_epi8(a0, zero), _mm_unpacklo_epi8(b0, zero));
+        __m128i s23 = _mm_add_epi16(_mm_unpackhi_epi8(a0, zero), _mm_unpackhi_epi8(b0, zero));
+        __m128i s45 = _mm_add_epi16(_mm_unpacklo_epi8(a1, zero), _mm_unpacklo_epi8(b1, zero));
+        __m128i s67 = _mm_add_epi16(_mm_unpackhi_epi8(a1, zero), _mm_unpackhi_epi8(b1, zero));
+
+        // Horizontal sums of the pixel pairs.
+        __m128i lo = _mm_add_epi16(_mm_unpacklo_epi64(s01, s23), _mm_unpackhi_epi64(s01, s23));
+        __m128i hi = _mm_add_epi16(_mm_unpacklo_epi64(s45, s67), _mm_unpackhi_epi64(s45, s67));
+        lo = _mm_srli_epi16(_mm_add_epi16(lo, two), 2);
+        hi = _mm_srli_epi16(_mm_add_epi16(hi, two), 2);
+
+        _mm_storeu_si128((__m128i*)(out + x * 4), _mm_packus_epi16(lo, hi));
+    }
+    return x;
+}
+
+#elif defined(TEXTURE_GEN_NEON)
+
+static const char* isaName = "NEON";
+
+static inline uint8x16_t lerp_pixels(float32x4_t base, float32x4_t delta, float32x4_t t) {
+    const float32x4_t half = vdupq_n_f32(0.5f);
+    int32x4_t p0 = vcvtq_s32_f32(vaddq_f32(vaddq_f32(base, vmulq_n_f32(delta, vgetq_lane_f32(t, 0))), half));
+    int32x4_t p1 = vcvtq_s32_f32(vaddq_f32(vaddq_f32(base, vmulq_n_f32(delta, vgetq_lane_f32(t, 1))), half));
+    int32x4_t p2 = vcvtq_s32_f32(vaddq_f32(vaddq_f32(base, vmulq_n_f32(delta, vgetq_lane_f32(t, 2))), half));
+    int32x4_t p3 = vcvtq_s32_f32(vaddq_f32(vaddq_f32(base, vmulq_n_f32(delta, vgetq_lane_f32(t, 3))), half));
+    int16x8_t lo = vcombine_s16(vqmovn_s32(p0), vqmovn_s32(p1));
+    int16x8_t hi = vcombine_s16(vqmovn_s32(p2), vqmovn_s32(p3));
+    return vcombine_u8(vqmovun_s16(lo), vqmovun_s16(hi));
+}
+
+static int fill_span(unsigned char* out, int count, uint32_t pixel) {
+    uint8x16_t value = vreinterpretq_u8_u32(vdupq_n_u32(pixel));
+    int x = 0;
+    for (; x + 4 <= count; x += 4) {
+        vst1q_u8(out + x * 4, value);
+    }
+    return x;
+}
+
+static int gradient_span(unsigned char* row, const pattern_params* params, int y) {
+    float32x4_t base = vld1q_f32(params->base);
+    float32x4_t delta = vld1q_f32(params->delta);
+    float32x4_t rowT = vdupq_n_f32((float)y * params->stepY);
+    const float initial[4] = { 0.0f, 1.0f, 2.0f, 3.0f };
+    float32x4_t columns = vld1q_f32(initial);
+    const float32x4_t four = vdupq_n_f32(4.0f);
+
+    int x = 0;
+    for (; x + 4 <= params->width; x += 4) {
+        float32x4_t t = vaddq_f32(vmulq_n_f32(columns, params->stepX), rowT);
+        vst1q_u8(row + x * 4, lerp_pixels(base, delta, t));
+        columns = vaddq_f32(columns, four);
+    }
+    return x;
+}
+
+static int noise_span(unsigned char* row, const pattern_params* params, int y) {
+    float32x4_t base = vld1q_f32(params->base);
+    float32x4_t delta = vld1q_f32(params->delta);
+    uint32_t start = noise_row_start(params, y);
+    const uint32_t offsets[4] = { 0, NOISE_COLUMN_STEP, 2u * NOISE_COLUMN_STEP, 3u * NOISE_COLUMN_STEP };
+    uint32x4_t h = vaddq_u32(vdupq_n_u32(start), vld1q_u32(offsets));
+    const uint32x4_t step = vdupq_n_u32(4u * NOISE_COLUMN_STEP);
+
+    int x = 0;
+    for (; x + 4 <= params->width; x += 4) {
+        uint32x4_t m = h;
+        for (int round = 0; round < 2; round++) {
+            m = veorq_u32(m, vshlq_n_u32(m, 13));
+            m = veorq_u32(m, vshrq_n_u32(m, 17));
+            m = veorq_u32(m, vshlq_n_u32(m, 5));
+        }
+        float32x4_t t = vmulq_n_f32(vcvtq_f32_u32(vshrq_n_u32(m, 24)), 1.0f / 255.0f);
+        vst1q_u8(row + x * 4, lerp_pixels(base, delta, t));
+        h = vaddq_u32(h, step);
+    }
+    return x;
+}
+
+static int downsample_span(unsigned char* out, const unsigned char* r0, const unsigned char* r1,
+                           int srcWidth, int dstWidth) {
+    int x = 0;
+    for (; x + 4 <= dstWidth && 2 * x + 8 <= srcWidth; x += 4) {
+        uint8x16_t a0 = vld1q_u8(r0 + x * 8);
+        uint8x16_t a1 = vld1q_u8(r0 + x * 8 + 16);
+        uint8x16_t b0 = vld1q_u8(r1 + x * 8);
+        uint8x16_t b1 = vld1q_u8(r1 + x * 8 + 16);
+
+        uint16x8_t s01 = vaddl_u8(vget_low_u8(a0), vget_low_u8(b0));
+        uint16x8_t s23 = vaddl_u8(vget_high_u8(a0), vget_high_u8(b0));
+        uint16x8_t s45 = vaddl_u8(vget_low_u8(a1), vget_low_u8(b1));
+        uint16x8_t s67 = vaddl_u8(vget_high_u8(a1), vget_high_u8(b1));
+
+        uint16x8_t lo = vaddq_u16(vcombine_u16(vget_low_u16(s01), vget_low_u16(s23)),
+                                  vcombine_u16(vget_high_u16(s01), vget_high_u16(s23)));
+        uint16x8_t hi = vaddq_u16(vcombine_u16(vget_low_u16(s45), vget_low_u16(s67)),
+                                  vcombine_u16(vget_high_u16(s45), vget_high_u16(s67)));
+
+        vst1q_u8(out + x * 4, vcombine_u8(vmovn_u16(vrshrq_n_u16(lo, 2)), vmovn_u16(vrshrq_n_u16(hi, 2))));
+    }
+    return x;
+}
+
+#else
+
+static const char* isaName = "scalar";
+
+static int fill_span(unsigned char* out, int count, uint32_t pixel) {
+    (void)out; (void)count; (void)pixel;
+    return 0;
+}
+
+static int gradient_span(unsigned char* row, const pattern_params* params, int y) {
+    (void)row; (void)params; (void)y;
+    return 0;
+}
+
+static int noise_span(unsigned char* row, const pattern_params* params, int y) {
+    (void)row; (void)params; (void)y;
+    return 0;
+}
+
+static int downsample_span(unsigned char* out, const unsigned char* r0, const unsigned char* r1,
+                           int srcWidth, int dstWidth) {
+    (void)out; (void)r0; (void)r1; (void)srcWidth; (void)dstWidth;
+    return 0;
+}
+
+#endif
+
+const char* texture_gen_isa(void) {
+    return isaName;
+}
+
+static void fill_pixels(unsigned char* out, int count, uint32_t pixel) {
+    for (int x = fill_span(out, count, pixel); x < count; x++) {
+        memcpy(out + x * 4, &pixel, 4);
+    }
+}
+
+static void checker_row(unsigned char* row, const pattern_params* params, int y) {
+    // Fill the row cell by cell instead of testing every pixel.
+    int parity = cell_index(y, params->cells, params->height) & 1;
+    for (int cell = 0; cell < params->cells; cell++) {
+        int x0 = cell_start(cell, params->cells, params->width);
+        int x1 = cell_start(cell + 1, params->cells, params->width);
+        fill_pixels(row + (size_t)x0 * 4, x1 - x0, ((cell + parity) & 1) ? params->color1 : params->color0);
+    }
+}
+
+static void gradient_row(unsigned char* row, const pattern_params* params, int y) {
+    float rowT = (float)y * params->stepY;
+    for (int x = gradient_span(row, params, y); x < params->width; x++) {
+        lerp_pixel(row + x * 4, params, (float)x * params->stepX + rowT);
+    }
+}
+
+static void noise_row(unsigned char* row, const pattern_params* params, int y) {
+    uint32_t start = noise_row_start(params, y);
+    for (int x = noise_span(row, params, y); x < params->width; x++) {
+        lerp_pixel(row + x * 4, params, noise_weight(start + (uint32_t)x * NOISE_COLUMN_STEP));
+    }
+}
+
+void texture_gen_rows(const texture_desc* desc, unsigned char* pixels, int firstRow, int rowCount) {
+    pattern_params params;
+    prepare_params(desc, &params);
+
+    size_t stride = (size_t)desc->width * 4;
+    for (int y = firstRow; y < firstRow + rowCount; y++) {
+        unsigned char* row = pixels + (size_t)y * stride;
+        switch (desc->pattern) {
+            case TEXTURE_PATTERN_CHECKER:
+                // Consecutive rows of the same cells are identical.
+                if (y > firstRow && cell_index(y, params.cells, params.height) == cell_index(y - 1, params.cells, params.height)) {
+                    memcpy(row, row - stride, stride);
+                } else {
+                    checker_row(row, &params, y);
+                }
+                break;
+            case TEXTURE_PATTERN_GRADIENT:
+                gradient_row(row, &params, y);
+                break;
+            case TEXTURE_PATTERN_NOISE:
+                noise_row(row, &params, y);
+                break;
+        }
+    }
+}
+
+void texture_gen_rows_scalar(const texture_desc* desc, unsigned char* pixels, int firstRow, int rowCount) {
+    pattern_params params;
+    prepare_params(desc, &params);
+
+    for (int y = firstRow; y < firstRow + rowCount; y++) {
+        unsigned char* row = pixels + (size_t)y * desc->width * 4;
+        float rowT = (float)y * params.stepY;
+        uint32_t start = noise_row_start(&params, y);
+
+        for (int x = 0; x < desc->width; x++) {
+            switch (desc->pattern) {
+                case TEXTURE_PATTERN_CHECKER: {
+                    int cell = cell_index(x, params.cells, params.width) + cell_index(y, params.cells, params.height);
+                    memcpy(row + x * 4, (cell & 1) ? desc->color1 : desc->color0, 4);
+                    break;
+                }
+                case TEXTURE_PATTERN_GRADIENT:
+                    lerp_pixel(row + x * 4, &params, (float)x * params.stepX + rowT);
+                    break;
+                case TEXTURE_PATTERN_NOISE:
+                    lerp_pixel(row + x * 4, &params, noise_weight(start + (uint32_t)x * NOISE_COLUMN_STEP));
+                    break;
+            }
+        }
+    }
+}
+
+// Split the rows in contiguous ranges run as jobs (a few per thread, so the
+// threads that finish first steal from the others), and wait for all of them
+// with the calling thread helping.
+static void parallel_rows(job_system* jobs, int rows, job_range_func func, void* context) {
+    int threadCount = jobs ? job_system_thread_count(jobs) : 1;
+    if (threadCount < 2 || rows < 2 * TEXTURE_GEN_MIN_ROWS_PER_JOB) {
+        func(context, 0, (size_t)rows);
+        return;
+    }
+
+    size_t grain = (size_t)rows / ((size_t)threadCount * 4);
+    if (grain < TEXTURE_GEN_MIN_ROWS_PER_JOB) {
+        grain = TEXTURE_GEN_MIN_ROWS_PER_JOB;
+    }
+    job_counter counter;
+    job_counter_init(&counter);
+    job_parallel_for(jobs, (size_t)rows, grain, func, context, &counter);
+    job_wait(jobs, &counter);
+}
+
+typedef struct {
+    const texture_desc* desc;
+    unsigned char* pixels;
+} fill_context;
+
+static void fill_band(void* context, size_t begin, size_t end) {
+    fill_context* fill = context;
+    texture_gen_rows(fill->desc, fill->pixels, (int)begin, (int)(end - begin));
+}
+
+void texture_gen_fill(const texture_desc* desc, unsigned char* pixels, job_system* jobs) {
+    PROFILE_ZONE_BEGIN("texture_gen_fill");
+    fill_context context = { desc, pixels };
+    parallel_rows(jobs, desc->height, fill_band, &context);
+    PROFILE_ZONE_END();
+}
+
+int texture_gen_mip_levels(int width, int height) {
+    int size = width > height ? width : height;
+    int levels = 1;
+    while (size > 1) {
+        size /= 2;
+        levels++;
+    }
+    return levels;
+}
+
+size_t texture_gen_mip_offset(int width, int height, int level) {
+    size_t offset = 0;
+    for (int i = 0; i < level; i++) {
+        offset += (size_t)width * height * 4;
+        width = width > 1 ? width / 2 : 1;
+        height = height > 1 ? height / 2 : 1;
+    }
+    return offset;
+}
+
+size_t texture_gen_mip_chain_size(int width, int height) {
+    return texture_gen_mip_offset(width, height, texture_gen_mip_levels(width, height));
+}
+
+typedef struct {
+    const unsigned char* src;
+    int srcWidth;
+    int srcHeight;
+    unsigned char* dst;
+    int dstWidth;
+} downsample_context;
+
+static void downsample_band(void* context, size_t begin, size_t end) {
+    downsample_context* level = context;
+    size_t srcStride = (size_t)level->srcWidth * 4;
+
+    for (int y = (int)begin; y < (int)end; y++) {
+        // Odd sizes reuse the last row (or column) of the source.
+        int y1 = 2 * y + 1 < level->srcHeight ? 2 * y + 1 : level->srcHeight - 1;
+        const unsigned char* r0 = level->src + (size_t)(2 * y) * srcStride;
+        const unsigned char* r1 = level->src + (size_t)y1 * srcStride;
+        unsigned char* out = level->dst + (size_t)y * level->dstWidth * 4;
+
+        for (int x = downsample_span(out, r0, r1, level->srcWidth, level->dstWidth); x < level->dstWidth; x++) {
+            int x0 = 2 * x * 4;
+            int x1 = (2 * x + 1 < level->srcWidth ? 2 * x + 1 : level->srcWidth - 1) * 4;
+            for (int c = 0; c < 4; c++) {
+                out[x * 4 + c] = (unsigned char)((r0[x0 + c] + r0[x1 + c] + r1[x0 + c] + r1[x1 + c] + 2) >> 2);
+            }
+        }
+    }
+}
+
+void texture_gen_mips(unsigned char* pixels, int width, int height, job_system* jobs) {
+    PROFILE_ZONE_BEGIN("texture_gen_mips");
+    int levels = texture_gen_mip_levels(width, height);
+    unsigned char* src = pixels;
+    for (int level = 1; level < levels; level++) {
+        downsample_context context;
+        context.src = src;
+        context.srcWidth = width;
+        context.srcHeight = height;
+        context.dst = src + (size_t)width * height * 4;
+        context.dstWidth = width > 1 ? width / 2 : 1;
+
+        int dstHeight = height > 1 ? height / 2 : 1;
+        parallel_rows(jobs, dstHeight, downsample_band, &context);
+
+        src = context.dst;
+        width = context.dstWidth;
+        height = dstHeight;
+    }
+    PROFILE_ZONE_END();
+}
@@ -0,0 +1,67 @@
+//
+// Copyright (c) 2025, Byteplug LLC.
+//
+// This source file is part of a project made by the Erlangsters community and
+// is released under the MIT license. Please refer to the LICENSE.md file that
+// can be found at the root of the project repository.
+//
+// Written by Jonathan De Wachter <jonathan.dewachter@byteplug.io>
+//
+#ifndef TEXTURE_GEN_H
+#define TEXTURE_GEN_H
+
+#include <stddef.h>
+#include "job.h"
+
+// Procedural RGBA8 textures generated on the CPU. Rows are generated with
+// SSE2 or NEON when the compiler targets them (with a scalar fallback
+// otherwise), and texture_gen_fill() and texture_gen_mips() split the rows
+// into jobs of a job system (see job.h), so the threads are started once
+// rather than on every call and every level of a chain.
+//
+// Pixels are tightly packed (the stride is width * 4 bytes), so the output
+// can be written directly into a mapped pixel buffer object and uploaded
+// with the default GL_UNPACK_ALIGNMENT.
+typedef enum {
+    TEXTURE_PATTERN_CHECKER,
+    TEXTURE_PATTERN_GRADIENT,
+    TEXTURE_PATTERN_NOISE
+} texture_pattern;
+
+typedef struct {
+    texture_pattern pattern;
+    int width;
+    int height;
+    unsigned char color0[4];
+    unsigned char color1[4];
+    int cells;          // Checker: number of cells along each axis.
+    unsigned int seed;  // Noise: seed of the hash.
+} texture_desc;
+
+// Name of the instruction set used by texture_gen_rows() ("SSE2", "NEON" or
+// "scalar").
+const char* texture_gen_isa(void);
+
+// Generate the rows [firstRow, firstRow + rowCount) of the texture; pixels
+// points to the first row of the whole texture. The scalar variant is the
+// reference implementation.
+void texture_gen_rows(const texture_desc* desc, unsigned char* pixels, int firstRow, int rowCount);
+void texture_gen_rows_scalar(const texture_desc* desc, unsigned char* pixels, int firstRow, int rowCount);
+
+// Generate the whole texture. The rows are split into jobs of the system
+// when there is one (the calling thread must then be one of its threads), and
+// generated by the calling thread alone when it is NULL.
+void texture_gen_fill(const texture_desc* desc, unsigned char* pixels, job_system* jobs);
+
+// Number of levels of a full mip chain, and the size in bytes of the chain
+// (base level included) when the levels are stored one after the other.
+int texture_gen_mip_levels(int width, int height);
+size_t texture_gen_mip_chain_size(int width, int height);
+size_t texture_gen_mip_offset(int width, int height, int level);
+
+// Generate levels 1 and above of a mip chain by 2x2 box filtering, the base
+// level being at the start of pixels (see texture_gen_mip_chain_size()). The
+// jobs are as with texture_gen_fill().
+void texture_gen_mips(unsigned char* pixels, int width, int height, job_system* jobs);
+
+#endif // TEXTURE_GEN_H
@@ -0,0 +1,165 @@
+//
+// Copyright (c) 2025, Byteplug LLC.
+//
+// This source file is part of a project made by the Erlangsters community and
+// is released under the MIT license. Please refer to the LICENSE.md file that
+// can be found at the root of the project repository.
+//
+// Written by Jonathan De Wachter <jonathan.dewachter@byteplug.io>
+//
+#include "thread.h"
+#include <stdlib.h>
+#include "profiler.h"
+
+#if !defined(_WIN32)
+    #include <sched.h>
+    #include <unistd.h>
+#endif
+
+typedef struct {
+    thread_func func;
+    void* arg;
+} thread_start;
+
+#if defined(_WIN32)
+static DWORD WINAPI thread_trampoline(LPVOID param)
+#else
+static void* thread_trampoline(void* param)
+#endif
+{
+    thread_start start = *(thread_start*)param;
+    free(param);
+
+    start.func(start.arg);
+    profiler_thread_exit();
+
+#if defined(_WIN32)
+    return 0;
+#else
+    return NULL;
+#endif
+}
+
+int thread_create(thread_t* thread, thread_func func, void* arg) {
+    thread_start* start = malloc(sizeof(thread_start));
+    if (!start) {
+        return -1;
+    }
+    start->func = func;
+    start->arg = arg;
+
+#if defined(_WIN32)
+    *thread = CreateThread(NULL, 0, thread_trampoline, start, 0, NULL);
+    if (*thread == NULL) {
+        free(start);
+        return -1;
+    }
+#else
+    if (pthread_create(thread, NULL, thread_trampoline, start) != 0) {
+        free(start);
+        return -1;
+    }
+#endif
+
+    return 0;
+}
+
+void thread_join(thread_t thread) {
+#if defined(_WIN32)
+    WaitForSingleObject(thread, INFINITE);
+    CloseHandle(thread);
+#else
+    pthread_join(thread, NULL);
+#endif
+}
+
+void thread_yield(void) {
+#if defined(_WIN32)
+    SwitchToThread();
+#else
+    sched_yield();
+#endif
+}
+
+int thread_hardware_concurrency(void) {
+#if defined(_WIN32)
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    int count = (int)info.dwNumberOfProcessors;
+#else
+    int count = (int)sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+    return count > 0 ? count : 1;
+}
+
+void mutex_init(mutex_t* mutex) {
+#if defined(_WIN32)
+    InitializeCriticalSection(mutex);
+#else
+    pthread_mutex_init(mutex, NULL);
+#endif
+}
+
+void mutex_destroy(mutex_t* mutex) {
+#if defined(_WIN32)
+    DeleteCriticalSection(mutex);
+#else
+    pthread_mutex_destroy(mutex);
+#endif
+}
+
+void mutex_lock(mutex_t* mutex) {
+#if defined(_WIN32)
+    EnterCriticalSection(mutex);
+#else
+    pthread_mutex_lock(mutex);
+#endif
+}
+
+void mutex_unlock(mutex_t* mutex) {
+#if defined(_WIN32)
+    LeaveCriticalSection(mutex);
+#else
+    pthread_mutex_unlock(mutex);
+#endif
+}
+
+void cond_init(cond_t* cond) {
+#if defined(_WIN32)
+    InitializeConditionVariable(cond);
+#else
+    pthread_cond_init(cond, NULL);
+#endif
+}
+
+void cond_destroy(cond_t* cond) {
+#if defined(_WIN32)
+    (void)cond;
+#else
+    pthread_cond_destroy(cond);
+#endif
+}
+
+void cond_wait(cond_t* cond, mutex_t* mutex) {
+#if defined(_WIN32)
+    SleepConditionVariableCS(cond, mutex, INFINITE);
+#else
+    pthread_cond_wait(cond, mutex);
+#endif
+}
+
+void cond_signal(cond_t* cond) {
+#if defined(_WIN32)
+    WakeConditionVariable(cond);
+#else
+    pthread_cond_signal(cond);
+#endif
+}
+
+void cond_broadcast(cond_t* cond) {
+#if defined(_WIN32)
+    WakeAllConditionVariable(cond);
+#else
+    pthread_cond_broadcast(cond);
+#endif
+}
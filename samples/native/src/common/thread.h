@@ -0,0 +1,52 @@
+//
+// Copyright (c) 2025, Byteplug LLC.
+//
+// This source file is part of a project made by the Erlangsters community and
+// is released under the MIT license. Please refer to the LICENSE.md file that
+// can be found at the root of the project repository.
+//
+// Written by Jonathan De Wachter <jonathan.dewachter@byteplug.io>
+//
+#ifndef THREAD_H
+#define THREAD_H
+
+// Thin portability layer over the native threading API. C11 <threads.h> is
+// not available with MSVC nor on macOS, so the samples use this instead.
+#if defined(_WIN32)
+    #ifndef WIN32_LEAN_AND_MEAN
+        #define WIN32_LEAN_AND_MEAN
+    #endif
+    #include <windows.h>
+    typedef HANDLE thread_t;
+    typedef CRITICAL_SECTION mutex_t;
+    typedef CONDITION_VARIABLE cond_t;
+#else
+    #include <pthread.h>
+    typedef pthread_t thread_t;
+    typedef pthread_mutex_t mutex_t;
+    typedef pthread_cond_t cond_t;
+#endif
+
+typedef void (*thread_func)(void* arg);
+
+int thread_create(thread_t* thread, thread_func func, void* arg);
+void thread_join(thread_t thread);
+
+// Give the rest of the time slice of the calling thread to another thread.
+void thread_yield(void);
+
+// Number of hardware threads available to the process (at least 1).
+int thread_hardware_concurrency(void);
+
+void mutex_init(mutex_t* mutex);
+void mutex_destroy(mutex_t* mutex);
+void mutex_lock(mutex_t* mutex);
+void mutex_unlock(mutex_t* mutex);
+
+void cond_init(cond_t* cond);
+void cond_destroy(cond_t* cond);
+void cond_wait(cond_t* cond, mutex_t* mutex);
+void cond_signal(cond_t* cond);
+void cond_broadcast(cond_t* cond);
+
+#endif // THREAD_H
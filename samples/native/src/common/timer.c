@@ -0,0 +1,87 @@
+//
+// Copyright (c) 2025, Byteplug LLC.
+//
+// This source file is part of a project made by the Erlangsters community and
+// is released under the MIT license. Please refer to the LICENSE.md file that
+// can be found at the root of the project repository.
+//
+// Written by Jonathan De Wachter <jonathan.dewachter@byteplug.io>
+//
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+    #define _POSIX_C_SOURCE 200809L
+#endif
+
+#include "timer.h"
+#include "thread.h"
+
+#if defined(_WIN32)
+    #ifndef WIN32_LEAN_AND_MEAN
+        #define WIN32_LEAN_AND_MEAN
+    #endif
+    #include <windows.h>
+#else
+    #include <errno.h>
+    #include <time.h>
+#endif
+
+// How long before the deadline timer_sleep_until() stops sleeping and spins
+// instead: Sleep() has a granularity of a millisecond at best, while
+// clock_nanosleep() usually wakes up within the timer slack (50 µs) plus the
+// scheduling latency (around 100 µs in total on a virtual machine).
+#if defined(_WIN32)
+    #define SLEEP_MARGIN 0.002
+#else
+    #define SLEEP_MARGIN 0.0002
+#endif
+
+double timer_now(void) {
+#if defined(_WIN32)
+    static LARGE_INTEGER frequency;
+    LARGE_INTEGER counter;
+    if (frequency.QuadPart == 0) {
+        QueryPerformanceFrequency(&frequency);
+    }
+    QueryPerformanceCounter(&counter);
+    return (double)counter.QuadPart / (double)frequency.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+#endif
+}
+
+void timer_sleep(double seconds) {
+    if (seconds <= 0.0) {
+        return;
+    }
+
+#if defined(_WIN32)
+    Sleep((DWORD)(seconds * 1000.0));
+#else
+    struct timespec ts;
+    ts.tv_sec = (time_t)seconds;
+    ts.tv_nsec = (long)((seconds - (double)ts.tv_sec) * 1e9);
+    nanosleep(&ts, NULL);
+#endif
+}
+
+void timer_sleep_until(double deadline) {
+    double wake = deadline - SLEEP_MARGIN;
+    if (timer_now() < wake) {
+#if defined(_WIN32)
+        timer_sleep(wake - timer_now());
+#else
+        // Absolute, so a sleep interrupted or late to start is not extended.
+        struct timespec ts;
+        ts.tv_sec = (time_t)wake;
+        ts.tv_nsec = (long)((wake - (double)ts.tv_sec) * 1e9);
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR) {
+        }
+#endif
+    }
+    // Yielding gives the core away when another thread is ready, but is a
+    // busy wait otherwise.
+    while (timer_now() < deadline) {
+        thread_yield();
+    }
+}
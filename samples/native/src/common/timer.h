@@ -0,0 +1,26 @@
+//
+// Copyright (c) 2025, Byteplug LLC.
+//
+// This source file is part of a project made by the Erlangsters community and
+// is released under the MIT license. Please refer to the LICENSE.md file that
+// can be found at the root of the project repository.
+//
+// Written by Jonathan De Wachter <jonathan.dewachter@byteplug.io>
+//
+#ifndef TIMER_H
+#define TIMER_H
+
+// Monotonic time in seconds. Unlike glfwGetTime(), it can be used before GLFW
+// is initialized and from any thread.
+double timer_now(void);
+
+// Put the calling thread to sleep for the given duration in seconds.
+void timer_sleep(double seconds);
+
+// Sleep until timer_now() reaches deadline, without the oversleep of the
+// system sleep: the thread sleeps until shortly before the deadline (0.2 ms,
+// or 2 ms on Windows) and spins on thread_yield() for the rest, so it only
+// burns a core for that last stretch and does not wake up late.
+void timer_sleep_until(double deadline);
+
+#endif // TIMER_H
@@ -0,0 +1,283 @@
+//
+// Copyright (c) 2025, Byteplug LLC.
+//
+// This source file is part of a project made by the Erlangsters community and
+// is released under the MIT license. Please refer to the LICENSE.md file that
+// can be found at the root of the project repository.
+//
+// Written by Jonathan De Wachter <jonathan.dewachter@byteplug.io>
+//
+#include "transform.h"
+#include <stdlib.h>
+#include <string.h>
+
+// The local transform of the node changed since the last update.
+#define FLAG_LOCAL_DIRTY 1
+// The world matrix of the node was computed by the last update.
+#define FLAG_WORLD_CHANGED 2
+
+// Compute a * b for two affine matrices (the last row being 0, 0, 0, 1);
+// result must not alias either operand.
+static void multiplyAffine(float* result, const float* a, const float* b) {
+    for (int column = 0; column < 4; column++) {
+        const float* c = &b[column * 4];
+        result[column * 4 + 0] = a[0] * c[0] + a[4] * c[1] + a[8] * c[2];
+        result[column * 4 + 1] = a[1] * c[0] + a[5] * c[1] + a[9] * c[2];
+        result[column * 4 + 2] = a[2] * c[0] + a[6] * c[1] + a[10] * c[2];
+        result[column * 4 + 3] = 0.0f;
+    }
+    result[12] += a[12];
+    result[13] += a[13];
+    result[14] += a[14];
+    result[15] = 1.0f;
+}
+
+int transform_init(transform_hierarchy* hierarchy, int capacity) {
+    memset(hierarchy, 0, sizeof(transform_hierarchy));
+    size_t count = capacity > 0 ? (size_t)capacity : 1;
+    hierarchy->capacity = (int)count;
+    hierarchy->parent = malloc(count * sizeof(int));
+    hierarchy->position = malloc(count * 3 * sizeof(float));
+    hierarchy->rotation = malloc(count * 4 * sizeof(float));
+    hierarchy->scale = malloc(count * 3 * sizeof(float));
+    hierarchy->world = malloc(count * 16 * sizeof(float));
+    hierarchy->flags = malloc(count);
+    if (!hierarchy->parent || !hierarchy->position || !hierarchy->rotation || !hierarchy->scale ||
+        !hierarchy->world || !hierarchy->flags) {
+        transform_destroy(hierarchy);
+        return -1;
+    }
+    return 0;
+}
+
+void transform_destroy(transform_hierarchy* hierarchy) {
+    free(hierarchy->parent);
+    free(hierarchy->position);
+    free(hierarchy->rotation);
+    free(hierarchy->scale);
+    free(hierarchy->world);
+    free(hierarchy->flags);
+    memset(hierarchy, 0, sizeof(transform_hierarchy));
+}
+
+int transform_add(transform_hierarchy* hierarchy, int parent) {
+    if (hierarchy->count == hierarchy->capacity || parent >= hierarchy->count) {
+        return -1;
+    }
+
+    int node = hierarchy->count++;
+    hierarchy->parent[node] = parent;
+    float* position = &hierarchy->position[node * 3];
+    float* scale = &hierarchy->scale[node * 3];
+    position[0] = position[1] = position[2] = 0.0f;
+    scale[0] = scale[1] = scale[2] = 1.0f;
+    quat_identity(&hierarchy->rotation[node * 4]);
+    hierarchy->flags[node] = FLAG_LOCAL_DIRTY;
+    hierarchy->dirty = 1;
+    return node;
+}
+
+// Move every array in the order given by nodes (new index to old index).
+static int reorder(transform_hierarchy* hierarchy, const int* nodes, int* remap) {
+    size_t count = (size_t)hierarchy->count;
+    int* parent = malloc(count * sizeof(int));
+    float* position = malloc(count * 3 * sizeof(float));
+    float* rotation = malloc(count * 4 * sizeof(float));
+    float* scale = malloc(count * 3 * sizeof(float));
+    float* world = malloc(count * 16 * sizeof(float));
+    unsigned char* flags = malloc(count);
+    if (!parent || !position || !rotation || !scale || !world || !flags) {
+        free(parent);
+        free(position);
+        free(rotation);
+        free(scale);
+        free(world);
+        free(flags);
+        return -1;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        remap[nodes[i]] = (int)i;
+    }
+    for (size_t i = 0; i < count; i++) {
+        int old = nodes[i];
+        int oldParent = hierarchy->parent[old];
+        parent[i] = oldParent == TRANSFORM_NO_PARENT ? TRANSFORM_NO_PARENT : remap[oldParent];
+        memcpy(&position[i * 3], &hierarchy->position[old * 3], 3 * sizeof(float));
+        memcpy(&rotation[i * 4], &hierarchy->rotation[old * 4], 4 * sizeof(float));
+        memcpy(&scale[i * 3], &hierarchy->scale[old * 3], 3 * sizeof(float));
+        memcpy(&world[i * 16], &hierarchy->world[old * 16], 16 * sizeof(float));
+        flags[i] = hierarchy->flags[old];
+    }
+
+    free(hierarchy->parent);
+    free(hierarchy->position);
+    free(hierarchy->rotation);
+    free(hierarchy->scale);
+    free(hierarchy->world);
+    free(hierarchy->flags);
+    hierarchy->parent = parent;
+    hierarchy->position = position;
+    hierarchy->rotation = rotation;
+    hierarchy->scale = scale;
+    hierarchy->world = world;
+    hierarchy->flags = flags;
+    return 0;
+}
+
+// Sort the nodes in depth-first order, so every subtree is contiguous and
+// comes after its parent. The children of a node keep their relative order.
+static int sortNodes(transform_hierarchy* hierarchy, int* remap) {
+    size_t count = (size_t)hierarchy->count;
+    int* childOffsets = calloc(count + 2, sizeof(int));
+    int* children = malloc(count * sizeof(int));
+    int* order = malloc(count * sizeof(int));
+    int* stack = malloc(count * sizeof(int));
+    int* ownRemap = remap ? NULL : malloc(count * sizeof(int));
+    if (!childOffsets || !children || !order || !stack || (!remap && !ownRemap)) {
+        free(childOffsets);
+        free(children);
+        free(order);
+        free(stack);
+        free(ownRemap);
+        return -1;
+    }
+
+    // Children of every node in compressed rows, in group parent + 1 (so the
+    // roots are group 0). Filling the rows moves every offset from the start
+    // of its group to its end: group g then spans
+    // [childOffsets[g - 1], childOffsets[g]), and the roots [0, childOffsets[0]).
+    for (size_t i = 0; i < count; i++) {
+        childOffsets[hierarchy->parent[i] + 2]++;
+    }
+    for (size_t i = 1; i < count + 2; i++) {
+        childOffsets[i] += childOffsets[i - 1];
+    }
+    for (size_t i = 0; i < count; i++) {
+        children[childOffsets[hierarchy->parent[i] + 1]++] = (int)i;
+    }
+
+    // Push the children in reverse so they are visited in order.
+    size_t ordered = 0;
+    int top = 0;
+    for (int i = childOffsets[0] - 1; i >= 0; i--) {
+        stack[top++] = children[i];
+    }
+    while (top > 0) {
+        int node = stack[--top];
+        order[ordered++] = node;
+        int begin = childOffsets[node];
+        int end = childOffsets[node + 1];
+        for (int i = end - 1; i >= begin; i--) {
+            stack[top++] = children[i];
+        }
+    }
+
+    int result = reorder(hierarchy, order, remap ? remap : ownRemap);
+    free(childOffsets);
+    free(children);
+    free(order);
+    free(stack);
+    free(ownRemap);
+    return result;
+}
+
+int transform_set_parent(transform_hierarchy* hierarchy, int node, int parent, int* remap) {
+    if (node < 0 || node >= hierarchy->count ||
+        (parent != TRANSFORM_NO_PARENT && (parent < 0 || parent >= hierarchy->count))) {
+        return -1;
+    }
+    for (int ancestor = parent; ancestor != TRANSFORM_NO_PARENT; ancestor = hierarchy->parent[ancestor]) {
+        if (ancestor == node) {
+            return -1;
+        }
+    }
+
+    int previous = hierarchy->parent[node];
+    hierarchy->parent[node] = parent < 0 ? TRANSFORM_NO_PARENT : parent;
+    hierarchy->flags[node] |= FLAG_LOCAL_DIRTY;
+    hierarchy->dirty = 1;
+
+    if (parent > node) {
+        if (sortNodes(hierarchy, remap) != 0) {
+            hierarchy->parent[node] = previous;
+            return -1;
+        }
+    } else if (remap) {
+        for (int i = 0; i < hierarchy->count; i++) {
+            remap[i] = i;
+        }
+    }
+    return 0;
+}
+
+void transform_set_position(transform_hierarchy* hierarchy, int node, float x, float y, float z) {
+    float* position = &hierarchy->position[node * 3];
+    position[0] = x;
+    position[1] = y;
+    position[2] = z;
+    hierarchy->flags[node] |= FLAG_LOCAL_DIRTY;
+    hierarchy->dirty = 1;
+}
+
+void transform_set_rotation(transform_hierarchy* hierarchy, int node, const quat rotation) {
+    memcpy(&hierarchy->rotation[node * 4], rotation, 4 * sizeof(float));
+    hierarchy->flags[node] |= FLAG_LOCAL_DIRTY;
+    hierarchy->dirty = 1;
+}
+
+void transform_set_scale(transform_hierarchy* hierarchy, int node, float x, float y, float z) {
+    float* scale = &hierarchy->scale[node * 3];
+    scale[0] = x;
+    scale[1] = y;
+    scale[2] = z;
+    hierarchy->flags[node] |= FLAG_LOCAL_DIRTY;
+    hierarchy->dirty = 1;
+}
+
+void transform_mark_all(transform_hierarchy* hierarchy) {
+    for (int i = 0; i < hierarchy->count; i++) {
+        hierarchy->flags[i] |= FLAG_LOCAL_DIRTY;
+    }
+    hierarchy->dirty = 1;
+}
+
+int transform_update(transform_hierarchy* hierarchy) {
+    if (!hierarchy->dirty) {
+        // Only forget which matrices the previous update computed.
+        memset(hierarchy->flags, 0, (size_t)hierarchy->count);
+        return 0;
+    }
+
+    // Parents come first, so whether the world matrix of the parent changed
+    // is known by the time its children are visited.
+    int computed = 0;
+    const int* parents = hierarchy->parent;
+    unsigned char* flags = hierarchy->flags;
+    for (int i = 0; i < hierarchy->count; i++) {
+        int parent = parents[i];
+        int changed = (flags[i] & FLAG_LOCAL_DIRTY) ||
+            (parent != TRANSFORM_NO_PARENT && (flags[parent] & FLAG_WORLD_CHANGED));
+        flags[i] = changed ? FLAG_WORLD_CHANGED : 0;
+        if (!changed) {
+            continue;
+        }
+
+        float* world = &hierarchy->world[(size_t)i * 16];
+        if (parent == TRANSFORM_NO_PARENT) {
+            mat4_from_trs(world, &hierarchy->position[i * 3], &hierarchy->rotation[i * 4], &hierarchy->scale[i * 3]);
+        } else {
+            mat4 local;
+            mat4_from_trs(local, &hierarchy->position[i * 3], &hierarchy->rotation[i * 4], &hierarchy->scale[i * 3]);
+            multiplyAffine(world, &hierarchy->world[(size_t)parent * 16], local);
+        }
+        computed++;
+    }
+
+    hierarchy->dirty = 0;
+    return computed;
+}
+
+int transform_changed(const transform_hierarchy* hierarchy, int node) {
+    return (hierarchy->flags[node] & FLAG_WORLD_CHANGED) != 0;
+}
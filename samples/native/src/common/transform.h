@@ -0,0 +1,76 @@
+//
+// Copyright (c) 2025, Byteplug LLC.
+//
+// This source file is part of a project made by the Erlangsters community and
+// is released under the MIT license. Please refer to the LICENSE.md file that
+// can be found at the root of the project repository.
+//
+// Written by Jonathan De Wachter <jonathan.dewachter@byteplug.io>
+//
+#ifndef TRANSFORM_H
+#define TRANSFORM_H
+
+#include <stddef.h>
+#include "matrix.h"
+
+// Hierarchy of transforms, stored as structure of arrays: the local
+// positions, rotations and scales, the parents, and the world matrices are
+// each one contiguous array indexed by node.
+//
+// Nodes are kept in topological order (every parent comes before its
+// children), so transform_update() computes all the world matrices in a
+// single linear pass, and the world matrices are one array of count * 16
+// floats that can be uploaded as is.
+//
+// Changing the local transform of a node marks it dirty; the next update
+// only recomputes the world matrices of the dirty nodes and of their
+// descendants.
+#define TRANSFORM_NO_PARENT -1
+
+typedef struct {
+    int count;
+    int capacity;
+    int* parent;
+    float* position;  // 3 per node.
+    float* rotation;  // 4 per node (a quaternion).
+    float* scale;     // 3 per node.
+    float* world;     // 16 per node.
+    unsigned char* flags;
+    int dirty;  // Whether any node is dirty.
+} transform_hierarchy;
+
+int transform_init(transform_hierarchy* hierarchy, int capacity);
+void transform_destroy(transform_hierarchy* hierarchy);
+
+// Add a node with an identity transform under parent (TRANSFORM_NO_PARENT
+// for a root), which must already exist so the order is kept. Returns the
+// index of the node, or -1 when the hierarchy is full.
+int transform_add(transform_hierarchy* hierarchy, int parent);
+
+// Move a node (and its subtree) under another parent. When the parent comes
+// after the node, the nodes are sorted again; remap (when not NULL, count
+// entries) receives the new index of every node. Returns -1 (and changes
+// nothing) when the parent is in the subtree of the node, or the memory to
+// sort the nodes cannot be allocated. Returns -1 as well when the node or the
+// parent (other than TRANSFORM_NO_PARENT) is not in the hierarchy.
+int transform_set_parent(transform_hierarchy* hierarchy, int node, int parent, int* remap);
+
+void transform_set_position(transform_hierarchy* hierarchy, int node, float x, float y, float z);
+void transform_set_rotation(transform_hierarchy* hierarchy, int node, const quat rotation);
+void transform_set_scale(transform_hierarchy* hierarchy, int node, float x, float y, float z);
+
+// Mark every node dirty, so the next update recomputes everything.
+void transform_mark_all(transform_hierarchy* hierarchy);
+
+// Recompute the world matrices of the dirty nodes and their descendants.
+// Returns the number of matrices computed.
+int transform_update(transform_hierarchy* hierarchy);
+
+// Whether the world matrix of a node was computed by the last update.
+int transform_changed(const transform_hierarchy* hierarchy, int node);
+
+static inline const float* transform_world(const transform_hierarchy* hierarchy, int node) {
+    return &hierarchy->world[(size_t)node * 16];
+}
+
+#endif // TRANSFORM_H
@@ -20,6 +20,9 @@
 #include <string.h>
 #include "gl_api.h"
 #include "window.h"
+#include "profiler.h"
+#include "startup.h"
+#include "thread.h"
 #include <GLFW/glfw3native.h>
 #include <stdio.h>
 
@@ -44,29 +47,8 @@ void window_size_callback(GLFWwindow* window, int width, int height)
     glViewport(0, 0, width, height);
 }
 
-int initializeWindow(
-    GLFWwindow** window,
-    EGLDisplay* display,
-    EGLContext* context,
-    EGLSurface* surface,
-    int width, int height,
-    const char* title
-) {
-    // Initialize EGL.
-    *display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
-    if (*display == EGL_NO_DISPLAY) {
-        fprintf(stderr, "Failed to get EGL display\n");
-        glfwTerminate();
-            return -1;
-        }
-
-    if (!eglInitialize(*display, NULL, NULL)) {
-        fprintf(stderr, "Failed to initialize EGL\n");
-        glfwTerminate();
-        return -1;
-    }
-
-    // Set the rendering API.
+static void bind_api(void)
+{
     #if SAMPLE_OPENGL_API == SAMPLE_API_GL
         eglBindAPI(EGL_OPENGL_API);
     #elif SAMPLE_OPENGL_API == SAMPLE_API_GLES
@@ -74,8 +56,10 @@ int initializeWindow(
     #else
         #error "Unsupported OpenGL version."
     #endif
+}
 
-    // Choose an EGL config.
+static int choose_config(EGLDisplay display, EGLint surfaceType, EGLConfig* config)
+{
     #if SAMPLE_OPENGL_API == SAMPLE_API_GL
         EGLint renderableType = EGL_OPENGL_BIT;
     #elif SAMPLE_OPENGL_VERSION_MAJOR == 2
@@ -85,94 +69,339 @@ int initializeWindow(
     #endif
 
     EGLint configAttribs[] = {
-        EGL_SURFACE_TYPE, EGL_WINDOW_BIT,
+        EGL_SURFACE_TYPE, surfaceType,
         EGL_RENDERABLE_TYPE, renderableType,
+        EGL_DEPTH_SIZE, 16,
         EGL_NONE
     };
-    EGLConfig config;
     EGLint numConfigs;
-    if (!eglChooseConfig(*display, configAttribs, &config, 1, &numConfigs) || numConfigs < 1) {
-        fprintf(stderr, "Failed to choose EGL config\n");
-        eglTerminate(*display);
+    if (!eglChooseConfig(display, configAttribs, config, 1, &numConfigs) || numConfigs < 1) {
         return -1;
     }
 
-    // Create an EGL context.
-    EGLint contextAttribs[] = {
-        EGL_CONTEXT_MAJOR_VERSION, SAMPLE_OPENGL_VERSION_MAJOR,
-        EGL_CONTEXT_MINOR_VERSION, SAMPLE_OPENGL_VERSION_MINOR,
-        EGL_NONE
-    };
-    *context = eglCreateContext(*display, config, EGL_NO_CONTEXT, contextAttribs);
-    if (*context == EGL_NO_CONTEXT) {
+    return 0;
+}
+
+static int check_context_extensions(EGLDisplay display)
+{
+    // Requesting an explicit GLES 3.x context through EGL depends on
+    // EGL_KHR_create_context on the EGL implementations we target today.
+    #if SAMPLE_OPENGL_API == SAMPLE_API_GLES && SAMPLE_OPENGL_VERSION_MAJOR >= 3
+        const char* egl_extensions = eglQueryString(display, EGL_EXTENSIONS);
+        if (!egl_extensions || strstr(egl_extensions, "EGL_KHR_create_context") == NULL) {
+            fprintf(stderr, "EGL_KHR_create_context is required for OpenGL ES 3.x contexts\n");
+            return -1;
+        }
+    #else
+        (void)display;
+    #endif
+
+    return 0;
+}
+
+static void print_versions(EGLDisplay display)
+{
+    const char* egl_version = eglQueryString(display, EGL_VERSION);
+    printf("EGL Version: %s\n", egl_version);
+
+    const char* gl_version = (const char*)glGetString(GL_VERSION);
+    printf("OpenGL Version: %s\n", gl_version);
+}
+
+// Everything EGL needs before a surface can be created. It does not depend on
+// the window, so initializeWindow() runs it on a separate thread while GLFW
+// creates the window on the main thread.
+typedef struct {
+    EGLint surfaceType;
+    EGLDisplay display;
+    EGLConfig config;
+    EGLContext context;
+    int result;
+} egl_setup;
+
+static void run_egl_setup(egl_setup* setup)
+{
+    int phase = startup_phase_begin("egl_initialize");
+    setup->display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    if (setup->display == EGL_NO_DISPLAY) {
+        fprintf(stderr, "Failed to get EGL display\n");
+        startup_phase_end(phase);
+        return;
+    }
+
+    if (!eglInitialize(setup->display, NULL, NULL)) {
+        fprintf(stderr, "Failed to initialize EGL\n");
+        setup->display = EGL_NO_DISPLAY;
+        startup_phase_end(phase);
+        return;
+    }
+    startup_phase_end(phase);
+
+    // Set the rendering API (it is per-thread state, so the thread making the
+    // context current binds it again).
+    bind_api();
+
+    // Choose an EGL config.
+    phase = startup_phase_begin("egl_choose_config");
+    if (choose_config(setup->display, setup->surfaceType, &setup->config) != 0) {
+        fprintf(stderr, "Failed to choose EGL config\n");
+        eglTerminate(setup->display);
+        setup->display = EGL_NO_DISPLAY;
+        startup_phase_end(phase);
+        return;
+    }
+    startup_phase_end(phase);
+
+    // Create an EGL context, making sure the explicit context version we
+    // request is honored.
+    phase = startup_phase_begin("egl_create_context");
+    if (check_context_extensions(setup->display) != 0) {
+        eglTerminate(setup->display);
+        setup->display = EGL_NO_DISPLAY;
+        startup_phase_end(phase);
+        return;
+    }
+    setup->context = createSharedContext(setup->display, setup->config, EGL_NO_CONTEXT);
+    if (setup->context == EGL_NO_CONTEXT) {
         fprintf(stderr, "Failed to create EGL context\n");
-        eglTerminate(*display);
-        return -1;
+        eglTerminate(setup->display);
+        setup->display = EGL_NO_DISPLAY;
+        startup_phase_end(phase);
+        return;
+    }
+    startup_phase_end(phase);
+
+    setup->result = 0;
+}
+
+static void setup_egl(egl_setup* setup)
+{
+    setup->result = -1;
+    setup->context = EGL_NO_CONTEXT;
+
+    PROFILE_ZONE_BEGIN("setup_egl");
+    run_egl_setup(setup);
+    PROFILE_ZONE_END();
+}
+
+static void setup_egl_thread(void* arg)
+{
+    PROFILE_THREAD_NAME("egl setup");
+    setup_egl(arg);
+}
+
+int initializeWindow(
+    GLFWwindow** window,
+    EGLDisplay* display,
+    EGLContext* context,
+    EGLSurface* surface,
+    int width, int height,
+    const char* title
+) {
+    PROFILE_ZONE_BEGIN("initializeWindow");
+
+    // Initialize EGL in the background.
+    egl_setup egl;
+    egl.surfaceType = EGL_WINDOW_BIT;
+
+    thread_t eglThread;
+    int eglThreaded = thread_create(&eglThread, setup_egl_thread, &egl) == 0;
+    if (!eglThreaded) {
+        setup_egl(&egl);
+    }
+
+    // Meanwhile, initialize GLFW and create the window. GLFW must be used
+    // from the main thread.
+    int phase = startup_phase_begin("glfw_init");
+    int glfwReady = glfwInit();
+    startup_phase_end(phase);
+
+    if (glfwReady) {
+        // Create a GLFW window (without OpenGL context).
+        phase = startup_phase_begin("glfw_create_window");
+        glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
+        *window = glfwCreateWindow(width, height, title, NULL, NULL);
+        startup_phase_end(phase);
+    } else {
+        *window = NULL;
     }
 
-    // Initialize GLFW.
-    if (!glfwInit()) {
-        fprintf(stderr, "Failed to initialize GLFW\n");
+    if (eglThreaded) {
+        thread_join(eglThread);
+    }
+
+    if (!glfwReady || !*window) {
+        fprintf(stderr, glfwReady ? "Failed to create GLFW window\n" : "Failed to initialize GLFW\n");
+        glfwTerminate();
+        if (egl.result == 0) {
+            eglDestroyContext(egl.display, egl.context);
+            eglTerminate(egl.display);
+        }
+        PROFILE_ZONE_END();
         return -1;
     }
 
-    // Create a GLFW window (without OpenGL context).
-    glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
-    *window = glfwCreateWindow(width, height, title, NULL, NULL);
-    if (!*window) {
-        fprintf(stderr, "Failed to create GLFW window\n");
+    if (egl.result != 0) {
+        glfwDestroyWindow(*window);
         glfwTerminate();
-        eglDestroyContext(*display, *context);
-        eglTerminate(*display);
+        PROFILE_ZONE_END();
         return -1;
     }
 
-    // Requesting an explicit GLES 3.x context through EGL depends on
-    // EGL_KHR_create_context on the EGL implementations we target today.
-    #if SAMPLE_OPENGL_API == SAMPLE_API_GLES && SAMPLE_OPENGL_VERSION_MAJOR >= 3
-        const char* egl_extensions = eglQueryString(*display, EGL_EXTENSIONS);
-        if (!egl_extensions || strstr(egl_extensions, "EGL_KHR_create_context") == NULL) {
-            fprintf(stderr, "EGL_KHR_create_context is required for OpenGL ES 3.x contexts\n");
-            glfwDestroyWindow(*window);
-            glfwTerminate();
-            eglDestroyContext(*display, *context);
-            eglTerminate(*display);
-            return -1;
-        }
-    #endif
+    *display = egl.display;
+    *context = egl.context;
+    bind_api();
 
     // Set the GLFW window size callback to adjust the OpenGL viewport.
     glfwSetWindowSizeCallback(*window, window_size_callback);
 
     // GLFW gives us the platform-native window object, while EGL turns it into
     // the presentation surface used by the samples.
-    *surface = eglCreateWindowSurface(*display, config, get_native_window_handle(*window), NULL);
+    phase = startup_phase_begin("egl_create_window_surface");
+    *surface = eglCreateWindowSurface(*display, egl.config, get_native_window_handle(*window), NULL);
+    startup_phase_end(phase);
     if (*surface == EGL_NO_SURFACE) {
         fprintf(stderr, "Failed to create EGL surface\n");
         glfwDestroyWindow(*window);
         glfwTerminate();
         eglDestroyContext(*display, *context);
         eglTerminate(*display);
+        PROFILE_ZONE_END();
         return -1;
     }
 
     // Make the EGL context current.
+    phase = startup_phase_begin("egl_make_current");
     if (!eglMakeCurrent(*display, *surface, *surface, *context)) {
         fprintf(stderr, "Failed to make EGL context current\n");
+        startup_phase_end(phase);
         eglDestroySurface(*display, *surface);
         glfwDestroyWindow(*window);
         glfwTerminate();
         eglDestroyContext(*display, *context);
         eglTerminate(*display);
+        PROFILE_ZONE_END();
         return -1;
     }
+    startup_phase_end(phase);
 
     // Display the OpenGL version and EGL version.
-    const char* egl_version = eglQueryString(*display, EGL_VERSION);
-    printf("EGL Version: %s\n", egl_version);
+    print_versions(*display);
 
-    const char* gl_version = (const char*)glGetString(GL_VERSION);
-    printf("OpenGL Version: %s\n", gl_version);
+    PROFILE_ZONE_END();
+    return 0;
+}
+
+int initializeHeadless(
+    EGLDisplay* display,
+    EGLConfig* config,
+    EGLContext* context,
+    EGLSurface* surface,
+    int width, int height
+) {
+    egl_setup egl;
+    egl.surfaceType = EGL_PBUFFER_BIT;
+    setup_egl(&egl);
+    if (egl.result != 0) {
+        return -1;
+    }
+
+    *display = egl.display;
+    *config = egl.config;
+    *context = egl.context;
+
+    *surface = createOffscreenSurface(*display, *config, width, height);
+    if (*surface == EGL_NO_SURFACE) {
+        fprintf(stderr, "Failed to create EGL pbuffer surface\n");
+        eglDestroyContext(*display, *context);
+        eglTerminate(*display);
+        return -1;
+    }
+
+    int phase = startup_phase_begin("egl_make_current");
+    if (!eglMakeCurrent(*display, *surface, *surface, *context)) {
+        fprintf(stderr, "Failed to make EGL context current\n");
+        startup_phase_end(phase);
+        eglDestroySurface(*display, *surface);
+        eglDestroyContext(*display, *context);
+        eglTerminate(*display);
+        return -1;
+    }
+    startup_phase_end(phase);
+
+    print_versions(*display);
+
+    return 0;
+}
+
+void terminateHeadless(EGLDisplay display, EGLContext context, EGLSurface surface) {
+    eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    eglDestroySurface(display, surface);
+    eglDestroyContext(display, context);
+    eglTerminate(display);
+}
+
+EGLContext createSharedContext(EGLDisplay display, EGLConfig config, EGLContext share) {
+    EGLint contextAttribs[] = {
+        EGL_CONTEXT_MAJOR_VERSION, SAMPLE_OPENGL_VERSION_MAJOR,
+        EGL_CONTEXT_MINOR_VERSION, SAMPLE_OPENGL_VERSION_MINOR,
+        // Some drivers only emit KHR_debug messages for debug contexts.
+        #if defined(SAMPLE_GL_DEBUG)
+            EGL_CONTEXT_OPENGL_DEBUG, EGL_TRUE,
+        #endif
+        EGL_NONE
+    };
+    return eglCreateContext(display, config, share, contextAttribs);
+}
+
+EGLSurface createOffscreenSurface(EGLDisplay display, EGLConfig config, int width, int height) {
+    EGLint surfaceAttribs[] = {
+        EGL_WIDTH, width,
+        EGL_HEIGHT, height,
+        EGL_NONE
+    };
+    return eglCreatePbufferSurface(display, config, surfaceAttribs);
+}
+
+int createWindowSurface(
+    GLFWwindow** window,
+    EGLSurface* surface,
+    EGLDisplay display,
+    EGLConfig config,
+    int width, int height,
+    const char* title
+) {
+    glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
+    *window = glfwCreateWindow(width, height, title, NULL, NULL);
+    if (!*window) {
+        fprintf(stderr, "Failed to create GLFW window\n");
+        return -1;
+    }
+
+    *surface = eglCreateWindowSurface(display, config, get_native_window_handle(*window), NULL);
+    if (*surface == EGL_NO_SURFACE) {
+        fprintf(stderr, "Failed to create EGL surface\n");
+        glfwDestroyWindow(*window);
+        return -1;
+    }
+
+    return 0;
+}
+
+int queryContextConfig(EGLDisplay display, EGLContext context, EGLConfig* config) {
+    EGLint configId;
+    if (!eglQueryContext(display, context, EGL_CONFIG_ID, &configId)) {
+        return -1;
+    }
+
+    EGLint configAttribs[] = {
+        EGL_CONFIG_ID, configId,
+        EGL_NONE
+    };
+    EGLint numConfigs;
+    if (!eglChooseConfig(display, configAttribs, config, 1, &numConfigs) || numConfigs < 1) {
+        return -1;
+    }
 
     return 0;
 }
@@ -14,6 +14,9 @@
 #include <GLFW/glfw3.h>
 #include <EGL/egl.h>
 
+// Create the window, the EGL context and its window surface, and make the
+// context current. EGL is initialized on a separate thread while GLFW creates
+// the window; both are recorded as startup phases (see startup.h).
 int initializeWindow(
     GLFWwindow** window,
     EGLDisplay* display,
@@ -26,4 +29,41 @@ int initializeWindow(
 
 void terminateWindow(GLFWwindow* window);
 
+// Initialize EGL without a window. The context is made current on a small
+// pbuffer surface so it can be used to create resources shared with other
+// contexts; GLFW is left untouched.
+int initializeHeadless(
+    EGLDisplay* display,
+    EGLConfig* config,
+    EGLContext* context,
+    EGLSurface* surface,
+    int width,
+    int height
+);
+
+void terminateHeadless(EGLDisplay display, EGLContext context, EGLSurface surface);
+
+// Create a context of the sample's API version. When a share context is
+// given, programs, buffers and textures are shared with it (but container
+// objects such as vertex arrays and framebuffers are not).
+EGLContext createSharedContext(EGLDisplay display, EGLConfig config, EGLContext share);
+
+EGLSurface createOffscreenSurface(EGLDisplay display, EGLConfig config, int width, int height);
+
+// Create an additional GLFW window and its EGL surface. GLFW must have been
+// initialized already (by initializeWindow()) and this must be called from
+// the main thread.
+int createWindowSurface(
+    GLFWwindow** window,
+    EGLSurface* surface,
+    EGLDisplay display,
+    EGLConfig config,
+    int width,
+    int height,
+    const char* title
+);
+
+// Retrieve the config a context was created with.
+int queryContextConfig(EGLDisplay display, EGLContext context, EGLConfig* config);
+
 #endif // WINDOW_H
@@ -0,0 +1,505 @@
+//
+// Copyright (c) 2025, Byteplug LLC.
+//
+// This source file is part of a project made by the Erlangsters community and
+// is released under the MIT license. Please refer to the LICENSE.md file that
+// can be found at the root of the project repository.
+//
+// Written by Jonathan De Wachter <jonathan.dewachter@byteplug.io>
+//
+#include <math.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "gl_api.h"
+#include "gl_debug.h"
+#include "gpu_memory.h"
+#include "job.h"
+#include "matrix.h"
+#include "window.h"
+#include "options.h"
+#include "profiler.h"
+#include "report.h"
+#include "shader.h"
+#include "thread.h"
+#include "timer.h"
+
+// Spins a large cloud of objects around the camera and runs the CPU side of
+// every frame on the job system: the model matrices of the objects are
+// updated, then (once they all are) the objects are culled against the view
+// frustum and the visible ones are appended to the draw list, which the main
+// thread then uploads and draws as points. The frames are run with 1, 2, 4,
+// ... threads up to --threads, to measure how the CPU work scales.
+
+#define ATTRIB_POSITION 0
+#define ATTRIB_COLOR 1
+
+#define FIELD_OF_VIEW 60.0f
+#define CLOUD_RADIUS 100.0f
+
+// Visible objects are appended to the draw list in batches of this size, so
+// the cursor of the list is not contended.
+#define DRAW_BATCH 256
+
+static const char* vertexSource =
+    "ATTRIBUTE vec4 vertPosition;\n"
+    "ATTRIBUTE vec3 vertColor;\n"
+    "VARYING_OUT vec3 fragColor;\n"
+    "uniform mat4 mViewProj;\n"
+    "uniform float pointScale;\n"
+    "void main() {\n"
+    "    fragColor = vertColor;\n"
+    "    gl_Position = mViewProj * vec4(vertPosition.xyz, 1.0);\n"
+    "    gl_PointSize = clamp(vertPosition.w * pointScale / gl_Position.w, 1.0, 32.0);\n"
+    "}\n";
+
+static const char* fragmentSource =
+    "VARYING_IN vec3 fragColor;\n"
+    "void main() {\n"
+    "    vec2 offset = gl_PointCoord * 2.0 - 1.0;\n"
+    "    float distance = dot(offset, offset);\n"
+    "    if (distance > 1.0) {\n"
+    "        discard;\n"
+    "    }\n"
+    "    FRAG_COLOR = vec4(fragColor * (1.0 - 0.5 * distance), 1.0);\n"
+    "}\n";
+
+static const char* attributes[] = { "vertPosition", "vertColor", NULL };
+
+// An entry of the draw list: the position and size of the object, then its
+// color.
+typedef struct {
+    float position[4];
+    float color[3];
+} draw_item;
+
+// The objects, in structure of arrays.
+typedef struct {
+    int count;
+    float* orbitRadius;
+    float* orbitAngle;
+    float* orbitSpeed;
+    float* height;
+    float* spin;
+    float* scale;
+    float* tint;  // 3 per object.
+    float* matrices;  // 16 per object.
+} objects;
+
+typedef struct {
+    objects objects;
+    draw_item* drawList;
+    atomic_int drawCount;
+    float time;
+    float planes[6][4];  // Frustum planes of the current frame.
+
+    // The stages of a frame.
+    job_system* jobs;
+    job_counter updated;
+    job_counter culled;
+
+    GLuint program;
+    GLint viewProjLocation;
+    GLint pointScaleLocation;
+    GLuint vbo;
+    size_t vboSize;
+    #if SAMPLE_OPENGL_API == SAMPLE_API_GL || SAMPLE_OPENGL_VERSION_MAJOR >= 3
+        GLuint vao;
+    #endif
+} scene;
+
+typedef struct {
+    int threads;
+    long long frames;
+    double seconds;
+    double cpuSeconds;
+    double visible;
+} run_stats;
+
+static float randomFloat(unsigned int* state) {
+    *state = *state * 1664525u + 1013904223u;
+    return (float)(*state >> 8) / 16777216.0f;
+}
+
+static int createScene(scene* scene, int objectCount) {
+    const float pi = 3.14159265358979323846f;
+    objects* objects = &scene->objects;
+    size_t count = (size_t)objectCount;
+    objects->count = objectCount;
+    objects->orbitRadius = malloc(count * sizeof(float));
+    objects->orbitAngle = malloc(count * sizeof(float));
+    objects->orbitSpeed = malloc(count * sizeof(float));
+    objects->height = malloc(count * sizeof(float));
+    objects->spin = malloc(count * sizeof(float));
+    objects->scale = malloc(count * sizeof(float));
+    objects->tint = malloc(count * 3 * sizeof(float));
+    objects->matrices = malloc(count * 16 * sizeof(float));
+    scene->drawList = malloc(count * sizeof(draw_item));
+    if (!objects->orbitRadius || !objects->orbitAngle || !objects->orbitSpeed || !objects->height ||
+        !objects->spin || !objects->scale || !objects->tint || !objects->matrices || !scene->drawList) {
+        fprintf(stderr, "Failed to allocate %d objects\n", objectCount);
+        return -1;
+    }
+
+    unsigned int state = 1;
+    for (size_t i = 0; i < count; i++) {
+        float radius = 5.0f + sqrtf(randomFloat(&state)) * CLOUD_RADIUS;
+        objects->orbitRadius[i] = radius;
+        objects->orbitAngle[i] = randomFloat(&state) * 2.0f * pi;
+        objects->orbitSpeed[i] = (0.5f + randomFloat(&state)) * 4.0f / radius;
+        objects->height[i] = (randomFloat(&state) - 0.5f) * 20.0f;
+        objects->spin[i] = (randomFloat(&state) - 0.5f) * 4.0f;
+        objects->scale[i] = 0.3f + randomFloat(&state) * 0.7f;
+        objects->tint[i * 3 + 0] = 0.4f + randomFloat(&state) * 0.6f;
+        objects->tint[i * 3 + 1] = 0.4f + randomFloat(&state) * 0.6f;
+        objects->tint[i * 3 + 2] = 0.4f + randomFloat(&state) * 0.6f;
+    }
+
+    shader_program program = {
+        .label = "Object program",
+        .vertex = vertexSource,
+        .fragment = fragmentSource,
+        .attributes = attributes
+    };
+    scene->program = shader_build(&program);
+    if (!scene->program) {
+        return -1;
+    }
+    scene->viewProjLocation = glGetUniformLocation(scene->program, "mViewProj");
+    scene->pointScaleLocation = glGetUniformLocation(scene->program, "pointScale");
+
+    #if SAMPLE_OPENGL_API == SAMPLE_API_GL || SAMPLE_OPENGL_VERSION_MAJOR >= 3
+        glGenVertexArrays(1, &scene->vao);
+        glBindVertexArray(scene->vao);
+    #endif
+
+    // The draw list is streamed every frame; the buffer is sized for the
+    // worst case, every object being visible.
+    scene->vboSize = count * sizeof(draw_item);
+    glGenBuffers(1, &scene->vbo);
+    glBindBuffer(GL_ARRAY_BUFFER, scene->vbo);
+    GL_CHECK(glBufferData(GL_ARRAY_BUFFER, scene->vboSize, NULL, GL_STREAM_DRAW));
+    gpu_memory_track(GPU_MEMORY_BUFFER, scene->vbo, scene->vboSize);
+    gl_debug_label(GL_BUFFER, scene->vbo, "Draw list");
+
+    glVertexAttribPointer(ATTRIB_POSITION, 4, GL_FLOAT, GL_FALSE, sizeof(draw_item), 0);
+    glVertexAttribPointer(ATTRIB_COLOR, 3, GL_FLOAT, GL_FALSE, sizeof(draw_item),
+        (void*)offsetof(draw_item, color));
+    glEnableVertexAttribArray(ATTRIB_POSITION);
+    glEnableVertexAttribArray(ATTRIB_COLOR);
+
+    #if SAMPLE_OPENGL_API == SAMPLE_API_GL
+        glEnable(GL_PROGRAM_POINT_SIZE);
+    #endif
+    glEnable(GL_DEPTH_TEST);
+
+    return 0;
+}
+
+static void deleteScene(scene* scene) {
+    gpu_memory_untrack(GPU_MEMORY_BUFFER, scene->vbo);
+    glDeleteBuffers(1, &scene->vbo);
+    #if SAMPLE_OPENGL_API == SAMPLE_API_GL || SAMPLE_OPENGL_VERSION_MAJOR >= 3
+        glDeleteVertexArrays(1, &scene->vao);
+    #endif
+    glDeleteProgram(scene->program);
+
+    objects* objects = &scene->objects;
+    free(objects->orbitRadius);
+    free(objects->orbitAngle);
+    free(objects->orbitSpeed);
+    free(objects->height);
+    free(objects->spin);
+    free(objects->scale);
+    free(objects->tint);
+    free(objects->matrices);
+    free(scene->drawList);
+}
+
+// Stage 1: the model matrices of a range of objects, each one orbiting
+// around the center and spinning on itself.
+static void updateObjects(void* arg, size_t begin, size_t end) {
+    PROFILE_ZONE_BEGIN("update");
+    scene* scene = arg;
+    objects* objects = &scene->objects;
+    for (size_t i = begin; i < end; i++) {
+        float angle = objects->orbitAngle[i] + scene->time * objects->orbitSpeed[i];
+        float spin = scene->time * objects->spin[i];
+        float scale = objects->scale[i];
+        float* m = &objects->matrices[i * 16];
+
+        mat4 rotation;
+        mat4_identity(rotation);
+        mat4_rotate_y(rotation, rotation, spin);
+        mat4_rotate_x(rotation, rotation, spin * 0.7f);
+        for (int k = 0; k < 12; k++) {
+            m[k] = rotation[k] * scale;
+        }
+        m[12] = cosf(angle) * objects->orbitRadius[i];
+        m[13] = objects->height[i];
+        m[14] = sinf(angle) * objects->orbitRadius[i];
+        m[15] = 1.0f;
+    }
+    PROFILE_ZONE_END();
+}
+
+// Stage 2: cull a range of objects against the view frustum, and append the
+// visible ones to the draw list.
+static void cullObjects(void* arg, size_t begin, size_t end) {
+    PROFILE_ZONE_BEGIN("cull");
+    scene* scene = arg;
+    const objects* objects = &scene->objects;
+    draw_item batch[DRAW_BATCH];
+    int batchCount = 0;
+
+    for (size_t i = begin; i < end; i++) {
+        const float* m = &objects->matrices[i * 16];
+        float radius = objects->scale[i];
+        int visible = 1;
+        for (int p = 0; p < 6 && visible; p++) {
+            const float* plane = scene->planes[p];
+            visible = plane[0] * m[12] + plane[1] * m[13] + plane[2] * m[14] + plane[3] > -radius;
+        }
+        if (!visible) {
+            continue;
+        }
+
+        // Shade the object by how much its (rotated) up axis faces up.
+        float shade = 0.4f + 0.6f * fabsf(m[5]) / radius;
+        draw_item* item = &batch[batchCount++];
+        item->position[0] = m[12];
+        item->position[1] = m[13];
+        item->position[2] = m[14];
+        item->position[3] = radius;
+        item->color[0] = objects->tint[i * 3 + 0] * shade;
+        item->color[1] = objects->tint[i * 3 + 1] * shade;
+        item->color[2] = objects->tint[i * 3 + 2] * shade;
+
+        if (batchCount == DRAW_BATCH) {
+            int first = atomic_fetch_add(&scene->drawCount, batchCount);
+            memcpy(&scene->drawList[first], batch, (size_t)batchCount * sizeof(draw_item));
+            batchCount = 0;
+        }
+    }
+    if (batchCount > 0) {
+        int first = atomic_fetch_add(&scene->drawCount, batchCount);
+        memcpy(&scene->drawList[first], batch, (size_t)batchCount * sizeof(draw_item));
+    }
+    PROFILE_ZONE_END();
+}
+
+// Stage 1 starts the culling; it runs as a job once every matrix is updated.
+static void startCulling(void* arg) {
+    scene* scene = arg;
+    job_parallel_for(scene->jobs, (size_t)scene->objects.count, 0, cullObjects, scene, &scene->culled);
+}
+
+// Extract the normalized planes of the frustum from a view-projection
+// matrix (column-major), pointing inwards.
+static void frustumPlanes(float planes[6][4], const mat4 m) {
+    for (int i = 0; i < 6; i++) {
+        int row = i / 2;
+        float sign = i % 2 == 0 ? 1.0f : -1.0f;
+        for (int k = 0; k < 4; k++) {
+            planes[i][k] = m[k * 4 + 3] + sign * m[k * 4 + row];
+        }
+        float length = sqrtf(planes[i][0] * planes[i][0] + planes[i][1] * planes[i][1] + planes[i][2] * planes[i][2]);
+        for (int k = 0; k < 4; k++) {
+            planes[i][k] /= length;
+        }
+    }
+}
+
+// Render frames for a while with a job system of the given number of
+// threads. Only the CPU stages (from the kick-off to the draw list being
+// complete) count towards cpuSeconds; every frame is waited for, so the
+// frame rate includes the GPU work.
+static void runThreads(scene* scene, int threads, double duration, GLFWwindow* window, EGLDisplay display,
+                       EGLSurface surface, run_stats* stats) {
+    const float pi = 3.14159265358979323846f;
+    memset(stats, 0, sizeof(run_stats));
+    stats->threads = threads;
+
+    scene->jobs = job_system_create(threads);
+    if (!scene->jobs) {
+        fprintf(stderr, "Failed to create a job system of %d threads\n", threads);
+        return;
+    }
+    stats->threads = job_system_thread_count(scene->jobs);
+    job_counter_init(&scene->updated);
+    job_counter_init(&scene->culled);
+
+    float fovy = FIELD_OF_VIEW * pi / 180.0f;
+    mat4 proj, view, viewProj;
+    mat4_perspective(proj, fovy, 640.0f / 480.0f, 0.5f, CLOUD_RADIUS * 2.5f);
+    float pointScale = 480.0f / (2.0f * tanf(fovy * 0.5f));
+
+    double start = timer_now();
+    double end = start + duration;
+    while (timer_now() < end && !(window && glfwWindowShouldClose(window))) {
+        PROFILE_ZONE_BEGIN("frame");
+        PROFILE_GPU_ZONE_BEGIN("frame");
+
+        // The camera stands at the center of the cloud and turns around.
+        scene->time = (float)(timer_now() - start);
+        float heading = scene->time * 0.2f;
+        mat4_look_at(view,
+            0.0f, 15.0f, 0.0f,
+            cosf(heading) * 50.0f, 0.0f, sinf(heading) * 50.0f,
+            0, 1, 0
+        );
+        mat4_multiply(viewProj, proj, view);
+        frustumPlanes(scene->planes, viewProj);
+
+        PROFILE_ZONE_BEGIN("jobs");
+        double cpuStart = timer_now();
+        atomic_store(&scene->drawCount, 0);
+        job_parallel_for(scene->jobs, (size_t)scene->objects.count, 0, updateObjects, scene, &scene->updated);
+        job_run_after(scene->jobs, startCulling, scene, &scene->updated, &scene->culled);
+        job_wait(scene->jobs, &scene->culled);
+        stats->cpuSeconds += timer_now() - cpuStart;
+        PROFILE_ZONE_END();
+
+        int drawCount = atomic_load(&scene->drawCount);
+        stats->visible += drawCount;
+
+        glClearColor(0.02f, 0.02f, 0.05f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+        PROFILE_GPU_ZONE_BEGIN("draw");
+        glUseProgram(scene->program);
+        glUniformMatrix4fv(scene->viewProjLocation, 1, GL_FALSE, viewProj);
+        glUniform1f(scene->pointScaleLocation, pointScale);
+        #if SAMPLE_OPENGL_API == SAMPLE_API_GL || SAMPLE_OPENGL_VERSION_MAJOR >= 3
+            glBindVertexArray(scene->vao);
+        #endif
+        glBindBuffer(GL_ARRAY_BUFFER, scene->vbo);
+        glBufferData(GL_ARRAY_BUFFER, scene->vboSize, NULL, GL_STREAM_DRAW);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, (GLsizeiptr)drawCount * sizeof(draw_item), scene->drawList);
+        glDrawArrays(GL_POINTS, 0, drawCount);
+        PROFILE_GPU_ZONE_END();
+
+        PROFILE_GPU_ZONE_END();
+        PROFILE_ZONE_BEGIN("eglSwapBuffers");
+        eglSwapBuffers(display, surface);
+        PROFILE_ZONE_END();
+        glFinish();
+        profiler_gpu_collect();
+        PROFILE_ZONE_END();
+        stats->frames++;
+
+        if (window) {
+            glfwPollEvents();
+        }
+    }
+    stats->seconds = timer_now() - start;
+
+    job_system_destroy(scene->jobs);
+    scene->jobs = NULL;
+}
+
+// 1, 2, 4, ... threads, and the maximum.
+static int nextThreadCount(int threads, int maxThreads) {
+    if (threads < maxThreads && threads * 2 > maxThreads) {
+        return maxThreads;
+    }
+    return threads * 2;
+}
+
+int main(int argc, char** argv) {
+    int objectCount = option_int(argc, argv, "--objects", 200000);
+    int maxThreads = option_int(argc, argv, "--threads", thread_hardware_concurrency());
+    double duration = option_double(argc, argv, "--seconds", 2.0);
+    int useWindow = option_flag(argc, argv, "--window");
+    const char* reportPath = option_string(argc, argv, "--json", NULL);
+    const char* tracePath = option_string(argc, argv, "--trace", NULL);
+
+    if (objectCount < 1) {
+        fprintf(stderr, "The number of objects must be positive\n");
+        return -1;
+    }
+    if (maxThreads < 1) {
+        maxThreads = 1;
+    }
+    if (maxThreads > JOB_MAX_THREADS) {
+        maxThreads = JOB_MAX_THREADS;
+    }
+
+    PROFILE_THREAD_NAME("main");
+
+    GLFWwindow* window = NULL;
+    EGLDisplay display;
+    EGLConfig config;
+    EGLContext context;
+    EGLSurface surface;
+    if (useWindow) {
+        if (initializeWindow(&window, &display, &context, &surface, 640, 480, "Erlangsters - Job Scaling") != 0) {
+            return -1;
+        }
+    } else if (initializeHeadless(&display, &config, &context, &surface, 640, 480) != 0) {
+        return -1;
+    }
+    gl_debug_install();
+    profiler_gpu_init();
+
+    static scene scene;
+    if (createScene(&scene, objectCount) != 0) {
+        return -1;
+    }
+    printf("Updating and culling %d objects with up to %d threads (%d hardware threads)\n",
+        objectCount, maxThreads, thread_hardware_concurrency());
+
+    report* report = report_open(reportPath);
+    report_string(report, "sample", "job-scaling");
+    report_integer(report, "objects", objectCount);
+    report_integer(report, "hardware_threads", thread_hardware_concurrency());
+    report_begin_array(report, "runs");
+
+    double baseline = 0.0;
+    for (int threads = 1; threads <= maxThreads; threads = nextThreadCount(threads, maxThreads)) {
+        run_stats stats;
+        runThreads(&scene, threads, duration, window, display, surface, &stats);
+        if (stats.frames == 0) {
+            break;
+        }
+
+        double frames = (double)stats.frames;
+        double cpuMilliseconds = stats.cpuSeconds * 1000.0 / frames;
+        if (baseline == 0.0) {
+            baseline = cpuMilliseconds;
+        }
+        double speedup = baseline / cpuMilliseconds;
+        printf("%2d threads  CPU: %7.3f ms/frame  speedup: %5.2fx  efficiency: %5.1f%%  visible: %8.0f  %7.1f frames/s\n",
+            stats.threads, cpuMilliseconds, speedup, speedup * 100.0 / stats.threads,
+            stats.visible / frames, frames / stats.seconds);
+
+        report_begin_object(report, NULL);
+        report_integer(report, "threads", stats.threads);
+        report_integer(report, "frames", stats.frames);
+        report_number(report, "frames_per_second", frames / stats.seconds);
+        report_number(report, "cpu_milliseconds_per_frame", cpuMilliseconds);
+        report_number(report, "speedup", speedup);
+        report_number(report, "visible_per_frame", stats.visible / frames);
+        report_end_object(report);
+    }
+
+    report_end_array(report);
+    gpu_memory_print();
+    gpu_memory_report(report);
+    report_close(report);
+
+    deleteScene(&scene);
+    gl_debug_summary();
+    profiler_gpu_shutdown();
+    if (tracePath) {
+        profiler_write_trace(tracePath);
+    }
+    if (window) {
+        terminateWindow(window);
+    } else {
+        terminateHeadless(display, context, surface);
+    }
+
+    return 0;
+}
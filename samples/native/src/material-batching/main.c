@@ -0,0 +1,548 @@
+//
+// Copyright (c) 2025, Byteplug LLC.
+//
+// This source file is part of a project made by the Erlangsters community and
+// is released under the MIT license. Please refer to the LICENSE.md file that
+// can be found at the root of the project repository.
+//
+// Written by Jonathan De Wachter <jonathan.dewachter@byteplug.io>
+//
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "arena.h"
+#include "gl_api.h"
+#include "gl_debug.h"
+#include "gpu_memory.h"
+#include "material.h"
+#include "matrix.h"
+#include "window.h"
+#include "options.h"
+#include "report.h"
+#include "shader.h"
+#include "texture_gen.h"
+#include "timer.h"
+
+// Draws a grid of cubes that all have a different material, three ways:
+//
+// - "separate": one GL_TEXTURE_2D per material, bound before each draw;
+// - "shared": the materials of a material_set, bound once, with the layer
+//   (or the atlas tile on OpenGL ES 2.0) passed as a constant vertex
+//   attribute of each draw;
+// - "instanced": the same material set with all the cubes drawn by a single
+//   instanced draw call, the layer being a per-instance attribute (not
+//   available on OpenGL ES 2.0).
+
+#define MAX_OBJECTS 4096
+
+#define ATTRIB_POSITION 0
+#define ATTRIB_TEXCOORD 1
+#define ATTRIB_OFFSET 2
+#define ATTRIB_MATERIAL 3
+
+// Both programs are variants of the same source: the material set is either
+// an atlas, indexed with a UV transform, or a texture array, indexed with a
+// layer (in the first component of the material attribute).
+static const char* vertexSource =
+    "ATTRIBUTE vec3 vertPosition;\n"
+    "ATTRIBUTE vec2 vertTexCoord;\n"
+    "ATTRIBUTE vec3 vertOffset;\n"
+    "ATTRIBUTE vec4 vertMaterial;\n"
+    "#ifdef TEXTURE_ARRAY\n"
+    "VARYING_OUT vec3 fragTexCoord;\n"
+    "#else\n"
+    "VARYING_OUT vec2 fragTexCoord;\n"
+    "#endif\n"
+    "uniform mat4 mWorld;\n"
+    "uniform mat4 mView;\n"
+    "uniform mat4 mProj;\n"
+    "void main()\n"
+    "{\n"
+    "#ifdef TEXTURE_ARRAY\n"
+    "    fragTexCoord = vec3(vertTexCoord, vertMaterial.x);\n"
+    "#else\n"
+    "    fragTexCoord = vertTexCoord * vertMaterial.xy + vertMaterial.zw;\n"
+    "#endif\n"
+    "    vec4 position = mWorld * vec4(vertPosition, 1.0);\n"
+    "    gl_Position = mProj * mView * vec4(position.xyz + vertOffset, 1.0);\n"
+    "}\n";
+
+static const char* fragmentSource =
+    "#ifdef TEXTURE_ARRAY\n"
+    "VARYING_IN vec3 fragTexCoord;\n"
+    "uniform sampler2DArray materials;\n"
+    "#else\n"
+    "VARYING_IN vec2 fragTexCoord;\n"
+    "uniform sampler2D texture0;\n"
+    "#endif\n"
+    "void main()\n"
+    "{\n"
+    "#ifdef TEXTURE_ARRAY\n"
+    "    FRAG_COLOR = texture(materials, fragTexCoord);\n"
+    "#else\n"
+    "    FRAG_COLOR = texture(texture0, fragTexCoord);\n"
+    "#endif\n"
+    "}\n";
+
+static const char* attributes[] = { "vertPosition", "vertTexCoord", "vertOffset", "vertMaterial", NULL };
+
+static const float vertices[] = {
+    // Format: X, Y, Z, U, V
+    // Top
+    -1.0f,  1.0f, -1.0f,   0.0f, 0.0f,
+    -1.0f,  1.0f,  1.0f,   0.0f, 1.0f,
+     1.0f,  1.0f,  1.0f,   1.0f, 1.0f,
+     1.0f,  1.0f, -1.0f,   1.0f, 0.0f,
+
+    // Left
+    -1.0f,  1.0f,  1.0f,   0.0f, 0.0f,
+    -1.0f, -1.0f,  1.0f,   0.0f, 1.0f,
+    -1.0f, -1.0f, -1.0f,   1.0f, 1.0f,
+    -1.0f,  1.0f, -1.0f,   1.0f, 0.0f,
+
+    // Right
+     1.0f,  1.0f,  1.0f,   0.0f, 0.0f,
+     1.0f, -1.0f,  1.0f,   0.0f, 1.0f,
+     1.0f, -1.0f, -1.0f,   1.0f, 1.0f,
+     1.0f,  1.0f, -1.0f,   1.0f, 0.0f,
+
+    // Front
+     1.0f,  1.0f,  1.0f,   0.0f, 0.0f,
+     1.0f, -1.0f,  1.0f,   0.0f, 1.0f,
+    -1.0f, -1.0f,  1.0f,   1.0f, 1.0f,
+    -1.0f,  1.0f,  1.0f,   1.0f, 0.0f,
+
+    // Back
+     1.0f,  1.0f, -1.0f,   0.0f, 0.0f,
+     1.0f, -1.0f, -1.0f,   0.0f, 1.0f,
+    -1.0f, -1.0f, -1.0f,   1.0f, 1.0f,
+    -1.0f,  1.0f, -1.0f,   1.0f, 0.0f,
+
+    // Bottom
+    -1.0f, -1.0f, -1.0f,   0.0f, 0.0f,
+    -1.0f, -1.0f,  1.0f,   0.0f, 1.0f,
+     1.0f, -1.0f,  1.0f,   1.0f, 1.0f,
+     1.0f, -1.0f, -1.0f,   1.0f, 0.0f
+};
+
+static const unsigned short indices[] = {
+    0, 1, 2,    0, 2, 3,    // Top
+    5, 4, 6,    6, 4, 7,    // Left
+    8, 9, 10,   8, 10, 11,  // Right
+    13, 12, 14, 15, 14, 12, // Front
+    16, 17, 18, 16, 18, 19, // Back
+    21, 20, 22, 22, 20, 23  // Bottom
+};
+
+typedef enum {
+    MODE_SEPARATE,
+    MODE_SHARED,
+    MODE_INSTANCED,
+    MODE_COUNT
+} draw_mode;
+
+static const char* modeNames[MODE_COUNT] = { "separate", "shared", "instanced" };
+
+// Per-object data; it is also the layout of the instance buffer.
+typedef struct {
+    float offset[3];
+    float layer;
+} object;
+
+typedef struct {
+    int objectCount;
+    object objects[MAX_OBJECTS];
+    float uvTransforms[MAX_OBJECTS][4];
+    GLuint textures[MAX_OBJECTS];
+    material_set materials;
+
+    GLuint singleProgram;
+    GLuint arrayProgram;
+    GLuint vbo;
+    GLuint ebo;
+    GLuint instanceBuffer;
+    GLuint vao;
+    GLuint instancedVao;
+} scene;
+
+typedef struct {
+    long long frames;
+    double seconds;
+    double submitSeconds;
+    int draws;
+    int binds;
+} mode_stats;
+
+// Both kinds of sampler read from texture unit 0.
+static void setupProgram(GLuint program, const mat4 view, const mat4 proj) {
+    glUseProgram(program);
+    glUniform1i(glGetUniformLocation(program, "texture0"), 0);
+    glUniform1i(glGetUniformLocation(program, "materials"), 0);
+    glUniformMatrix4fv(glGetUniformLocation(program, "mView"), 1, GL_FALSE, view);
+    glUniformMatrix4fv(glGetUniformLocation(program, "mProj"), 1, GL_FALSE, proj);
+    glUseProgram(0);
+}
+
+// Generate a different procedural texture (with its mip chain) for every
+// object, and add it both as a separate texture and to the material set.
+static int createMaterials(scene* scene, int size, arena* staging) {
+    int levels = texture_gen_mip_levels(size, size);
+    unsigned char* pixels = arena_alloc(staging, texture_gen_mip_chain_size(size, size), 16);
+    if (!pixels) {
+        return -1;
+    }
+
+    if (material_set_init(&scene->materials, size, size, scene->objectCount, 1) != 0) {
+        return -1;
+    }
+
+    glGenTextures(scene->objectCount, scene->textures);
+    for (int i = 0; i < scene->objectCount; i++) {
+        unsigned int hash = (unsigned int)(i + 1) * 2654435761u;
+        texture_desc desc = {
+            (texture_pattern)(i % 3), size, size,
+            { (unsigned char)(hash >> 24), (unsigned char)(hash >> 16), (unsigned char)(hash >> 8), 255 },
+            { (unsigned char)(hash >> 8), (unsigned char)(hash >> 24), (unsigned char)(hash >> 16), 255 },
+            2 + i % 7, (unsigned int)i
+        };
+        texture_gen_fill(&desc, pixels, NULL);
+        texture_gen_mips(pixels, size, size, NULL);
+
+        glBindTexture(GL_TEXTURE_2D, scene->textures[i]);
+        for (int level = 0; level < levels; level++) {
+            int levelSize = size >> level > 0 ? size >> level : 1;
+            GL_CHECK(glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA, levelSize, levelSize, 0, GL_RGBA, GL_UNSIGNED_BYTE,
+                pixels + texture_gen_mip_offset(size, size, level)));
+        }
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        gpu_memory_track(GPU_MEMORY_TEXTURE, scene->textures[i],
+            gpu_memory_texture_size(GL_RGBA, GL_UNSIGNED_BYTE, size, size, 1, levels));
+
+        int material = material_set_add(&scene->materials, pixels);
+        scene->objects[i].layer = (float)material;
+        material_set_uv_transform(&scene->materials, material, scene->uvTransforms[i]);
+    }
+
+    arena_reset(staging);
+    return 0;
+}
+
+static void setupVertexArrays(scene* scene) {
+    glBindBuffer(GL_ARRAY_BUFFER, scene->vbo);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, scene->ebo);
+    glVertexAttribPointer(ATTRIB_POSITION, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), 0);
+    glVertexAttribPointer(ATTRIB_TEXCOORD, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(3 * sizeof(float)));
+    glEnableVertexAttribArray(ATTRIB_POSITION);
+    glEnableVertexAttribArray(ATTRIB_TEXCOORD);
+}
+
+static int createScene(scene* scene, int objectCount, int materialSize, arena* staging) {
+    const float pi = 3.14159265358979323846f;
+    scene->objectCount = objectCount;
+
+    // Lay the cubes out on a square grid facing the camera, far enough that
+    // the whole grid fits the field of view.
+    int columns = 1;
+    while (columns * columns < objectCount) {
+        columns++;
+    }
+    const float spacing = 3.5f;
+    for (int i = 0; i < objectCount; i++) {
+        scene->objects[i].offset[0] = ((float)(i % columns) - (float)(columns - 1) * 0.5f) * spacing;
+        scene->objects[i].offset[1] = ((float)(i / columns) - (float)(columns - 1) * 0.5f) * spacing;
+        scene->objects[i].offset[2] = 0.0f;
+    }
+    float distance = (float)columns * spacing * 1.25f + 4.0f;
+
+    mat4 view, proj;
+    mat4_look_at(view,
+        0, 0, -distance,
+        0, 0, 0,
+        0, 1, 0
+    );
+    mat4_perspective(proj, 45.0f * pi / 180.0f, 640.0f / 480.0f, 0.1f, distance * 2.0f);
+
+    // The materials are generated while the programs compile.
+    shader_program programs[2] = {
+        { .label = "Single texture program", .vertex = vertexSource, .fragment = fragmentSource, .attributes = attributes },
+        {
+            .label = "Texture array program",
+            .defines = "#define TEXTURE_ARRAY\n",
+            .vertex = vertexSource,
+            .fragment = fragmentSource,
+            .attributes = attributes
+        }
+    };
+    int programCount = MATERIAL_USE_TEXTURE_ARRAY ? 2 : 1;
+    shader_submit(programs, programCount);
+    int materialsFailed = createMaterials(scene, materialSize, staging) != 0;
+    int programsFailed = shader_finish(programs, programCount) > 0;
+
+    scene->singleProgram = programs[0].program;
+    #if MATERIAL_USE_TEXTURE_ARRAY
+        scene->arrayProgram = programs[1].program;
+    #endif
+    if (materialsFailed || programsFailed) {
+        return -1;
+    }
+    setupProgram(scene->singleProgram, view, proj);
+    #if MATERIAL_USE_TEXTURE_ARRAY
+        setupProgram(scene->arrayProgram, view, proj);
+    #endif
+
+    glGenBuffers(1, &scene->vbo);
+    glBindBuffer(GL_ARRAY_BUFFER, scene->vbo);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+    gpu_memory_track(GPU_MEMORY_BUFFER, scene->vbo, sizeof(vertices));
+
+    glGenBuffers(1, &scene->ebo);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, scene->ebo);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
+    gpu_memory_track(GPU_MEMORY_BUFFER, scene->ebo, sizeof(indices));
+
+    #if MATERIAL_USE_TEXTURE_ARRAY
+        // One vertex array for the per-draw modes (the offset and material
+        // attributes are constant values), one for the instanced mode.
+        glGenVertexArrays(1, &scene->vao);
+        glBindVertexArray(scene->vao);
+        setupVertexArrays(scene);
+
+        size_t instanceBytes = (size_t)objectCount * sizeof(object);
+        glGenBuffers(1, &scene->instanceBuffer);
+        glBindBuffer(GL_ARRAY_BUFFER, scene->instanceBuffer);
+        glBufferData(GL_ARRAY_BUFFER, instanceBytes, scene->objects, GL_STATIC_DRAW);
+        gpu_memory_track(GPU_MEMORY_BUFFER, scene->instanceBuffer, instanceBytes);
+
+        glGenVertexArrays(1, &scene->instancedVao);
+        glBindVertexArray(scene->instancedVao);
+        setupVertexArrays(scene);
+        glBindBuffer(GL_ARRAY_BUFFER, scene->instanceBuffer);
+        glVertexAttribPointer(ATTRIB_OFFSET, 3, GL_FLOAT, GL_FALSE, sizeof(object), (void*)offsetof(object, offset));
+        glVertexAttribPointer(ATTRIB_MATERIAL, 1, GL_FLOAT, GL_FALSE, sizeof(object), (void*)offsetof(object, layer));
+        glVertexAttribDivisor(ATTRIB_OFFSET, 1);
+        glVertexAttribDivisor(ATTRIB_MATERIAL, 1);
+        glEnableVertexAttribArray(ATTRIB_OFFSET);
+        glEnableVertexAttribArray(ATTRIB_MATERIAL);
+        glBindVertexArray(0);
+    #else
+        setupVertexArrays(scene);
+    #endif
+
+    glEnable(GL_DEPTH_TEST);
+    glEnable(GL_CULL_FACE);
+    glFrontFace(GL_CCW);
+    glCullFace(GL_BACK);
+
+    return 0;
+}
+
+static void deleteScene(scene* scene) {
+    for (int i = 0; i < scene->objectCount; i++) {
+        gpu_memory_untrack(GPU_MEMORY_TEXTURE, scene->textures[i]);
+    }
+    glDeleteTextures(scene->objectCount, scene->textures);
+    material_set_destroy(&scene->materials);
+
+    gpu_memory_untrack(GPU_MEMORY_BUFFER, scene->vbo);
+    gpu_memory_untrack(GPU_MEMORY_BUFFER, scene->ebo);
+    gpu_memory_untrack(GPU_MEMORY_BUFFER, scene->instanceBuffer);
+    glDeleteBuffers(1, &scene->vbo);
+    glDeleteBuffers(1, &scene->ebo);
+    #if MATERIAL_USE_TEXTURE_ARRAY
+        glDeleteBuffers(1, &scene->instanceBuffer);
+        glDeleteVertexArrays(1, &scene->vao);
+        glDeleteVertexArrays(1, &scene->instancedVao);
+        glDeleteProgram(scene->arrayProgram);
+    #endif
+    glDeleteProgram(scene->singleProgram);
+}
+
+// Issue the draw calls of a frame and count them, along with the texture
+// binds.
+static void drawScene(scene* scene, draw_mode mode, const mat4 world, mode_stats* stats) {
+    int count = scene->objectCount;
+    GLuint program = scene->singleProgram;
+    #if MATERIAL_USE_TEXTURE_ARRAY
+        if (mode != MODE_SEPARATE) {
+            program = scene->arrayProgram;
+        }
+        glBindVertexArray(mode == MODE_INSTANCED ? scene->instancedVao : scene->vao);
+    #endif
+
+    glUseProgram(program);
+    glUniformMatrix4fv(glGetUniformLocation(program, "mWorld"), 1, GL_FALSE, world);
+    glActiveTexture(GL_TEXTURE0);
+
+    stats->draws = 0;
+    stats->binds = 0;
+    switch (mode) {
+        case MODE_SEPARATE:
+            glVertexAttrib4f(ATTRIB_MATERIAL, 1.0f, 1.0f, 0.0f, 0.0f);
+            for (int i = 0; i < count; i++) {
+                glBindTexture(GL_TEXTURE_2D, scene->textures[i]);
+                glVertexAttrib3fv(ATTRIB_OFFSET, scene->objects[i].offset);
+                glDrawElements(GL_TRIANGLES, 36, GL_UNSIGNED_SHORT, 0);
+            }
+            stats->draws = count;
+            stats->binds = count;
+            break;
+        case MODE_SHARED:
+            material_set_bind(&scene->materials, 0);
+            for (int i = 0; i < count; i++) {
+                glVertexAttrib3fv(ATTRIB_OFFSET, scene->objects[i].offset);
+                #if MATERIAL_USE_TEXTURE_ARRAY
+                    glVertexAttrib1f(ATTRIB_MATERIAL, scene->objects[i].layer);
+                #else
+                    glVertexAttrib4fv(ATTRIB_MATERIAL, scene->uvTransforms[i]);
+                #endif
+                glDrawElements(GL_TRIANGLES, 36, GL_UNSIGNED_SHORT, 0);
+            }
+            stats->draws = count;
+            stats->binds = 1;
+            break;
+        case MODE_INSTANCED:
+            #if MATERIAL_USE_TEXTURE_ARRAY
+                material_set_bind(&scene->materials, 0);
+                glDrawElementsInstanced(GL_TRIANGLES, 36, GL_UNSIGNED_SHORT, 0, count);
+                stats->draws = 1;
+                stats->binds = 1;
+            #endif
+            break;
+        default:
+            break;
+    }
+}
+
+// Render frames in the given mode for a while. Every frame is waited for, so
+// the frame rate includes the GPU work.
+static void runMode(scene* scene, draw_mode mode, double duration, GLFWwindow* window,
+                    EGLDisplay display, EGLSurface surface, mode_stats* stats) {
+    mat4 world, rotatedY;
+    stats->frames = 0;
+    stats->submitSeconds = 0.0;
+
+    double start = timer_now();
+    double end = start + duration;
+    while (timer_now() < end && !(window && glfwWindowShouldClose(window))) {
+        float angle = (float)(timer_now() - start);
+        mat4_identity(world);
+        mat4_rotate_y(rotatedY, world, angle);
+        mat4_rotate_x(world, rotatedY, angle * 0.25f);
+
+        glClearColor(0.75f, 0.85f, 0.8f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+        double submitStart = timer_now();
+        gl_debug_push_group(modeNames[mode]);
+        drawScene(scene, mode, world, stats);
+        gl_debug_pop_group();
+        stats->submitSeconds += timer_now() - submitStart;
+
+        eglSwapBuffers(display, surface);
+        glFinish();
+        stats->frames++;
+
+        if (window) {
+            glfwPollEvents();
+        }
+    }
+    stats->seconds = timer_now() - start;
+}
+
+int main(int argc, char** argv) {
+    int objectCount = option_int(argc, argv, "--objects", 256);
+    int materialSize = option_int(argc, argv, "--material-size", 64);
+    double duration = option_double(argc, argv, "--seconds", 2.0);
+    int useWindow = option_flag(argc, argv, "--window");
+    const char* reportPath = option_string(argc, argv, "--json", NULL);
+
+    if (objectCount < 1 || objectCount > MAX_OBJECTS) {
+        fprintf(stderr, "The number of objects must be between 1 and %d\n", MAX_OBJECTS);
+        return -1;
+    }
+    if (materialSize < 1) {
+        materialSize = 64;
+    }
+
+    // OpenGL ES 2.0 only supports mipmaps on power of two textures.
+    #if defined(OPENGL_ES_VERSION_20)
+        while (materialSize & (materialSize - 1)) {
+            materialSize &= materialSize - 1;
+        }
+    #endif
+
+    GLFWwindow* window = NULL;
+    EGLDisplay display;
+    EGLConfig config;
+    EGLContext context;
+    EGLSurface surface;
+    if (useWindow) {
+        if (initializeWindow(&window, &display, &context, &surface, 640, 480, "Erlangsters - Material Batching") != 0) {
+            return -1;
+        }
+    } else if (initializeHeadless(&display, &config, &context, &surface, 640, 480) != 0) {
+        return -1;
+    }
+    gl_debug_install();
+
+    arena staging;
+    if (arena_init(&staging, texture_gen_mip_chain_size(materialSize, materialSize) + 16) != 0) {
+        fprintf(stderr, "Failed to allocate the staging memory\n");
+        return -1;
+    }
+
+    static scene scene;
+    if (createScene(&scene, objectCount, materialSize, &staging) != 0) {
+        return -1;
+    }
+    arena_destroy(&staging);
+
+    printf("Drawing %d cubes with %d materials of %dx%d (%s)\n", objectCount, objectCount,
+        materialSize, materialSize, MATERIAL_USE_TEXTURE_ARRAY ? "texture array" : "atlas");
+
+    report* report = report_open(reportPath);
+    report_string(report, "sample", "material-batching");
+    report_string(report, "material_set", MATERIAL_USE_TEXTURE_ARRAY ? "texture_array" : "atlas");
+    report_integer(report, "objects", objectCount);
+    report_integer(report, "material_size", materialSize);
+    report_begin_array(report, "modes");
+
+    int modeCount = MATERIAL_USE_TEXTURE_ARRAY ? MODE_COUNT : MODE_INSTANCED;
+    for (int mode = 0; mode < modeCount; mode++) {
+        mode_stats stats;
+        runMode(&scene, (draw_mode)mode, duration, window, display, surface, &stats);
+        if (stats.frames == 0) {
+            break;
+        }
+
+        double fps = (double)stats.frames / stats.seconds;
+        double submitMs = stats.submitSeconds * 1000.0 / (double)stats.frames;
+        printf("%-10s draws: %5d  texture binds: %5d  %9.1f frames/s  submission: %7.3f ms/frame\n",
+            modeNames[mode], stats.draws, stats.binds, fps, submitMs);
+
+        report_begin_object(report, NULL);
+        report_string(report, "mode", modeNames[mode]);
+        report_integer(report, "draws_per_frame", stats.draws);
+        report_integer(report, "binds_per_frame", stats.binds);
+        report_integer(report, "frames", stats.frames);
+        report_number(report, "frames_per_second", fps);
+        report_number(report, "submission_ms_per_frame", submitMs);
+        report_end_object(report);
+    }
+
+    report_end_array(report);
+    gpu_memory_print();
+    gpu_memory_report(report);
+    report_close(report);
+
+    deleteScene(&scene);
+    gl_debug_summary();
+    if (window) {
+        terminateWindow(window);
+    } else {
+        terminateHeadless(display, context, surface);
+    }
+
+    return 0;
+}
@@ -0,0 +1,542 @@
+//
+// Copyright (c) 2025, Byteplug LLC.
+//
+// This source file is part of a project made by the Erlangsters community and
+// is released under the MIT license. Please refer to the LICENSE.md file that
+// can be found at the root of the project repository.
+//
+// Written by Jonathan De Wachter <jonathan.dewachter@byteplug.io>
+//
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "gl_api.h"
+#include "gl_debug.h"
+#include "gpu_memory.h"
+#include "matrix.h"
+#include "mesh_lod.h"
+#include "window.h"
+#include "options.h"
+#include "profiler.h"
+#include "report.h"
+#include "shader.h"
+#include "timer.h"
+
+// Flies over a large field of rocks, each one a detailed mesh, and draws it
+// twice: every rock at full detail ("full"), then with the level of detail
+// of each rock picked from its screen-space error ("lod"). The levels are
+// generated at startup with mesh_lod_build() and stored in a single index
+// buffer, next to the single vertex buffer they share.
+
+#define ATTRIB_POSITION 0
+#define ATTRIB_NORMAL 1
+
+#define CELL_SIZE 8.0f
+#define FIELD_OF_VIEW 60.0f
+
+static const char* vertexSource =
+    "ATTRIBUTE vec3 vertPosition;\n"
+    "ATTRIBUTE vec3 vertNormal;\n"
+    "VARYING_OUT vec3 fragColor;\n"
+    "uniform mat4 mViewProj;\n"
+    "uniform vec4 objectTransform;\n"
+    "uniform vec3 objectColor;\n"
+    "void main() {\n"
+    "    float light = 0.35 + 0.65 * max(dot(vertNormal, vec3(0.48, 0.8, 0.36)), 0.0);\n"
+    "    fragColor = objectColor * light;\n"
+    "    gl_Position = mViewProj * vec4(objectTransform.xyz + vertPosition * objectTransform.w, 1.0);\n"
+    "}\n";
+
+static const char* fragmentSource =
+    "VARYING_IN vec3 fragColor;\n"
+    "void main() {\n"
+    "    FRAG_COLOR = vec4(fragColor, 1.0);\n"
+    "}\n";
+
+static const char* attributes[] = { "vertPosition", "vertNormal", NULL };
+
+typedef enum {
+    MODE_FULL,
+    MODE_LOD,
+    MODE_COUNT
+} lod_mode;
+
+static const char* modeNames[MODE_COUNT] = { "full", "lod" };
+
+typedef struct {
+    float transform[4];  // Position and scale.
+    float color[3];
+    int level;
+} object;
+
+typedef struct {
+    int objectCount;
+    object* objects;
+    float radius;  // Bounding radius of the mesh.
+    mesh_lod_chain chain;
+
+    GLuint program;
+    GLint viewProjLocation;
+    GLint transformLocation;
+    GLint colorLocation;
+    GLuint vbo;
+    GLuint ebo;
+    #if SAMPLE_OPENGL_API == SAMPLE_API_GL || SAMPLE_OPENGL_VERSION_MAJOR >= 3
+        GLuint vao;
+    #endif
+} scene;
+
+typedef struct {
+    long long frames;
+    double seconds;
+    double triangles;
+    double switches;
+    double levelCounts[MESH_LOD_MAX_LEVELS];
+} mode_stats;
+
+// A sphere of rings x (2 * rings) quads, its radius displaced by a few
+// octaves of waves so it looks like a rock. The longitude wraps around and
+// the poles are single vertices, so the mesh is closed and has no seams.
+// Vertices are a position followed by a normal.
+static int buildRock(int rings, float** vertices, size_t* vertexCount,
+                     unsigned short** indices, size_t* indexCount, float* radius) {
+    const float pi = 3.14159265358979323846f;
+    int segments = rings * 2;
+    size_t vertices_ = (size_t)(rings - 1) * segments + 2;
+    size_t indices_ = (size_t)segments * (rings - 1) * 6;
+    if (rings < 2 || vertices_ > 65536) {
+        return -1;
+    }
+
+    float* v = calloc(vertices_ * 6, sizeof(float));
+    unsigned short* i = malloc(indices_ * sizeof(unsigned short));
+    if (!v || !i) {
+        free(v);
+        free(i);
+        return -1;
+    }
+
+    // Vertex 0 is the north pole, the last one the south pole.
+    *radius = 0.0f;
+    for (size_t n = 0; n < vertices_; n++) {
+        float theta, phi;
+        if (n == 0) {
+            theta = 0.0f;
+            phi = 0.0f;
+        } else if (n == vertices_ - 1) {
+            theta = pi;
+            phi = 0.0f;
+        } else {
+            theta = pi * (float)((n - 1) / segments + 1) / (float)rings;
+            phi = 2.0f * pi * (float)((n - 1) % segments) / (float)segments;
+        }
+        float x = sinf(theta) * cosf(phi);
+        float y = cosf(theta);
+        float z = sinf(theta) * sinf(phi);
+        float r = 1.0f
+            + 0.12f * sinf(3.0f * x + 1.7f) * sinf(2.0f * y + 0.4f) * sinf(3.0f * z + 2.1f)
+            + 0.05f * sinf(9.0f * x + 4.0f * y) * sinf(7.0f * z + 1.3f)
+            + 0.02f * sinf(23.0f * y + 2.0f) * sinf(19.0f * x + 17.0f * z);
+        v[n * 6 + 0] = x * r;
+        v[n * 6 + 1] = y * r * 0.7f;
+        v[n * 6 + 2] = z * r;
+        if (r > *radius) {
+            *radius = r;
+        }
+    }
+
+    size_t count = 0;
+    unsigned short south = (unsigned short)(vertices_ - 1);
+    for (int s = 0; s < segments; s++) {
+        int next = (s + 1) % segments;
+        i[count++] = 0;
+        i[count++] = (unsigned short)(1 + next);
+        i[count++] = (unsigned short)(1 + s);
+
+        int last = 1 + (rings - 2) * segments;
+        i[count++] = south;
+        i[count++] = (unsigned short)(last + s);
+        i[count++] = (unsigned short)(last + next);
+    }
+    for (int ring = 0; ring < rings - 2; ring++) {
+        int row = 1 + ring * segments;
+        for (int s = 0; s < segments; s++) {
+            int next = (s + 1) % segments;
+            unsigned short a = (unsigned short)(row + s);
+            unsigned short b = (unsigned short)(row + next);
+            unsigned short c = (unsigned short)(row + segments + s);
+            unsigned short d = (unsigned short)(row + segments + next);
+            i[count++] = a;
+            i[count++] = b;
+            i[count++] = c;
+            i[count++] = c;
+            i[count++] = b;
+            i[count++] = d;
+        }
+    }
+
+    // Smooth normals, from the area weighted normals of the triangles.
+    for (size_t t = 0; t < count; t += 3) {
+        float* p0 = &v[i[t] * 6];
+        float* p1 = &v[i[t + 1] * 6];
+        float* p2 = &v[i[t + 2] * 6];
+        float ex = p1[0] - p0[0], ey = p1[1] - p0[1], ez = p1[2] - p0[2];
+        float fx = p2[0] - p0[0], fy = p2[1] - p0[1], fz = p2[2] - p0[2];
+        float nx = ey * fz - ez * fy;
+        float ny = ez * fx - ex * fz;
+        float nz = ex * fy - ey * fx;
+        for (int k = 0; k < 3; k++) {
+            float* normal = &v[i[t + k] * 6 + 3];
+            normal[0] += nx;
+            normal[1] += ny;
+            normal[2] += nz;
+        }
+    }
+    for (size_t n = 0; n < vertices_; n++) {
+        float* normal = &v[n * 6 + 3];
+        float length = sqrtf(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+        if (length > 0.0f) {
+            normal[0] /= length;
+            normal[1] /= length;
+            normal[2] /= length;
+        }
+    }
+
+    *vertices = v;
+    *vertexCount = vertices_;
+    *indices = i;
+    *indexCount = count;
+    return 0;
+}
+
+static int createScene(scene* scene, int grid, int rings, report* report) {
+    float* vertices;
+    unsigned short* indices;
+    size_t vertexCount, indexCount;
+    if (buildRock(rings, &vertices, &vertexCount, &indices, &indexCount, &scene->radius) != 0) {
+        fprintf(stderr, "Failed to build a rock mesh with %d rings (at most 65536 vertices)\n", rings);
+        return -1;
+    }
+
+    PROFILE_ZONE_BEGIN("build_lod_chain");
+    double start = timer_now();
+    int result = mesh_lod_build(&scene->chain, indices, indexCount, vertices, vertexCount, 6, MESH_LOD_MAX_LEVELS);
+    double buildSeconds = timer_now() - start;
+    PROFILE_ZONE_END();
+    free(indices);
+    if (result != 0) {
+        free(vertices);
+        fprintf(stderr, "Failed to allocate the levels of detail\n");
+        return -1;
+    }
+
+    printf("Rock mesh: %zu vertices, %d levels built in %.1f ms\n", vertexCount, scene->chain.levelCount,
+        buildSeconds * 1000.0);
+    report_number(report, "lod_build_seconds", buildSeconds);
+    report_begin_array(report, "levels");
+    for (int level = 0; level < scene->chain.levelCount; level++) {
+        const mesh_lod_level* lod = &scene->chain.levels[level];
+        printf("  level %d: %7zu triangles  error: %.5f\n", level, lod->indexCount / 3, lod->error);
+        report_begin_object(report, NULL);
+        report_integer(report, "triangles", (long long)(lod->indexCount / 3));
+        report_number(report, "error", lod->error);
+        report_end_object(report);
+    }
+    report_end_array(report);
+
+    // Lay the rocks out on a grid, with some jitter, and vary their size and
+    // color.
+    scene->objectCount = grid * grid;
+    scene->objects = calloc((size_t)scene->objectCount, sizeof(object));
+    if (!scene->objects) {
+        free(vertices);
+        return -1;
+    }
+    for (int i = 0; i < scene->objectCount; i++) {
+        unsigned int hash = (unsigned int)(i + 1) * 2654435761u;
+        object* rock = &scene->objects[i];
+        float jitterX = ((float)((hash >> 4) & 0xff) / 255.0f - 0.5f) * CELL_SIZE * 0.4f;
+        float jitterZ = ((float)((hash >> 12) & 0xff) / 255.0f - 0.5f) * CELL_SIZE * 0.4f;
+        float scale = 1.0f + (float)((hash >> 20) & 0xff) / 255.0f * 1.5f;
+        float shade = 0.5f + (float)((hash >> 24) & 0xff) / 255.0f * 0.3f;
+        rock->transform[0] = ((float)(i % grid) - (float)(grid - 1) * 0.5f) * CELL_SIZE + jitterX;
+        rock->transform[1] = scale * 0.3f;
+        rock->transform[2] = (float)(i / grid) * CELL_SIZE + jitterZ;
+        rock->transform[3] = scale;
+        rock->color[0] = shade;
+        rock->color[1] = shade * 0.92f;
+        rock->color[2] = shade * 0.8f;
+    }
+
+    shader_program program = {
+        .label = "Rock program",
+        .vertex = vertexSource,
+        .fragment = fragmentSource,
+        .attributes = attributes
+    };
+    scene->program = shader_build(&program);
+    if (!scene->program) {
+        free(vertices);
+        return -1;
+    }
+    scene->viewProjLocation = glGetUniformLocation(scene->program, "mViewProj");
+    scene->transformLocation = glGetUniformLocation(scene->program, "objectTransform");
+    scene->colorLocation = glGetUniformLocation(scene->program, "objectColor");
+
+    // One vertex buffer, and one index buffer holding every level.
+    size_t vertexBytes = vertexCount * 6 * sizeof(float);
+    size_t indexBytes = scene->chain.indexCount * sizeof(unsigned short);
+
+    #if SAMPLE_OPENGL_API == SAMPLE_API_GL || SAMPLE_OPENGL_VERSION_MAJOR >= 3
+        glGenVertexArrays(1, &scene->vao);
+        glBindVertexArray(scene->vao);
+    #endif
+
+    glGenBuffers(1, &scene->vbo);
+    glBindBuffer(GL_ARRAY_BUFFER, scene->vbo);
+    GL_CHECK(glBufferData(GL_ARRAY_BUFFER, vertexBytes, vertices, GL_STATIC_DRAW));
+    gpu_memory_track(GPU_MEMORY_BUFFER, scene->vbo, vertexBytes);
+    gl_debug_label(GL_BUFFER, scene->vbo, "Rock vertices");
+
+    glGenBuffers(1, &scene->ebo);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, scene->ebo);
+    GL_CHECK(glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexBytes, scene->chain.indices, GL_STATIC_DRAW));
+    gpu_memory_track(GPU_MEMORY_BUFFER, scene->ebo, indexBytes);
+    gl_debug_label(GL_BUFFER, scene->ebo, "Rock levels of detail");
+
+    glVertexAttribPointer(ATTRIB_POSITION, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), 0);
+    glVertexAttribPointer(ATTRIB_NORMAL, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(3 * sizeof(float)));
+    glEnableVertexAttribArray(ATTRIB_POSITION);
+    glEnableVertexAttribArray(ATTRIB_NORMAL);
+    free(vertices);
+
+    glEnable(GL_DEPTH_TEST);
+    glEnable(GL_CULL_FACE);
+    glFrontFace(GL_CCW);
+    glCullFace(GL_BACK);
+
+    return 0;
+}
+
+static void deleteScene(scene* scene) {
+    gpu_memory_untrack(GPU_MEMORY_BUFFER, scene->vbo);
+    gpu_memory_untrack(GPU_MEMORY_BUFFER, scene->ebo);
+    glDeleteBuffers(1, &scene->vbo);
+    glDeleteBuffers(1, &scene->ebo);
+    #if SAMPLE_OPENGL_API == SAMPLE_API_GL || SAMPLE_OPENGL_VERSION_MAJOR >= 3
+        glDeleteVertexArrays(1, &scene->vao);
+    #endif
+    glDeleteProgram(scene->program);
+
+    mesh_lod_destroy(&scene->chain);
+    free(scene->objects);
+}
+
+// Pick the level of every rock (keeping the full mesh in the "full" mode)
+// and draw them, one draw call per rock.
+static void drawScene(scene* scene, lod_mode mode, const mat4 viewProj, const float eye[3],
+                      float projectionScale, float threshold, float hysteresis, mode_stats* stats) {
+    PROFILE_ZONE_BEGIN("select_lod");
+    for (int i = 0; i < scene->objectCount; i++) {
+        object* rock = &scene->objects[i];
+        int level = 0;
+        if (mode == MODE_LOD) {
+            float dx = rock->transform[0] - eye[0];
+            float dy = rock->transform[1] - eye[1];
+            float dz = rock->transform[2] - eye[2];
+            float distance = sqrtf(dx * dx + dy * dy + dz * dz) - scene->radius * rock->transform[3];
+            level = mesh_lod_select(&scene->chain, rock->level, distance, rock->transform[3],
+                projectionScale, threshold, hysteresis);
+        }
+        if (level != rock->level) {
+            stats->switches++;
+            rock->level = level;
+        }
+    }
+    PROFILE_ZONE_END();
+
+    PROFILE_ZONE_BEGIN("draw");
+    PROFILE_GPU_ZONE_BEGIN("draw");
+    glUseProgram(scene->program);
+    glUniformMatrix4fv(scene->viewProjLocation, 1, GL_FALSE, viewProj);
+    #if SAMPLE_OPENGL_API == SAMPLE_API_GL || SAMPLE_OPENGL_VERSION_MAJOR >= 3
+        glBindVertexArray(scene->vao);
+    #endif
+    for (int i = 0; i < scene->objectCount; i++) {
+        const object* rock = &scene->objects[i];
+        const mesh_lod_level* lod = &scene->chain.levels[rock->level];
+        glUniform4fv(scene->transformLocation, 1, rock->transform);
+        glUniform3fv(scene->colorLocation, 1, rock->color);
+        glDrawElements(GL_TRIANGLES, (GLsizei)lod->indexCount, GL_UNSIGNED_SHORT,
+            (const void*)(lod->indexOffset * sizeof(unsigned short)));
+
+        stats->triangles += (double)(lod->indexCount / 3);
+        stats->levelCounts[rock->level]++;
+    }
+    PROFILE_GPU_ZONE_END();
+    PROFILE_ZONE_END();
+}
+
+// Render frames in the given mode for a while, the camera flying over the
+// field and back. Every frame is waited for, so the frame rate includes the
+// GPU work.
+static void runMode(scene* scene, lod_mode mode, int grid, double duration, float threshold, float hysteresis,
+                    GLFWwindow* window, EGLDisplay display, EGLSurface surface, mode_stats* stats) {
+    const float pi = 3.14159265358979323846f;
+    memset(stats, 0, sizeof(mode_stats));
+    for (int i = 0; i < scene->objectCount; i++) {
+        scene->objects[i].level = 0;
+    }
+
+    float depth = (float)grid * CELL_SIZE;
+    float fovy = FIELD_OF_VIEW * pi / 180.0f;
+    mat4 view, proj, viewProj;
+    mat4_perspective(proj, fovy, 640.0f / 480.0f, 0.1f, depth * 1.5f);
+    float projectionScale = mesh_lod_projection_scale(fovy, 480);
+
+    double start = timer_now();
+    double end = start + duration;
+    while (timer_now() < end && !(window && glfwWindowShouldClose(window))) {
+        PROFILE_ZONE_BEGIN("frame");
+        PROFILE_GPU_ZONE_BEGIN("frame");
+
+        // Start at the front of the field, fly to its middle and come back,
+        // once every 20 seconds.
+        float t = (float)(timer_now() - start) * 2.0f * pi / 20.0f;
+        float eye[3] = { 0.0f, 6.0f, -CELL_SIZE * 2.0f + (1.0f - cosf(t)) * depth * 0.25f };
+        mat4_look_at(view,
+            eye[0], eye[1], eye[2],
+            eye[0] + sinf(t) * 0.3f, 2.0f, eye[2] + 20.0f,
+            0, 1, 0
+        );
+        mat4_multiply(viewProj, proj, view);
+
+        glClearColor(0.62f, 0.72f, 0.82f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+        gl_debug_push_group(modeNames[mode]);
+        drawScene(scene, mode, viewProj, eye, projectionScale, threshold, hysteresis, stats);
+        gl_debug_pop_group();
+
+        PROFILE_GPU_ZONE_END();
+        PROFILE_ZONE_BEGIN("eglSwapBuffers");
+        eglSwapBuffers(display, surface);
+        PROFILE_ZONE_END();
+        glFinish();
+        profiler_gpu_collect();
+        PROFILE_ZONE_END();
+        stats->frames++;
+
+        if (window) {
+            glfwPollEvents();
+        }
+    }
+    stats->seconds = timer_now() - start;
+}
+
+int main(int argc, char** argv) {
+    int grid = option_int(argc, argv, "--grid", 16);
+    int rings = option_int(argc, argv, "--rings", 64);
+    float threshold = (float)option_double(argc, argv, "--threshold", 1.0);
+    float hysteresis = (float)option_double(argc, argv, "--hysteresis", 0.25);
+    double duration = option_double(argc, argv, "--seconds", 2.0);
+    int useWindow = option_flag(argc, argv, "--window");
+    const char* reportPath = option_string(argc, argv, "--json", NULL);
+    const char* tracePath = option_string(argc, argv, "--trace", NULL);
+
+    if (grid < 1 || grid > 256) {
+        fprintf(stderr, "The grid size must be between 1 and 256\n");
+        return -1;
+    }
+    if (threshold <= 0.0f || hysteresis < 0.0f || hysteresis >= 1.0f) {
+        fprintf(stderr, "The threshold must be positive and the hysteresis between 0 and 1\n");
+        return -1;
+    }
+
+    PROFILE_THREAD_NAME("main");
+
+    GLFWwindow* window = NULL;
+    EGLDisplay display;
+    EGLConfig config;
+    EGLContext context;
+    EGLSurface surface;
+    if (useWindow) {
+        if (initializeWindow(&window, &display, &context, &surface, 640, 480, "Erlangsters - Mesh LOD") != 0) {
+            return -1;
+        }
+    } else if (initializeHeadless(&display, &config, &context, &surface, 640, 480) != 0) {
+        return -1;
+    }
+    gl_debug_install();
+    profiler_gpu_init();
+
+    report* report = report_open(reportPath);
+    report_string(report, "sample", "mesh-lod");
+    report_integer(report, "objects", grid * grid);
+    report_number(report, "threshold_pixels", threshold);
+    report_number(report, "hysteresis", hysteresis);
+
+    static scene scene;
+    if (createScene(&scene, grid, rings, report) != 0) {
+        return -1;
+    }
+    printf("Drawing %d rocks (threshold: %.2f pixels, hysteresis: %.0f%%)\n",
+        scene.objectCount, threshold, hysteresis * 100.0f);
+
+    report_begin_array(report, "modes");
+    double fullTriangles = 0.0;
+    for (int mode = 0; mode < MODE_COUNT; mode++) {
+        mode_stats stats;
+        runMode(&scene, (lod_mode)mode, grid, duration, threshold, hysteresis, window, display, surface, &stats);
+        if (stats.frames == 0) {
+            break;
+        }
+
+        double frames = (double)stats.frames;
+        double fps = frames / stats.seconds;
+        double triangles = stats.triangles / frames;
+        if (mode == MODE_FULL) {
+            fullTriangles = triangles;
+        }
+        printf("%-5s triangles: %10.0f (%5.1f%%)  switches: %6.2f  %8.1f frames/s  levels:",
+            modeNames[mode], triangles, fullTriangles > 0.0 ? triangles * 100.0 / fullTriangles : 100.0,
+            stats.switches / frames, fps);
+        for (int level = 0; level < scene.chain.levelCount; level++) {
+            printf(" %.0f", stats.levelCounts[level] / frames);
+        }
+        printf("\n");
+
+        report_begin_object(report, NULL);
+        report_string(report, "mode", modeNames[mode]);
+        report_integer(report, "frames", stats.frames);
+        report_number(report, "frames_per_second", fps);
+        report_number(report, "triangles_per_frame", triangles);
+        report_number(report, "switches_per_frame", stats.switches / frames);
+        report_begin_array(report, "objects_per_level");
+        for (int level = 0; level < scene.chain.levelCount; level++) {
+            report_number(report, NULL, stats.levelCounts[level] / frames);
+        }
+        report_end_array(report);
+        report_end_object(report);
+    }
+
+    report_end_array(report);
+    gpu_memory_print();
+    gpu_memory_report(report);
+    report_close(report);
+
+    deleteScene(&scene);
+    gl_debug_summary();
+    profiler_gpu_shutdown();
+    if (tracePath) {
+        profiler_write_trace(tracePath);
+    }
+    if (window) {
+        terminateWindow(window);
+    } else {
+        terminateHeadless(display, context, surface);
+    }
+
+    return 0;
+}
@@ -0,0 +1,586 @@
+//
+// Copyright (c) 2025, Byteplug LLC.
+//
+// This source file is part of a project made by the Erlangsters community and
+// is released under the MIT license. Please refer to the LICENSE.md file that
+// can be found at the root of the project repository.
+//
+// Written by Jonathan De Wachter <jonathan.dewachter@byteplug.io>
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdatomic.h>
+#include "gl_api.h"
+#include "gl_debug.h"
+#include "gpu_memory.h"
+#include "matrix.h"
+#include "window.h"
+#include "thread.h"
+#include "timer.h"
+#include "options.h"
+#include "profiler.h"
+#include "report.h"
+#include "shader.h"
+#include "startup.h"
+#include "texture_gen.h"
+
+#define MAX_VIEWS 256
+#define MAX_THREADS 64
+
+#define CHECKER_TEXTURE_WIDTH 16
+#define CHECKER_TEXTURE_HEIGHT 16
+
+// Uniform values are stored in the program object, which is shared between
+// all the contexts. Views rendered concurrently would race on them, so the
+// per-view world matrix is passed as a constant vertex attribute instead
+// (current attribute values are per-context state).
+const char* vertexShaderSource =
+    "ATTRIBUTE vec3 vertPosition;\n"
+    "ATTRIBUTE vec2 vertTexCoord;\n"
+    "ATTRIBUTE mat4 vertWorld;\n"
+    "VARYING_OUT vec2 fragTexCoord;\n"
+    "uniform mat4 mView;\n"
+    "uniform mat4 mProj;\n"
+    "void main()\n"
+    "{\n"
+    "    fragTexCoord = vertTexCoord;\n"
+    "    gl_Position = mProj * mView * vertWorld * vec4(vertPosition, 1.0);\n"
+    "}\n";
+
+const char* fragmentShaderSource =
+    "VARYING_IN vec2 fragTexCoord;\n"
+    "uniform sampler2D texture0;\n"
+    "void main()\n"
+    "{\n"
+    "    FRAG_COLOR = texture(texture0, fragTexCoord);\n"
+    "}\n";
+
+// The world matrix takes the locations 2 to 5.
+const char* attributes[] = { "vertPosition", "vertTexCoord", "vertWorld", NULL };
+
+static const float vertices[] = {
+    // Format: X, Y, Z, U, V
+    // Top
+    -1.0f,  1.0f, -1.0f,   0.0f, 0.0f,
+    -1.0f,  1.0f,  1.0f,   0.0f, 1.0f,
+     1.0f,  1.0f,  1.0f,   1.0f, 1.0f,
+     1.0f,  1.0f, -1.0f,   1.0f, 0.0f,
+
+    // Left
+    -1.0f,  1.0f,  1.0f,   0.0f, 0.0f,
+    -1.0f, -1.0f,  1.0f,   0.0f, 1.0f,
+    -1.0f, -1.0f, -1.0f,   1.0f, 1.0f,
+    -1.0f,  1.0f, -1.0f,   1.0f, 0.0f,
+
+    // Right
+     1.0f,  1.0f,  1.0f,   0.0f, 0.0f,
+     1.0f, -1.0f,  1.0f,   0.0f, 1.0f,
+     1.0f, -1.0f, -1.0f,   1.0f, 1.0f,
+     1.0f,  1.0f, -1.0f,   1.0f, 0.0f,
+
+    // Front
+     1.0f,  1.0f,  1.0f,   0.0f, 0.0f,
+     1.0f, -1.0f,  1.0f,   0.0f, 1.0f,
+    -1.0f, -1.0f,  1.0f,   1.0f, 1.0f,
+    -1.0f,  1.0f,  1.0f,   1.0f, 0.0f,
+
+    // Back
+     1.0f,  1.0f, -1.0f,   0.0f, 0.0f,
+     1.0f, -1.0f, -1.0f,   0.0f, 1.0f,
+    -1.0f, -1.0f, -1.0f,   1.0f, 1.0f,
+    -1.0f,  1.0f, -1.0f,   1.0f, 0.0f,
+
+    // Bottom
+    -1.0f, -1.0f, -1.0f,   0.0f, 0.0f,
+    -1.0f, -1.0f,  1.0f,   0.0f, 1.0f,
+     1.0f, -1.0f,  1.0f,   1.0f, 1.0f,
+     1.0f, -1.0f, -1.0f,   1.0f, 0.0f
+};
+
+static const unsigned short indices[] = {
+    0, 1, 2,    0, 2, 3,    // Top
+    5, 4, 6,    6, 4, 7,    // Left
+    8, 9, 10,   8, 10, 11,  // Right
+    13, 12, 14, 15, 14, 12, // Front
+    16, 17, 18, 16, 18, 19, // Back
+    21, 20, 22, 22, 20, 23  // Bottom
+};
+
+typedef struct {
+    GLFWwindow* window;
+    EGLSurface surface;
+    float phase;
+} view;
+
+// Objects created by the root context and shared with every worker context.
+typedef struct {
+    GLuint program;
+    GLuint vbo;
+    GLuint ebo;
+    GLuint texture;
+    GLint posAttrib;
+    GLint texCoordAttrib;
+    GLint worldAttrib;
+} shared_resources;
+
+typedef struct {
+    EGLDisplay display;
+    EGLContext context;
+    int index;
+    int threadCount;
+    int initialized;
+    #if SAMPLE_OPENGL_API == SAMPLE_API_GL || SAMPLE_OPENGL_VERSION_MAJOR >= 3
+        GLuint vao;
+    #endif
+
+    const shared_resources* resources;
+    view* views;
+    int viewCount;
+    int width;
+    int height;
+    int presentToWindow;
+
+    atomic_int* running;
+    atomic_llong* frames;
+} worker;
+
+static int createSharedResources(shared_resources* resources, float aspect) {
+    const float pi = 3.14159265358979323846f;
+
+    shader_program program = {
+        .label = "Multi-view program",
+        .vertex = vertexShaderSource,
+        .fragment = fragmentShaderSource,
+        .attributes = attributes
+    };
+    resources->program = shader_build(&program);
+    if (!resources->program) {
+        return -1;
+    }
+
+    resources->posAttrib = 0;
+    resources->texCoordAttrib = 1;
+    resources->worldAttrib = 2;
+
+    glGenBuffers(1, &resources->vbo);
+    glBindBuffer(GL_ARRAY_BUFFER, resources->vbo);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+    gpu_memory_track(GPU_MEMORY_BUFFER, resources->vbo, sizeof(vertices));
+
+    glGenBuffers(1, &resources->ebo);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, resources->ebo);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
+    gpu_memory_track(GPU_MEMORY_BUFFER, resources->ebo, sizeof(indices));
+
+    unsigned char textureData[CHECKER_TEXTURE_WIDTH * CHECKER_TEXTURE_HEIGHT * 4];
+    texture_desc checker = {
+        TEXTURE_PATTERN_CHECKER, CHECKER_TEXTURE_WIDTH, CHECKER_TEXTURE_HEIGHT,
+        { 128, 0, 0, 255 }, { 255, 0, 0, 255 }, 8, 0
+    };
+    texture_gen_fill(&checker, textureData, NULL);
+
+    glGenTextures(1, &resources->texture);
+    glBindTexture(GL_TEXTURE_2D, resources->texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, CHECKER_TEXTURE_WIDTH, CHECKER_TEXTURE_HEIGHT,
+        0, GL_RGBA, GL_UNSIGNED_BYTE, textureData);
+    gpu_memory_track(GPU_MEMORY_TEXTURE, resources->texture, gpu_memory_texture_size(GL_RGBA,
+        GL_UNSIGNED_BYTE, CHECKER_TEXTURE_WIDTH, CHECKER_TEXTURE_HEIGHT, 1, 1));
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+    // Every view has the same size, so the view and projection matrices are
+    // identical for all of them and can live in the shared program.
+    mat4 view, proj;
+    mat4_look_at(view,
+        0, 0, -8,
+        0, 0, 0,
+        0, 1, 0
+    );
+    mat4_perspective(proj, 45.0f * pi / 180.0f, aspect, 0.1f, 1000.0f);
+
+    glUseProgram(resources->program);
+    glUniform1i(glGetUniformLocation(resources->program, "texture0"), 0);
+    glUniformMatrix4fv(glGetUniformLocation(resources->program, "mView"), 1, GL_FALSE, (float*)view);
+    glUniformMatrix4fv(glGetUniformLocation(resources->program, "mProj"), 1, GL_FALSE, (float*)proj);
+    glUseProgram(0);
+
+    // Other contexts may only observe the shared objects once their creation
+    // has completed on the GPU.
+    glFinish();
+
+    return 0;
+}
+
+static void deleteSharedResources(shared_resources* resources) {
+    gpu_memory_untrack(GPU_MEMORY_TEXTURE, resources->texture);
+    gpu_memory_untrack(GPU_MEMORY_BUFFER, resources->vbo);
+    gpu_memory_untrack(GPU_MEMORY_BUFFER, resources->ebo);
+    glDeleteTextures(1, &resources->texture);
+    glDeleteBuffers(1, &resources->vbo);
+    glDeleteBuffers(1, &resources->ebo);
+    glDeleteProgram(resources->program);
+}
+
+// Set up the per-context state of a worker; vertex arrays are container
+// objects and therefore never shared between contexts.
+static void initializeWorkerContext(worker* worker) {
+    const shared_resources* resources = worker->resources;
+
+    // The message callback is per-context state.
+    gl_debug_install();
+
+    #if SAMPLE_OPENGL_API == SAMPLE_API_GL || SAMPLE_OPENGL_VERSION_MAJOR >= 3
+        glGenVertexArrays(1, &worker->vao);
+        glBindVertexArray(worker->vao);
+    #endif
+
+    glBindBuffer(GL_ARRAY_BUFFER, resources->vbo);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, resources->ebo);
+    glVertexAttribPointer(resources->posAttrib, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), 0);
+    glVertexAttribPointer(resources->texCoordAttrib, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(3 * sizeof(float)));
+    glEnableVertexAttribArray(resources->posAttrib);
+    glEnableVertexAttribArray(resources->texCoordAttrib);
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, resources->texture);
+    glUseProgram(resources->program);
+
+    glEnable(GL_DEPTH_TEST);
+    glEnable(GL_CULL_FACE);
+    glFrontFace(GL_CCW);
+    glCullFace(GL_BACK);
+    glViewport(0, 0, worker->width, worker->height);
+
+    worker->initialized = 1;
+}
+
+static void renderView(worker* worker, view* view, double time) {
+    mat4 world, rotatedY;
+    float angle = (float)time + view->phase;
+
+    mat4_identity(world);
+    mat4_rotate_y(rotatedY, world, angle);
+    mat4_rotate_x(world, rotatedY, angle * 0.25f);
+
+    GLint worldAttrib = worker->resources->worldAttrib;
+    for (int column = 0; column < 4; column++) {
+        glVertexAttrib4fv(worldAttrib + column, &world[column * 4]);
+    }
+
+    glClearColor(0.75f, 0.85f, 0.8f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    glDrawElements(GL_TRIANGLES, 36, GL_UNSIGNED_SHORT, 0);
+
+    if (worker->presentToWindow) {
+        eglSwapBuffers(worker->display, view->surface);
+    } else {
+        // Pbuffers are never presented; wait for the frame to complete so the
+        // frame counter reflects finished work rather than queued commands.
+        glFinish();
+    }
+}
+
+// Vertex arrays belong to the context that created them, so the one of every
+// initialized worker is deleted with its context current (on the given
+// surface) before the context is destroyed. The contexts not created yet are
+// EGL_NO_CONTEXT.
+static void destroyWorkerContexts(worker* workers, int count, EGLSurface surface) {
+    for (int i = 0; i < count; i++) {
+        if (workers[i].context == EGL_NO_CONTEXT) {
+            continue;
+        }
+        #if SAMPLE_OPENGL_API == SAMPLE_API_GL || SAMPLE_OPENGL_VERSION_MAJOR >= 3
+            if (workers[i].initialized && eglMakeCurrent(workers[i].display, surface, surface, workers[i].context)) {
+                glDeleteVertexArrays(1, &workers[i].vao);
+                eglMakeCurrent(workers[i].display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+            }
+        #else
+            (void)surface;
+        #endif
+        eglDestroyContext(workers[i].display, workers[i].context);
+        workers[i].context = EGL_NO_CONTEXT;
+    }
+}
+
+// Destroy the views other than the root one, then the root context with its
+// window or pbuffer. The views not created yet have no surface.
+static void terminate(GLFWwindow* rootWindow, EGLDisplay display, EGLContext rootContext, EGLSurface rootSurface,
+                      view* views, int viewCount) {
+    for (int i = 0; i < viewCount; i++) {
+        if (views[i].surface != EGL_NO_SURFACE && views[i].surface != rootSurface) {
+            eglDestroySurface(display, views[i].surface);
+        }
+        if (views[i].window && views[i].window != rootWindow) {
+            glfwDestroyWindow(views[i].window);
+        }
+    }
+    if (rootWindow) {
+        terminateWindow(rootWindow);
+    } else {
+        terminateHeadless(display, rootContext, rootSurface);
+    }
+}
+
+static void workerMain(void* arg) {
+    worker* worker = arg;
+
+    char name[32];
+    snprintf(name, sizeof(name), "worker %d", worker->index);
+    PROFILE_THREAD_NAME(name);
+
+    // Views are distributed round-robin over the workers; each view is owned
+    // by exactly one worker for the duration of a round.
+    while (atomic_load_explicit(worker->running, memory_order_relaxed)) {
+        for (int i = worker->index; i < worker->viewCount; i += worker->threadCount) {
+            view* view = &worker->views[i];
+            if (!eglMakeCurrent(worker->display, view->surface, view->surface, worker->context)) {
+                fprintf(stderr, "Worker %d failed to make its context current\n", worker->index);
+                atomic_store(worker->running, 0);
+                break;
+            }
+
+            if (!worker->initialized) {
+                initializeWorkerContext(worker);
+            }
+            if (worker->presentToWindow) {
+                eglSwapInterval(worker->display, 0);
+            }
+
+            PROFILE_ZONE_BEGIN("render_view");
+            renderView(worker, view, timer_now());
+            PROFILE_ZONE_END();
+            atomic_fetch_add_explicit(worker->frames, 1, memory_order_relaxed);
+        }
+    }
+
+    eglMakeCurrent(worker->display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+}
+
+int main(int argc, char** argv) {
+    startup_begin();
+
+    int viewCount = option_int(argc, argv, "--views", 8);
+    int maxThreads = option_int(argc, argv, "--threads", thread_hardware_concurrency());
+    double warmup = option_double(argc, argv, "--warmup", 0.25);
+    double duration = option_double(argc, argv, "--seconds", 2.0);
+    int width = option_int(argc, argv, "--width", 320);
+    int height = option_int(argc, argv, "--height", 240);
+    int useWindows = option_flag(argc, argv, "--windows");
+    const char* reportPath = option_string(argc, argv, "--json", NULL);
+    const char* tracePath = option_string(argc, argv, "--trace", NULL);
+    PROFILE_THREAD_NAME("main");
+
+    if (viewCount < 1 || viewCount > MAX_VIEWS) {
+        fprintf(stderr, "The number of views must be between 1 and %d\n", MAX_VIEWS);
+        return -1;
+    }
+    if (maxThreads < 1) {
+        maxThreads = 1;
+    }
+    if (maxThreads > MAX_THREADS) {
+        maxThreads = MAX_THREADS;
+    }
+    if (maxThreads > viewCount) {
+        maxThreads = viewCount;
+    }
+
+    // The root context owns every shared object. With windows, it is the
+    // context of the first window; otherwise it renders to a tiny pbuffer.
+    EGLDisplay display;
+    EGLConfig config;
+    EGLContext rootContext;
+    EGLSurface rootSurface = EGL_NO_SURFACE;
+    GLFWwindow* rootWindow = NULL;
+
+    static view views[MAX_VIEWS];
+    if (useWindows) {
+        if (initializeWindow(&rootWindow, &display, &rootContext, &rootSurface, width, height, "Erlangsters - Multi View") != 0) {
+            return -1;
+        }
+        if (queryContextConfig(display, rootContext, &config) != 0) {
+            fprintf(stderr, "Failed to query the EGL config of the root context\n");
+            terminate(rootWindow, display, rootContext, rootSurface, views, 0);
+            return -1;
+        }
+
+        views[0].window = rootWindow;
+        views[0].surface = rootSurface;
+        for (int i = 1; i < viewCount; i++) {
+            if (createWindowSurface(&views[i].window, &views[i].surface, display, config, width, height, "Erlangsters - Multi View") != 0) {
+                terminate(rootWindow, display, rootContext, rootSurface, views, i);
+                return -1;
+            }
+        }
+    } else {
+        if (initializeHeadless(&display, &config, &rootContext, &rootSurface, 1, 1) != 0) {
+            return -1;
+        }
+
+        for (int i = 0; i < viewCount; i++) {
+            views[i].window = NULL;
+            views[i].surface = createOffscreenSurface(display, config, width, height);
+            if (views[i].surface == EGL_NO_SURFACE) {
+                fprintf(stderr, "Failed to create the pbuffer of view %d\n", i);
+                terminate(rootWindow, display, rootContext, rootSurface, views, i);
+                return -1;
+            }
+        }
+    }
+
+    for (int i = 0; i < viewCount; i++) {
+        views[i].phase = (float)i * 0.5f;
+    }
+
+    gl_debug_install();
+
+    int phase = startup_phase_begin("shared_resources");
+    shared_resources resources;
+    if (createSharedResources(&resources, (float)width / (float)height) != 0) {
+        terminate(rootWindow, display, rootContext, rootSurface, views, viewCount);
+        return -1;
+    }
+    startup_phase_end(phase);
+
+    // Worker contexts are created upfront and reused across the rounds of
+    // the benchmark; only the threads driving them change.
+    phase = startup_phase_begin("worker_contexts");
+    static worker workers[MAX_THREADS];
+    for (int i = 0; i < maxThreads; i++) {
+        workers[i].display = display;
+        workers[i].context = createSharedContext(display, config, rootContext);
+        workers[i].initialized = 0;
+        if (workers[i].context == EGL_NO_CONTEXT) {
+            fprintf(stderr, "Failed to create the shared context of worker %d\n", i);
+            destroyWorkerContexts(workers, i, rootSurface);
+            deleteSharedResources(&resources);
+            terminate(rootWindow, display, rootContext, rootSurface, views, viewCount);
+            return -1;
+        }
+    }
+
+    startup_phase_end(phase);
+
+    startup_print();
+    gpu_memory_print();
+    printf("Rendering %d %s views of %dx%d with up to %d threads\n",
+        viewCount, useWindows ? "window" : "pbuffer", width, height, maxThreads);
+
+    report* report = report_open(reportPath);
+    report_string(report, "sample", "multi-view");
+    report_string(report, "surface", useWindows ? "window" : "pbuffer");
+    report_integer(report, "views", viewCount);
+    report_integer(report, "width", width);
+    report_integer(report, "height", height);
+    startup_report(report);
+    gpu_memory_report(report);
+    report_begin_array(report, "rounds");
+
+    // Release the root context so that its surface (the first window) can
+    // be made current by a worker.
+    eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+
+    double singleThreadFps = 0.0;
+    int threadCount = 1;
+    while (threadCount <= maxThreads) {
+        atomic_int running = 1;
+        atomic_llong frames = 0;
+
+        static thread_t threads[MAX_THREADS];
+        int started = 0;
+        for (int i = 0; i < threadCount; i++) {
+            workers[i].index = i;
+            workers[i].threadCount = threadCount;
+            workers[i].resources = &resources;
+            workers[i].views = views;
+            workers[i].viewCount = viewCount;
+            workers[i].width = width;
+            workers[i].height = height;
+            workers[i].presentToWindow = useWindows;
+            workers[i].running = &running;
+            workers[i].frames = &frames;
+
+            if (thread_create(&threads[i], workerMain, &workers[i]) != 0) {
+                fprintf(stderr, "Failed to start worker thread %d\n", i);
+                atomic_store(&running, 0);
+                break;
+            }
+            started++;
+        }
+
+        // Let every worker initialize its context before measuring.
+        double start = timer_now();
+        long long startFrames = 0;
+        int measuring = 0;
+        double end = start + warmup + duration;
+        while (atomic_load(&running) && timer_now() < end) {
+            if (!measuring && timer_now() >= start + warmup) {
+                startFrames = atomic_load(&frames);
+                start = timer_now();
+                measuring = 1;
+            }
+            if (useWindows) {
+                glfwPollEvents();
+                if (glfwWindowShouldClose(rootWindow)) {
+                    atomic_store(&running, 0);
+                }
+            }
+            timer_sleep(0.005);
+        }
+        double elapsed = timer_now() - start;
+        long long renderedFrames = atomic_load(&frames) - startFrames;
+
+        int completed = atomic_load(&running);
+        atomic_store(&running, 0);
+        for (int i = 0; i < started; i++) {
+            thread_join(threads[i]);
+        }
+
+        if (!completed || !measuring) {
+            break;
+        }
+
+        double fps = (double)renderedFrames / elapsed;
+        if (threadCount == 1) {
+            singleThreadFps = fps;
+        }
+        double efficiency = singleThreadFps > 0.0 ? fps / (singleThreadFps * threadCount) : 0.0;
+
+        printf("threads: %2d  aggregate: %9.1f frames/s  per view: %8.1f frames/s  efficiency: %5.1f%%\n",
+            threadCount, fps, fps / viewCount, efficiency * 100.0);
+
+        report_begin_object(report, NULL);
+        report_integer(report, "threads", threadCount);
+        report_integer(report, "frames", renderedFrames);
+        report_number(report, "seconds", elapsed);
+        report_number(report, "frames_per_second", fps);
+        report_number(report, "frames_per_second_per_view", fps / viewCount);
+        report_number(report, "efficiency", efficiency);
+        report_end_object(report);
+
+        // Double the thread count at every round, making sure the maximum
+        // requested is measured as well.
+        if (threadCount == maxThreads) {
+            break;
+        }
+        threadCount = threadCount * 2 > maxThreads ? maxThreads : threadCount * 2;
+    }
+
+    report_end_array(report);
+    report_close(report);
+
+    // The worker contexts go first, then everything else is torn down from
+    // the root context.
+    destroyWorkerContexts(workers, maxThreads, rootSurface);
+    eglMakeCurrent(display, rootSurface, rootSurface, rootContext);
+    deleteSharedResources(&resources);
+    gl_debug_summary();
+    if (tracePath) {
+        profiler_write_trace(tracePath);
+    }
+
+    terminate(rootWindow, display, rootContext, rootSurface, views, viewCount);
+
+    return 0;
+}
@@ -0,0 +1,961 @@
+//
+// Copyright (c) 2025, Byteplug LLC.
+//
+// This source file is part of a project made by the Erlangsters community and
+// is released under the MIT license. Please refer to the LICENSE.md file that
+// can be found at the root of the project repository.
+//
+// Written by Jonathan De Wachter <jonathan.dewachter@byteplug.io>
+//
+#include <math.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "gl_api.h"
+#include "gl_debug.h"
+#include "gpu_memory.h"
+#include "matrix.h"
+#include "window.h"
+#include "options.h"
+#include "profiler.h"
+#include "report.h"
+#include "shader.h"
+#include "timer.h"
+
+// Walks a camera around a dense interior (a grid of rooms connected by
+// doorways and filled with small objects) where most of the scene is hidden
+// behind walls, and draws it:
+//
+// - "all": every object, with a single instanced draw (one draw per object
+//   on OpenGL ES 2.0);
+// - "frustum": only the objects in the view frustum, selected by a compute
+//   shader that writes the surviving instances and an indirect draw command;
+// - "hi-z": same, but the objects are also tested against a hierarchical
+//   depth buffer (a max-depth mip pyramid) built from the depth buffer of
+//   the previous frame.
+//
+// The culling modes need compute shaders, so they are only available on
+// OpenGL 4.6 and OpenGL ES 3.1+. Because the pyramid is one frame late, an
+// object that just came into view may be missing for a frame.
+
+#if defined(OPENGL_VERSION_46) || defined(OPENGL_ES_VERSION_31) || defined(OPENGL_ES_VERSION_32)
+    #define OCCLUSION_CULLING 1
+#else
+    #define OCCLUSION_CULLING 0
+#endif
+
+#define ATTRIB_POSITION 0
+#define ATTRIB_NORMAL 1
+#define ATTRIB_CENTER 2
+#define ATTRIB_EXTENT 3
+
+#define ROOM_SIZE 10.0f
+#define WALL_HEIGHT 4.0f
+#define WALL_THICKNESS 0.25f
+#define DOOR_WIDTH 2.0f
+#define OBJECTS_PER_ROOM 48
+
+#define CULL_GROUP_SIZE 64
+#define HIZ_GROUP_SIZE 8
+
+// Number of frames the culling statistics are read back behind.
+#define STATS_LATENCY 3
+
+static const char* vertexSource =
+    "ATTRIBUTE vec3 vertPosition;\n"
+    "ATTRIBUTE vec3 vertNormal;\n"
+    "ATTRIBUTE vec4 instCenter;\n"
+    "ATTRIBUTE vec4 instExtent;\n"
+    "VARYING_OUT vec3 fragColor;\n"
+    "uniform mat4 mViewProj;\n"
+    "void main() {\n"
+    "    float light = 0.55 + 0.45 * max(dot(vertNormal, vec3(0.4, 0.8, 0.45)), 0.0);\n"
+    "    fragColor = vec3(0.9, 0.85, 0.75) * instCenter.w * light;\n"
+    "    gl_Position = mViewProj * vec4(instCenter.xyz + vertPosition * instExtent.xyz, 1.0);\n"
+    "}\n";
+
+static const char* fragmentSource =
+    "VARYING_IN vec3 fragColor;\n"
+    "void main() {\n"
+    "    FRAG_COLOR = vec4(fragColor, 1.0);\n"
+    "}\n";
+
+static const char* attributes[] = { "vertPosition", "vertNormal", "instCenter", "instExtent", NULL };
+
+#if OCCLUSION_CULLING
+// The pyramid is built by halving the depth buffer, then each level in turn,
+// keeping the farthest depth of the texels a texel covers. When a level has
+// an odd size, its last row and column are folded into the last texels of
+// the next level, so every texel of a level covers whole texels of the
+// level below. The first level reads the depth texture, the others the
+// previous level (the HI_Z_SOURCE variant).
+static const char* reduceSource =
+    "layout(local_size_x = 8, local_size_y = 8) in;\n"
+    "#ifdef HI_Z_SOURCE\n"
+    "layout(r32f, binding = 0) readonly uniform image2D source;\n"
+    "#define SOURCE_SIZE() imageSize(source)\n"
+    "#define SOURCE_DEPTH(p) imageLoad(source, p).r\n"
+    "#else\n"
+    "layout(binding = 0) uniform sampler2D source;\n"
+    "#define SOURCE_SIZE() textureSize(source, 0)\n"
+    "#define SOURCE_DEPTH(p) texelFetch(source, p, 0).r\n"
+    "#endif\n"
+    "layout(r32f, binding = 1) writeonly uniform image2D destination;\n"
+    "void main() {\n"
+    "    ivec2 p = ivec2(gl_GlobalInvocationID.xy);\n"
+    "    ivec2 size = imageSize(destination);\n"
+    "    if (p.x >= size.x || p.y >= size.y) {\n"
+    "        return;\n"
+    "    }\n"
+    "    ivec2 sourceSize = SOURCE_SIZE();\n"
+    "    ivec2 last = sourceSize - 1;\n"
+    "    int columns = p.x == size.x - 1 && (sourceSize.x & 1) == 1 ? 3 : 2;\n"
+    "    int rows = p.y == size.y - 1 && (sourceSize.y & 1) == 1 ? 3 : 2;\n"
+    "    float depth = 0.0;\n"
+    "    for (int y = 0; y < rows; y++) {\n"
+    "        for (int x = 0; x < columns; x++) {\n"
+    "            depth = max(depth, SOURCE_DEPTH(min(p * 2 + ivec2(x, y), last)));\n"
+    "        }\n"
+    "    }\n"
+    "    imageStore(destination, p, vec4(depth));\n"
+    "}\n";
+
+// One invocation per object. The draw block is also the indirect draw
+// command (the instance count is the number of visible objects), followed
+// by the statistics.
+static const char* cullSource =
+    "layout(local_size_x = 64) in;\n"
+    "struct Instance {\n"
+    "    vec4 center;\n"
+    "    vec4 extent;\n"
+    "};\n"
+    "layout(std430, binding = 0) readonly buffer Instances {\n"
+    "    Instance instances[];\n"
+    "};\n"
+    "layout(std430, binding = 1) writeonly buffer Visible {\n"
+    "    Instance visible[];\n"
+    "};\n"
+    "layout(std430, binding = 2) buffer Draw {\n"
+    "    uint count;\n"
+    "    uint instanceCount;\n"
+    "    uint firstIndex;\n"
+    "    int baseVertex;\n"
+    "    uint baseInstance;\n"
+    "    uint frustumCulled;\n"
+    "    uint occluded;\n"
+    "} draw;\n"
+    "layout(binding = 0) uniform sampler2D hiZ;\n"
+    "uniform mat4 mViewProj;\n"
+    "uniform mat4 mPreviousViewProj;\n"
+    "uniform ivec2 depthSize;\n"
+    "uniform int hiZLevels;\n"
+    "uniform int objectCount;\n"
+    "uniform int useHiZ;\n"
+    "\n"
+    "vec4 corner(Instance instance, int i) {\n"
+    "    vec3 signs = vec3((i & 1) != 0 ? 1.0 : -1.0, (i & 2) != 0 ? 1.0 : -1.0, (i & 4) != 0 ? 1.0 : -1.0);\n"
+    "    return vec4(instance.center.xyz + signs * instance.extent.xyz, 1.0);\n"
+    "}\n"
+    "\n"
+    "bool outsideFrustum(Instance instance) {\n"
+    "    bvec3 allBelow = bvec3(true);\n"
+    "    bvec3 allAbove = bvec3(true);\n"
+    "    for (int i = 0; i < 8; i++) {\n"
+    "        vec4 clip = mViewProj * corner(instance, i);\n"
+    "        allBelow = bvec3(allBelow.x && clip.x < -clip.w, allBelow.y && clip.y < -clip.w, allBelow.z && clip.z < -clip.w);\n"
+    "        allAbove = bvec3(allAbove.x && clip.x > clip.w, allAbove.y && clip.y > clip.w, allAbove.z && clip.z > clip.w);\n"
+    "    }\n"
+    "    return any(allBelow) || any(allAbove);\n"
+    "}\n"
+    "\n"
+    // Project the box with the previous camera, then compare its nearest
+    // depth with the farthest depth of the texels that cover its screen
+    // rectangle, at the first level where it spans at most 2x2 texels.
+    // Boxes that cross the near plane or the edges of the previous frame are
+    // assumed visible.
+    "bool occluded(Instance instance) {\n"
+    "    vec3 lower = vec3(1.0);\n"
+    "    vec3 upper = vec3(0.0);\n"
+    "    for (int i = 0; i < 8; i++) {\n"
+    "        vec4 clip = mPreviousViewProj * corner(instance, i);\n"
+    "        if (clip.w <= 0.0) {\n"
+    "            return false;\n"
+    "        }\n"
+    "        vec3 window = clip.xyz / clip.w * 0.5 + 0.5;\n"
+    "        lower = min(lower, window);\n"
+    "        upper = max(upper, window);\n"
+    "    }\n"
+    "    if (lower.x < 0.0 || lower.y < 0.0 || upper.x > 1.0 || upper.y > 1.0) {\n"
+    "        return false;\n"
+    "    }\n"
+    "\n"
+    "    ivec2 first = min(ivec2(lower.xy * vec2(depthSize)), depthSize - 1);\n"
+    "    ivec2 last = min(ivec2(upper.xy * vec2(depthSize)), depthSize - 1);\n"
+    "    int span = max(last.x - first.x, last.y - first.y);\n"
+    "    int level = 0;\n"
+    "    while (span > (2 << level) && level < hiZLevels - 1) {\n"
+    "        level++;\n"
+    "    }\n"
+    "    ivec2 levelLast = max(depthSize >> (level + 1), ivec2(1)) - 1;\n"
+    "    first = min(first >> (level + 1), levelLast);\n"
+    "    last = min(last >> (level + 1), levelLast);\n"
+    "\n"
+    "    float depth = max(\n"
+    "        max(texelFetch(hiZ, first, level).r, texelFetch(hiZ, ivec2(last.x, first.y), level).r),\n"
+    "        max(texelFetch(hiZ, ivec2(first.x, last.y), level).r, texelFetch(hiZ, last, level).r));\n"
+    "    return lower.z > depth;\n"
+    "}\n"
+    "\n"
+    "void main() {\n"
+    "    int index = int(gl_GlobalInvocationID.x);\n"
+    "    if (index >= objectCount) {\n"
+    "        return;\n"
+    "    }\n"
+    "    Instance instance = instances[index];\n"
+    "    if (outsideFrustum(instance)) {\n"
+    "        atomicAdd(draw.frustumCulled, 1u);\n"
+    "    } else if (useHiZ != 0 && occluded(instance)) {\n"
+    "        atomicAdd(draw.occluded, 1u);\n"
+    "    } else {\n"
+    "        visible[atomicAdd(draw.instanceCount, 1u)] = instance;\n"
+    "    }\n"
+    "}\n";
+#endif
+
+typedef enum {
+    MODE_ALL,
+    MODE_FRUSTUM,
+    MODE_HI_Z,
+    MODE_COUNT
+} cull_mode;
+
+static const char* modeNames[MODE_COUNT] = { "all", "frustum", "hi-z" };
+
+// An axis-aligned box, with its shade in the w component of the center. It
+// is also the layout of the instance buffers.
+typedef struct {
+    float center[4];
+    float extent[4];
+} instance;
+
+// The layout of the draw block of the culling shader.
+typedef struct {
+    GLuint count;
+    GLuint instanceCount;
+    GLuint firstIndex;
+    GLint baseVertex;
+    GLuint baseInstance;
+    GLuint frustumCulled;
+    GLuint occluded;
+} cull_output;
+
+typedef struct {
+    int width;
+    int height;
+    int instanceCount;
+    int capacity;
+    instance* instances;
+
+    GLuint drawProgram;
+    GLuint vbo;
+    GLuint ebo;
+    GLuint instanceBuffer;
+    #if SAMPLE_OPENGL_API == SAMPLE_API_GL || SAMPLE_OPENGL_VERSION_MAJOR >= 3
+        GLuint vao;
+    #endif
+
+    #if OCCLUSION_CULLING
+        GLuint depthReduceProgram;
+        GLuint hiZReduceProgram;
+        GLuint cullProgram;
+        GLuint visibleBuffer;
+        GLuint drawBuffer;
+        GLuint cullVao;
+
+        GLuint framebuffer;
+        GLuint colorBuffer;
+        GLuint depthTexture;
+        GLuint hiZTexture;
+        int hiZWidth;
+        int hiZHeight;
+        int hiZLevels;
+        int hasHistory;
+        mat4 previousViewProj;
+
+        GLuint statsBuffers[STATS_LATENCY];
+        GLsync statsFences[STATS_LATENCY];
+        int statsSlot;
+    #endif
+} scene;
+
+typedef struct {
+    long long frames;
+    double seconds;
+    long long sampledFrames;
+    double visible;
+    double frustumCulled;
+    double occluded;
+} mode_stats;
+
+static void addBox(scene* scene, float x, float y, float z, float extentX, float extentY, float extentZ, float shade) {
+    instance* box = &scene->instances[scene->instanceCount++];
+    box->center[0] = x;
+    box->center[1] = y;
+    box->center[2] = z;
+    box->center[3] = shade;
+    box->extent[0] = extentX;
+    box->extent[1] = extentY;
+    box->extent[2] = extentZ;
+    box->extent[3] = 0.0f;
+}
+
+// A wall of one room side along the X axis (or the Z axis when swapped),
+// with a doorway in its middle unless it is on the outside.
+static void addWall(scene* scene, float along, float across, int outside, int swapped) {
+    float pieces[2][2] = {
+        { along, along + ROOM_SIZE },
+        { 0.0f, 0.0f }
+    };
+    int pieceCount = 1;
+    if (!outside) {
+        float doorway = along + (ROOM_SIZE - DOOR_WIDTH) * 0.5f;
+        pieces[0][1] = doorway;
+        pieces[1][0] = doorway + DOOR_WIDTH;
+        pieces[1][1] = along + ROOM_SIZE;
+        pieceCount = 2;
+    }
+
+    for (int i = 0; i < pieceCount; i++) {
+        float center = (pieces[i][0] + pieces[i][1]) * 0.5f;
+        float extent = (pieces[i][1] - pieces[i][0]) * 0.5f;
+        if (swapped) {
+            addBox(scene, across, WALL_HEIGHT * 0.5f, center, WALL_THICKNESS * 0.5f, WALL_HEIGHT * 0.5f, extent, 0.8f);
+        } else {
+            addBox(scene, center, WALL_HEIGHT * 0.5f, across, extent, WALL_HEIGHT * 0.5f, WALL_THICKNESS * 0.5f, 0.8f);
+        }
+    }
+}
+
+// Lay out a grid of rooms x rooms rooms, centered on the origin, with walls
+// between them and stacks of small objects inside.
+static int buildScene(scene* scene, int rooms) {
+    int walls = 2 * (rooms + 1) * rooms * 2;
+    scene->capacity = 1 + walls + rooms * rooms * OBJECTS_PER_ROOM;
+    scene->instances = malloc((size_t)scene->capacity * sizeof(instance));
+    if (!scene->instances) {
+        return -1;
+    }
+    scene->instanceCount = 0;
+
+    float origin = -(float)rooms * ROOM_SIZE * 0.5f;
+    float size = (float)rooms * ROOM_SIZE;
+
+    // The floor.
+    addBox(scene, 0.0f, -0.05f, 0.0f, size * 0.5f, 0.05f, size * 0.5f, 0.6f);
+
+    for (int line = 0; line <= rooms; line++) {
+        float across = origin + (float)line * ROOM_SIZE;
+        int outside = line == 0 || line == rooms;
+        for (int room = 0; room < rooms; room++) {
+            float along = origin + (float)room * ROOM_SIZE;
+            addWall(scene, along, across, outside, 0);
+            addWall(scene, along, across, outside, 1);
+        }
+    }
+
+    // Three layers of 4x4 objects per room, with some variation in size and
+    // shade.
+    for (int roomZ = 0; roomZ < rooms; roomZ++) {
+        for (int roomX = 0; roomX < rooms; roomX++) {
+            for (int i = 0; i < OBJECTS_PER_ROOM; i++) {
+                unsigned int hash = (unsigned int)(scene->instanceCount + 1) * 2654435761u;
+                float extent = 0.2f + (float)((hash >> 8) & 0xff) / 255.0f * 0.15f;
+                float shade = 0.45f + (float)((hash >> 16) & 0xff) / 255.0f * 0.55f;
+                float x = origin + (float)roomX * ROOM_SIZE + 2.0f + (float)(i % 4) * 2.0f;
+                float z = origin + (float)roomZ * ROOM_SIZE + 2.0f + (float)(i / 4 % 4) * 2.0f;
+                float y = 0.5f + (float)(i / 16);
+                addBox(scene, x, y, z, extent, extent, extent, shade);
+            }
+        }
+    }
+
+    return 0;
+}
+
+// A unit cube (from -1 to 1) with a normal per face, wound counter-clockwise.
+static void buildCube(float vertices[24 * 6], unsigned short indices[36]) {
+    int vertex = 0;
+    int index = 0;
+    for (int axis = 0; axis < 3; axis++) {
+        for (int side = 0; side < 2; side++) {
+            float sign = side == 0 ? 1.0f : -1.0f;
+            int u = side == 0 ? (axis + 1) % 3 : (axis + 2) % 3;
+            int v = side == 0 ? (axis + 2) % 3 : (axis + 1) % 3;
+            static const float corners[4][2] = { { -1, -1 }, { 1, -1 }, { 1, 1 }, { -1, 1 } };
+
+            for (int i = 0; i < 4; i++) {
+                float* out = &vertices[(vertex + i) * 6];
+                memset(out, 0, 6 * sizeof(float));
+                out[axis] = sign;
+                out[u] = corners[i][0];
+                out[v] = corners[i][1];
+                out[3 + axis] = sign;
+            }
+
+            static const int quad[6] = { 0, 1, 2, 0, 2, 3 };
+            for (int i = 0; i < 6; i++) {
+                indices[index++] = (unsigned short)(vertex + quad[i]);
+            }
+            vertex += 4;
+        }
+    }
+}
+
+static void setupVertexArrays(scene* scene, GLuint instanceBuffer) {
+    glBindBuffer(GL_ARRAY_BUFFER, scene->vbo);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, scene->ebo);
+    glVertexAttribPointer(ATTRIB_POSITION, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), 0);
+    glVertexAttribPointer(ATTRIB_NORMAL, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(3 * sizeof(float)));
+    glEnableVertexAttribArray(ATTRIB_POSITION);
+    glEnableVertexAttribArray(ATTRIB_NORMAL);
+
+    #if SAMPLE_OPENGL_API == SAMPLE_API_GL || SAMPLE_OPENGL_VERSION_MAJOR >= 3
+        glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+        glVertexAttribPointer(ATTRIB_CENTER, 4, GL_FLOAT, GL_FALSE, sizeof(instance), (void*)offsetof(instance, center));
+        glVertexAttribPointer(ATTRIB_EXTENT, 4, GL_FLOAT, GL_FALSE, sizeof(instance), (void*)offsetof(instance, extent));
+        glVertexAttribDivisor(ATTRIB_CENTER, 1);
+        glVertexAttribDivisor(ATTRIB_EXTENT, 1);
+        glEnableVertexAttribArray(ATTRIB_CENTER);
+        glEnableVertexAttribArray(ATTRIB_EXTENT);
+    #else
+        (void)instanceBuffer;
+    #endif
+}
+
+static GLuint createBuffer(GLenum target, size_t size, const void* data, GLenum usage, const char* label) {
+    GLuint buffer;
+    glGenBuffers(1, &buffer);
+    glBindBuffer(target, buffer);
+    GL_CHECK(glBufferData(target, size, data, usage));
+    gpu_memory_track(GPU_MEMORY_BUFFER, buffer, size);
+    gl_debug_label(GL_BUFFER, buffer, label);
+    return buffer;
+}
+
+#if OCCLUSION_CULLING
+// The scene is rendered into a framebuffer with a depth texture, so the
+// depth of each frame can be read by the compute shaders that build the
+// pyramid; it is then blitted to the surface.
+static int createCullingResources(scene* scene) {
+    size_t instanceBytes = (size_t)scene->instanceCount * sizeof(instance);
+    scene->visibleBuffer = createBuffer(GL_ARRAY_BUFFER, instanceBytes, NULL, GL_DYNAMIC_COPY, "Visible instances");
+    scene->drawBuffer = createBuffer(GL_DRAW_INDIRECT_BUFFER, sizeof(cull_output), NULL, GL_DYNAMIC_COPY, "Indirect draw");
+    for (int i = 0; i < STATS_LATENCY; i++) {
+        scene->statsBuffers[i] = createBuffer(GL_COPY_WRITE_BUFFER, sizeof(cull_output), NULL, GL_STREAM_READ,
+            "Culling statistics");
+        scene->statsFences[i] = NULL;
+    }
+    scene->statsSlot = 0;
+
+    glGenVertexArrays(1, &scene->cullVao);
+    glBindVertexArray(scene->cullVao);
+    setupVertexArrays(scene, scene->visibleBuffer);
+    glBindVertexArray(0);
+
+    glGenRenderbuffers(1, &scene->colorBuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, scene->colorBuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, scene->width, scene->height);
+    gpu_memory_track(GPU_MEMORY_RENDERBUFFER, scene->colorBuffer,
+        gpu_memory_texture_size(GL_RGBA, GL_UNSIGNED_BYTE, scene->width, scene->height, 1, 1));
+
+    glGenTextures(1, &scene->depthTexture);
+    glBindTexture(GL_TEXTURE_2D, scene->depthTexture);
+    GL_CHECK(glTexStorage2D(GL_TEXTURE_2D, 1, GL_DEPTH_COMPONENT32F, scene->width, scene->height));
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    gpu_memory_track(GPU_MEMORY_TEXTURE, scene->depthTexture, (size_t)scene->width * scene->height * 4);
+    gl_debug_label(GL_TEXTURE, scene->depthTexture, "Depth buffer");
+
+    glGenFramebuffers(1, &scene->framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, scene->framebuffer);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, scene->colorBuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, scene->depthTexture, 0);
+    GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    if (status != GL_FRAMEBUFFER_COMPLETE) {
+        fprintf(stderr, "The scene framebuffer is incomplete (0x%04X)\n", status);
+        return -1;
+    }
+
+    // The first level of the pyramid is half the size of the depth buffer
+    // and the chain goes down to a single texel.
+    scene->hiZWidth = scene->width / 2 > 0 ? scene->width / 2 : 1;
+    scene->hiZHeight = scene->height / 2 > 0 ? scene->height / 2 : 1;
+    scene->hiZLevels = 1;
+    while ((scene->hiZWidth >> scene->hiZLevels) > 0 || (scene->hiZHeight >> scene->hiZLevels) > 0) {
+        scene->hiZLevels++;
+    }
+
+    glGenTextures(1, &scene->hiZTexture);
+    glBindTexture(GL_TEXTURE_2D, scene->hiZTexture);
+    GL_CHECK(glTexStorage2D(GL_TEXTURE_2D, scene->hiZLevels, GL_R32F, scene->hiZWidth, scene->hiZHeight));
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    gpu_memory_track(GPU_MEMORY_TEXTURE, scene->hiZTexture,
+        gpu_memory_texture_size(GL_RED, GL_FLOAT, scene->hiZWidth, scene->hiZHeight, 1, scene->hiZLevels));
+    gl_debug_label(GL_TEXTURE, scene->hiZTexture, "Hi-Z pyramid");
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    scene->hasHistory = 0;
+    return 0;
+}
+
+static void deleteCullingResources(scene* scene) {
+    for (int i = 0; i < STATS_LATENCY; i++) {
+        if (scene->statsFences[i]) {
+            glDeleteSync(scene->statsFences[i]);
+        }
+        gpu_memory_untrack(GPU_MEMORY_BUFFER, scene->statsBuffers[i]);
+    }
+    glDeleteBuffers(STATS_LATENCY, scene->statsBuffers);
+
+    gpu_memory_untrack(GPU_MEMORY_BUFFER, scene->visibleBuffer);
+    gpu_memory_untrack(GPU_MEMORY_BUFFER, scene->drawBuffer);
+    glDeleteBuffers(1, &scene->visibleBuffer);
+    glDeleteBuffers(1, &scene->drawBuffer);
+    glDeleteVertexArrays(1, &scene->cullVao);
+
+    gpu_memory_untrack(GPU_MEMORY_RENDERBUFFER, scene->colorBuffer);
+    gpu_memory_untrack(GPU_MEMORY_TEXTURE, scene->depthTexture);
+    gpu_memory_untrack(GPU_MEMORY_TEXTURE, scene->hiZTexture);
+    glDeleteFramebuffers(1, &scene->framebuffer);
+    glDeleteRenderbuffers(1, &scene->colorBuffer);
+    glDeleteTextures(1, &scene->depthTexture);
+    glDeleteTextures(1, &scene->hiZTexture);
+
+    glDeleteProgram(scene->depthReduceProgram);
+    glDeleteProgram(scene->hiZReduceProgram);
+    glDeleteProgram(scene->cullProgram);
+}
+#endif
+
+static int createScene(scene* scene, int rooms) {
+    if (buildScene(scene, rooms) != 0) {
+        fprintf(stderr, "Failed to allocate the scene\n");
+        return -1;
+    }
+
+    // All the programs compile at once, while the buffers are created.
+    shader_program programs[] = {
+        { .label = "Draw program", .vertex = vertexSource, .fragment = fragmentSource, .attributes = attributes },
+        #if OCCLUSION_CULLING
+            { .label = "Depth reduction program", .compute = reduceSource },
+            { .label = "Hi-Z reduction program", .defines = "#define HI_Z_SOURCE\n", .compute = reduceSource },
+            { .label = "Culling program", .compute = cullSource }
+        #endif
+    };
+    int programCount = (int)(sizeof(programs) / sizeof(programs[0]));
+    shader_submit(programs, programCount);
+
+    float vertices[24 * 6];
+    unsigned short indices[36];
+    buildCube(vertices, indices);
+
+    scene->vbo = createBuffer(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW, "Cube vertices");
+    scene->ebo = createBuffer(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW, "Cube indices");
+
+    #if SAMPLE_OPENGL_API == SAMPLE_API_GL || SAMPLE_OPENGL_VERSION_MAJOR >= 3
+        // The culling shader reads the instances as a storage buffer, the
+        // "all" mode as per-instance attributes.
+        scene->instanceBuffer = createBuffer(GL_ARRAY_BUFFER, (size_t)scene->instanceCount * sizeof(instance),
+            scene->instances, GL_STATIC_DRAW, "Instances");
+
+        glGenVertexArrays(1, &scene->vao);
+        glBindVertexArray(scene->vao);
+        setupVertexArrays(scene, scene->instanceBuffer);
+        glBindVertexArray(0);
+    #else
+        setupVertexArrays(scene, 0);
+    #endif
+
+    int failures = shader_finish(programs, programCount);
+    scene->drawProgram = programs[0].program;
+    #if OCCLUSION_CULLING
+        scene->depthReduceProgram = programs[1].program;
+        scene->hiZReduceProgram = programs[2].program;
+        scene->cullProgram = programs[3].program;
+    #endif
+    if (failures > 0) {
+        return -1;
+    }
+
+    #if OCCLUSION_CULLING
+        if (createCullingResources(scene) != 0) {
+            return -1;
+        }
+    #endif
+
+    glEnable(GL_DEPTH_TEST);
+    glEnable(GL_CULL_FACE);
+    glFrontFace(GL_CCW);
+    glCullFace(GL_BACK);
+
+    return 0;
+}
+
+static void deleteScene(scene* scene) {
+    #if OCCLUSION_CULLING
+        deleteCullingResources(scene);
+    #endif
+
+    gpu_memory_untrack(GPU_MEMORY_BUFFER, scene->vbo);
+    gpu_memory_untrack(GPU_MEMORY_BUFFER, scene->ebo);
+    glDeleteBuffers(1, &scene->vbo);
+    glDeleteBuffers(1, &scene->ebo);
+    #if SAMPLE_OPENGL_API == SAMPLE_API_GL || SAMPLE_OPENGL_VERSION_MAJOR >= 3
+        gpu_memory_untrack(GPU_MEMORY_BUFFER, scene->instanceBuffer);
+        glDeleteBuffers(1, &scene->instanceBuffer);
+        glDeleteVertexArrays(1, &scene->vao);
+    #endif
+    glDeleteProgram(scene->drawProgram);
+
+    free(scene->instances);
+}
+
+#if OCCLUSION_CULLING
+// Build the pyramid from the depth buffer of the frame that was just drawn.
+static void buildHiZ(scene* scene) {
+    PROFILE_GPU_ZONE_BEGIN("build_hi_z");
+    gl_debug_push_group("Build Hi-Z");
+
+    int width = scene->hiZWidth;
+    int height = scene->hiZHeight;
+
+    glUseProgram(scene->depthReduceProgram);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, scene->depthTexture);
+    glBindImageTexture(1, scene->hiZTexture, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+    glDispatchCompute((width + HIZ_GROUP_SIZE - 1) / HIZ_GROUP_SIZE, (height + HIZ_GROUP_SIZE - 1) / HIZ_GROUP_SIZE, 1);
+
+    glUseProgram(scene->hiZReduceProgram);
+    for (int level = 1; level < scene->hiZLevels; level++) {
+        width = width / 2 > 0 ? width / 2 : 1;
+        height = height / 2 > 0 ? height / 2 : 1;
+
+        glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+        glBindImageTexture(0, scene->hiZTexture, level - 1, GL_FALSE, 0, GL_READ_ONLY, GL_R32F);
+        glBindImageTexture(1, scene->hiZTexture, level, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+        glDispatchCompute((width + HIZ_GROUP_SIZE - 1) / HIZ_GROUP_SIZE, (height + HIZ_GROUP_SIZE - 1) / HIZ_GROUP_SIZE, 1);
+    }
+
+    // The next culling pass reads the pyramid with texelFetch().
+    glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    gl_debug_pop_group();
+    PROFILE_GPU_ZONE_END();
+}
+
+// Fill the indirect draw command and the visible instance buffer.
+static void cullScene(scene* scene, const mat4 viewProj, int useHiZ) {
+    PROFILE_GPU_ZONE_BEGIN("cull");
+    gl_debug_push_group("Cull");
+
+    cull_output reset = { 36, 0, 0, 0, 0, 0, 0 };
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, scene->drawBuffer);
+    glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0, sizeof(reset), &reset);
+
+    GLuint program = scene->cullProgram;
+    glUseProgram(program);
+    glUniformMatrix4fv(glGetUniformLocation(program, "mViewProj"), 1, GL_FALSE, viewProj);
+    glUniformMatrix4fv(glGetUniformLocation(program, "mPreviousViewProj"), 1, GL_FALSE, scene->previousViewProj);
+    glUniform2i(glGetUniformLocation(program, "depthSize"), scene->width, scene->height);
+    glUniform1i(glGetUniformLocation(program, "hiZLevels"), scene->hiZLevels);
+    glUniform1i(glGetUniformLocation(program, "objectCount"), scene->instanceCount);
+    glUniform1i(glGetUniformLocation(program, "useHiZ"), useHiZ && scene->hasHistory);
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, scene->hiZTexture);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, scene->instanceBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, scene->visibleBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, scene->drawBuffer);
+    glDispatchCompute((scene->instanceCount + CULL_GROUP_SIZE - 1) / CULL_GROUP_SIZE, 1, 1);
+
+    glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    gl_debug_pop_group();
+    PROFILE_GPU_ZONE_END();
+}
+
+// Add the statistics of a slot to the totals once the GPU is done with it.
+static void readCullStats(scene* scene, int slot, mode_stats* stats) {
+    GLsync fence = scene->statsFences[slot];
+    if (!fence) {
+        return;
+    }
+
+    GLenum result;
+    do {
+        result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+    } while (result == GL_TIMEOUT_EXPIRED);
+    glDeleteSync(fence);
+    scene->statsFences[slot] = NULL;
+
+    glBindBuffer(GL_COPY_READ_BUFFER, scene->statsBuffers[slot]);
+    const cull_output* output = glMapBufferRange(GL_COPY_READ_BUFFER, 0, sizeof(cull_output), GL_MAP_READ_BIT);
+    if (output) {
+        stats->visible += output->instanceCount;
+        stats->frustumCulled += output->frustumCulled;
+        stats->occluded += output->occluded;
+        stats->sampledFrames++;
+        glUnmapBuffer(GL_COPY_READ_BUFFER);
+    }
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+}
+
+// Copy the statistics of this frame to the next slot of the ring; they are
+// read back STATS_LATENCY frames later, so the CPU never waits on the GPU.
+static void queueCullStats(scene* scene, mode_stats* stats) {
+    int slot = scene->statsSlot;
+    readCullStats(scene, slot, stats);
+
+    glBindBuffer(GL_COPY_READ_BUFFER, scene->drawBuffer);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, scene->statsBuffers[slot]);
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, sizeof(cull_output));
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    scene->statsFences[slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+    scene->statsSlot = (slot + 1) % STATS_LATENCY;
+}
+#endif
+
+// Draw every object, without any culling.
+static void drawAll(scene* scene) {
+    #if SAMPLE_OPENGL_API == SAMPLE_API_GL || SAMPLE_OPENGL_VERSION_MAJOR >= 3
+        glBindVertexArray(scene->vao);
+        GL_CHECK(glDrawElementsInstanced(GL_TRIANGLES, 36, GL_UNSIGNED_SHORT, 0, scene->instanceCount));
+        glBindVertexArray(0);
+    #else
+        for (int i = 0; i < scene->instanceCount; i++) {
+            glVertexAttrib4fv(ATTRIB_CENTER, scene->instances[i].center);
+            glVertexAttrib4fv(ATTRIB_EXTENT, scene->instances[i].extent);
+            glDrawElements(GL_TRIANGLES, 36, GL_UNSIGNED_SHORT, 0);
+        }
+    #endif
+}
+
+static void drawFrame(scene* scene, cull_mode mode, const mat4 viewProj, mode_stats* stats) {
+    #if OCCLUSION_CULLING
+        if (mode != MODE_ALL) {
+            cullScene(scene, viewProj, mode == MODE_HI_Z);
+            queueCullStats(scene, stats);
+        }
+        glBindFramebuffer(GL_FRAMEBUFFER, scene->framebuffer);
+    #endif
+
+    glViewport(0, 0, scene->width, scene->height);
+    glClearColor(0.75f, 0.85f, 0.8f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    PROFILE_GPU_ZONE_BEGIN("draw");
+    gl_debug_push_group("Draw");
+    glUseProgram(scene->drawProgram);
+    glUniformMatrix4fv(glGetUniformLocation(scene->drawProgram, "mViewProj"), 1, GL_FALSE, viewProj);
+    #if OCCLUSION_CULLING
+        if (mode != MODE_ALL) {
+            glBindVertexArray(scene->cullVao);
+            glBindBuffer(GL_DRAW_INDIRECT_BUFFER, scene->drawBuffer);
+            GL_CHECK(glDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_SHORT, 0));
+            glBindVertexArray(0);
+        } else {
+            drawAll(scene);
+        }
+    #else
+        drawAll(scene);
+    #endif
+    gl_debug_pop_group();
+    PROFILE_GPU_ZONE_END();
+
+    if (mode == MODE_ALL) {
+        stats->visible += scene->instanceCount;
+        stats->sampledFrames++;
+    }
+
+    #if OCCLUSION_CULLING
+        if (mode == MODE_HI_Z) {
+            buildHiZ(scene);
+            memcpy(scene->previousViewProj, viewProj, sizeof(mat4));
+            scene->hasHistory = 1;
+        }
+
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, scene->framebuffer);
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+        glBlitFramebuffer(0, 0, scene->width, scene->height, 0, 0, scene->width, scene->height,
+            GL_COLOR_BUFFER_BIT, GL_NEAREST);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    #else
+        (void)mode;
+    #endif
+}
+
+// Render frames in the given mode for a while, with the camera turning
+// around in the middle room. Every frame is waited for, so the frame rate
+// includes the GPU work.
+static void runMode(scene* scene, cull_mode mode, int rooms, double duration, GLFWwindow* window,
+                    EGLDisplay display, EGLSurface surface, mode_stats* stats) {
+    const float pi = 3.14159265358979323846f;
+    memset(stats, 0, sizeof(mode_stats));
+
+    float eyeX = -(float)rooms * ROOM_SIZE * 0.5f + (float)(rooms / 2) * ROOM_SIZE + ROOM_SIZE * 0.5f;
+    float eyeZ = eyeX;
+    mat4 view, proj, viewProj;
+    mat4_perspective(proj, 60.0f * pi / 180.0f, (float)scene->width / (float)scene->height,
+        0.1f, (float)rooms * ROOM_SIZE * 1.5f);
+
+    #if OCCLUSION_CULLING
+        scene->hasHistory = 0;
+    #endif
+
+    double start = timer_now();
+    double end = start + duration;
+    while (timer_now() < end && !(window && glfwWindowShouldClose(window))) {
+        PROFILE_ZONE_BEGIN("frame");
+        PROFILE_GPU_ZONE_BEGIN("frame");
+
+        float yaw = (float)(timer_now() - start) * 0.5f;
+        mat4_look_at(view,
+            eyeX, 1.7f, eyeZ,
+            eyeX + sinf(yaw), 1.7f, eyeZ + cosf(yaw),
+            0, 1, 0
+        );
+        mat4_multiply(viewProj, proj, view);
+
+        gl_debug_push_group(modeNames[mode]);
+        drawFrame(scene, mode, viewProj, stats);
+        gl_debug_pop_group();
+
+        PROFILE_GPU_ZONE_END();
+        PROFILE_ZONE_BEGIN("eglSwapBuffers");
+        eglSwapBuffers(display, surface);
+        PROFILE_ZONE_END();
+        glFinish();
+        profiler_gpu_collect();
+        PROFILE_ZONE_END();
+        stats->frames++;
+
+        if (window) {
+            glfwPollEvents();
+        }
+    }
+    stats->seconds = timer_now() - start;
+
+    #if OCCLUSION_CULLING
+        for (int slot = 0; slot < STATS_LATENCY; slot++) {
+            readCullStats(scene, slot, stats);
+        }
+    #else
+        (void)pi;
+    #endif
+}
+
+int main(int argc, char** argv) {
+    int rooms = option_int(argc, argv, "--rooms", 8);
+    int width = option_int(argc, argv, "--width", 640);
+    int height = option_int(argc, argv, "--height", 480);
+    double duration = option_double(argc, argv, "--seconds", 2.0);
+    int useWindow = option_flag(argc, argv, "--window");
+    const char* reportPath = option_string(argc, argv, "--json", NULL);
+    const char* tracePath = option_string(argc, argv, "--trace", NULL);
+
+    if (rooms < 1 || rooms > 32) {
+        fprintf(stderr, "The number of rooms must be between 1 and 32\n");
+        return -1;
+    }
+    if (width < 1 || height < 1) {
+        fprintf(stderr, "The width and the height must be positive\n");
+        return -1;
+    }
+
+    PROFILE_THREAD_NAME("main");
+
+    GLFWwindow* window = NULL;
+    EGLDisplay display;
+    EGLConfig config;
+    EGLContext context;
+    EGLSurface surface;
+    if (useWindow) {
+        if (initializeWindow(&window, &display, &context, &surface, width, height, "Erlangsters - Occlusion Culling") != 0) {
+            return -1;
+        }
+    } else if (initializeHeadless(&display, &config, &context, &surface, width, height) != 0) {
+        return -1;
+    }
+    gl_debug_install();
+    profiler_gpu_init();
+
+    static scene scene;
+    scene.width = width;
+    scene.height = height;
+    if (createScene(&scene, rooms) != 0) {
+        return -1;
+    }
+
+    printf("Drawing %d rooms with %d objects at %dx%d (%s)\n", rooms * rooms, scene.instanceCount,
+        width, height, OCCLUSION_CULLING ? "GPU culling" : "no culling, compute shaders are not available");
+
+    report* report = report_open(reportPath);
+    report_string(report, "sample", "occlusion-culling");
+    report_integer(report, "rooms", rooms * rooms);
+    report_integer(report, "objects", scene.instanceCount);
+    report_integer(report, "width", width);
+    report_integer(report, "height", height);
+    report_begin_array(report, "modes");
+
+    int modeCount = OCCLUSION_CULLING ? MODE_COUNT : MODE_FRUSTUM;
+    for (int mode = 0; mode < modeCount; mode++) {
+        mode_stats stats;
+        runMode(&scene, (cull_mode)mode, rooms, duration, window, display, surface, &stats);
+        if (stats.frames == 0) {
+            break;
+        }
+
+        double fps = (double)stats.frames / stats.seconds;
+        double samples = stats.sampledFrames > 0 ? (double)stats.sampledFrames : 1.0;
+        double visible = stats.visible / samples;
+        double frustumCulled = stats.frustumCulled / samples;
+        double occluded = stats.occluded / samples;
+        printf("%-8s visible: %8.1f  frustum culled: %8.1f  occluded: %8.1f  %9.1f frames/s\n",
+            modeNames[mode], visible, frustumCulled, occluded, fps);
+
+        report_begin_object(report, NULL);
+        report_string(report, "mode", modeNames[mode]);
+        report_integer(report, "frames", stats.frames);
+        report_number(report, "frames_per_second", fps);
+        report_number(report, "visible_per_frame", visible);
+        report_number(report, "frustum_culled_per_frame", frustumCulled);
+        report_number(report, "occluded_per_frame", occluded);
+        report_end_object(report);
+    }
+
+    report_end_array(report);
+    gpu_memory_print();
+    gpu_memory_report(report);
+    report_close(report);
+
+    deleteScene(&scene);
+    gl_debug_summary();
+    profiler_gpu_shutdown();
+    if (tracePath) {
+        profiler_write_trace(tracePath);
+    }
+    if (window) {
+        terminateWindow(window);
+    } else {
+        terminateHeadless(display, context, surface);
+    }
+
+    return 0;
+}
@@ -0,0 +1,751 @@
+//
+// Copyright (c) 2025, Byteplug LLC.
+//
+// This source file is part of a project made by the Erlangsters community and
+// is released under the MIT license. Please refer to the LICENSE.md file that
+// can be found at the root of the project repository.
+//
+// Written by Jonathan De Wachter <jonathan.dewachter@byteplug.io>
+//
+#include <math.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "gl_api.h"
+#include "gl_debug.h"
+#include "gl_extensions.h"
+#include "gpu_memory.h"
+#include "matrix.h"
+#include "window.h"
+#include "options.h"
+#include "profiler.h"
+#include "render_graph.h"
+#include "report.h"
+#include "shader.h"
+#include "timer.h"
+
+// Draws a field of cubes, some of them glowing, through a post-processing
+// chain declared with the render graph of src/common/render_graph.h:
+//
+//   scene (HDR, with depth) -> bright pass (half size) -> blur, horizontal
+//   then vertical, --blur times -> tone map (scene + bloom) -> FXAA -> screen
+//
+// and compares:
+//
+// - "direct": the scene drawn straight to the screen, without any post
+//   effect;
+// - "unpooled": the chain with a texture per target, and the contents of
+//   every target kept;
+// - "pooled": the chain with the targets aliased (the half-size targets of
+//   the blur passes end up sharing two textures) and their contents
+//   discarded before they are drawn, and the depth buffer after the scene.
+//
+// The scene is rendered to half float targets when the driver can render to
+// them (always on OpenGL and OpenGL ES 3.2); otherwise it is scaled down to
+// fit in 8-bit targets, and scaled back up by the tone mapping.
+
+#define ATTRIB_POSITION 0
+#define ATTRIB_NORMAL 1
+#define ATTRIB_CENTER 2
+#define ATTRIB_EXTENT 3
+
+#define CUBE_SPACING 3.0f
+#define GLOWING_CUBES 7  // One cube out of 7 glows.
+#define MAX_BLUR_PASSES 8
+
+// Scale of the scene in 8-bit targets (it goes up to about 4).
+#define LDR_SCENE_SCALE 0.25f
+
+static const char* sceneVertexSource =
+    "ATTRIBUTE vec3 vertPosition;\n"
+    "ATTRIBUTE vec3 vertNormal;\n"
+    "ATTRIBUTE vec4 instCenter;\n"
+    "ATTRIBUTE vec4 instExtent;\n"
+    "VARYING_OUT vec3 fragColor;\n"
+    "uniform mat4 mViewProj;\n"
+    "uniform float outputScale;\n"
+    "void main() {\n"
+    "    float light = 0.2 + 0.8 * max(dot(vertNormal, vec3(0.4, 0.8, 0.45)), 0.0);\n"
+    "    vec3 albedo = vec3(0.75, 0.7, 0.65) * instCenter.w;\n"
+    "    fragColor = (albedo * light + vec3(1.0, 0.55, 0.25) * instExtent.w) * outputScale;\n"
+    "    gl_Position = mViewProj * vec4(instCenter.xyz + vertPosition * instExtent.xyz, 1.0);\n"
+    "}\n";
+
+static const char* sceneFragmentSource =
+    "VARYING_IN vec3 fragColor;\n"
+    "void main() {\n"
+    "    FRAG_COLOR = vec4(fragColor, 1.0);\n"
+    "}\n";
+
+static const char* sceneAttributes[] = { "vertPosition", "vertNormal", "instCenter", "instExtent", NULL };
+
+// A triangle covering the screen.
+static const char* postVertexSource =
+    "ATTRIBUTE vec2 vertPosition;\n"
+    "VARYING_OUT vec2 fragCoord;\n"
+    "void main() {\n"
+    "    fragCoord = vertPosition * 0.5 + 0.5;\n"
+    "    gl_Position = vec4(vertPosition, 0.0, 1.0);\n"
+    "}\n";
+
+static const char* postAttributes[] = { "vertPosition", NULL };
+
+// Keeps what is brighter than white; the bilinear fetch at the center of
+// 2x2 texels averages them.
+static const char* brightFragmentSource =
+    "VARYING_IN vec2 fragCoord;\n"
+    "uniform sampler2D source;\n"
+    "uniform float inputScale;\n"
+    "void main() {\n"
+    "    vec3 color = texture(source, fragCoord).rgb * inputScale;\n"
+    "    FRAG_COLOR = vec4(max(color - vec3(1.0), 0.0) / inputScale, 1.0);\n"
+    "}\n";
+
+// A 9-tap Gaussian blur along one axis, in 5 fetches: the taps off the
+// center are taken in pairs, between two texels, with the weight of both.
+static const char* blurFragmentSource =
+    "VARYING_IN vec2 fragCoord;\n"
+    "uniform sampler2D source;\n"
+    "uniform vec2 direction;\n"
+    "void main() {\n"
+    "    vec2 near = direction * 1.3846153846;\n"
+    "    vec2 far = direction * 3.2307692308;\n"
+    "    vec3 color = texture(source, fragCoord).rgb * 0.2270270270;\n"
+    "    color += (texture(source, fragCoord + near).rgb + texture(source, fragCoord - near).rgb) * 0.3162162162;\n"
+    "    color += (texture(source, fragCoord + far).rgb + texture(source, fragCoord - far).rgb) * 0.0702702703;\n"
+    "    FRAG_COLOR = vec4(color, 1.0);\n"
+    "}\n";
+
+// Filmic curve (Narkowicz's fit of ACES), then an approximate gamma. The
+// luma goes in the alpha channel for FXAA.
+static const char* toneMapFragmentSource =
+    "VARYING_IN vec2 fragCoord;\n"
+    "uniform sampler2D scene;\n"
+    "uniform sampler2D bloom;\n"
+    "uniform float inputScale;\n"
+    "uniform float exposure;\n"
+    "void main() {\n"
+    "    vec3 hdr = (texture(scene, fragCoord).rgb + texture(bloom, fragCoord).rgb * 0.6) * inputScale * exposure;\n"
+    "    vec3 color = clamp((hdr * (2.51 * hdr + 0.03)) / (hdr * (2.43 * hdr + 0.59) + 0.14), 0.0, 1.0);\n"
+    "    color = sqrt(color);\n"
+    "    FRAG_COLOR = vec4(color, dot(color, vec3(0.299, 0.587, 0.114)));\n"
+    "}\n";
+
+// FXAA in its simplest form: the direction of the edge is estimated from the
+// luma of the 4 diagonal neighbors, and the pixel is blurred along it; the
+// wider blur is only kept when it stays within the local luma range.
+static const char* fxaaFragmentSource =
+    "VARYING_IN vec2 fragCoord;\n"
+    "uniform sampler2D source;\n"
+    "uniform vec2 texelSize;\n"
+    "void main() {\n"
+    "    float lumaNW = texture(source, fragCoord + vec2(-1.0, -1.0) * texelSize).a;\n"
+    "    float lumaNE = texture(source, fragCoord + vec2(1.0, -1.0) * texelSize).a;\n"
+    "    float lumaSW = texture(source, fragCoord + vec2(-1.0, 1.0) * texelSize).a;\n"
+    "    float lumaSE = texture(source, fragCoord + vec2(1.0, 1.0) * texelSize).a;\n"
+    "    float lumaM = texture(source, fragCoord).a;\n"
+    "    float lumaMin = min(lumaM, min(min(lumaNW, lumaNE), min(lumaSW, lumaSE)));\n"
+    "    float lumaMax = max(lumaM, max(max(lumaNW, lumaNE), max(lumaSW, lumaSE)));\n"
+    "\n"
+    "    vec2 direction = vec2(-((lumaNW + lumaNE) - (lumaSW + lumaSE)), (lumaNW + lumaSW) - (lumaNE + lumaSE));\n"
+    "    float reduce = max((lumaNW + lumaNE + lumaSW + lumaSE) * (0.25 / 8.0), 1.0 / 128.0);\n"
+    "    float scale = 1.0 / (min(abs(direction.x), abs(direction.y)) + reduce);\n"
+    "    direction = clamp(direction * scale, vec2(-8.0), vec2(8.0)) * texelSize;\n"
+    "\n"
+    "    vec3 colorA = 0.5 * (texture(source, fragCoord + direction * (1.0 / 3.0 - 0.5)).rgb +\n"
+    "                         texture(source, fragCoord + direction * (2.0 / 3.0 - 0.5)).rgb);\n"
+    "    vec3 colorB = colorA * 0.5 + 0.25 * (texture(source, fragCoord - direction * 0.5).rgb +\n"
+    "                                         texture(source, fragCoord + direction * 0.5).rgb);\n"
+    "    float lumaB = dot(colorB, vec3(0.299, 0.587, 0.114));\n"
+    "    FRAG_COLOR = vec4(lumaB < lumaMin || lumaB > lumaMax ? colorA : colorB, 1.0);\n"
+    "}\n";
+
+typedef enum {
+    MODE_DIRECT,
+    MODE_UNPOOLED,
+    MODE_POOLED,
+    MODE_COUNT
+} post_mode;
+
+static const char* modeNames[MODE_COUNT] = { "direct", "unpooled", "pooled" };
+
+// An axis-aligned box, with its shade in the w component of the center and
+// its glow in the w component of the extent. It is also the layout of the
+// instance buffer.
+typedef struct {
+    float center[4];
+    float extent[4];
+} instance;
+
+typedef struct scene scene;
+
+typedef struct {
+    scene* scene;
+    float direction[2];
+} blur_pass;
+
+struct scene {
+    int width;
+    int height;
+    float extent;  // Size of the field of cubes.
+    mat4 viewProj;
+
+    int instanceCount;
+    instance* instances;
+
+    // Format of the scene and bloom targets, and the scale of the scene in
+    // them.
+    GLenum hdrInternalFormat;
+    GLenum hdrType;
+    float hdrScale;
+    int blurPasses;
+    blur_pass blurs[MAX_BLUR_PASSES * 2];
+
+    GLuint sceneProgram;
+    GLuint brightProgram;
+    GLuint blurProgram;
+    GLuint toneMapProgram;
+    GLuint fxaaProgram;
+    GLuint vbo;
+    GLuint ebo;
+    GLuint triangleBuffer;
+    #if SAMPLE_OPENGL_API == SAMPLE_API_GL || SAMPLE_OPENGL_VERSION_MAJOR >= 3
+        GLuint instanceBuffer;
+        GLuint vao;
+        GLuint triangleVao;
+    #endif
+
+    render_graph graph;
+    float outputScale;  // Of the scene pass, 1 when drawn to the screen.
+};
+
+typedef struct {
+    long long frames;
+    double seconds;
+} mode_stats;
+
+static float randomFloat(unsigned int* state) {
+    *state = *state * 1664525u + 1013904223u;
+    return (float)(*state >> 8) / 16777216.0f;
+}
+
+static void addBox(scene* scene, float x, float y, float z, float extentX, float extentY, float extentZ,
+                   float shade, float glow) {
+    instance* box = &scene->instances[scene->instanceCount++];
+    box->center[0] = x;
+    box->center[1] = y;
+    box->center[2] = z;
+    box->center[3] = shade;
+    box->extent[0] = extentX;
+    box->extent[1] = extentY;
+    box->extent[2] = extentZ;
+    box->extent[3] = glow;
+}
+
+// A floor with a grid x grid field of cubes on it.
+static int buildScene(scene* scene, int grid) {
+    scene->instances = malloc((size_t)(1 + grid * grid) * sizeof(instance));
+    if (!scene->instances) {
+        return -1;
+    }
+    scene->extent = (float)grid * CUBE_SPACING;
+    scene->instanceCount = 0;
+
+    unsigned int state = 4242u;
+    float half = scene->extent * 0.5f;
+    addBox(scene, 0.0f, -0.05f, 0.0f, half + CUBE_SPACING, 0.05f, half + CUBE_SPACING, 0.6f, 0.0f);
+    for (int z = 0; z < grid; z++) {
+        for (int x = 0; x < grid; x++) {
+            float size = 0.4f + randomFloat(&state) * 0.6f;
+            float height = 0.3f + randomFloat(&state) * 1.5f;
+            float shade = 0.5f + randomFloat(&state) * 0.5f;
+            float glow = (x + z * grid) % GLOWING_CUBES == 0 ? 2.0f + randomFloat(&state) * 2.0f : 0.0f;
+            addBox(scene, -half + ((float)x + 0.5f) * CUBE_SPACING, height, -half + ((float)z + 0.5f) * CUBE_SPACING,
+                size, height, size, shade, glow);
+        }
+    }
+    return 0;
+}
+
+// A unit cube (from -1 to 1) with a normal per face, wound counter-clockwise.
+static void buildCube(float vertices[24 * 6], unsigned short indices[36]) {
+    int vertex = 0;
+    int index = 0;
+    for (int axis = 0; axis < 3; axis++) {
+        for (int side = 0; side < 2; side++) {
+            float sign = side == 0 ? 1.0f : -1.0f;
+            int u = side == 0 ? (axis + 1) % 3 : (axis + 2) % 3;
+            int v = side == 0 ? (axis + 2) % 3 : (axis + 1) % 3;
+            static const float corners[4][2] = { { -1, -1 }, { 1, -1 }, { 1, 1 }, { -1, 1 } };
+
+            for (int i = 0; i < 4; i++) {
+                float* out = &vertices[(vertex + i) * 6];
+                memset(out, 0, 6 * sizeof(float));
+                out[axis] = sign;
+                out[u] = corners[i][0];
+                out[v] = corners[i][1];
+                out[3 + axis] = sign;
+            }
+
+            static const int quad[6] = { 0, 1, 2, 0, 2, 3 };
+            for (int i = 0; i < 6; i++) {
+                indices[index++] = (unsigned short)(vertex + quad[i]);
+            }
+            vertex += 4;
+        }
+    }
+}
+
+static GLuint createBuffer(GLenum target, size_t size, const void* data, GLenum usage, const char* label) {
+    GLuint buffer;
+    glGenBuffers(1, &buffer);
+    glBindBuffer(target, buffer);
+    GL_CHECK(glBufferData(target, size, data, usage));
+    gpu_memory_track(GPU_MEMORY_BUFFER, buffer, size);
+    gl_debug_label(GL_BUFFER, buffer, label);
+    return buffer;
+}
+
+static void setupCubeArrays(scene* scene) {
+    glBindBuffer(GL_ARRAY_BUFFER, scene->vbo);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, scene->ebo);
+    glVertexAttribPointer(ATTRIB_POSITION, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), 0);
+    glVertexAttribPointer(ATTRIB_NORMAL, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(3 * sizeof(float)));
+    glEnableVertexAttribArray(ATTRIB_POSITION);
+    glEnableVertexAttribArray(ATTRIB_NORMAL);
+
+    #if SAMPLE_OPENGL_API == SAMPLE_API_GL || SAMPLE_OPENGL_VERSION_MAJOR >= 3
+        glBindBuffer(GL_ARRAY_BUFFER, scene->instanceBuffer);
+        glVertexAttribPointer(ATTRIB_CENTER, 4, GL_FLOAT, GL_FALSE, sizeof(instance), (void*)offsetof(instance, center));
+        glVertexAttribPointer(ATTRIB_EXTENT, 4, GL_FLOAT, GL_FALSE, sizeof(instance), (void*)offsetof(instance, extent));
+        glVertexAttribDivisor(ATTRIB_CENTER, 1);
+        glVertexAttribDivisor(ATTRIB_EXTENT, 1);
+        glEnableVertexAttribArray(ATTRIB_CENTER);
+        glEnableVertexAttribArray(ATTRIB_EXTENT);
+    #endif
+}
+
+static void setupTriangleArrays(scene* scene) {
+    glBindBuffer(GL_ARRAY_BUFFER, scene->triangleBuffer);
+    glVertexAttribPointer(ATTRIB_POSITION, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), 0);
+    glEnableVertexAttribArray(ATTRIB_POSITION);
+    #if SAMPLE_OPENGL_API == SAMPLE_API_GLES && SAMPLE_OPENGL_VERSION_MAJOR == 2
+        glDisableVertexAttribArray(ATTRIB_NORMAL);
+    #endif
+}
+
+// Whether the driver can render to half float textures.
+static int halfFloatTargets(void) {
+    #if SAMPLE_OPENGL_API == SAMPLE_API_GL || (SAMPLE_OPENGL_VERSION_MAJOR == 3 && SAMPLE_OPENGL_VERSION_MINOR >= 2)
+        return 1;
+    #elif SAMPLE_OPENGL_VERSION_MAJOR >= 3
+        return gl_has_extension("GL_EXT_color_buffer_half_float") || gl_has_extension("GL_EXT_color_buffer_float");
+    #else
+        return 0;
+    #endif
+}
+
+static int createScene(scene* scene, int grid) {
+    if (buildScene(scene, grid) != 0) {
+        fprintf(stderr, "Failed to allocate the scene\n");
+        return -1;
+    }
+
+    shader_program programs[] = {
+        { .label = "Scene program", .vertex = sceneVertexSource, .fragment = sceneFragmentSource,
+          .attributes = sceneAttributes },
+        { .label = "Bright pass program", .vertex = postVertexSource, .fragment = brightFragmentSource,
+          .attributes = postAttributes },
+        { .label = "Blur program", .vertex = postVertexSource, .fragment = blurFragmentSource,
+          .attributes = postAttributes },
+        { .label = "Tone mapping program", .vertex = postVertexSource, .fragment = toneMapFragmentSource,
+          .attributes = postAttributes },
+        { .label = "FXAA program", .vertex = postVertexSource, .fragment = fxaaFragmentSource,
+          .attributes = postAttributes }
+    };
+    int programCount = (int)(sizeof(programs) / sizeof(programs[0]));
+    shader_submit(programs, programCount);
+
+    float vertices[24 * 6];
+    unsigned short indices[36];
+    buildCube(vertices, indices);
+    static const float triangle[6] = { -1.0f, -1.0f, 3.0f, -1.0f, -1.0f, 3.0f };
+
+    scene->vbo = createBuffer(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW, "Cube vertices");
+    scene->ebo = createBuffer(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW, "Cube indices");
+    scene->triangleBuffer = createBuffer(GL_ARRAY_BUFFER, sizeof(triangle), triangle, GL_STATIC_DRAW,
+        "Full-screen triangle");
+
+    #if SAMPLE_OPENGL_API == SAMPLE_API_GL || SAMPLE_OPENGL_VERSION_MAJOR >= 3
+        scene->instanceBuffer = createBuffer(GL_ARRAY_BUFFER, (size_t)scene->instanceCount * sizeof(instance),
+            scene->instances, GL_STATIC_DRAW, "Instances");
+        glGenVertexArrays(1, &scene->vao);
+        glBindVertexArray(scene->vao);
+        setupCubeArrays(scene);
+        glGenVertexArrays(1, &scene->triangleVao);
+        glBindVertexArray(scene->triangleVao);
+        setupTriangleArrays(scene);
+        glBindVertexArray(0);
+    #endif
+
+    if (halfFloatTargets()) {
+        #if SAMPLE_OPENGL_API == SAMPLE_API_GL || SAMPLE_OPENGL_VERSION_MAJOR >= 3
+            scene->hdrInternalFormat = GL_RGBA16F;
+            scene->hdrType = GL_HALF_FLOAT;
+            scene->hdrScale = 1.0f;
+        #endif
+    } else {
+        #if SAMPLE_OPENGL_API == SAMPLE_API_GL || SAMPLE_OPENGL_VERSION_MAJOR >= 3
+            scene->hdrInternalFormat = GL_RGBA8;
+        #else
+            scene->hdrInternalFormat = GL_RGBA;
+        #endif
+        scene->hdrType = GL_UNSIGNED_BYTE;
+        scene->hdrScale = LDR_SCENE_SCALE;
+    }
+
+    int failures = shader_finish(programs, programCount);
+    scene->sceneProgram = programs[0].program;
+    scene->brightProgram = programs[1].program;
+    scene->blurProgram = programs[2].program;
+    scene->toneMapProgram = programs[3].program;
+    scene->fxaaProgram = programs[4].program;
+    if (failures > 0) {
+        return -1;
+    }
+
+    // The samplers follow the order of the inputs of the passes.
+    glUseProgram(scene->brightProgram);
+    glUniform1i(glGetUniformLocation(scene->brightProgram, "source"), 0);
+    glUniform1f(glGetUniformLocation(scene->brightProgram, "inputScale"), 1.0f / scene->hdrScale);
+    glUseProgram(scene->blurProgram);
+    glUniform1i(glGetUniformLocation(scene->blurProgram, "source"), 0);
+    glUseProgram(scene->toneMapProgram);
+    glUniform1i(glGetUniformLocation(scene->toneMapProgram, "scene"), 0);
+    glUniform1i(glGetUniformLocation(scene->toneMapProgram, "bloom"), 1);
+    glUniform1f(glGetUniformLocation(scene->toneMapProgram, "inputScale"), 1.0f / scene->hdrScale);
+    glUniform1f(glGetUniformLocation(scene->toneMapProgram, "exposure"), 1.2f);
+    glUseProgram(scene->fxaaProgram);
+    glUniform1i(glGetUniformLocation(scene->fxaaProgram, "source"), 0);
+    glUniform2f(glGetUniformLocation(scene->fxaaProgram, "texelSize"), 1.0f / (float)scene->width,
+        1.0f / (float)scene->height);
+    glUseProgram(0);
+
+    render_graph_init(&scene->graph, scene->width, scene->height);
+    return 0;
+}
+
+static void deleteScene(scene* scene) {
+    render_graph_destroy(&scene->graph);
+
+    gpu_memory_untrack(GPU_MEMORY_BUFFER, scene->vbo);
+    gpu_memory_untrack(GPU_MEMORY_BUFFER, scene->ebo);
+    gpu_memory_untrack(GPU_MEMORY_BUFFER, scene->triangleBuffer);
+    glDeleteBuffers(1, &scene->vbo);
+    glDeleteBuffers(1, &scene->ebo);
+    glDeleteBuffers(1, &scene->triangleBuffer);
+    #if SAMPLE_OPENGL_API == SAMPLE_API_GL || SAMPLE_OPENGL_VERSION_MAJOR >= 3
+        gpu_memory_untrack(GPU_MEMORY_BUFFER, scene->instanceBuffer);
+        glDeleteBuffers(1, &scene->instanceBuffer);
+        glDeleteVertexArrays(1, &scene->vao);
+        glDeleteVertexArrays(1, &scene->triangleVao);
+    #endif
+    glDeleteProgram(scene->sceneProgram);
+    glDeleteProgram(scene->brightProgram);
+    glDeleteProgram(scene->blurProgram);
+    glDeleteProgram(scene->toneMapProgram);
+    glDeleteProgram(scene->fxaaProgram);
+
+    free(scene->instances);
+}
+
+static void drawTriangle(scene* scene) {
+    #if SAMPLE_OPENGL_API == SAMPLE_API_GL || SAMPLE_OPENGL_VERSION_MAJOR >= 3
+        glBindVertexArray(scene->triangleVao);
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+        glBindVertexArray(0);
+    #else
+        setupTriangleArrays(scene);
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+    #endif
+}
+
+static void scenePass(void* data) {
+    scene* scene = data;
+    PROFILE_GPU_ZONE_BEGIN("scene");
+    glEnable(GL_DEPTH_TEST);
+    glEnable(GL_CULL_FACE);
+    glClearColor(0.05f * scene->outputScale, 0.06f * scene->outputScale, 0.08f * scene->outputScale, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    glUseProgram(scene->sceneProgram);
+    glUniformMatrix4fv(glGetUniformLocation(scene->sceneProgram, "mViewProj"), 1, GL_FALSE, scene->viewProj);
+    glUniform1f(glGetUniformLocation(scene->sceneProgram, "outputScale"), scene->outputScale);
+    #if SAMPLE_OPENGL_API == SAMPLE_API_GL || SAMPLE_OPENGL_VERSION_MAJOR >= 3
+        glBindVertexArray(scene->vao);
+        GL_CHECK(glDrawElementsInstanced(GL_TRIANGLES, 36, GL_UNSIGNED_SHORT, 0, scene->instanceCount));
+        glBindVertexArray(0);
+    #else
+        setupCubeArrays(scene);
+        for (int i = 0; i < scene->instanceCount; i++) {
+            glVertexAttrib4fv(ATTRIB_CENTER, scene->instances[i].center);
+            glVertexAttrib4fv(ATTRIB_EXTENT, scene->instances[i].extent);
+            glDrawElements(GL_TRIANGLES, 36, GL_UNSIGNED_SHORT, 0);
+        }
+    #endif
+
+    glDisable(GL_DEPTH_TEST);
+    glDisable(GL_CULL_FACE);
+    PROFILE_GPU_ZONE_END();
+}
+
+static void brightPass(void* data) {
+    scene* scene = data;
+    PROFILE_GPU_ZONE_BEGIN("bright_pass");
+    glUseProgram(scene->brightProgram);
+    drawTriangle(scene);
+    PROFILE_GPU_ZONE_END();
+}
+
+static void blurPass(void* data) {
+    blur_pass* blur = data;
+    PROFILE_GPU_ZONE_BEGIN("blur");
+    glUseProgram(blur->scene->blurProgram);
+    glUniform2fv(glGetUniformLocation(blur->scene->blurProgram, "direction"), 1, blur->direction);
+    drawTriangle(blur->scene);
+    PROFILE_GPU_ZONE_END();
+}
+
+static void toneMapPass(void* data) {
+    scene* scene = data;
+    PROFILE_GPU_ZONE_BEGIN("tone_map");
+    glUseProgram(scene->toneMapProgram);
+    drawTriangle(scene);
+    PROFILE_GPU_ZONE_END();
+}
+
+static void fxaaPass(void* data) {
+    scene* scene = data;
+    PROFILE_GPU_ZONE_BEGIN("fxaa");
+    glUseProgram(scene->fxaaProgram);
+    drawTriangle(scene);
+    PROFILE_GPU_ZONE_END();
+}
+
+// Declare the passes of a mode and compile them. The pool of the graph is
+// kept from mode to mode.
+static int buildGraph(scene* scene, post_mode mode) {
+    render_graph* graph = &scene->graph;
+    render_graph_reset(graph, scene->width, scene->height);
+    if (mode == MODE_DIRECT) {
+        scene->outputScale = 1.0f;
+        render_graph_pass(graph, "Scene", RENDER_GRAPH_BACKBUFFER, NULL, 0, scenePass, scene);
+        return render_graph_compile(graph, 0);
+    }
+
+    int halfWidth = scene->width / 2 > 0 ? scene->width / 2 : 1;
+    int halfHeight = scene->height / 2 > 0 ? scene->height / 2 : 1;
+    render_target_desc hdr = {
+        .name = "Scene", .width = scene->width, .height = scene->height,
+        .internalFormat = scene->hdrInternalFormat, .format = GL_RGBA, .type = scene->hdrType, .depth = 1
+    };
+    render_target_desc bloom = hdr;
+    bloom.name = "Bloom";
+    bloom.width = halfWidth;
+    bloom.height = halfHeight;
+    bloom.depth = 0;
+    render_target_desc ldr = {
+        .name = "Tone mapped", .width = scene->width, .height = scene->height,
+        #if SAMPLE_OPENGL_API == SAMPLE_API_GL || SAMPLE_OPENGL_VERSION_MAJOR >= 3
+            .internalFormat = GL_RGBA8,
+        #else
+            .internalFormat = GL_RGBA,
+        #endif
+        .format = GL_RGBA, .type = GL_UNSIGNED_BYTE
+    };
+
+    scene->outputScale = scene->hdrScale;
+    int sceneTarget = render_graph_target(graph, &hdr);
+    int source = render_graph_target(graph, &bloom);
+    render_graph_pass(graph, "Scene", sceneTarget, NULL, 0, scenePass, scene);
+    render_graph_pass(graph, "Bright pass", source, &sceneTarget, 1, brightPass, scene);
+
+    // Every blur pass writes a target of its own, and leaves it to the graph
+    // to find out that two textures are enough.
+    for (int i = 0; i < scene->blurPasses * 2; i++) {
+        blur_pass* blur = &scene->blurs[i];
+        blur->scene = scene;
+        blur->direction[0] = i % 2 == 0 ? 1.0f / (float)halfWidth : 0.0f;
+        blur->direction[1] = i % 2 == 0 ? 0.0f : 1.0f / (float)halfHeight;
+        int output = render_graph_target(graph, &bloom);
+        render_graph_pass(graph, i % 2 == 0 ? "Horizontal blur" : "Vertical blur", output, &source, 1, blurPass, blur);
+        source = output;
+    }
+
+    int toneMapped = render_graph_target(graph, &ldr);
+    int toneMapInputs[2] = { sceneTarget, source };
+    render_graph_pass(graph, "Tone mapping", toneMapped, toneMapInputs, 2, toneMapPass, scene);
+    render_graph_pass(graph, "FXAA", RENDER_GRAPH_BACKBUFFER, &toneMapped, 1, fxaaPass, scene);
+
+    return render_graph_compile(graph, mode == MODE_POOLED ? RENDER_GRAPH_ALIAS | RENDER_GRAPH_INVALIDATE : 0);
+}
+
+// Render frames in the given mode for a while, with the camera circling
+// above the field. Every frame is waited for, so the frame rate includes the
+// GPU work.
+static void runMode(scene* scene, post_mode mode, double duration, GLFWwindow* window,
+                    EGLDisplay display, EGLSurface surface, mode_stats* stats) {
+    const float pi = 3.14159265358979323846f;
+    memset(stats, 0, sizeof(mode_stats));
+
+    mat4 view, proj;
+    mat4_perspective(proj, 60.0f * pi / 180.0f, (float)scene->width / (float)scene->height,
+        0.5f, scene->extent * 1.5f);
+    float radius = scene->extent * 0.55f;
+    float height = scene->extent * 0.25f;
+
+    double start = timer_now();
+    double end = start + duration;
+    while (timer_now() < end && !(window && glfwWindowShouldClose(window))) {
+        PROFILE_ZONE_BEGIN("frame");
+        PROFILE_GPU_ZONE_BEGIN("frame");
+
+        float angle = (float)(timer_now() - start) * 0.2f;
+        mat4_look_at(view,
+            sinf(angle) * radius, height, cosf(angle) * radius,
+            0, 0, 0,
+            0, 1, 0
+        );
+        mat4_multiply(scene->viewProj, proj, view);
+
+        gl_debug_push_group(modeNames[mode]);
+        render_graph_execute(&scene->graph);
+        gl_debug_pop_group();
+
+        PROFILE_GPU_ZONE_END();
+        PROFILE_ZONE_BEGIN("eglSwapBuffers");
+        eglSwapBuffers(display, surface);
+        PROFILE_ZONE_END();
+        glFinish();
+        profiler_gpu_collect();
+        PROFILE_ZONE_END();
+        stats->frames++;
+
+        if (window) {
+            glfwPollEvents();
+        }
+    }
+    stats->seconds = timer_now() - start;
+}
+
+int main(int argc, char** argv) {
+    int grid = option_int(argc, argv, "--grid", 24);
+    int blurPasses = option_int(argc, argv, "--blur", 2);
+    int width = option_int(argc, argv, "--width", 640);
+    int height = option_int(argc, argv, "--height", 480);
+    double duration = option_double(argc, argv, "--seconds", 2.0);
+    int useWindow = option_flag(argc, argv, "--window");
+    const char* reportPath = option_string(argc, argv, "--json", NULL);
+    const char* tracePath = option_string(argc, argv, "--trace", NULL);
+
+    if (grid < 1 || grid > 128) {
+        fprintf(stderr, "The grid size must be between 1 and 128\n");
+        return -1;
+    }
+    if (blurPasses < 0 || blurPasses > MAX_BLUR_PASSES) {
+        fprintf(stderr, "The number of blur passes must be between 0 and %d\n", MAX_BLUR_PASSES);
+        return -1;
+    }
+    if (width < 1 || height < 1) {
+        fprintf(stderr, "The width and the height must be positive\n");
+        return -1;
+    }
+
+    PROFILE_THREAD_NAME("main");
+
+    GLFWwindow* window = NULL;
+    EGLDisplay display;
+    EGLConfig config;
+    EGLContext context;
+    EGLSurface surface;
+    if (useWindow) {
+        if (initializeWindow(&window, &display, &context, &surface, width, height, "Erlangsters - Post-Processing") != 0) {
+            return -1;
+        }
+    } else if (initializeHeadless(&display, &config, &context, &surface, width, height) != 0) {
+        return -1;
+    }
+    gl_debug_install();
+    profiler_gpu_init();
+
+    static scene scene;
+    scene.width = width;
+    scene.height = height;
+    scene.blurPasses = blurPasses;
+    if (createScene(&scene, grid) != 0) {
+        return -1;
+    }
+
+    printf("Drawing %d objects at %dx%d with %d blur passes (%s targets, %s)\n", scene.instanceCount,
+        width, height, blurPasses * 2, scene.hdrScale == 1.0f ? "half float" : "8-bit",
+        render_graph_can_invalidate() ? "framebuffers can be invalidated" : "framebuffers cannot be invalidated");
+
+    report* report = report_open(reportPath);
+    report_string(report, "sample", "post-processing");
+    report_integer(report, "objects", scene.instanceCount);
+    report_integer(report, "width", width);
+    report_integer(report, "height", height);
+    report_integer(report, "blur_passes", blurPasses * 2);
+    report_integer(report, "half_float_targets", scene.hdrScale == 1.0f);
+    report_integer(report, "can_invalidate", render_graph_can_invalidate());
+    report_begin_array(report, "modes");
+
+    for (int mode = 0; mode < MODE_COUNT; mode++) {
+        if (buildGraph(&scene, (post_mode)mode) != 0) {
+            break;
+        }
+
+        mode_stats stats;
+        runMode(&scene, (post_mode)mode, duration, window, display, surface, &stats);
+        if (stats.frames == 0) {
+            break;
+        }
+
+        const render_graph* graph = &scene.graph;
+        double fps = (double)stats.frames / stats.seconds;
+        printf("%-8s passes: %2d  targets: %2d  textures: %2d  memory: %8.1f KiB (declared: %8.1f KiB)  %7.1f frames/s\n",
+            modeNames[mode], graph->passCount, graph->targetCount, graph->textureCount,
+            (double)graph->bytes / 1024.0, (double)graph->declaredBytes / 1024.0, fps);
+
+        report_begin_object(report, NULL);
+        report_string(report, "mode", modeNames[mode]);
+        report_integer(report, "frames", stats.frames);
+        report_number(report, "frames_per_second", fps);
+        report_integer(report, "passes", graph->passCount);
+        report_integer(report, "targets", graph->targetCount);
+        report_integer(report, "textures", graph->textureCount);
+        report_integer(report, "target_bytes", (long long)graph->bytes);
+        report_integer(report, "declared_target_bytes", (long long)graph->declaredBytes);
+        report_end_object(report);
+    }
+
+    report_end_array(report);
+    gpu_memory_print();
+    gpu_memory_report(report);
+    report_close(report);
+
+    deleteScene(&scene);
+    gl_debug_summary();
+    profiler_gpu_shutdown();
+    if (tracePath) {
+        profiler_write_trace(tracePath);
+    }
+    if (window) {
+        terminateWindow(window);
+    } else {
+        terminateHeadless(display, context, surface);
+    }
+
+    return 0;
+}
@@ -0,0 +1,956 @@
+//
+// Copyright (c) 2025, Byteplug LLC.
+//
+// This source file is part of a project made by the Erlangsters community and
+// is released under the MIT license. Please refer to the LICENSE.md file that
+// can be found at the root of the project repository.
+//
+// Written by Jonathan De Wachter <jonathan.dewachter@byteplug.io>
+//
+#include <math.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "gl_api.h"
+#include "gl_debug.h"
+#include "gpu_memory.h"
+#include "hud.h"
+#include "job.h"
+#include "matrix.h"
+#include "window.h"
+#include "options.h"
+#include "profiler.h"
+#include "report.h"
+#include "shader.h"
+#include "skinning.h"
+#include "thread.h"
+#include "timer.h"
+
+// Animates a field of tentacles, each one a tube bent by a chain of bones,
+// and deforms them with linear blend skinning ("lbs") and dual quaternion
+// skinning ("dqs") in turn, with the palettes of bones going through every
+// path available:
+//
+// - "cpu": the vertices are skinned on the CPU (src/common/skinning.h, with
+//   SSE2 or NEON), over the threads of the job system, then streamed to a
+//   vertex buffer; it is the path of OpenGL ES 2.0 for large palettes;
+// - "uniform": the vertex shader skins with a palette in a uniform array,
+//   set before the draw of every tentacle;
+// - "ubo": the palettes of many tentacles are streamed to a uniform buffer,
+//   and every range of it drawn with a single instanced draw;
+// - "texture": the palettes of all tentacles are streamed to a float texture
+//   and fetched by instance, and everything is drawn at once.
+//
+// The palettes are computed on the job system in all cases. The number of
+// vertices skinned per second (including the draws) is printed for every
+// mode, and shown live with --hud.
+
+#define ATTRIB_POSITION 0
+#define ATTRIB_NORMAL 1
+#define ATTRIB_BONES 2
+#define ATTRIB_WEIGHTS 3
+
+#define MAX_BONES 32
+#define TENTACLE_HEIGHT 4.0f
+#define TENTACLE_RADIUS 0.25f
+#define TENTACLE_SPACING 1.5f
+#define SEGMENTS 16  // Vertices around the tube.
+
+// Width of the palette texture, in texels.
+#define PALETTE_TEXTURE_WIDTH 1024
+
+static const char* vertexSource =
+    "ATTRIBUTE vec4 vertPosition;\n"
+    "ATTRIBUTE vec3 vertNormal;\n"
+    "#ifndef SKIN_ON_CPU\n"
+    "ATTRIBUTE vec4 vertBones;\n"
+    "ATTRIBUTE vec4 vertWeights;\n"
+    "#endif\n"
+    "VARYING_OUT vec3 fragNormal;\n"
+    "uniform mat4 mViewProj;\n"
+    "\n"
+    "#if defined(PALETTE_UNIFORMS)\n"
+    "uniform vec4 palette[PALETTE_VECTORS];\n"
+    "#define BONE(index, i) palette[(index) * VECTORS_PER_BONE + (i)]\n"
+    "#elif defined(PALETTE_UNIFORM_BLOCK)\n"
+    "layout(std140) uniform Palettes {\n"
+    "    vec4 palette[PALETTE_VECTORS];\n"
+    "};\n"
+    "#define BONE(index, i) palette[(gl_InstanceID * BONE_COUNT + (index)) * VECTORS_PER_BONE + (i)]\n"
+    "#elif defined(PALETTE_TEXTURE)\n"
+    "uniform highp sampler2D palette;\n"
+    "vec4 fetchBone(int index, int i) {\n"
+    "    int texel = (gl_InstanceID * BONE_COUNT + index) * VECTORS_PER_BONE + i;\n"
+    "    return texelFetch(palette, ivec2(texel % PALETTE_TEXTURE_WIDTH, texel / PALETTE_TEXTURE_WIDTH), 0);\n"
+    "}\n"
+    "#define BONE(index, i) fetchBone(index, i)\n"
+    "#endif\n"
+    "\n"
+    "#if defined(LINEAR_BLEND)\n"
+    "// The bones are the 3 first rows of their matrix.\n"
+    "void skin(out vec3 position, out vec3 normal) {\n"
+    "    vec4 row0 = vec4(0.0);\n"
+    "    vec4 row1 = vec4(0.0);\n"
+    "    vec4 row2 = vec4(0.0);\n"
+    "    for (int k = 0; k < 4; k++) {\n"
+    "        int bone = int(vertBones[k]);\n"
+    "        row0 += BONE(bone, 0) * vertWeights[k];\n"
+    "        row1 += BONE(bone, 1) * vertWeights[k];\n"
+    "        row2 += BONE(bone, 2) * vertWeights[k];\n"
+    "    }\n"
+    "    position = vec3(dot(row0, vertPosition), dot(row1, vertPosition), dot(row2, vertPosition));\n"
+    "    normal = vec3(dot(row0.xyz, vertNormal), dot(row1.xyz, vertNormal), dot(row2.xyz, vertNormal));\n"
+    "}\n"
+    "#elif defined(DUAL_QUATERNION)\n"
+    "// The bones are a rotation and a dual part.\n"
+    "void skin(out vec3 position, out vec3 normal) {\n"
+    "    vec4 pivot = BONE(int(vertBones.x), 0);\n"
+    "    vec4 real = vec4(0.0);\n"
+    "    vec4 dual = vec4(0.0);\n"
+    "    for (int k = 0; k < 4; k++) {\n"
+    "        int bone = int(vertBones[k]);\n"
+    "        vec4 rotation = BONE(bone, 0);\n"
+    "        float weight = dot(rotation, pivot) < 0.0 ? -vertWeights[k] : vertWeights[k];\n"
+    "        real += rotation * weight;\n"
+    "        dual += BONE(bone, 1) * weight;\n"
+    "    }\n"
+    "    float scale = 1.0 / length(real);\n"
+    "    real *= scale;\n"
+    "    dual *= scale;\n"
+    "    vec3 translation = 2.0 * (real.w * dual.xyz - dual.w * real.xyz + cross(real.xyz, dual.xyz));\n"
+    "    position = vertPosition.xyz + 2.0 * cross(real.xyz, cross(real.xyz, vertPosition.xyz) + real.w * vertPosition.xyz) + translation;\n"
+    "    normal = vertNormal + 2.0 * cross(real.xyz, cross(real.xyz, vertNormal) + real.w * vertNormal);\n"
+    "}\n"
+    "#endif\n"
+    "\n"
+    "void main() {\n"
+    "#ifdef SKIN_ON_CPU\n"
+    "    vec3 position = vertPosition.xyz;\n"
+    "    vec3 normal = vertNormal;\n"
+    "#else\n"
+    "    vec3 position;\n"
+    "    vec3 normal;\n"
+    "    skin(position, normal);\n"
+    "#endif\n"
+    "    fragNormal = normal;\n"
+    "    gl_Position = mViewProj * vec4(position, 1.0);\n"
+    "}\n";
+
+static const char* fragmentSource =
+    "VARYING_IN vec3 fragNormal;\n"
+    "void main() {\n"
+    "    vec3 normal = normalize(fragNormal);\n"
+    "    float light = 0.25 + 0.75 * max(dot(normal, vec3(0.4, 0.8, 0.45)), 0.0);\n"
+    "    FRAG_COLOR = vec4(vec3(0.85, 0.45, 0.55) * light, 1.0);\n"
+    "}\n";
+
+static const char* skinnedAttributes[] = { "vertPosition", "vertNormal", "vertBones", "vertWeights", NULL };
+static const char* cpuAttributes[] = { "vertPosition", "vertNormal", NULL };
+
+typedef enum {
+    PALETTE_CPU,
+    PALETTE_UNIFORMS,
+    PALETTE_UNIFORM_BLOCK,
+    PALETTE_TEXTURE
+} palette_path;
+
+typedef struct {
+    const char* name;
+    palette_path path;
+    int dualQuat;
+} skin_mode;
+
+static const skin_mode modes[] = {
+    { "cpu-lbs", PALETTE_CPU, 0 },
+    { "cpu-dqs", PALETTE_CPU, 1 },
+    { "uniform-lbs", PALETTE_UNIFORMS, 0 },
+    { "uniform-dqs", PALETTE_UNIFORMS, 1 },
+    #if SAMPLE_OPENGL_API == SAMPLE_API_GL || SAMPLE_OPENGL_VERSION_MAJOR >= 3
+        { "ubo-lbs", PALETTE_UNIFORM_BLOCK, 0 },
+        { "ubo-dqs", PALETTE_UNIFORM_BLOCK, 1 },
+        { "texture-lbs", PALETTE_TEXTURE, 0 },
+        { "texture-dqs", PALETTE_TEXTURE, 1 },
+    #endif
+};
+
+#define MODE_COUNT ((int)(sizeof(modes) / sizeof(modes[0])))
+
+typedef struct {
+    float position[2];
+    float heading;
+    float phase;
+    float speed;
+} tentacle;
+
+// How the palettes of a mode are laid out: every tentacle has
+// floatsPerTentacle floats, and they come in batches of batchSize tentacles,
+// batchStride floats apart (the batches of a uniform buffer start at the
+// offset alignment).
+typedef struct {
+    int floatsPerBone;
+    int floatsPerTentacle;
+    int batchSize;
+    size_t batchStride;
+    size_t size;  // Floats in all.
+} palette_layout;
+
+typedef struct {
+    int instanceCount;
+    int boneCount;
+    int rings;  // Rings of vertices along a tentacle.
+    tentacle* tentacles;
+    float extent;  // Size of the field of tentacles.
+
+    // The mesh of a tentacle, in its bind pose.
+    skin_vertex* vertices;
+    int vertexCount;
+    int indexCount;
+    int chunkSize;  // Tentacles fitting in 16-bit indices.
+
+    const skin_mode* mode;
+    palette_layout layout;
+    float* palettes;
+    float* skinned;  // 6 floats per vertex of every tentacle (CPU modes).
+    float time;
+
+    job_system* jobs;
+    job_counter animated;
+    hud* hud;  // NULL without --hud.
+
+    GLuint programs[MODE_COUNT];
+    char defines[MODE_COUNT][256];
+    GLuint meshBuffer;
+    GLuint indexBuffer;
+    GLuint skinnedBuffer;
+    size_t skinnedSize;
+    #if SAMPLE_OPENGL_API == SAMPLE_API_GL || SAMPLE_OPENGL_VERSION_MAJOR >= 3
+        GLuint meshVao;
+        GLuint skinnedVao;
+        GLuint uniformBuffer;
+        size_t uniformBufferSize;
+        GLuint paletteTexture;
+        int paletteRows;
+        GLint uniformBlockSize;
+        GLint uniformBufferAlignment;
+    #endif
+} scene;
+
+typedef struct {
+    long long frames;
+    double seconds;
+    double cpuSeconds;
+    int draws;  // Per frame.
+} mode_stats;
+
+static float randomFloat(unsigned int* state) {
+    *state = *state * 1664525u + 1013904223u;
+    return (float)(*state >> 8) / 16777216.0f;
+}
+
+// A tube along +Y, from 0 to TENTACLE_HEIGHT, narrowing toward its tip. Its
+// vertices are bound to the two bones closest to their ring (bone j spans
+// [j, j + 1] * TENTACLE_HEIGHT / boneCount in the bind pose).
+static int buildTentacle(scene* scene) {
+    const float pi = 3.14159265358979323846f;
+    int rings = scene->rings;
+    scene->vertexCount = (rings + 1) * SEGMENTS;
+    scene->indexCount = rings * SEGMENTS * 6;
+    scene->vertices = malloc((size_t)scene->vertexCount * sizeof(skin_vertex));
+    if (!scene->vertices) {
+        return -1;
+    }
+
+    float boneLength = TENTACLE_HEIGHT / (float)scene->boneCount;
+    for (int ring = 0; ring <= rings; ring++) {
+        float y = TENTACLE_HEIGHT * (float)ring / (float)rings;
+        float radius = TENTACLE_RADIUS * (1.0f - 0.7f * (float)ring / (float)rings);
+
+        // Blend between the centers of the bones around y.
+        float u = y / boneLength - 0.5f;
+        int bone = (int)floorf(u);
+        float blend = u - (float)bone;
+        if (bone < 0) {
+            bone = 0;
+            blend = 0.0f;
+        } else if (bone >= scene->boneCount - 1) {
+            bone = scene->boneCount - 1;
+            blend = 0.0f;
+        }
+        int first = blend <= 0.5f ? bone : bone + 1;
+        int second = blend <= 0.5f ? bone + 1 : bone;
+        float weight = blend <= 0.5f ? 1.0f - blend : blend;
+        if (second >= scene->boneCount) {
+            second = first;
+        }
+
+        for (int segment = 0; segment < SEGMENTS; segment++) {
+            float angle = 2.0f * pi * (float)segment / (float)SEGMENTS;
+            skin_vertex* vertex = &scene->vertices[ring * SEGMENTS + segment];
+            memset(vertex, 0, sizeof(skin_vertex));
+            vertex->position[0] = cosf(angle) * radius;
+            vertex->position[1] = y;
+            vertex->position[2] = sinf(angle) * radius;
+            vertex->position[3] = 1.0f;
+            vertex->normal[0] = cosf(angle);
+            vertex->normal[2] = sinf(angle);
+            vertex->bones[0] = (unsigned char)first;
+            vertex->bones[1] = (unsigned char)second;
+            vertex->bones[2] = (unsigned char)first;
+            vertex->bones[3] = (unsigned char)first;
+            vertex->weights[0] = weight;
+            vertex->weights[1] = 1.0f - weight;
+        }
+    }
+    return 0;
+}
+
+// The indices of chunkSize tentacles, one after the other in the vertex
+// buffer; the first ones are the indices of a single tentacle.
+static unsigned short* buildIndices(const scene* scene) {
+    unsigned short* indices = malloc((size_t)scene->indexCount * (size_t)scene->chunkSize * sizeof(unsigned short));
+    if (!indices) {
+        return NULL;
+    }
+    int index = 0;
+    for (int instance = 0; instance < scene->chunkSize; instance++) {
+        int base = instance * scene->vertexCount;
+        for (int ring = 0; ring < scene->rings; ring++) {
+            for (int segment = 0; segment < SEGMENTS; segment++) {
+                int next = (segment + 1) % SEGMENTS;
+                int a = base + ring * SEGMENTS + segment;
+                int b = base + ring * SEGMENTS + next;
+                int c = base + (ring + 1) * SEGMENTS + next;
+                int d = base + (ring + 1) * SEGMENTS + segment;
+                indices[index++] = (unsigned short)a;
+                indices[index++] = (unsigned short)d;
+                indices[index++] = (unsigned short)c;
+                indices[index++] = (unsigned short)a;
+                indices[index++] = (unsigned short)c;
+                indices[index++] = (unsigned short)b;
+            }
+        }
+    }
+    return indices;
+}
+
+static GLuint createBuffer(GLenum target, size_t size, const void* data, GLenum usage, const char* label) {
+    GLuint buffer;
+    glGenBuffers(1, &buffer);
+    glBindBuffer(target, buffer);
+    GL_CHECK(glBufferData(target, size, data, usage));
+    gpu_memory_track(GPU_MEMORY_BUFFER, buffer, size);
+    gl_debug_label(GL_BUFFER, buffer, label);
+    return buffer;
+}
+
+static void setupMeshArrays(scene* scene) {
+    glBindBuffer(GL_ARRAY_BUFFER, scene->meshBuffer);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, scene->indexBuffer);
+    glVertexAttribPointer(ATTRIB_POSITION, 4, GL_FLOAT, GL_FALSE, sizeof(skin_vertex),
+        (void*)offsetof(skin_vertex, position));
+    glVertexAttribPointer(ATTRIB_NORMAL, 3, GL_FLOAT, GL_FALSE, sizeof(skin_vertex),
+        (void*)offsetof(skin_vertex, normal));
+    glVertexAttribPointer(ATTRIB_BONES, 4, GL_UNSIGNED_BYTE, GL_FALSE, sizeof(skin_vertex),
+        (void*)offsetof(skin_vertex, bones));
+    glVertexAttribPointer(ATTRIB_WEIGHTS, 4, GL_FLOAT, GL_FALSE, sizeof(skin_vertex),
+        (void*)offsetof(skin_vertex, weights));
+    glEnableVertexAttribArray(ATTRIB_POSITION);
+    glEnableVertexAttribArray(ATTRIB_NORMAL);
+    glEnableVertexAttribArray(ATTRIB_BONES);
+    glEnableVertexAttribArray(ATTRIB_WEIGHTS);
+}
+
+// Point the arrays at the skinned vertices of a chunk of tentacles.
+static void setupSkinnedArrays(scene* scene, int firstInstance) {
+    size_t offset = (size_t)firstInstance * (size_t)scene->vertexCount * 6 * sizeof(float);
+    glBindBuffer(GL_ARRAY_BUFFER, scene->skinnedBuffer);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, scene->indexBuffer);
+    glVertexAttribPointer(ATTRIB_POSITION, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)offset);
+    glVertexAttribPointer(ATTRIB_NORMAL, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float),
+        (void*)(offset + 3 * sizeof(float)));
+    glEnableVertexAttribArray(ATTRIB_POSITION);
+    glEnableVertexAttribArray(ATTRIB_NORMAL);
+    #if SAMPLE_OPENGL_API == SAMPLE_API_GLES && SAMPLE_OPENGL_VERSION_MAJOR == 2
+        glDisableVertexAttribArray(ATTRIB_BONES);
+        glDisableVertexAttribArray(ATTRIB_WEIGHTS);
+    #endif
+}
+
+static palette_layout layoutOf(const scene* scene, const skin_mode* mode) {
+    palette_layout layout;
+    if (mode->path == PALETTE_CPU) {
+        layout.floatsPerBone = mode->dualQuat ? 8 : 16;
+    } else {
+        // The rows of a matrix, or the two halves of a dual quaternion, are
+        // vec4 in the shaders.
+        layout.floatsPerBone = mode->dualQuat ? 8 : 12;
+    }
+    layout.floatsPerTentacle = layout.floatsPerBone * scene->boneCount;
+    layout.batchSize = scene->instanceCount;
+    layout.batchStride = (size_t)layout.floatsPerTentacle * (size_t)scene->instanceCount;
+
+    #if SAMPLE_OPENGL_API == SAMPLE_API_GL || SAMPLE_OPENGL_VERSION_MAJOR >= 3
+        if (mode->path == PALETTE_UNIFORM_BLOCK) {
+            size_t tentacleBytes = (size_t)layout.floatsPerTentacle * sizeof(float);
+            size_t alignment = (size_t)scene->uniformBufferAlignment;
+            layout.batchSize = (int)((size_t)scene->uniformBlockSize / tentacleBytes);
+            if (layout.batchSize > scene->instanceCount) {
+                layout.batchSize = scene->instanceCount;
+            }
+            size_t batchBytes = (size_t)layout.batchSize * tentacleBytes;
+            layout.batchStride = (batchBytes + alignment - 1) / alignment * alignment / sizeof(float);
+        }
+    #endif
+
+    int batches = (scene->instanceCount + layout.batchSize - 1) / layout.batchSize;
+    layout.size = (size_t)batches * layout.batchStride;
+    if (mode->path == PALETTE_TEXTURE) {
+        // Whole rows of texels.
+        size_t rowFloats = PALETTE_TEXTURE_WIDTH * 4;
+        layout.size = (layout.size + rowFloats - 1) / rowFloats * rowFloats;
+    }
+    return layout;
+}
+
+static float* paletteOf(const scene* scene, int instance) {
+    const palette_layout* layout = &scene->layout;
+    size_t batch = (size_t)(instance / layout->batchSize);
+    size_t index = (size_t)(instance % layout->batchSize);
+    return scene->palettes + batch * layout->batchStride + index * (size_t)layout->floatsPerTentacle;
+}
+
+static int createScene(scene* scene) {
+    const float pi = 3.14159265358979323846f;
+    if (buildTentacle(scene) != 0) {
+        fprintf(stderr, "Failed to allocate the tentacle\n");
+        return -1;
+    }
+    scene->chunkSize = 65536 / scene->vertexCount;
+    if (scene->chunkSize > scene->instanceCount) {
+        scene->chunkSize = scene->instanceCount;
+    }
+
+    // A square field of tentacles.
+    int side = (int)ceilf(sqrtf((float)scene->instanceCount));
+    scene->extent = (float)side * TENTACLE_SPACING;
+    scene->tentacles = malloc((size_t)scene->instanceCount * sizeof(tentacle));
+    scene->skinnedSize = (size_t)scene->instanceCount * (size_t)scene->vertexCount * 6 * sizeof(float);
+    scene->skinned = malloc(scene->skinnedSize);
+    if (!scene->tentacles || !scene->skinned) {
+        fprintf(stderr, "Failed to allocate %d tentacles\n", scene->instanceCount);
+        return -1;
+    }
+    unsigned int state = 7u;
+    for (int i = 0; i < scene->instanceCount; i++) {
+        tentacle* t = &scene->tentacles[i];
+        t->position[0] = ((float)(i % side) + 0.5f) * TENTACLE_SPACING - scene->extent * 0.5f;
+        t->position[1] = ((float)(i / side) + 0.5f) * TENTACLE_SPACING - scene->extent * 0.5f;
+        t->heading = randomFloat(&state) * 2.0f * pi;
+        t->phase = randomFloat(&state) * 2.0f * pi;
+        t->speed = 1.0f + randomFloat(&state) * 1.5f;
+    }
+
+    #if SAMPLE_OPENGL_API == SAMPLE_API_GL || SAMPLE_OPENGL_VERSION_MAJOR >= 3
+        glGetIntegerv(GL_MAX_UNIFORM_BLOCK_SIZE, &scene->uniformBlockSize);
+        glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &scene->uniformBufferAlignment);
+        if (scene->uniformBlockSize > 65536) {
+            scene->uniformBlockSize = 65536;
+        }
+    #endif
+
+    // A program per mode, the CPU modes sharing theirs.
+    shader_program programs[MODE_COUNT];
+    int programCount = 0;
+    for (int m = 0; m < MODE_COUNT; m++) {
+        const skin_mode* mode = &modes[m];
+        if (mode->path == PALETTE_CPU) {
+            if (m == 0) {
+                programs[programCount++] = (shader_program){
+                    .label = "CPU skinning program",
+                    .defines = "#define SKIN_ON_CPU 1\n",
+                    .vertex = vertexSource,
+                    .fragment = fragmentSource,
+                    .attributes = cpuAttributes
+                };
+            }
+            continue;
+        }
+
+        static const char* pathDefines[] = {
+            "",
+            "#define PALETTE_UNIFORMS 1\n",
+            "#define PALETTE_UNIFORM_BLOCK 1\n",
+            "#define PALETTE_TEXTURE 1\n"
+        };
+        palette_layout layout = layoutOf(scene, mode);
+        int vectorsPerBone = layout.floatsPerBone / 4;
+        int paletteVectors = layout.floatsPerTentacle / 4;
+        if (mode->path == PALETTE_UNIFORM_BLOCK) {
+            paletteVectors *= layout.batchSize;
+        }
+        snprintf(scene->defines[m], sizeof(scene->defines[m]),
+            "%s#define %s 1\n#define VECTORS_PER_BONE %d\n#define BONE_COUNT %d\n"
+            "#define PALETTE_VECTORS %d\n#define PALETTE_TEXTURE_WIDTH %d\n",
+            pathDefines[mode->path], mode->dualQuat ? "DUAL_QUATERNION" : "LINEAR_BLEND", vectorsPerBone,
+            scene->boneCount, paletteVectors, PALETTE_TEXTURE_WIDTH);
+        programs[programCount++] = (shader_program){
+            .label = mode->name,
+            .defines = scene->defines[m],
+            .vertex = vertexSource,
+            .fragment = fragmentSource,
+            .attributes = skinnedAttributes
+        };
+    }
+    shader_submit(programs, programCount);
+
+    unsigned short* indices = buildIndices(scene);
+    if (!indices) {
+        fprintf(stderr, "Failed to allocate the indices\n");
+        return -1;
+    }
+    scene->meshBuffer = createBuffer(GL_ARRAY_BUFFER, (size_t)scene->vertexCount * sizeof(skin_vertex),
+        scene->vertices, GL_STATIC_DRAW, "Tentacle vertices");
+    scene->indexBuffer = createBuffer(GL_ELEMENT_ARRAY_BUFFER,
+        (size_t)scene->indexCount * (size_t)scene->chunkSize * sizeof(unsigned short), indices, GL_STATIC_DRAW,
+        "Tentacle indices");
+    free(indices);
+    scene->skinnedBuffer = createBuffer(GL_ARRAY_BUFFER, scene->skinnedSize, NULL, GL_STREAM_DRAW,
+        "Skinned vertices");
+
+    #if SAMPLE_OPENGL_API == SAMPLE_API_GL || SAMPLE_OPENGL_VERSION_MAJOR >= 3
+        glGenVertexArrays(1, &scene->meshVao);
+        glBindVertexArray(scene->meshVao);
+        setupMeshArrays(scene);
+        glGenVertexArrays(1, &scene->skinnedVao);
+        glBindVertexArray(scene->skinnedVao);
+        setupSkinnedArrays(scene, 0);
+        glBindVertexArray(0);
+
+        // Sized for the largest layout.
+        scene->uniformBufferSize = 0;
+        size_t textureFloats = 0;
+        for (int m = 0; m < MODE_COUNT; m++) {
+            palette_layout layout = layoutOf(scene, &modes[m]);
+            if (modes[m].path == PALETTE_UNIFORM_BLOCK && layout.size * sizeof(float) > scene->uniformBufferSize) {
+                scene->uniformBufferSize = layout.size * sizeof(float);
+            } else if (modes[m].path == PALETTE_TEXTURE && layout.size > textureFloats) {
+                textureFloats = layout.size;
+            }
+        }
+        scene->uniformBuffer = createBuffer(GL_UNIFORM_BUFFER, scene->uniformBufferSize, NULL, GL_STREAM_DRAW,
+            "Palettes");
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+        scene->paletteRows = (int)(textureFloats / (PALETTE_TEXTURE_WIDTH * 4));
+        glGenTextures(1, &scene->paletteTexture);
+        glBindTexture(GL_TEXTURE_2D, scene->paletteTexture);
+        GL_CHECK(glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, PALETTE_TEXTURE_WIDTH, scene->paletteRows, 0,
+            GL_RGBA, GL_FLOAT, NULL));
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        gpu_memory_track(GPU_MEMORY_TEXTURE, scene->paletteTexture,
+            gpu_memory_texture_size(GL_RGBA, GL_FLOAT, PALETTE_TEXTURE_WIDTH, scene->paletteRows, 1, 1));
+        gl_debug_label(GL_TEXTURE, scene->paletteTexture, "Palettes");
+    #endif
+
+    // The largest layout, for the palettes on the CPU.
+    size_t paletteFloats = 0;
+    for (int m = 0; m < MODE_COUNT; m++) {
+        palette_layout layout = layoutOf(scene, &modes[m]);
+        if (layout.size > paletteFloats) {
+            paletteFloats = layout.size;
+        }
+    }
+    scene->palettes = calloc(paletteFloats, sizeof(float));
+    if (!scene->palettes) {
+        fprintf(stderr, "Failed to allocate the palettes\n");
+        return -1;
+    }
+
+    int failures = shader_finish(programs, programCount);
+    for (int m = 0, p = 0; m < MODE_COUNT; m++) {
+        if (modes[m].path == PALETTE_CPU && m > 0) {
+            scene->programs[m] = scene->programs[0];
+            continue;
+        }
+        scene->programs[m] = programs[p++].program;
+    }
+    if (failures > 0) {
+        return -1;
+    }
+
+    // The samplers and blocks are bound to unit and binding point 0.
+    #if SAMPLE_OPENGL_API == SAMPLE_API_GL || SAMPLE_OPENGL_VERSION_MAJOR >= 3
+        for (int m = 0; m < MODE_COUNT; m++) {
+            GLuint program = scene->programs[m];
+            if (modes[m].path == PALETTE_UNIFORM_BLOCK) {
+                glUniformBlockBinding(program, glGetUniformBlockIndex(program, "Palettes"), 0);
+            } else if (modes[m].path == PALETTE_TEXTURE) {
+                glUseProgram(program);
+                glUniform1i(glGetUniformLocation(program, "palette"), 0);
+            }
+        }
+        glUseProgram(0);
+    #endif
+
+    glEnable(GL_DEPTH_TEST);
+    glEnable(GL_CULL_FACE);
+    return 0;
+}
+
+static void deleteScene(scene* scene) {
+    gpu_memory_untrack(GPU_MEMORY_BUFFER, scene->meshBuffer);
+    gpu_memory_untrack(GPU_MEMORY_BUFFER, scene->indexBuffer);
+    gpu_memory_untrack(GPU_MEMORY_BUFFER, scene->skinnedBuffer);
+    glDeleteBuffers(1, &scene->meshBuffer);
+    glDeleteBuffers(1, &scene->indexBuffer);
+    glDeleteBuffers(1, &scene->skinnedBuffer);
+    #if SAMPLE_OPENGL_API == SAMPLE_API_GL || SAMPLE_OPENGL_VERSION_MAJOR >= 3
+        gpu_memory_untrack(GPU_MEMORY_BUFFER, scene->uniformBuffer);
+        gpu_memory_untrack(GPU_MEMORY_TEXTURE, scene->paletteTexture);
+        glDeleteBuffers(1, &scene->uniformBuffer);
+        glDeleteTextures(1, &scene->paletteTexture);
+        glDeleteVertexArrays(1, &scene->meshVao);
+        glDeleteVertexArrays(1, &scene->skinnedVao);
+    #endif
+    for (int m = 0; m < MODE_COUNT; m++) {
+        if (modes[m].path != PALETTE_CPU || m == 0) {
+            glDeleteProgram(scene->programs[m]);
+        }
+    }
+
+    free(scene->vertices);
+    free(scene->tentacles);
+    free(scene->skinned);
+    free(scene->palettes);
+}
+
+// Compute the palettes of a range of tentacles, in the layout of the mode,
+// and skin their vertices when it is done on the CPU. Every bone bends a
+// little around a horizontal axis turning along the chain.
+static void animateTentacles(void* arg, size_t begin, size_t end) {
+    PROFILE_ZONE_BEGIN("animate");
+    scene* scene = arg;
+    const skin_mode* mode = scene->mode;
+    const float one[3] = { 1.0f, 1.0f, 1.0f };
+    float boneLength = TENTACLE_HEIGHT / (float)scene->boneCount;
+
+    for (size_t i = begin; i < end; i++) {
+        const tentacle* t = &scene->tentacles[i];
+        float* palette = paletteOf(scene, (int)i);
+
+        mat4 world;
+        quat heading;
+        float position[3] = { t->position[0], 0.0f, t->position[1] };
+        quat_from_axis_angle(heading, 0.0f, 1.0f, 0.0f, t->heading);
+        mat4_from_trs(world, position, heading, one);
+
+        for (int j = 0; j < scene->boneCount; j++) {
+            float axis = t->phase + (float)j * 0.4f;
+            float angle = 0.3f * sinf(scene->time * t->speed + t->phase + (float)j * 0.5f);
+            float offset[3] = { 0.0f, j == 0 ? 0.0f : boneLength, 0.0f };
+            quat bend;
+            quat_from_axis_angle(bend, cosf(axis), 0.0f, sinf(axis), angle);
+            mat4 local;
+            mat4_from_trs(local, offset, bend, one);
+            mat4_multiply(world, world, local);
+
+            // Times the inverse of the bind pose, a translation down the
+            // chain.
+            mat4 bone;
+            memcpy(bone, world, sizeof(mat4));
+            float bind = (float)j * boneLength;
+            bone[12] -= world[4] * bind;
+            bone[13] -= world[5] * bind;
+            bone[14] -= world[6] * bind;
+
+            float* out = palette + (size_t)j * (size_t)scene->layout.floatsPerBone;
+            if (mode->dualQuat) {
+                skin_dual_quat_from_matrix(out, bone);
+            } else if (mode->path == PALETTE_CPU) {
+                memcpy(out, bone, sizeof(mat4));
+            } else {
+                for (int row = 0; row < 3; row++) {
+                    for (int column = 0; column < 4; column++) {
+                        out[row * 4 + column] = bone[column * 4 + row];
+                    }
+                }
+            }
+        }
+
+        if (mode->path == PALETTE_CPU) {
+            float* output = scene->skinned + i * (size_t)scene->vertexCount * 6;
+            if (mode->dualQuat) {
+                skin_dual_quat(scene->vertices, (size_t)scene->vertexCount, palette, output);
+            } else {
+                skin_linear(scene->vertices, (size_t)scene->vertexCount, palette, output);
+            }
+        }
+    }
+    PROFILE_ZONE_END();
+}
+
+// Upload what the frame needs and draw every tentacle. Returns the number of
+// draw calls.
+static int drawTentacles(scene* scene, GLuint program) {
+    const skin_mode* mode = scene->mode;
+    const palette_layout* layout = &scene->layout;
+    int draws = 0;
+
+    if (mode->path == PALETTE_CPU) {
+        glBindBuffer(GL_ARRAY_BUFFER, scene->skinnedBuffer);
+        glBufferData(GL_ARRAY_BUFFER, scene->skinnedSize, NULL, GL_STREAM_DRAW);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, scene->skinnedSize, scene->skinned);
+        #if SAMPLE_OPENGL_API == SAMPLE_API_GL || SAMPLE_OPENGL_VERSION_MAJOR >= 3
+            glBindVertexArray(scene->skinnedVao);
+        #endif
+        for (int first = 0; first < scene->instanceCount; first += scene->chunkSize) {
+            int count = scene->instanceCount - first < scene->chunkSize ? scene->instanceCount - first : scene->chunkSize;
+            setupSkinnedArrays(scene, first);
+            glDrawElements(GL_TRIANGLES, scene->indexCount * count, GL_UNSIGNED_SHORT, 0);
+            draws++;
+        }
+    } else if (mode->path == PALETTE_UNIFORMS) {
+        #if SAMPLE_OPENGL_API == SAMPLE_API_GL || SAMPLE_OPENGL_VERSION_MAJOR >= 3
+            glBindVertexArray(scene->meshVao);
+        #else
+            setupMeshArrays(scene);
+        #endif
+        GLint location = glGetUniformLocation(program, "palette");
+        for (int i = 0; i < scene->instanceCount; i++) {
+            glUniform4fv(location, layout->floatsPerTentacle / 4, paletteOf(scene, i));
+            glDrawElements(GL_TRIANGLES, scene->indexCount, GL_UNSIGNED_SHORT, 0);
+            draws++;
+        }
+    }
+    #if SAMPLE_OPENGL_API == SAMPLE_API_GL || SAMPLE_OPENGL_VERSION_MAJOR >= 3
+        else if (mode->path == PALETTE_UNIFORM_BLOCK) {
+            size_t size = layout->size * sizeof(float);
+            glBindBuffer(GL_UNIFORM_BUFFER, scene->uniformBuffer);
+            glBufferData(GL_UNIFORM_BUFFER, scene->uniformBufferSize, NULL, GL_STREAM_DRAW);
+            glBufferSubData(GL_UNIFORM_BUFFER, 0, size, scene->palettes);
+            glBindVertexArray(scene->meshVao);
+            for (int first = 0; first < scene->instanceCount; first += layout->batchSize) {
+                int count = scene->instanceCount - first < layout->batchSize ? scene->instanceCount - first : layout->batchSize;
+                size_t offset = (size_t)(first / layout->batchSize) * layout->batchStride * sizeof(float);
+                glBindBufferRange(GL_UNIFORM_BUFFER, 0, scene->uniformBuffer, offset,
+                    (size_t)layout->batchSize * (size_t)layout->floatsPerTentacle * sizeof(float));
+                glDrawElementsInstanced(GL_TRIANGLES, scene->indexCount, GL_UNSIGNED_SHORT, 0, count);
+                draws++;
+            }
+        } else {
+            int rows = (int)(layout->size / (PALETTE_TEXTURE_WIDTH * 4));
+            glActiveTexture(GL_TEXTURE0);
+            glBindTexture(GL_TEXTURE_2D, scene->paletteTexture);
+            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, PALETTE_TEXTURE_WIDTH, rows, GL_RGBA, GL_FLOAT, scene->palettes);
+            glBindVertexArray(scene->meshVao);
+            glDrawElementsInstanced(GL_TRIANGLES, scene->indexCount, GL_UNSIGNED_SHORT, 0, scene->instanceCount);
+            draws++;
+        }
+        glBindVertexArray(0);
+    #endif
+    return draws;
+}
+
+// Render frames in the given mode for a while, with the camera circling the
+// field. Every frame is waited for, so the frame rate includes the GPU work.
+static void runMode(scene* scene, int m, double duration, GLFWwindow* window, EGLDisplay display,
+                    EGLSurface surface, mode_stats* stats) {
+    const float pi = 3.14159265358979323846f;
+    memset(stats, 0, sizeof(mode_stats));
+    scene->mode = &modes[m];
+    scene->layout = layoutOf(scene, scene->mode);
+    GLuint program = scene->programs[m];
+
+    mat4 proj, view, viewProj;
+    mat4_perspective(proj, 60.0f * pi / 180.0f, 640.0f / 480.0f, 0.5f, scene->extent * 3.0f + 10.0f);
+    float radius = scene->extent * 0.8f + 4.0f;
+
+    double start = timer_now();
+    double end = start + duration;
+    double previous = start;
+    while (timer_now() < end && !(window && glfwWindowShouldClose(window))) {
+        PROFILE_ZONE_BEGIN("frame");
+        PROFILE_GPU_ZONE_BEGIN("frame");
+
+        scene->time = (float)(timer_now() - start);
+        float angle = scene->time * 0.15f;
+        mat4_look_at(view,
+            sinf(angle) * radius, radius * 0.6f, cosf(angle) * radius,
+            0.0f, TENTACLE_HEIGHT * 0.4f, 0.0f,
+            0, 1, 0
+        );
+        mat4_multiply(viewProj, proj, view);
+
+        PROFILE_ZONE_BEGIN("jobs");
+        double cpuStart = timer_now();
+        job_parallel_for(scene->jobs, (size_t)scene->instanceCount, 0, animateTentacles, scene, &scene->animated);
+        job_wait(scene->jobs, &scene->animated);
+        stats->cpuSeconds += timer_now() - cpuStart;
+        PROFILE_ZONE_END();
+
+        glClearColor(0.08f, 0.09f, 0.12f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+        PROFILE_GPU_ZONE_BEGIN("draw");
+        gl_debug_push_group(scene->mode->name);
+        glUseProgram(program);
+        glUniformMatrix4fv(glGetUniformLocation(program, "mViewProj"), 1, GL_FALSE, viewProj);
+        stats->draws = drawTentacles(scene, program);
+        gl_debug_pop_group();
+        PROFILE_GPU_ZONE_END();
+
+        if (scene->hud) {
+            double now = timer_now();
+            double vertices = (double)scene->instanceCount * (double)scene->vertexCount;
+            hud_printf(scene->hud, "Mode: %s", scene->mode->name);
+            hud_printf(scene->hud, "Skinned: %.2f M vertices/s", vertices / (now - previous) / 1e6);
+            hud_draw(scene->hud, now - previous, stats->draws);
+            previous = now;
+        }
+
+        PROFILE_GPU_ZONE_END();
+        PROFILE_ZONE_BEGIN("eglSwapBuffers");
+        eglSwapBuffers(display, surface);
+        PROFILE_ZONE_END();
+        glFinish();
+        profiler_gpu_collect();
+        PROFILE_ZONE_END();
+        stats->frames++;
+
+        if (window) {
+            glfwPollEvents();
+        }
+    }
+    stats->seconds = timer_now() - start;
+}
+
+int main(int argc, char** argv) {
+    int instanceCount = option_int(argc, argv, "--instances", 1024);
+    int boneCount = option_int(argc, argv, "--bones", 16);
+    int rings = option_int(argc, argv, "--rings", 48);
+    int threads = option_int(argc, argv, "--threads", thread_hardware_concurrency());
+    double duration = option_double(argc, argv, "--seconds", 2.0);
+    int useWindow = option_flag(argc, argv, "--window");
+    int useHud = option_flag(argc, argv, "--hud");
+    const char* reportPath = option_string(argc, argv, "--json", NULL);
+    const char* tracePath = option_string(argc, argv, "--trace", NULL);
+
+    if (instanceCount < 1) {
+        fprintf(stderr, "The number of instances must be positive\n");
+        return -1;
+    }
+    if (boneCount < 2 || boneCount > MAX_BONES) {
+        fprintf(stderr, "The number of bones must be between 2 and %d\n", MAX_BONES);
+        return -1;
+    }
+    if (rings < 1 || rings > 255) {
+        fprintf(stderr, "The number of rings must be between 1 and 255\n");
+        return -1;
+    }
+    if (threads < 1) {
+        threads = 1;
+    }
+    if (threads > JOB_MAX_THREADS) {
+        threads = JOB_MAX_THREADS;
+    }
+
+    PROFILE_THREAD_NAME("main");
+
+    GLFWwindow* window = NULL;
+    EGLDisplay display;
+    EGLConfig config;
+    EGLContext context;
+    EGLSurface surface;
+    if (useWindow) {
+        if (initializeWindow(&window, &display, &context, &surface, 640, 480, "Erlangsters - Skinning") != 0) {
+            return -1;
+        }
+    } else if (initializeHeadless(&display, &config, &context, &surface, 640, 480) != 0) {
+        return -1;
+    }
+    gl_debug_install();
+    profiler_gpu_init();
+
+    static scene scene;
+    scene.instanceCount = instanceCount;
+    scene.boneCount = boneCount;
+    scene.rings = rings;
+    if (createScene(&scene) != 0) {
+        return -1;
+    }
+    scene.jobs = job_system_create(threads);
+    if (!scene.jobs) {
+        fprintf(stderr, "Failed to create a job system of %d threads\n", threads);
+        return -1;
+    }
+    job_counter_init(&scene.animated);
+    static hud overlay;
+    if (useHud && hud_init(&overlay, 640, 480) == 0) {
+        scene.hud = &overlay;
+    }
+
+    long long vertices = (long long)instanceCount * scene.vertexCount;
+    printf("Skinning %d tentacles of %d vertices and %d bones (%lld vertices) on %d threads (%s)\n",
+        instanceCount, scene.vertexCount, boneCount, vertices, job_system_thread_count(scene.jobs), skin_isa());
+
+    report* report = report_open(reportPath);
+    report_string(report, "sample", "skinning");
+    report_integer(report, "instances", instanceCount);
+    report_integer(report, "bones", boneCount);
+    report_integer(report, "vertices", vertices);
+    report_integer(report, "threads", job_system_thread_count(scene.jobs));
+    report_string(report, "isa", skin_isa());
+    report_begin_array(report, "modes");
+
+    for (int m = 0; m < MODE_COUNT; m++) {
+        mode_stats stats;
+        runMode(&scene, m, duration, window, display, surface, &stats);
+        if (stats.frames == 0) {
+            break;
+        }
+
+        double frames = (double)stats.frames;
+        double verticesPerSecond = (double)vertices * frames / stats.seconds;
+        double cpuMilliseconds = stats.cpuSeconds * 1000.0 / frames;
+        printf("%-12s %8.2f M vertices/s  CPU: %7.3f ms/frame  draws: %5d  %7.1f frames/s\n",
+            modes[m].name, verticesPerSecond / 1e6, cpuMilliseconds, stats.draws, frames / stats.seconds);
+
+        report_begin_object(report, NULL);
+        report_string(report, "mode", modes[m].name);
+        report_integer(report, "frames", stats.frames);
+        report_number(report, "frames_per_second", frames / stats.seconds);
+        report_number(report, "vertices_per_second", verticesPerSecond);
+        report_number(report, "cpu_milliseconds_per_frame", cpuMilliseconds);
+        report_integer(report, "draws_per_frame", stats.draws);
+        report_end_object(report);
+    }
+
+    report_end_array(report);
+    if (scene.hud) {
+        printf("HUD: %.3f ms/frame on the CPU\n", hud_average_cost(scene.hud));
+        report_number(report, "hud_milliseconds_per_frame", hud_average_cost(scene.hud));
+    }
+    gpu_memory_print();
+    gpu_memory_report(report);
+    report_close(report);
+
+    if (scene.hud) {
+        hud_destroy(scene.hud);
+    }
+    job_system_destroy(scene.jobs);
+    deleteScene(&scene);
+    gl_debug_summary();
+    profiler_gpu_shutdown();
+    if (tracePath) {
+        profiler_write_trace(tracePath);
+    }
+    if (window) {
+        terminateWindow(window);
+    } else {
+        terminateHeadless(display, context, surface);
+    }
+
+    return 0;
+}
@@ -0,0 +1,314 @@
+//
+// Copyright (c) 2025, Byteplug LLC.
+//
+// This source file is part of a project made by the Erlangsters community and
+// is released under the MIT license. Please refer to the LICENSE.md file that
+// can be found at the root of the project repository.
+//
+// Written by Jonathan De Wachter <jonathan.dewachter@byteplug.io>
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "gl_api.h"
+#include "gl_debug.h"
+#include "job.h"
+#include "window.h"
+#include "options.h"
+#include "report.h"
+#include "texture_gen.h"
+#include "thread.h"
+#include "timer.h"
+
+// Measures the procedural texture generator of texture_gen.h against the
+// per-pixel routine the samples used before, then the cost of getting a
+// generated texture (with its mip chain) onto the GPU, either staged in
+// client memory or generated straight into a mapped pixel unpack buffer.
+//
+// The threads of the job system are started before anything is measured, so
+// the threaded results do not include their startup.
+
+// The checker is measured twice: with the cells of 2 pixels of the legacy
+// routine, which is its worst case, and with cells of 8 pixels.
+#define CHECKER_CELL_SIZE 8
+
+typedef struct {
+    const char* name;
+    texture_pattern pattern;
+    int cells;
+} pattern_case;
+
+// The routine the samples used to generate their checker texture.
+static void legacyCheckerTexture(unsigned char* data, int width, int height,
+                                 unsigned char r1, unsigned char g1, unsigned char b1,
+                                 unsigned char r2, unsigned char g2, unsigned char b2) {
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            size_t index = ((size_t)y * width + x) * 4;
+            int isAlternate = (x / 2 + y / 2) % 2;
+
+            data[index + 0] = isAlternate ? r1 : r2;
+            data[index + 1] = isAlternate ? g1 : g2;
+            data[index + 2] = isAlternate ? b1 : b2;
+            data[index + 3] = 255;
+        }
+    }
+}
+
+typedef struct {
+    texture_desc desc;
+    unsigned char* pixels;
+    job_system* jobs;  // NULL on a single thread.
+    GLuint texture;
+    GLuint buffer;
+} benchmark;
+
+typedef void (*benchmark_func)(benchmark* benchmark);
+
+static void runLegacy(benchmark* benchmark) {
+    legacyCheckerTexture(benchmark->pixels, benchmark->desc.width, benchmark->desc.height, 255, 0, 0, 128, 0, 0);
+}
+
+static void runScalar(benchmark* benchmark) {
+    texture_gen_rows_scalar(&benchmark->desc, benchmark->pixels, 0, benchmark->desc.height);
+}
+
+static void runFill(benchmark* benchmark) {
+    texture_gen_fill(&benchmark->desc, benchmark->pixels, benchmark->jobs);
+}
+
+static void runMips(benchmark* benchmark) {
+    texture_gen_mips(benchmark->pixels, benchmark->desc.width, benchmark->desc.height, benchmark->jobs);
+}
+
+// Upload every level of the chain, from client memory or from the pixel
+// unpack buffer currently bound (the pixel pointers are then offsets).
+static void uploadMipChain(const benchmark* benchmark, int fromBuffer) {
+    int width = benchmark->desc.width;
+    int height = benchmark->desc.height;
+    int levels = texture_gen_mip_levels(width, height);
+
+    glBindTexture(GL_TEXTURE_2D, benchmark->texture);
+    for (int level = 0; level < levels; level++) {
+        size_t offset = texture_gen_mip_offset(benchmark->desc.width, benchmark->desc.height, level);
+        GL_CHECK(glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE,
+            fromBuffer ? (const void*)offset : benchmark->pixels + offset));
+        width = width > 1 ? width / 2 : 1;
+        height = height > 1 ? height / 2 : 1;
+    }
+    glFinish();
+}
+
+static void runStagedUpload(benchmark* benchmark) {
+    runFill(benchmark);
+    runMips(benchmark);
+    uploadMipChain(benchmark, 0);
+}
+
+#if SAMPLE_OPENGL_API == SAMPLE_API_GL || SAMPLE_OPENGL_VERSION_MAJOR >= 3
+static void runMappedUpload(benchmark* benchmark) {
+    size_t size = texture_gen_mip_chain_size(benchmark->desc.width, benchmark->desc.height);
+
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, benchmark->buffer);
+    unsigned char* mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size,
+        GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+    if (mapped) {
+        unsigned char* pixels = benchmark->pixels;
+        benchmark->pixels = mapped;
+        runFill(benchmark);
+        runMips(benchmark);
+        benchmark->pixels = pixels;
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+        uploadMipChain(benchmark, 1);
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+}
+#endif
+
+// Best time out of the given number of runs.
+static double measure(benchmark_func func, benchmark* benchmark, int iterations) {
+    double best = 0.0;
+    for (int i = 0; i < iterations; i++) {
+        double start = timer_now();
+        func(benchmark);
+        double elapsed = timer_now() - start;
+        if (i == 0 || elapsed < best) {
+            best = elapsed;
+        }
+    }
+    return best;
+}
+
+static void printResult(report* report, const char* name, const char* pattern, int threads,
+                        double seconds, double megapixels, double baselineSeconds) {
+    double speedup = baselineSeconds > 0.0 ? baselineSeconds / seconds : 1.0;
+    printf("%-16s %-11s threads: %2d  %9.2f ms  %9.1f MP/s  %6.2fx\n",
+        name, pattern, threads, seconds * 1000.0, megapixels / seconds, speedup);
+
+    report_begin_object(report, NULL);
+    report_string(report, "name", name);
+    report_string(report, "pattern", pattern);
+    report_integer(report, "threads", threads);
+    report_number(report, "seconds", seconds);
+    report_number(report, "megapixels_per_second", megapixels / seconds);
+    report_number(report, "speedup", speedup);
+    report_end_object(report);
+}
+
+int main(int argc, char** argv) {
+    int size = option_int(argc, argv, "--size", 4096);
+    int iterations = option_int(argc, argv, "--iterations", 3);
+    int threadCount = option_int(argc, argv, "--threads", thread_hardware_concurrency());
+    const char* reportPath = option_string(argc, argv, "--json", NULL);
+
+    if (size < 1 || iterations < 1) {
+        fprintf(stderr, "The size and the number of iterations must be positive\n");
+        return -1;
+    }
+    if (threadCount < 1) {
+        threadCount = 1;
+    }
+
+    #if defined(OPENGL_ES_VERSION_20)
+        while (size & (size - 1)) {
+            size &= size - 1;
+        }
+    #endif
+
+    EGLDisplay display;
+    EGLConfig config;
+    EGLContext context;
+    EGLSurface surface;
+    if (initializeHeadless(&display, &config, &context, &surface, 1, 1) != 0) {
+        return -1;
+    }
+    gl_debug_install();
+
+    job_system* jobs = NULL;
+    if (threadCount > 1) {
+        jobs = job_system_create(threadCount);
+        if (!jobs) {
+            fprintf(stderr, "Failed to start %d threads\n", threadCount);
+            terminateHeadless(display, context, surface);
+            return -1;
+        }
+    }
+
+    size_t imageSize = (size_t)size * size * 4;
+    size_t chainSize = texture_gen_mip_chain_size(size, size);
+    unsigned char* reference = malloc(imageSize);
+    unsigned char* pixels = malloc(chainSize);
+    if (!reference || !pixels) {
+        fprintf(stderr, "Failed to allocate %zu bytes for the textures\n", imageSize + chainSize);
+        free(reference);
+        free(pixels);
+        if (jobs) {
+            job_system_destroy(jobs);
+        }
+        terminateHeadless(display, context, surface);
+        return -1;
+    }
+
+    double megapixels = (double)size * size / 1e6;
+    printf("Generating %dx%d textures (%s, best of %d runs)\n", size, size, texture_gen_isa(), iterations);
+
+    report* report = report_open(reportPath);
+    report_string(report, "sample", "texture-benchmark");
+    report_string(report, "isa", texture_gen_isa());
+    report_integer(report, "size", size);
+    report_begin_array(report, "results");
+
+    benchmark bench;
+    memset(&bench, 0, sizeof(bench));
+    // The checker of the legacy routine: cells of 2 pixels, starting with the
+    // darker color (an odd size ends with a cell of 1 pixel).
+    bench.desc = (texture_desc){
+        TEXTURE_PATTERN_CHECKER, size, size, { 128, 0, 0, 255 }, { 255, 0, 0, 255 }, (size + 1) / 2, 1
+    };
+
+    bench.pixels = pixels;
+    double legacySeconds = measure(runLegacy, &bench, iterations);
+
+    // A speedup over the legacy routine only means something for the same
+    // image.
+    int mismatches = 0;
+    bench.pixels = reference;
+    runScalar(&bench);
+    if (memcmp(reference, pixels, imageSize) != 0) {
+        fprintf(stderr, "The checker pattern differs from the legacy routine\n");
+        mismatches++;
+        legacySeconds = 0.0;
+    } else {
+        printResult(report, "legacy", "checker", 1, legacySeconds, megapixels, legacySeconds);
+    }
+
+    // Speedups are relative to the legacy routine for its checker, and to the
+    // scalar reference for the others.
+    pattern_case cases[] = {
+        { "checker", TEXTURE_PATTERN_CHECKER, bench.desc.cells },
+        { "checker-8px", TEXTURE_PATTERN_CHECKER, (size + CHECKER_CELL_SIZE - 1) / CHECKER_CELL_SIZE },
+        { "gradient", TEXTURE_PATTERN_GRADIENT, 1 },
+        { "noise", TEXTURE_PATTERN_NOISE, 1 }
+    };
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        bench.desc.pattern = cases[i].pattern;
+        bench.desc.cells = cases[i].cells;
+
+        bench.pixels = reference;
+        bench.jobs = NULL;
+        double scalarSeconds = measure(runScalar, &bench, iterations);
+        double baselineSeconds = i == 0 && legacySeconds > 0.0 ? legacySeconds : scalarSeconds;
+        printResult(report, "scalar", cases[i].name, 1, scalarSeconds, megapixels, baselineSeconds);
+
+        bench.pixels = pixels;
+        double simdSeconds = measure(runFill, &bench, iterations);
+        printResult(report, texture_gen_isa(), cases[i].name, 1, simdSeconds, megapixels, baselineSeconds);
+
+        bench.jobs = jobs;
+        double threadedSeconds = measure(runFill, &bench, iterations);
+        printResult(report, texture_gen_isa(), cases[i].name, threadCount, threadedSeconds, megapixels, baselineSeconds);
+
+        if (memcmp(reference, pixels, imageSize) != 0) {
+            fprintf(stderr, "The %s pattern differs from the scalar reference\n", cases[i].name);
+            mismatches++;
+        }
+    }
+
+    // The mip chain is measured in megapixels of the base level.
+    bench.jobs = NULL;
+    double mipSeconds = measure(runMips, &bench, iterations);
+    printResult(report, "mips", "noise", 1, mipSeconds, megapixels, mipSeconds);
+    bench.jobs = jobs;
+    printResult(report, "mips", "noise", threadCount, measure(runMips, &bench, iterations), megapixels, mipSeconds);
+
+    // Generation, mip chain and upload, until the GPU is done with it.
+    glGenTextures(1, &bench.texture);
+    double stagedSeconds = measure(runStagedUpload, &bench, iterations);
+    printResult(report, "staged upload", "noise", threadCount, stagedSeconds, megapixels, stagedSeconds);
+
+    #if SAMPLE_OPENGL_API == SAMPLE_API_GL || SAMPLE_OPENGL_VERSION_MAJOR >= 3
+        glGenBuffers(1, &bench.buffer);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, bench.buffer);
+        glBufferData(GL_PIXEL_UNPACK_BUFFER, chainSize, NULL, GL_STREAM_DRAW);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        printResult(report, "mapped upload", "noise", threadCount,
+            measure(runMappedUpload, &bench, iterations), megapixels, stagedSeconds);
+        glDeleteBuffers(1, &bench.buffer);
+    #endif
+    glDeleteTextures(1, &bench.texture);
+
+    report_end_array(report);
+    report_integer(report, "mismatches", mismatches);
+    report_close(report);
+
+    free(reference);
+    free(pixels);
+    if (jobs) {
+        job_system_destroy(jobs);
+    }
+
+    gl_debug_summary();
+    terminateHeadless(display, context, surface);
+
+    return mismatches == 0 ? 0 : -1;
+}
@@ -9,20 +9,68 @@
 //
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <math.h>
+#include "arena.h"
+#include "frame_pacing.h"
 #include "gl_api.h"
+#include "gl_debug.h"
+#include "gpu_memory.h"
+#include "hud.h"
 #include "matrix.h"
 #include "window.h"
+#include "options.h"
+#include "port.h"
+#include "profiler.h"
+#include "report.h"
+#include "shader.h"
+#include "startup.h"
+#include "texture_gen.h"
+#include "thread.h"
+#include "timer.h"
+#include "transform.h"
+
+#define TEXTURE_SIZE 16
+#define MAX_OBJECTS 16384
+
+// With --port, the sample is the program of an Erlang port opened with
+// {packet, 4} (see src/common/port.h), rendering headless. Every packet is a
+// batch of commands for one frame, answered once the frame is rendered (and
+// finished on the GPU). All the fields are little-endian:
+//
+//   batch     = sequence:u32 flags:u8 command*
+//   command   = 1 red:f32 green:f32 blue:f32 alpha:f32       (clear color)
+//             | 2 count:u32                                  (object count)
+//             | 3 first:u32 count:u32 transform[count]       (transforms)
+//   transform = position:f32[3] rotation:f32[4] scale:f32[3]
+//   reply     = sequence:u32 status:u8 objects:u32 frame_us:u32
+//
+// The objects are cubes, the roots of the transform hierarchy; the rotation
+// is a quaternion (x, y, z, w). A batch is checked before any of it is
+// applied, so a rejected batch changes nothing. With BATCH_NO_DRAW, the batch
+// is applied without drawing, which measures the boundary alone. frame_us is
+// the time between the batch being read and the reply being written.
+enum {
+    BATCH_CLEAR_COLOR = 1,
+    BATCH_OBJECT_COUNT = 2,
+    BATCH_TRANSFORMS = 3
+};
+
+enum {
+    BATCH_OK = 0,
+    BATCH_MALFORMED = 1,
+    BATCH_TOO_MANY_OBJECTS = 2
+};
+
+#define BATCH_NO_DRAW 0x01
+#define BATCH_HEADER_SIZE 5
+#define BATCH_TRANSFORM_SIZE (10 * 4)
+#define BATCH_REPLY_SIZE 13
 
-#define CHECKER_TEXTURE_WIDTH 16
-#define CHECKER_TEXTURE_HEIGHT 16
-
-#if defined(OPENGL_VERSION_33)
 const char* vertexShaderSource =
-    "#version 330 core\n"
-    "layout(location = 0) in vec3 vertPosition;\n"
-    "layout(location = 1) in vec2 vertTexCoord;\n"
-    "out vec2 fragTexCoord;\n"
+    "ATTRIBUTE vec3 vertPosition;\n"
+    "ATTRIBUTE vec2 vertTexCoord;\n"
+    "VARYING_OUT vec2 fragTexCoord;\n"
     "uniform mat4 mWorld;\n"
     "uniform mat4 mView;\n"
     "uniform mat4 mProj;\n"
@@ -33,230 +81,368 @@ const char* vertexShaderSource =
     "}\n";
 
 const char* fragmentShaderSource =
-    "#version 330 core\n"
-    "in vec2 fragTexCoord;\n"
-    "out vec4 FragColor;\n"
+    "VARYING_IN vec2 fragTexCoord;\n"
     "uniform sampler2D texture0;\n"
     "void main()\n"
     "{\n"
-    "    FragColor = texture(texture0, fragTexCoord);\n"
-    "}\n";
-#elif defined(OPENGL_VERSION_41)
-const char* vertexShaderSource =
-    "#version 410 core\n"
-    "layout(location = 0) in vec3 vertPosition;\n"
-    "layout(location = 1) in vec2 vertTexCoord;\n"
-    "out vec2 fragTexCoord;\n"
-    "uniform mat4 mWorld;\n"
-    "uniform mat4 mView;\n"
-    "uniform mat4 mProj;\n"
-    "void main()\n"
-    "{\n"
-    "    fragTexCoord = vertTexCoord;\n"
-    "    gl_Position = mProj * mView * mWorld * vec4(vertPosition, 1.0);\n"
+    "    FRAG_COLOR = texture(texture0, fragTexCoord);\n"
     "}\n";
 
-const char* fragmentShaderSource =
-    "#version 410 core\n"
-    "in vec2 fragTexCoord;\n"
-    "out vec4 FragColor;\n"
-    "uniform sampler2D texture0;\n"
-    "void main()\n"
-    "{\n"
-    "    FragColor = texture(texture0, fragTexCoord);\n"
-    "}\n";
-#elif defined(OPENGL_VERSION_46)
-const char* vertexShaderSource =
-    "#version 460 core\n"
-    "layout(location = 0) in vec3 vertPosition;\n"
-    "layout(location = 1) in vec2 vertTexCoord;\n"
-    "out vec2 fragTexCoord;\n"
-    "uniform mat4 mWorld;\n"
-    "uniform mat4 mView;\n"
-    "uniform mat4 mProj;\n"
-    "void main()\n"
-    "{\n"
-    "    fragTexCoord = vertTexCoord;\n"
-    "    gl_Position = mProj * mView * mWorld * vec4(vertPosition, 1.0);\n"
-    "}\n";
+const char* attributes[] = { "vertPosition", "vertTexCoord", NULL };
 
-const char* fragmentShaderSource =
-    "#version 460 core\n"
-    "in vec2 fragTexCoord;\n"
-    "out vec4 FragColor;\n"
-    "uniform sampler2D texture0;\n"
-    "void main()\n"
-    "{\n"
-    "    FragColor = texture(texture0, fragTexCoord);\n"
-    "}\n";
-#elif defined(OPENGL_ES_VERSION_20)
-const char* vertexShaderSource =
-    "#version 100\n"
-    "attribute vec3 vertPosition;\n"
-    "attribute vec2 vertTexCoord;\n"
-    "varying vec2 fragTexCoord;\n"
-    "uniform mat4 mWorld;\n"
-    "uniform mat4 mView;\n"
-    "uniform mat4 mProj;\n"
-    "void main()\n"
-    "{\n"
-    "    fragTexCoord = vertTexCoord;\n"
-    "    gl_Position = mProj * mView * mWorld * vec4(vertPosition, 1.0);\n"
-    "}\n";
+typedef struct {
+    texture_desc desc;
+    unsigned char* data;
+    int threadCount;
+} texture_job;
 
-const char* fragmentShaderSource =
-    "#version 100\n"
-    "precision mediump float;\n"
-    "varying vec2 fragTexCoord;\n"
-    "uniform sampler2D texture0;\n"
-    "void main()\n"
-    "{\n"
-    "    gl_FragColor = texture2D(texture0, fragTexCoord);\n"
-    "}\n";
-#elif defined(OPENGL_ES_VERSION_30)
-const char* vertexShaderSource =
-    "#version 300 es\n"
-    "precision mediump float;\n"
-    "layout(location = 0) in vec3 vertPosition;\n"
-    "layout(location = 1) in vec2 vertTexCoord;\n"
-    "out vec2 fragTexCoord;\n"
-    "uniform mat4 mWorld;\n"
-    "uniform mat4 mView;\n"
-    "uniform mat4 mProj;\n"
-    "void main()\n"
-    "{\n"
-    "    fragTexCoord = vertTexCoord;\n"
-    "    gl_Position = mProj * mView * mWorld * vec4(vertPosition, 1.0);\n"
-    "}\n";
+static void generateTextureJob(void* arg) {
+    texture_job* job = arg;
 
-const char* fragmentShaderSource =
-    "#version 300 es\n"
-    "precision mediump float;\n"
-    "in vec2 fragTexCoord;\n"
-    "out vec4 FragColor;\n"
-    "uniform sampler2D texture0;\n"
-    "void main()\n"
-    "{\n"
-    "    FragColor = texture(texture0, fragTexCoord);\n"
-    "}\n";
-#elif defined(OPENGL_ES_VERSION_31)
-const char* vertexShaderSource =
-    "#version 310 es\n"
-    "precision mediump float;\n"
-    "layout(location = 0) in vec3 vertPosition;\n"
-    "layout(location = 1) in vec2 vertTexCoord;\n"
-    "out vec2 fragTexCoord;\n"
-    "uniform mat4 mWorld;\n"
-    "uniform mat4 mView;\n"
-    "uniform mat4 mProj;\n"
-    "void main()\n"
-    "{\n"
-    "    fragTexCoord = vertTexCoord;\n"
-    "    gl_Position = mProj * mView * mWorld * vec4(vertPosition, 1.0);\n"
-    "}\n";
+    int phase = startup_phase_begin("texture_generate");
+    PROFILE_ZONE_BEGIN("generate_texture");
 
-const char* fragmentShaderSource =
-    "#version 310 es\n"
-    "precision mediump float;\n"
-    "in vec2 fragTexCoord;\n"
-    "out vec4 FragColor;\n"
-    "uniform sampler2D texture0;\n"
-    "void main()\n"
-    "{\n"
-    "    FragColor = texture(texture0, fragTexCoord);\n"
-    "}\n";
-#elif defined(OPENGL_ES_VERSION_32)
-const char* vertexShaderSource =
-    "#version 320 es\n"
-    "precision mediump float;\n"
-    "layout(location = 0) in vec3 vertPosition;\n"
-    "layout(location = 1) in vec2 vertTexCoord;\n"
-    "out vec2 fragTexCoord;\n"
-    "uniform mat4 mWorld;\n"
-    "uniform mat4 mView;\n"
-    "uniform mat4 mProj;\n"
-    "void main()\n"
-    "{\n"
-    "    fragTexCoord = vertTexCoord;\n"
-    "    gl_Position = mProj * mView * mWorld * vec4(vertPosition, 1.0);\n"
-    "}\n";
+    // The threads are started once for the whole chain (the texture is
+    // generated by this thread alone when they cannot be).
+    job_system* jobs = job->threadCount > 1 ? job_system_create(job->threadCount) : NULL;
+    texture_gen_fill(&job->desc, job->data, jobs);
+    texture_gen_mips(job->data, job->desc.width, job->desc.height, jobs);
+    if (jobs) {
+        job_system_destroy(jobs);
+    }
+    PROFILE_ZONE_END();
+    startup_phase_end(phase);
+}
 
-const char* fragmentShaderSource =
-    "#version 320 es\n"
-    "precision mediump float;\n"
-    "in vec2 fragTexCoord;\n"
-    "out vec4 FragColor;\n"
-    "uniform sampler2D texture0;\n"
-    "void main()\n"
-    "{\n"
-    "    FragColor = texture(texture0, fragTexCoord);\n"
-    "}\n";
-#else
-    #error "Unsupported OpenGL version."
-#endif
-
-void generateCheckerTexture(unsigned char* data, int width, int height,
-                          unsigned char r1, unsigned char g1, unsigned char b1,
-                          unsigned char r2, unsigned char g2, unsigned char b2) {
-    for (int y = 0; y < height; y++) {
-        for (int x = 0; x < width; x++) {
-            int index = (y * width + x) * 4;
-            int isAlternate = (x / 2 + y / 2) % 2;
-
-            data[index + 0] = isAlternate ? r1 : r2;
-            data[index + 1] = isAlternate ? g1 : g2;
-            data[index + 2] = isAlternate ? b1 : b2;
-            data[index + 3] = 255;
+static unsigned int readU32(const unsigned char* data) {
+    return (unsigned int)data[0] | ((unsigned int)data[1] << 8) | ((unsigned int)data[2] << 16) |
+        ((unsigned int)data[3] << 24);
+}
+
+static float readF32(const unsigned char* data) {
+    unsigned int bits = readU32(data);
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+static void writeU32(unsigned char* data, unsigned int value) {
+    data[0] = (unsigned char)value;
+    data[1] = (unsigned char)(value >> 8);
+    data[2] = (unsigned char)(value >> 16);
+    data[3] = (unsigned char)(value >> 24);
+}
+
+// The state of the scene driven through the port.
+typedef struct {
+    transform_hierarchy* objects;
+    int count;
+    float clearColor[4];
+    long long updates;
+} port_scene;
+
+// Walk the commands of a batch, either to check them or to apply them
+// (once checked). Returns the status of the batch.
+static int walkBatch(port_scene* scene, const unsigned char* data, size_t size, int apply) {
+    size_t offset = BATCH_HEADER_SIZE;
+    while (offset < size) {
+        int command = data[offset++];
+        size_t left = size - offset;
+        if (command == BATCH_CLEAR_COLOR) {
+            if (left < 4 * 4) {
+                return BATCH_MALFORMED;
+            }
+            if (apply) {
+                for (int i = 0; i < 4; i++) {
+                    scene->clearColor[i] = readF32(data + offset + i * 4);
+                }
+            }
+            offset += 4 * 4;
+        } else if (command == BATCH_OBJECT_COUNT) {
+            if (left < 4) {
+                return BATCH_MALFORMED;
+            }
+            unsigned int count = readU32(data + offset);
+            if (count > (unsigned int)scene->objects->count) {
+                return BATCH_TOO_MANY_OBJECTS;
+            }
+            if (apply) {
+                scene->count = (int)count;
+            }
+            offset += 4;
+        } else if (command == BATCH_TRANSFORMS) {
+            if (left < 2 * 4) {
+                return BATCH_MALFORMED;
+            }
+            unsigned int first = readU32(data + offset);
+            unsigned int count = readU32(data + offset + 4);
+            offset += 2 * 4;
+            if (count > (size - offset) / BATCH_TRANSFORM_SIZE) {
+                return BATCH_MALFORMED;
+            }
+            if (first > (unsigned int)scene->objects->count || count > (unsigned int)scene->objects->count - first) {
+                return BATCH_TOO_MANY_OBJECTS;
+            }
+            if (apply) {
+                const unsigned char* transform = data + offset;
+                for (unsigned int i = 0; i < count; i++) {
+                    int node = (int)(first + i);
+                    quat rotation = {
+                        readF32(transform + 12), readF32(transform + 16), readF32(transform + 20), readF32(transform + 24)
+                    };
+                    transform_set_position(scene->objects, node,
+                        readF32(transform), readF32(transform + 4), readF32(transform + 8));
+                    transform_set_rotation(scene->objects, node, rotation);
+                    transform_set_scale(scene->objects, node,
+                        readF32(transform + 28), readF32(transform + 32), readF32(transform + 36));
+                    transform += BATCH_TRANSFORM_SIZE;
+                }
+                scene->updates += count;
+            }
+            offset += (size_t)count * BATCH_TRANSFORM_SIZE;
+        } else {
+            return BATCH_MALFORMED;
         }
     }
+    return BATCH_OK;
+}
+
+// Render the batches read from the port until it is closed. Returns -1 when
+// the port failed.
+static int runPort(port* port, transform_hierarchy* objects, GLint worldUniform) {
+    port_scene scene = {
+        .objects = objects,
+        .count = 1,
+        .clearColor = { 0.75f, 0.85f, 0.8f, 1.0f }
+    };
+    long long batches = 0;
+    long long rejected = 0;
+    long long drawn = 0;
+    double busyTime = 0.0;
+
+    const unsigned char* data;
+    size_t size;
+    int result;
+    while ((result = port_read(port, &data, &size)) == 1) {
+        double start = timer_now();
+        PROFILE_ZONE_BEGIN("frame");
+        unsigned int sequence = size >= 4 ? readU32(data) : 0;
+        int flags = size >= BATCH_HEADER_SIZE ? data[4] : 0;
+
+        PROFILE_ZONE_BEGIN("update");
+        int status = size >= BATCH_HEADER_SIZE ? walkBatch(&scene, data, size, 0) : BATCH_MALFORMED;
+        if (status == BATCH_OK) {
+            walkBatch(&scene, data, size, 1);
+            transform_update(objects);
+        } else {
+            rejected++;
+        }
+        PROFILE_ZONE_END();
+
+        if (status == BATCH_OK && !(flags & BATCH_NO_DRAW)) {
+            PROFILE_GPU_ZONE_BEGIN("frame");
+            glClearColor(scene.clearColor[0], scene.clearColor[1], scene.clearColor[2], scene.clearColor[3]);
+            GL_CHECK(glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT));
+
+            PROFILE_ZONE_BEGIN("draw");
+            PROFILE_GPU_ZONE_BEGIN("draw");
+            for (int i = 0; i < scene.count; i++) {
+                glUniformMatrix4fv(worldUniform, 1, GL_FALSE, transform_world(objects, i));
+                glDrawElements(GL_TRIANGLES, 36, GL_UNSIGNED_SHORT, 0);
+            }
+            PROFILE_GPU_ZONE_END();
+            PROFILE_ZONE_END();
+            PROFILE_GPU_ZONE_END();
+
+            // The reply tells the frame is done, not only submitted, so the
+            // round trip seen by the other end includes the GPU.
+            PROFILE_ZONE_BEGIN("glFinish");
+            GL_CHECK(glFinish());
+            PROFILE_ZONE_END();
+            profiler_gpu_collect();
+            drawn += scene.count;
+        }
+
+        double busy = timer_now() - start;
+        unsigned char reply[BATCH_REPLY_SIZE];
+        writeU32(reply, sequence);
+        reply[4] = (unsigned char)status;
+        writeU32(reply + 5, (unsigned int)scene.count);
+        writeU32(reply + 9, (unsigned int)(busy * 1e6));
+        PROFILE_ZONE_END();
+        if (port_write(port, reply, sizeof(reply)) != 0) {
+            result = -1;
+            break;
+        }
+        busyTime += busy;
+        batches++;
+    }
+
+    // The standard output is the standard error by now.
+    printf("Port: %lld batches (%lld rejected), %.1f MiB read, %lld transforms updated, %lld objects drawn\n",
+        batches, rejected, port->bytesRead / (1024.0 * 1024.0), scene.updates, drawn);
+    if (batches > 0) {
+        printf("  %.3f ms/batch between reading it and replying\n", busyTime * 1000.0 / (double)batches);
+    }
+    return result < 0 ? -1 : 0;
 }
 
-int main() {
+// Delete the GL objects of the cube, at exit or when the setup fails part
+// way (the objects not created yet are 0).
+static void deleteResources(GLuint program, GLuint texture, GLuint VBO, GLuint EBO, GLuint VAO, GLuint PBO) {
+    gpu_memory_untrack(GPU_MEMORY_TEXTURE, texture);
+    gpu_memory_untrack(GPU_MEMORY_BUFFER, VBO);
+    gpu_memory_untrack(GPU_MEMORY_BUFFER, EBO);
+    gpu_memory_untrack(GPU_MEMORY_BUFFER, PBO);
+    glDeleteTextures(1, &texture);
+    glDeleteProgram(program);
+    glDeleteBuffers(1, &VBO);
+    glDeleteBuffers(1, &EBO);
+    #if SAMPLE_OPENGL_API == SAMPLE_API_GL || SAMPLE_OPENGL_VERSION_MAJOR >= 3
+        // Deleting a mapped buffer unmaps it.
+        glDeleteBuffers(1, &PBO);
+        glDeleteVertexArrays(1, &VAO);
+    #else
+        (void)VAO;
+    #endif
+}
+
+// The context is either the one of a window, or the headless one of the port
+// (port is NULL without it).
+static void terminate(GLFWwindow* window, EGLDisplay display, EGLContext context, EGLSurface surface, port* port) {
+    if (window) {
+        terminateWindow(window);
+    } else {
+        terminateHeadless(display, context, surface);
+    }
+    if (port) {
+        port_close(port);
+    }
+}
+
+int main(int argc, char** argv) {
+    startup_begin();
+
     const float pi = 3.14159265358979323846f;
-    GLFWwindow* window;
+    const char* reportPath = option_string(argc, argv, "--json", NULL);
+    const char* tracePath = option_string(argc, argv, "--trace", NULL);
+    const char* texturePattern = option_string(argc, argv, "--pattern", "checker");
+    int textureSize = option_int(argc, argv, "--texture-size", TEXTURE_SIZE);
+    int useHud = option_flag(argc, argv, "--hud");
+    const char* swapInterval = option_string(argc, argv, "--swap-interval", "1");
+    double targetRate = option_double(argc, argv, "--fps", 0.0);
+    const char* pacingLogPath = option_string(argc, argv, "--pacing-log", NULL);
+    int usePort = option_flag(argc, argv, "--port");
+    int maxObjects = option_int(argc, argv, "--max-objects", MAX_OBJECTS);
+    frame_swap_mode swapMode;
+    if (frame_swap_mode_parse(swapInterval, &swapMode) != 0) {
+        fprintf(stderr, "The swap interval must be 0, 1 or adaptive\n");
+        return -1;
+    }
+    if (textureSize < 1) {
+        textureSize = TEXTURE_SIZE;
+    }
+    if (maxObjects < 1) {
+        fprintf(stderr, "The maximum number of objects must be positive\n");
+        return -1;
+    }
+
+    // OpenGL ES 2.0 only supports mipmaps and GL_REPEAT on power of two
+    // textures.
+    #if defined(OPENGL_ES_VERSION_20)
+        while (textureSize & (textureSize - 1)) {
+            textureSize &= textureSize - 1;
+        }
+    #endif
+    PROFILE_THREAD_NAME("main");
+    GLFWwindow* window = NULL;
     EGLDisplay display;
+    EGLConfig config;
     EGLContext context;
     EGLSurface surface;
-    if (initializeWindow(&window, &display, &context, &surface, 640, 480, "Erlangsters - Textured Cube") != 0) {
+    port port;
+    if (usePort) {
+        // Before anything is printed to the standard output.
+        if (port_open(&port) != 0) {
+            fprintf(stderr, "Failed to take over the standard output\n");
+            return -1;
+        }
+        if (initializeHeadless(&display, &config, &context, &surface, 640, 480) != 0) {
+            port_close(&port);
+            return -1;
+        }
+        // The port draws its frames, not the HUD.
+        useHud = 0;
+    } else if (initializeWindow(&window, &display, &context, &surface, 640, 480, "Erlangsters - Textured Cube") != 0) {
         return -1;
     }
+    gl_debug_install();
+    profiler_gpu_init();
 
-    GLuint vertexShader = glCreateShader(GL_VERTEX_SHADER);
-    glShaderSource(vertexShader, 1, &vertexShaderSource, NULL);
-    glCompileShader(vertexShader);
-
-    GLint success;
-    GLchar infoLog[512];
-    glGetShaderiv(vertexShader, GL_COMPILE_STATUS, &success);
-    if (!success) {
-        glGetShaderInfoLog(vertexShader, 512, NULL, infoLog);
-        printf("Vertex shader compilation failed: %s\n", infoLog);
-        return -1;
+    texture_job textureJob = {
+        { TEXTURE_PATTERN_CHECKER, textureSize, textureSize, { 128, 0, 0, 255 }, { 255, 0, 0, 255 }, 8, 0 },
+        NULL,
+        thread_hardware_concurrency()
+    };
+    if (strcmp(texturePattern, "gradient") == 0) {
+        textureJob.desc.pattern = TEXTURE_PATTERN_GRADIENT;
+    } else if (strcmp(texturePattern, "noise") == 0) {
+        textureJob.desc.pattern = TEXTURE_PATTERN_NOISE;
     }
 
-    GLuint fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(fragmentShader, 1, &fragmentShaderSource, NULL);
-    glCompileShader(fragmentShader);
+    int textureLevels = texture_gen_mip_levels(textureSize, textureSize);
+    size_t textureBytes = texture_gen_mip_chain_size(textureSize, textureSize);
+
+    // The texture and its mip chain are generated on the CPU while the
+    // shaders compile, straight into a mapped pixel unpack buffer when
+    // available.
+    int textureMapped = 0;
+    GLuint PBO = 0;
+    #if SAMPLE_OPENGL_API == SAMPLE_API_GL || SAMPLE_OPENGL_VERSION_MAJOR >= 3
+        glGenBuffers(1, &PBO);
+        GL_CHECK(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, PBO));
+        GL_CHECK(glBufferData(GL_PIXEL_UNPACK_BUFFER, textureBytes, NULL, GL_STREAM_DRAW));
+        gpu_memory_track(GPU_MEMORY_BUFFER, PBO, textureBytes);
+        textureJob.data = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, textureBytes,
+            GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+        textureMapped = textureJob.data != NULL;
+        GL_CHECK(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0));
+    #endif
 
-    glGetShaderiv(fragmentShader, GL_COMPILE_STATUS, &success);
-    if (!success) {
-        glGetShaderInfoLog(fragmentShader, 512, NULL, infoLog);
-        printf("Fragment shader compilation failed: %s\n", infoLog);
-        return -1;
+    // Otherwise, the texture is staged in an arena like the rest of the
+    // transient CPU-side data, which is reset once the data reached the GPU.
+    // Nothing else goes through it, so it is left empty when the buffer is
+    // mapped.
+    arena staging = { 0 };
+    if (!textureMapped) {
+        if (arena_init(&staging, textureBytes) != 0) {
+            fprintf(stderr, "Failed to allocate %zu bytes of staging memory\n", textureBytes);
+            deleteResources(0, 0, 0, 0, 0, PBO);
+            terminate(window, display, context, surface, usePort ? &port : NULL);
+            return -1;
+        }
+        textureJob.data = arena_alloc(&staging, textureBytes, 16);
     }
 
-    GLuint shaderProgram = glCreateProgram();
-    glAttachShader(shaderProgram, vertexShader);
-    glAttachShader(shaderProgram, fragmentShader);
-    glLinkProgram(shaderProgram);
-
-    glGetProgramiv(shaderProgram, GL_LINK_STATUS, &success);
-    if (!success) {
-        glGetProgramInfoLog(shaderProgram, 512, NULL, infoLog);
-        printf("Shader program linking failed: %s\n", infoLog);
-        return -1;
-    }
+    thread_t textureThread;
+    int textureThreaded = thread_create(&textureThread, generateTextureJob, &textureJob) == 0;
+
+    // The program is only waited for once the resources are uploaded, so
+    // drivers that compile in the background overlap both. The attribute
+    // locations are bound, so the vertex layout does not need the program.
+    int shaderPhase = startup_phase_begin("shader_compile");
+    shader_program program = {
+        .label = "Textured cube program",
+        .vertex = vertexShaderSource,
+        .fragment = fragmentShaderSource,
+        .attributes = attributes
+    };
+    PROFILE_ZONE_BEGIN("shader_submit");
+    shader_submit(&program, 1);
+    PROFILE_ZONE_END();
 
+    int phase = startup_phase_begin("resource_upload");
+    PROFILE_ZONE_BEGIN("resource_upload");
     float vertices[] = {
         // Format: X, Y, Z, U, V
         // Top
@@ -305,62 +491,125 @@ int main() {
         21, 20, 22, 22, 20, 23  // Bottom
     };
 
+    // Core profiles require a vertex array object to be bound.
+    GLuint VAO = 0;
+    #if SAMPLE_OPENGL_API == SAMPLE_API_GL || SAMPLE_OPENGL_VERSION_MAJOR >= 3
+        glGenVertexArrays(1, &VAO);
+        glBindVertexArray(VAO);
+    #endif
+
     GLuint VBO, EBO;
     glGenBuffers(1, &VBO);
     glGenBuffers(1, &EBO);
 
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+    GL_CHECK(glBindBuffer(GL_ARRAY_BUFFER, VBO));
+    GL_CHECK(glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW));
+    gpu_memory_track(GPU_MEMORY_BUFFER, VBO, sizeof(vertices));
+    gl_debug_label(GL_BUFFER, VBO, "Cube vertices");
 
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
+    GL_CHECK(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO));
+    GL_CHECK(glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW));
+    gpu_memory_track(GPU_MEMORY_BUFFER, EBO, sizeof(indices));
+    gl_debug_label(GL_BUFFER, EBO, "Cube indices");
 
     GLuint texture;
     glGenTextures(1, &texture);
-    glBindTexture(GL_TEXTURE_2D, texture);
-
-    unsigned char textureData[CHECKER_TEXTURE_WIDTH * CHECKER_TEXTURE_HEIGHT * 4];
-    generateCheckerTexture(textureData, CHECKER_TEXTURE_WIDTH, CHECKER_TEXTURE_HEIGHT, 255, 0, 0, 128, 0, 0);
-
-    glTexImage2D(
-        GL_TEXTURE_2D,
-        0,
-        GL_RGBA,
-        CHECKER_TEXTURE_WIDTH,
-        CHECKER_TEXTURE_HEIGHT,
-        0,
-        GL_RGBA,
-        GL_UNSIGNED_BYTE,
-        textureData
-    );
+    GL_CHECK(glBindTexture(GL_TEXTURE_2D, texture));
+    gl_debug_label(GL_TEXTURE, texture, "Procedural texture");
 
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    if (textureThreaded) {
+        thread_join(textureThread);
+    } else {
+        generateTextureJob(&textureJob);
+    }
 
-    GLint posAttrib = 0;
-    GLint texCoordAttrib = 1;
-    #if defined(OPENGL_ES_VERSION_20)
-        posAttrib = glGetAttribLocation(shaderProgram, "vertPosition");
-        texCoordAttrib = glGetAttribLocation(shaderProgram, "vertTexCoord");
+    // With a pixel unpack buffer bound, the pixel pointers given to
+    // glTexImage2D() are offsets into the buffer.
+    #if SAMPLE_OPENGL_API == SAMPLE_API_GL || SAMPLE_OPENGL_VERSION_MAJOR >= 3
+        if (textureMapped) {
+            GL_CHECK(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, PBO));
+            GL_CHECK(glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER));
+        }
+    #endif
+
+    int levelSize = textureSize;
+    for (int level = 0; level < textureLevels; level++) {
+        size_t offset = texture_gen_mip_offset(textureSize, textureSize, level);
+        GL_CHECK(glTexImage2D(
+            GL_TEXTURE_2D,
+            level,
+            GL_RGBA,
+            levelSize,
+            levelSize,
+            0,
+            GL_RGBA,
+            GL_UNSIGNED_BYTE,
+            textureMapped ? (const void*)offset : textureJob.data + offset
+        ));
+        levelSize = levelSize > 1 ? levelSize / 2 : 1;
+    }
+    gpu_memory_track(GPU_MEMORY_TEXTURE, texture,
+        gpu_memory_texture_size(GL_RGBA, GL_UNSIGNED_BYTE, textureSize, textureSize, 1, textureLevels));
+
+    #if SAMPLE_OPENGL_API == SAMPLE_API_GL || SAMPLE_OPENGL_VERSION_MAJOR >= 3
+        GL_CHECK(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0));
+        gpu_memory_untrack(GPU_MEMORY_BUFFER, PBO);
+        glDeleteBuffers(1, &PBO);
+        PBO = 0;
     #endif
+    arena_reset(&staging);
 
-    glVertexAttribPointer(posAttrib, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), 0);
-    glVertexAttribPointer(texCoordAttrib, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(3 * sizeof(float)));
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
 
-    glEnableVertexAttribArray(posAttrib);
-    glEnableVertexAttribArray(texCoordAttrib);
+    GL_CHECK(glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), 0));
+    GL_CHECK(glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(3 * sizeof(float))));
+
+    GL_CHECK(glEnableVertexAttribArray(0));
+    GL_CHECK(glEnableVertexAttribArray(1));
+    PROFILE_ZONE_END();
+    startup_phase_end(phase);
+
+    PROFILE_ZONE_BEGIN("shader_finish");
+    int shaderPending = shader_pending(&program, 1);
+    int shaderFailures = shader_finish(&program, 1);
+    PROFILE_ZONE_END();
+    startup_phase_end(shaderPhase);
+    if (shaderFailures > 0) {
+        deleteResources(program.program, texture, VBO, EBO, VAO, PBO);
+        arena_destroy(&staging);
+        terminate(window, display, context, surface, usePort ? &port : NULL);
+        return -1;
+    }
+    GLuint shaderProgram = program.program;
 
+    phase = startup_phase_begin("scene_setup");
+    PROFILE_ZONE_BEGIN("scene_setup");
     GLint worldUniform = glGetUniformLocation(shaderProgram, "mWorld");
     GLint viewUniform = glGetUniformLocation(shaderProgram, "mView");
     GLint projUniform = glGetUniformLocation(shaderProgram, "mProj");
     GLint textureUniform = glGetUniformLocation(shaderProgram, "texture0");
 
-    mat4 world, view, proj;
-    mat4 rotatedY;
+    // The cube is the single node of its scene, except for the port which
+    // drives up to --max-objects cubes, all roots.
+    int objectCount = usePort ? maxObjects : 1;
+    transform_hierarchy scene;
+    if (transform_init(&scene, objectCount) != 0) {
+        fprintf(stderr, "Failed to allocate the scene of %d objects\n", objectCount);
+        deleteResources(shaderProgram, texture, VBO, EBO, VAO, PBO);
+        arena_destroy(&staging);
+        terminate(window, display, context, surface, usePort ? &port : NULL);
+        return -1;
+    }
+    int cube = transform_add(&scene, TRANSFORM_NO_PARENT);
+    for (int i = 1; i < objectCount; i++) {
+        transform_add(&scene, TRANSFORM_NO_PARENT);
+    }
+    transform_update(&scene);
 
-    mat4_identity(world);
+    mat4 view, proj;
     mat4_look_at(view,
         0, 0, -8,
         0, 0, 0,
@@ -379,40 +628,142 @@ int main() {
     glFrontFace(GL_CCW);
     glCullFace(GL_BACK);
 
-    glUseProgram(shaderProgram);
-    glUniform1i(textureUniform, 0);
+    GL_CHECK(glUseProgram(shaderProgram));
+    GL_CHECK(glUniform1i(textureUniform, 0));
 
-    glUniformMatrix4fv(worldUniform, 1, GL_FALSE, (float*)world);
+    glUniformMatrix4fv(worldUniform, 1, GL_FALSE, transform_world(&scene, cube));
     glUniformMatrix4fv(viewUniform, 1, GL_FALSE, (float*)view);
     glUniformMatrix4fv(projUniform, 1, GL_FALSE, (float*)proj);
 
-    while (!glfwWindowShouldClose(window)) {
-        double currentTime = glfwGetTime();
-        float angle = (float)currentTime;
-
-        mat4_identity(world);
-        mat4_rotate_y(rotatedY, world, angle);
-        mat4_rotate_x(world, rotatedY, angle * 0.25f);
-
-        glClearColor(0.75f, 0.85f, 0.8f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    static hud overlay;
+    if (useHud && hud_init(&overlay, 640, 480) != 0) {
+        useHud = 0;
+    }
 
-        glUniformMatrix4fv(worldUniform, 1, GL_FALSE, (float*)world);
+    // The frames of the port are paced by its batches.
+    frame_pacer pacer;
+    if (!usePort) {
+        GLFWmonitor* monitor = glfwGetPrimaryMonitor();
+        const GLFWvidmode* videoMode = monitor ? glfwGetVideoMode(monitor) : NULL;
+        frame_pacer_init(&pacer, display, surface, swapMode, targetRate, videoMode ? videoMode->refreshRate : 0.0,
+            pacingLogPath);
+    }
+    PROFILE_ZONE_END();
+    startup_phase_end(phase);
 
-        glDrawElements(GL_TRIANGLES, 36, GL_UNSIGNED_SHORT, 0);
+    int exitCode = 0;
+    if (usePort) {
+        if (runPort(&port, &scene, worldUniform) != 0) {
+            exitCode = -1;
+        }
+    } else {
+        int firstFramePhase = startup_phase_begin("first_frame");
+        double previousTime = glfwGetTime();
+        while (!glfwWindowShouldClose(window)) {
+            frame_pacer_begin(&pacer);
+            PROFILE_ZONE_BEGIN("frame");
+            PROFILE_GPU_ZONE_BEGIN("frame");
+
+            double currentTime = glfwGetTime();
+            float angle = (float)currentTime;
+
+            PROFILE_ZONE_BEGIN("update");
+            quat spinY, spinX, rotation;
+            quat_from_axis_angle(spinY, 0.0f, 1.0f, 0.0f, -angle);
+            quat_from_axis_angle(spinX, 1.0f, 0.0f, 0.0f, -angle * 0.25f);
+            quat_multiply(rotation, spinX, spinY);
+            transform_set_rotation(&scene, cube, rotation);
+            transform_update(&scene);
+            PROFILE_ZONE_END();
+
+            gl_debug_push_group("Clear");
+            PROFILE_GPU_ZONE_BEGIN("clear");
+            glClearColor(0.75f, 0.85f, 0.8f, 1.0f);
+            GL_CHECK(glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT));
+            PROFILE_GPU_ZONE_END();
+            gl_debug_pop_group();
+
+            gl_debug_push_group("Cube");
+            if (useHud) {
+                // The HUD binds its own program, texture and vertex arrays.
+                glUseProgram(shaderProgram);
+                glBindTexture(GL_TEXTURE_2D, texture);
+                #if SAMPLE_OPENGL_API == SAMPLE_API_GL || SAMPLE_OPENGL_VERSION_MAJOR >= 3
+                    glBindVertexArray(VAO);
+                #else
+                    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+                    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), 0);
+                    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(3 * sizeof(float)));
+                    glDisableVertexAttribArray(2);
+                #endif
+            }
+            PROFILE_ZONE_BEGIN("uniform_upload");
+            GL_CHECK(glUniformMatrix4fv(worldUniform, 1, GL_FALSE, transform_world(&scene, cube)));
+            PROFILE_ZONE_END();
+
+            PROFILE_ZONE_BEGIN("draw");
+            PROFILE_GPU_ZONE_BEGIN("draw");
+            GL_CHECK(glDrawElements(GL_TRIANGLES, 36, GL_UNSIGNED_SHORT, 0));
+            PROFILE_GPU_ZONE_END();
+            PROFILE_ZONE_END();
+            gl_debug_pop_group();
+
+            if (useHud) {
+                hud_printf(&overlay, "Texture: %s, %dx%d", texturePattern, textureSize, textureSize);
+                hud_printf(&overlay, "Latency: %.2f ms, jitter: %.2f ms", pacer.lastLatency * 1000.0,
+                    frame_pacer_jitter(&pacer));
+                hud_draw(&overlay, currentTime - previousTime, 1);
+            }
+            previousTime = currentTime;
+
+            PROFILE_GPU_ZONE_END();
+            frame_pacer_present(&pacer);
+            profiler_gpu_collect();
+            PROFILE_ZONE_END();
+
+            if (firstFramePhase >= 0) {
+                startup_phase_end(firstFramePhase);
+                firstFramePhase = -1;
+
+                startup_print();
+                printf("Parallel shader compilation: %s (%s when the upload was done)\n",
+                    shader_parallel_compile() ? "yes" : "no", shaderPending > 0 ? "still compiling" : "compiled");
+                gpu_memory_print();
+                printf("Staging arena peak: %.1f KiB\n", staging.peak / 1024.0);
+
+                report* report = report_open(reportPath);
+                report_string(report, "sample", "textured-cube");
+                report_integer(report, "texture_size", textureSize);
+                report_string(report, "texture_pattern", texturePattern);
+                startup_report(report);
+                report_integer(report, "parallel_shader_compile", shader_parallel_compile());
+                report_integer(report, "shader_pending_after_upload", shaderPending);
+                gpu_memory_report(report);
+                report_integer(report, "staging_peak_bytes", (long long)staging.peak);
+                report_close(report);
+            }
+
+            glfwPollEvents();
+        }
 
-        eglSwapBuffers(display, surface);
-        glfwPollEvents();
+        frame_pacer_print(&pacer);
+        frame_pacer_destroy(&pacer);
     }
+    if (useHud) {
+        printf("HUD: %.3f ms/frame on the CPU\n", hud_average_cost(&overlay));
+        hud_destroy(&overlay);
+    }
+    deleteResources(shaderProgram, texture, VBO, EBO, VAO, PBO);
 
-    glDeleteTextures(1, &texture);
-    glDeleteShader(vertexShader);
-    glDeleteShader(fragmentShader);
-    glDeleteProgram(shaderProgram);
-    glDeleteBuffers(1, &VBO);
-    glDeleteBuffers(1, &EBO);
+    arena_destroy(&staging);
+    transform_destroy(&scene);
 
-    terminateWindow(window);
+    gl_debug_summary();
+    profiler_gpu_shutdown();
+    if (tracePath) {
+        profiler_write_trace(tracePath);
+    }
+    terminate(window, display, context, surface, usePort ? &port : NULL);
 
-    return 0;
+    return exitCode;
 }
@@ -0,0 +1,526 @@
+//
+// Copyright (c) 2025, Byteplug LLC.
+//
+// This source file is part of a project made by the Erlangsters community and
+// is released under the MIT license. Please refer to the LICENSE.md file that
+// can be found at the root of the project repository.
+//
+// Written by Jonathan De Wachter <jonathan.dewachter@byteplug.io>
+//
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "gl_api.h"
+#include "gl_debug.h"
+#include "gpu_memory.h"
+#include "matrix.h"
+#include "transform.h"
+#include "window.h"
+#include "options.h"
+#include "profiler.h"
+#include "report.h"
+#include "shader.h"
+#include "timer.h"
+
+// A grid of planetary systems (a sun, its planets, their moons and the
+// rocks around them) where a fraction of the systems turn every frame. The
+// world matrices are computed three ways:
+//
+// - "pointers": every node is allocated on its own and points to its parent
+//   and children; the trees are walked every frame and the matrices gathered
+//   into one array for the upload.
+// - "soa-all": the nodes are in a transform_hierarchy, and every matrix is
+//   recomputed every frame.
+// - "soa-dirty": the same, but only the turning systems are recomputed.
+//
+// The world matrices are uploaded as is and drawn as points: the position,
+// the size and the color of a point are read from the columns of its
+// matrix.
+
+#define PLANETS 6
+#define MOONS 4
+#define ROCKS 4
+#define NODES_PER_SYSTEM (1 + PLANETS + PLANETS * MOONS + PLANETS * MOONS * ROCKS)
+
+#define SYSTEM_SPACING 30.0f
+#define FIELD_OF_VIEW 60.0f
+
+#define ATTRIB_AXIS_X 0
+#define ATTRIB_AXIS_Y 1
+#define ATTRIB_POSITION 2
+
+static const char* vertexSource =
+    "ATTRIBUTE vec3 worldAxisX;\n"
+    "ATTRIBUTE vec3 worldAxisY;\n"
+    "ATTRIBUTE vec3 worldPosition;\n"
+    "VARYING_OUT vec3 fragColor;\n"
+    "uniform mat4 mViewProj;\n"
+    "uniform float pointScale;\n"
+    "void main() {\n"
+    "    fragColor = 0.3 + 0.7 * abs(normalize(worldAxisY));\n"
+    "    gl_Position = mViewProj * vec4(worldPosition, 1.0);\n"
+    "    gl_PointSize = clamp(length(worldAxisX) * pointScale / gl_Position.w, 1.0, 16.0);\n"
+    "}\n";
+
+static const char* fragmentSource =
+    "VARYING_IN vec3 fragColor;\n"
+    "void main() {\n"
+    "    FRAG_COLOR = vec4(fragColor, 1.0);\n"
+    "}\n";
+
+static const char* attributes[] = { "worldAxisX", "worldAxisY", "worldPosition", NULL };
+
+typedef enum {
+    MODE_POINTERS,
+    MODE_SOA_ALL,
+    MODE_SOA_DIRTY,
+    MODE_COUNT
+} hierarchy_mode;
+
+static const char* modeNames[MODE_COUNT] = { "pointers", "soa-all", "soa-dirty" };
+
+// A node of the pointer based scene graph.
+typedef struct node {
+    float position[3];
+    quat rotation;
+    float scale[3];
+    mat4 world;
+    struct node* parent;
+    struct node** children;
+    int childCount;
+} node;
+
+// What turns in a system: the sun, the planets and the moons, each at its
+// own speed.
+typedef struct {
+    int index;  // In the hierarchy (and in the node array).
+    float speed;
+} spinner;
+
+typedef struct {
+    int systemCount;
+    int nodeCount;
+    float* worlds;  // Gathered world matrices of the pointer scene graph.
+
+    transform_hierarchy hierarchy;
+    node** nodes;  // In the order of the hierarchy.
+    int spinnerCount;
+    spinner* spinners;
+
+    GLuint program;
+    GLint viewProjLocation;
+    GLint pointScaleLocation;
+    GLuint vbo;
+    #if SAMPLE_OPENGL_API == SAMPLE_API_GL || SAMPLE_OPENGL_VERSION_MAJOR >= 3
+        GLuint vao;
+    #endif
+} scene;
+
+typedef struct {
+    long long frames;
+    double seconds;
+    double updateSeconds;
+    double computed;
+} mode_stats;
+
+static float randomFloat(unsigned int* state) {
+    *state = *state * 1664525u + 1013904223u;
+    return (float)(*state >> 8) / 16777216.0f;
+}
+
+// Add a node orbiting its parent at the given distance, with a random
+// orientation.
+static int addBody(transform_hierarchy* hierarchy, int parent, float distance, float scale, unsigned int* state) {
+    const float pi = 3.14159265358979323846f;
+    int body = transform_add(hierarchy, parent);
+    float angle = randomFloat(state) * 2.0f * pi;
+    quat rotation;
+    quat_from_axis_angle(rotation, 0.0f, 1.0f, 0.0f, randomFloat(state) * 2.0f * pi);
+    transform_set_position(hierarchy, body, cosf(angle) * distance, (randomFloat(state) - 0.5f) * distance * 0.2f,
+        sinf(angle) * distance);
+    transform_set_rotation(hierarchy, body, rotation);
+    transform_set_scale(hierarchy, body, scale, scale, scale);
+    return body;
+}
+
+// Build the systems in the hierarchy, and the same scene graph out of
+// individually allocated nodes. The nodes are allocated in a random order,
+// as they would be in a long-running application.
+static int buildSystems(scene* scene, int grid, double animated) {
+    transform_hierarchy* hierarchy = &scene->hierarchy;
+    scene->systemCount = grid * grid;
+    scene->nodeCount = scene->systemCount * NODES_PER_SYSTEM;
+    if (transform_init(hierarchy, scene->nodeCount) != 0) {
+        return -1;
+    }
+
+    int animatedSystems = (int)(scene->systemCount * animated + 0.5);
+    scene->spinners = malloc((size_t)scene->systemCount * (1 + PLANETS + PLANETS * MOONS) * sizeof(spinner));
+    scene->worlds = malloc((size_t)scene->nodeCount * 16 * sizeof(float));
+    scene->nodes = calloc((size_t)scene->nodeCount, sizeof(node*));
+    if (!scene->spinners || !scene->worlds || !scene->nodes) {
+        return -1;
+    }
+
+    unsigned int state = 7;
+    for (int system = 0; system < scene->systemCount; system++) {
+        // Spread the turning systems over the grid.
+        int spins = (int)((long long)(system + 1) * animatedSystems / scene->systemCount) !=
+                    (int)((long long)system * animatedSystems / scene->systemCount);
+
+        int sun = transform_add(hierarchy, TRANSFORM_NO_PARENT);
+        transform_set_position(hierarchy, sun,
+            ((float)(system % grid) - (float)(grid - 1) * 0.5f) * SYSTEM_SPACING, 0.0f,
+            ((float)(system / grid) - (float)(grid - 1) * 0.5f) * SYSTEM_SPACING);
+        transform_set_scale(hierarchy, sun, 2.0f, 2.0f, 2.0f);
+        if (spins) {
+            scene->spinners[scene->spinnerCount++] = (spinner){ sun, 0.1f + randomFloat(&state) * 0.2f };
+        }
+
+        for (int p = 0; p < PLANETS; p++) {
+            int planet = addBody(hierarchy, sun, 2.0f + (float)p * 0.6f, 0.4f, &state);
+            if (spins) {
+                scene->spinners[scene->spinnerCount++] = (spinner){ planet, 0.5f + randomFloat(&state) };
+            }
+            for (int m = 0; m < MOONS; m++) {
+                int moon = addBody(hierarchy, planet, 2.0f + (float)m * 0.4f, 0.4f, &state);
+                if (spins) {
+                    scene->spinners[scene->spinnerCount++] = (spinner){ moon, 1.0f + randomFloat(&state) * 2.0f };
+                }
+                for (int r = 0; r < ROCKS; r++) {
+                    addBody(hierarchy, moon, 1.5f + (float)r * 0.3f, 0.5f, &state);
+                }
+            }
+        }
+    }
+
+    // Allocate the nodes of the pointer scene graph in a shuffled order.
+    int* order = malloc((size_t)scene->nodeCount * sizeof(int));
+    int* childCounts = calloc((size_t)scene->nodeCount, sizeof(int));
+    if (!order || !childCounts) {
+        free(order);
+        free(childCounts);
+        return -1;
+    }
+    for (int i = 0; i < scene->nodeCount; i++) {
+        order[i] = i;
+    }
+    for (int i = scene->nodeCount - 1; i > 0; i--) {
+        int j = (int)(randomFloat(&state) * (float)(i + 1)) % (i + 1);
+        int swap = order[i];
+        order[i] = order[j];
+        order[j] = swap;
+    }
+    for (int i = 0; i < scene->nodeCount; i++) {
+        if (hierarchy->parent[i] != TRANSFORM_NO_PARENT) {
+            childCounts[hierarchy->parent[i]]++;
+        }
+    }
+
+    int result = 0;
+    for (int k = 0; k < scene->nodeCount && result == 0; k++) {
+        int i = order[k];
+        node* n = calloc(1, sizeof(node));
+        if (!n || (childCounts[i] > 0 && !(n->children = malloc((size_t)childCounts[i] * sizeof(node*))))) {
+            free(n);
+            result = -1;
+            break;
+        }
+        memcpy(n->position, &hierarchy->position[i * 3], sizeof(n->position));
+        memcpy(n->rotation, &hierarchy->rotation[i * 4], sizeof(n->rotation));
+        memcpy(n->scale, &hierarchy->scale[i * 3], sizeof(n->scale));
+        scene->nodes[i] = n;
+    }
+    for (int i = 0; i < scene->nodeCount && result == 0; i++) {
+        int parent = hierarchy->parent[i];
+        if (parent != TRANSFORM_NO_PARENT) {
+            node* p = scene->nodes[parent];
+            scene->nodes[i]->parent = p;
+            p->children[p->childCount++] = scene->nodes[i];
+        }
+    }
+
+    free(order);
+    free(childCounts);
+    return result;
+}
+
+static int createScene(scene* scene, int grid, double animated) {
+    if (buildSystems(scene, grid, animated) != 0) {
+        fprintf(stderr, "Failed to allocate %d systems\n", grid * grid);
+        return -1;
+    }
+
+    shader_program program = {
+        .label = "Node program",
+        .vertex = vertexSource,
+        .fragment = fragmentSource,
+        .attributes = attributes
+    };
+    scene->program = shader_build(&program);
+    if (!scene->program) {
+        return -1;
+    }
+    scene->viewProjLocation = glGetUniformLocation(scene->program, "mViewProj");
+    scene->pointScaleLocation = glGetUniformLocation(scene->program, "pointScale");
+
+    #if SAMPLE_OPENGL_API == SAMPLE_API_GL || SAMPLE_OPENGL_VERSION_MAJOR >= 3
+        glGenVertexArrays(1, &scene->vao);
+        glBindVertexArray(scene->vao);
+    #endif
+
+    // The vertices are the world matrices themselves: the first column is
+    // the X axis, the second the Y axis and the last the position.
+    size_t size = (size_t)scene->nodeCount * 16 * sizeof(float);
+    glGenBuffers(1, &scene->vbo);
+    glBindBuffer(GL_ARRAY_BUFFER, scene->vbo);
+    GL_CHECK(glBufferData(GL_ARRAY_BUFFER, size, NULL, GL_STREAM_DRAW));
+    gpu_memory_track(GPU_MEMORY_BUFFER, scene->vbo, size);
+    gl_debug_label(GL_BUFFER, scene->vbo, "World matrices");
+
+    glVertexAttribPointer(ATTRIB_AXIS_X, 3, GL_FLOAT, GL_FALSE, 16 * sizeof(float), 0);
+    glVertexAttribPointer(ATTRIB_AXIS_Y, 3, GL_FLOAT, GL_FALSE, 16 * sizeof(float), (void*)(4 * sizeof(float)));
+    glVertexAttribPointer(ATTRIB_POSITION, 3, GL_FLOAT, GL_FALSE, 16 * sizeof(float), (void*)(12 * sizeof(float)));
+    glEnableVertexAttribArray(ATTRIB_AXIS_X);
+    glEnableVertexAttribArray(ATTRIB_AXIS_Y);
+    glEnableVertexAttribArray(ATTRIB_POSITION);
+
+    #if SAMPLE_OPENGL_API == SAMPLE_API_GL
+        glEnable(GL_PROGRAM_POINT_SIZE);
+    #endif
+    glEnable(GL_DEPTH_TEST);
+
+    return 0;
+}
+
+static void deleteScene(scene* scene) {
+    gpu_memory_untrack(GPU_MEMORY_BUFFER, scene->vbo);
+    glDeleteBuffers(1, &scene->vbo);
+    #if SAMPLE_OPENGL_API == SAMPLE_API_GL || SAMPLE_OPENGL_VERSION_MAJOR >= 3
+        glDeleteVertexArrays(1, &scene->vao);
+    #endif
+    glDeleteProgram(scene->program);
+
+    if (scene->nodes) {
+        for (int i = 0; i < scene->nodeCount; i++) {
+            if (scene->nodes[i]) {
+                free(scene->nodes[i]->children);
+                free(scene->nodes[i]);
+            }
+        }
+    }
+    free(scene->nodes);
+    free(scene->worlds);
+    free(scene->spinners);
+    transform_destroy(&scene->hierarchy);
+}
+
+static void updateNode(node* n) {
+    if (n->parent) {
+        mat4 local;
+        mat4_from_trs(local, n->position, n->rotation, n->scale);
+        mat4_multiply(n->world, n->parent->world, local);
+    } else {
+        mat4_from_trs(n->world, n->position, n->rotation, n->scale);
+    }
+    for (int i = 0; i < n->childCount; i++) {
+        updateNode(n->children[i]);
+    }
+}
+
+// Turn the spinners and compute the world matrices; returns the number of
+// matrices computed.
+static int updateScene(scene* scene, hierarchy_mode mode, float time) {
+    for (int i = 0; i < scene->spinnerCount; i++) {
+        const spinner* spinner = &scene->spinners[i];
+        quat rotation;
+        quat_from_axis_angle(rotation, 0.0f, 1.0f, 0.0f, time * spinner->speed);
+        if (mode == MODE_POINTERS) {
+            memcpy(scene->nodes[spinner->index]->rotation, rotation, sizeof(quat));
+        } else {
+            transform_set_rotation(&scene->hierarchy, spinner->index, rotation);
+        }
+    }
+
+    if (mode != MODE_POINTERS) {
+        if (mode == MODE_SOA_ALL) {
+            transform_mark_all(&scene->hierarchy);
+        }
+        return transform_update(&scene->hierarchy);
+    }
+
+    for (int i = 0; i < scene->nodeCount; i++) {
+        if (!scene->nodes[i]->parent) {
+            updateNode(scene->nodes[i]);
+        }
+    }
+    for (int i = 0; i < scene->nodeCount; i++) {
+        memcpy(&scene->worlds[(size_t)i * 16], scene->nodes[i]->world, sizeof(mat4));
+    }
+    return scene->nodeCount;
+}
+
+// Render frames in the given mode for a while, the camera flying over the
+// grid. Every frame is waited for, so the frame rate includes the GPU work.
+static void runMode(scene* scene, hierarchy_mode mode, int grid, double duration, GLFWwindow* window,
+                    EGLDisplay display, EGLSurface surface, mode_stats* stats) {
+    const float pi = 3.14159265358979323846f;
+    memset(stats, 0, sizeof(mode_stats));
+
+    // Start from the same state in every mode.
+    transform_mark_all(&scene->hierarchy);
+    updateScene(scene, mode, 0.0f);
+
+    float extent = (float)grid * SYSTEM_SPACING;
+    float fovy = FIELD_OF_VIEW * pi / 180.0f;
+    mat4 view, proj, viewProj;
+    mat4_perspective(proj, fovy, 640.0f / 480.0f, 1.0f, extent * 3.0f);
+    float pointScale = 480.0f / (2.0f * tanf(fovy * 0.5f));
+
+    double start = timer_now();
+    double end = start + duration;
+    while (timer_now() < end && !(window && glfwWindowShouldClose(window))) {
+        PROFILE_ZONE_BEGIN("frame");
+        PROFILE_GPU_ZONE_BEGIN("frame");
+
+        float time = (float)(timer_now() - start);
+        PROFILE_ZONE_BEGIN("update");
+        double updateStart = timer_now();
+        stats->computed += updateScene(scene, mode, time);
+        stats->updateSeconds += timer_now() - updateStart;
+        PROFILE_ZONE_END();
+
+        float heading = time * 0.1f;
+        mat4_look_at(view,
+            sinf(heading) * extent * 0.6f, extent * 0.4f, -cosf(heading) * extent * 0.6f,
+            0.0f, 0.0f, 0.0f,
+            0, 1, 0
+        );
+        mat4_multiply(viewProj, proj, view);
+
+        glClearColor(0.02f, 0.02f, 0.05f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+        gl_debug_push_group(modeNames[mode]);
+        PROFILE_ZONE_BEGIN("upload");
+        const float* worlds = mode == MODE_POINTERS ? scene->worlds : scene->hierarchy.world;
+        glBindBuffer(GL_ARRAY_BUFFER, scene->vbo);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, (GLsizeiptr)scene->nodeCount * 16 * sizeof(float), worlds);
+        PROFILE_ZONE_END();
+
+        PROFILE_GPU_ZONE_BEGIN("draw");
+        glUseProgram(scene->program);
+        glUniformMatrix4fv(scene->viewProjLocation, 1, GL_FALSE, viewProj);
+        glUniform1f(scene->pointScaleLocation, pointScale);
+        #if SAMPLE_OPENGL_API == SAMPLE_API_GL || SAMPLE_OPENGL_VERSION_MAJOR >= 3
+            glBindVertexArray(scene->vao);
+        #endif
+        glDrawArrays(GL_POINTS, 0, scene->nodeCount);
+        PROFILE_GPU_ZONE_END();
+        gl_debug_pop_group();
+
+        PROFILE_GPU_ZONE_END();
+        PROFILE_ZONE_BEGIN("eglSwapBuffers");
+        eglSwapBuffers(display, surface);
+        PROFILE_ZONE_END();
+        glFinish();
+        profiler_gpu_collect();
+        PROFILE_ZONE_END();
+        stats->frames++;
+
+        if (window) {
+            glfwPollEvents();
+        }
+    }
+    stats->seconds = timer_now() - start;
+}
+
+int main(int argc, char** argv) {
+    int grid = option_int(argc, argv, "--grid", 32);
+    double animated = option_double(argc, argv, "--animated", 0.1);
+    double duration = option_double(argc, argv, "--seconds", 2.0);
+    int useWindow = option_flag(argc, argv, "--window");
+    const char* reportPath = option_string(argc, argv, "--json", NULL);
+    const char* tracePath = option_string(argc, argv, "--trace", NULL);
+
+    if (grid < 1 || grid > 128) {
+        fprintf(stderr, "The grid size must be between 1 and 128\n");
+        return -1;
+    }
+    if (animated < 0.0 || animated > 1.0) {
+        fprintf(stderr, "The animated fraction must be between 0 and 1\n");
+        return -1;
+    }
+
+    PROFILE_THREAD_NAME("main");
+
+    GLFWwindow* window = NULL;
+    EGLDisplay display;
+    EGLConfig config;
+    EGLContext context;
+    EGLSurface surface;
+    if (useWindow) {
+        if (initializeWindow(&window, &display, &context, &surface, 640, 480, "Erlangsters - Transform Hierarchy") != 0) {
+            return -1;
+        }
+    } else if (initializeHeadless(&display, &config, &context, &surface, 640, 480) != 0) {
+        return -1;
+    }
+    gl_debug_install();
+    profiler_gpu_init();
+
+    static scene scene;
+    if (createScene(&scene, grid, animated) != 0) {
+        deleteScene(&scene);
+        return -1;
+    }
+    printf("%d systems, %d nodes, %d spinning nodes (%.0f%% of the systems turn)\n",
+        scene.systemCount, scene.nodeCount, scene.spinnerCount, animated * 100.0);
+
+    report* report = report_open(reportPath);
+    report_string(report, "sample", "transform-hierarchy");
+    report_integer(report, "nodes", scene.nodeCount);
+    report_number(report, "animated", animated);
+    report_begin_array(report, "modes");
+
+    for (int mode = 0; mode < MODE_COUNT; mode++) {
+        mode_stats stats;
+        runMode(&scene, (hierarchy_mode)mode, grid, duration, window, display, surface, &stats);
+        if (stats.frames == 0) {
+            break;
+        }
+
+        double frames = (double)stats.frames;
+        double updateMilliseconds = stats.updateSeconds * 1000.0 / frames;
+        printf("%-9s update: %7.3f ms/frame  computed: %8.0f matrices/frame  %7.1f frames/s\n",
+            modeNames[mode], updateMilliseconds, stats.computed / frames, frames / stats.seconds);
+
+        report_begin_object(report, NULL);
+        report_string(report, "mode", modeNames[mode]);
+        report_integer(report, "frames", stats.frames);
+        report_number(report, "frames_per_second", frames / stats.seconds);
+        report_number(report, "update_milliseconds_per_frame", updateMilliseconds);
+        report_number(report, "matrices_per_frame", stats.computed / frames);
+        report_end_object(report);
+    }
+
+    report_end_array(report);
+    gpu_memory_print();
+    gpu_memory_report(report);
+    report_close(report);
+
+    deleteScene(&scene);
+    gl_debug_summary();
+    profiler_gpu_shutdown();
+    if (tracePath) {
+        profiler_write_trace(tracePath);
+    }
+    if (window) {
+        terminateWindow(window);
+    } else {
+        terminateHeadless(display, context, surface);
+    }
+
+    return 0;
+}
@@ -0,0 +1,774 @@
+//
+// Copyright (c) 2025, Byteplug LLC.
+//
+// This source file is part of a project made by the Erlangsters community and
+// is released under the MIT license. Please refer to the LICENSE.md file that
+// can be found at the root of the project repository.
+//
+// Written by Jonathan De Wachter <jonathan.dewachter@byteplug.io>
+//
+#include <math.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "chunk_stream.h"
+#include "gl_api.h"
+#include "gl_debug.h"
+#include "gpu_memory.h"
+#include "hud.h"
+#include "matrix.h"
+#include "window.h"
+#include "options.h"
+#include "profiler.h"
+#include "report.h"
+#include "shader.h"
+#include "texture_gen.h"
+#include "timer.h"
+
+// Flies over a world of --world x --world chunks, each one a block of
+// columns of cubes with its own mesh and texture, too large to be kept in
+// GPU memory as a whole (like the production scenes).
+//
+// The chunks are generated once into a pack file (--pack), which is then
+// streamed with src/common/chunk_stream.h: the chunks within --view chunks
+// of the camera are loaded from the memory-mapped pack by --loaders threads,
+// uploaded nearest first, and the least recently used ones are evicted when
+// the resident chunks would exceed --cap MiB.
+//
+// The flight is done twice from an empty cache: once uploading everything
+// loaded as soon as possible ("unbudgeted"), and once with at most --budget
+// KiB uploaded per frame ("budgeted"). Both report the bytes uploaded per
+// frame, the hitches (frames taking more than HITCH_FACTOR times the median),
+// the resident memory and the chunks missing (wanted, but not resident yet).
+
+#define ATTRIB_POSITION 0
+#define ATTRIB_NORMAL 1
+#define ATTRIB_TEXCOORD 2
+
+#define CHUNK_SIZE 8.0f  // World units along the sides of a chunk.
+#define COLUMNS 4        // Columns of cubes along the sides of a chunk.
+#define COLUMN_WIDTH (CHUNK_SIZE / COLUMNS)
+#define BOX_FACES 5      // The bottom of the columns is never seen.
+#define CHUNK_VERTICES (COLUMNS * COLUMNS * BOX_FACES * 4)
+#define CHUNK_INDICES (COLUMNS * COLUMNS * BOX_FACES * 6)
+
+#define HITCH_FACTOR 2.0
+
+// Changed with the generation of the chunks, so older packs are rebuilt.
+#define PACK_FORMAT 1ull
+
+static const char* vertexSource =
+    "ATTRIBUTE vec3 vertPosition;\n"
+    "ATTRIBUTE vec3 vertNormal;\n"
+    "ATTRIBUTE vec2 vertTexCoord;\n"
+    "VARYING_OUT vec3 fragNormal;\n"
+    "VARYING_OUT vec2 fragTexCoord;\n"
+    "VARYING_OUT float fragFog;\n"
+    "uniform mat4 mViewProj;\n"
+    "uniform vec2 focus;\n"
+    "uniform vec2 fogRange;\n"
+    "void main() {\n"
+    "    fragNormal = vertNormal;\n"
+    "    fragTexCoord = vertTexCoord;\n"
+    "    float distance = length(vertPosition.xz - focus);\n"
+    "    fragFog = clamp((distance - fogRange.x) / (fogRange.y - fogRange.x), 0.0, 1.0);\n"
+    "    gl_Position = mViewProj * vec4(vertPosition, 1.0);\n"
+    "}\n";
+
+static const char* fragmentSource =
+    "VARYING_IN vec3 fragNormal;\n"
+    "VARYING_IN vec2 fragTexCoord;\n"
+    "VARYING_IN float fragFog;\n"
+    "uniform sampler2D chunkTexture;\n"
+    "void main() {\n"
+    "    float light = 0.35 + 0.65 * max(dot(fragNormal, vec3(0.45, 0.8, 0.4)), 0.0);\n"
+    "    vec3 color = texture(chunkTexture, fragTexCoord).rgb * light;\n"
+    "    FRAG_COLOR = vec4(mix(color, vec3(0.55, 0.65, 0.75), fragFog), 1.0);\n"
+    "}\n";
+
+static const char* attributes[] = { "vertPosition", "vertNormal", "vertTexCoord", NULL };
+
+typedef struct {
+    float position[3];
+    float normal[3];
+    float texCoord[2];
+} world_vertex;
+
+typedef struct {
+    const char* name;
+    int budgeted;
+} stream_mode;
+
+static const stream_mode modes[] = {
+    { "unbudgeted", 0 },
+    { "budgeted", 1 }
+};
+
+#define MODE_COUNT ((int)(sizeof(modes) / sizeof(modes[0])))
+
+typedef struct {
+    GLuint buffer;
+    GLuint texture;
+    #if SAMPLE_OPENGL_API == SAMPLE_API_GL || SAMPLE_OPENGL_VERSION_MAJOR >= 3
+        GLuint vao;
+    #endif
+} gpu_chunk;
+
+typedef struct {
+    int worldSize;  // Chunks along each side.
+    int viewRadius;
+    int textureSize;
+    int textureLevels;
+    size_t vertexBytes;
+    size_t textureBytes;
+    const char* packPath;
+    unsigned long long packKey;
+
+    // The offsets (x and z) of the chunks within the view radius, nearest
+    // first, and the chunks wanted by the current frame.
+    int* offsets;
+    int offsetCount;
+    int* wanted;
+    int wantedCount;
+
+    gpu_chunk* chunks;
+    GLuint program;
+    GLint viewProjLocation;
+    GLint focusLocation;
+    GLint fogRangeLocation;
+    GLuint indexBuffer;
+    hud* hud;  // NULL without --hud.
+} scene;
+
+typedef struct {
+    long long frames;
+    double seconds;
+    double* frameTimes;  // In milliseconds.
+    size_t frameCapacity;
+
+    double uploadedBytes;
+    size_t maxUploadedBytes;
+    long long uploads;
+    long long evictions;
+    long long missing;  // Summed over the frames.
+    size_t residentBytes;
+    size_t peakResidentBytes;
+    int residentCount;
+
+    double medianMilliseconds;
+    double worstMilliseconds;
+    int hitches;
+} run_stats;
+
+static unsigned int hash2(int x, int z) {
+    unsigned int h = (unsigned int)x * 73856093u ^ (unsigned int)z * 19349663u;
+    h ^= h >> 13;
+    h *= 0x5bd1e995u;
+    h ^= h >> 15;
+    return h;
+}
+
+// In cubes, from 1 to 8: rolling hills with some noise on top.
+static int columnHeight(int x, int z) {
+    float hills = 1.0f + sinf((float)x * 0.23f) * cosf((float)z * 0.19f);
+    return 1 + (int)(3.0f * hills) + (int)(hash2(x, z) % 2u);
+}
+
+// The normal, then the two axes along the face (their cross product being the
+// normal, so the corners below are counter-clockwise from the outside).
+static const float faceAxes[BOX_FACES][3][3] = {
+    { { 0, 1, 0 }, { 0, 0, 1 }, { 1, 0, 0 } },
+    { { 1, 0, 0 }, { 0, 1, 0 }, { 0, 0, 1 } },
+    { { -1, 0, 0 }, { 0, 0, 1 }, { 0, 1, 0 } },
+    { { 0, 0, 1 }, { 1, 0, 0 }, { 0, 1, 0 } },
+    { { 0, 0, -1 }, { 0, 1, 0 }, { 1, 0, 0 } }
+};
+static const float faceCorners[4][2] = { { -1, -1 }, { 1, -1 }, { 1, 1 }, { -1, 1 } };
+
+// The vertices of a chunk, in world space, followed by its texture and its
+// mip chain. The texture covers the top of the chunk, and repeats on the
+// sides of every cube.
+static void buildChunk(const scene* scene, int chunkX, int chunkZ, unsigned char* data) {
+    world_vertex* vertex = (world_vertex*)data;
+    float originX = (float)chunkX * CHUNK_SIZE;
+    float originZ = (float)chunkZ * CHUNK_SIZE;
+    for (int column = 0; column < COLUMNS * COLUMNS; column++) {
+        int x = chunkX * COLUMNS + column % COLUMNS;
+        int z = chunkZ * COLUMNS + column / COLUMNS;
+        float height = (float)columnHeight(x, z) * COLUMN_WIDTH;
+        float center[3] = { ((float)x + 0.5f) * COLUMN_WIDTH, height * 0.5f, ((float)z + 0.5f) * COLUMN_WIDTH };
+        float half[3] = { COLUMN_WIDTH * 0.5f, height * 0.5f, COLUMN_WIDTH * 0.5f };
+
+        for (int face = 0; face < BOX_FACES; face++) {
+            const float* n = faceAxes[face][0];
+            const float* u = faceAxes[face][1];
+            const float* v = faceAxes[face][2];
+            for (int corner = 0; corner < 4; corner++, vertex++) {
+                float cu = faceCorners[corner][0];
+                float cv = faceCorners[corner][1];
+                for (int axis = 0; axis < 3; axis++) {
+                    vertex->position[axis] = center[axis] + half[axis] * (n[axis] + cu * u[axis] + cv * v[axis]);
+                    vertex->normal[axis] = n[axis];
+                }
+                const float* p = vertex->position;
+                if (n[1] != 0.0f) {
+                    vertex->texCoord[0] = (p[0] - originX) / CHUNK_SIZE;
+                    vertex->texCoord[1] = (p[2] - originZ) / CHUNK_SIZE;
+                } else {
+                    vertex->texCoord[0] = (p[0] * fabsf(n[2]) + p[2] * fabsf(n[0])) / COLUMN_WIDTH;
+                    vertex->texCoord[1] = p[1] / COLUMN_WIDTH;
+                }
+            }
+        }
+    }
+
+    unsigned int h = hash2(chunkX, chunkZ);
+    texture_desc desc = {
+        .pattern = (texture_pattern)(h % 3u),
+        .width = scene->textureSize,
+        .height = scene->textureSize,
+        .color0 = { (unsigned char)(96 + (h >> 8) % 128u), (unsigned char)(96 + (h >> 16) % 128u),
+            (unsigned char)(96 + (h >> 24) % 128u), 255 },
+        .color1 = { 40, 48, 56, 255 },
+        .cells = 4,
+        .seed = h
+    };
+    unsigned char* pixels = data + scene->vertexBytes;
+    texture_gen_fill(&desc, pixels, NULL);
+    texture_gen_mips(pixels, scene->textureSize, scene->textureSize, NULL);
+}
+
+static int writePack(const scene* scene) {
+    int count = scene->worldSize * scene->worldSize;
+    size_t chunkBytes = scene->vertexBytes + scene->textureBytes;
+    printf("Generating %s (%d chunks, %.1f MiB)\n", scene->packPath, count,
+        (double)chunkBytes * count / (1024.0 * 1024.0));
+
+    unsigned char* data = malloc(chunkBytes);
+    chunk_pack_writer* writer = chunk_pack_create(scene->packPath, count, scene->packKey);
+    if (!data || !writer) {
+        free(data);
+        if (writer) {
+            chunk_pack_finish(writer);
+        }
+        return -1;
+    }
+    for (int chunk = 0; chunk < count; chunk++) {
+        buildChunk(scene, chunk % scene->worldSize, chunk / scene->worldSize, data);
+        if (chunk_pack_add(writer, data, chunkBytes) != 0) {
+            break;
+        }
+    }
+    free(data);
+    return chunk_pack_finish(writer);
+}
+
+static int compareOffsets(const void* a, const void* b) {
+    const int* p = a;
+    const int* q = b;
+    int d0 = p[0] * p[0] + p[1] * p[1];
+    int d1 = q[0] * q[0] + q[1] * q[1];
+    return (d0 > d1) - (d0 < d1);
+}
+
+// Make the chunk resident: its vertices in a buffer, its texture with its mip
+// chain, and on OpenGL (ES) 3 a vertex array pointing at them.
+static size_t uploadChunk(void* arg, int chunk, const void* data, size_t size) {
+    scene* scene = arg;
+    gpu_chunk* gpu = &scene->chunks[chunk];
+    const unsigned char* bytes = data;
+    (void)size;
+
+    glGenBuffers(1, &gpu->buffer);
+    glBindBuffer(GL_ARRAY_BUFFER, gpu->buffer);
+    glBufferData(GL_ARRAY_BUFFER, scene->vertexBytes, bytes, GL_STATIC_DRAW);
+    gpu_memory_track(GPU_MEMORY_BUFFER, gpu->buffer, scene->vertexBytes);
+
+    glGenTextures(1, &gpu->texture);
+    glBindTexture(GL_TEXTURE_2D, gpu->texture);
+    int levelSize = scene->textureSize;
+    for (int level = 0; level < scene->textureLevels; level++) {
+        size_t offset = scene->vertexBytes + texture_gen_mip_offset(scene->textureSize, scene->textureSize, level);
+        glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA, levelSize, levelSize, 0, GL_RGBA, GL_UNSIGNED_BYTE,
+            bytes + offset);
+        levelSize = levelSize > 1 ? levelSize / 2 : 1;
+    }
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    gpu_memory_track(GPU_MEMORY_TEXTURE, gpu->texture, scene->textureBytes);
+
+    #if SAMPLE_OPENGL_API == SAMPLE_API_GL || SAMPLE_OPENGL_VERSION_MAJOR >= 3
+        glGenVertexArrays(1, &gpu->vao);
+        glBindVertexArray(gpu->vao);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, scene->indexBuffer);
+        glVertexAttribPointer(ATTRIB_POSITION, 3, GL_FLOAT, GL_FALSE, sizeof(world_vertex),
+            (void*)offsetof(world_vertex, position));
+        glVertexAttribPointer(ATTRIB_NORMAL, 3, GL_FLOAT, GL_FALSE, sizeof(world_vertex),
+            (void*)offsetof(world_vertex, normal));
+        glVertexAttribPointer(ATTRIB_TEXCOORD, 2, GL_FLOAT, GL_FALSE, sizeof(world_vertex),
+            (void*)offsetof(world_vertex, texCoord));
+        glEnableVertexAttribArray(ATTRIB_POSITION);
+        glEnableVertexAttribArray(ATTRIB_NORMAL);
+        glEnableVertexAttribArray(ATTRIB_TEXCOORD);
+        glBindVertexArray(0);
+    #endif
+
+    return scene->vertexBytes + scene->textureBytes;
+}
+
+static void evictChunk(void* arg, int chunk) {
+    scene* scene = arg;
+    gpu_chunk* gpu = &scene->chunks[chunk];
+    gpu_memory_untrack(GPU_MEMORY_BUFFER, gpu->buffer);
+    gpu_memory_untrack(GPU_MEMORY_TEXTURE, gpu->texture);
+    glDeleteBuffers(1, &gpu->buffer);
+    glDeleteTextures(1, &gpu->texture);
+    #if SAMPLE_OPENGL_API == SAMPLE_API_GL || SAMPLE_OPENGL_VERSION_MAJOR >= 3
+        glDeleteVertexArrays(1, &gpu->vao);
+    #endif
+    memset(gpu, 0, sizeof(gpu_chunk));
+}
+
+static int createScene(scene* scene) {
+    int viewRadius = scene->viewRadius;
+    scene->textureLevels = texture_gen_mip_levels(scene->textureSize, scene->textureSize);
+    scene->textureBytes = texture_gen_mip_chain_size(scene->textureSize, scene->textureSize);
+    scene->vertexBytes = CHUNK_VERTICES * sizeof(world_vertex);
+    scene->packKey = PACK_FORMAT << 48 | (unsigned long long)scene->worldSize << 16 |
+        (unsigned long long)scene->textureSize;
+
+    shader_program program = {
+        .label = "World program",
+        .vertex = vertexSource,
+        .fragment = fragmentSource,
+        .attributes = attributes
+    };
+    shader_submit(&program, 1);
+
+    int side = 2 * viewRadius + 1;
+    int chunkCount = scene->worldSize * scene->worldSize;
+    scene->offsets = malloc((size_t)side * (size_t)side * 2 * sizeof(int));
+    scene->wanted = malloc((size_t)side * (size_t)side * sizeof(int));
+    scene->chunks = calloc((size_t)chunkCount, sizeof(gpu_chunk));
+    if (!scene->offsets || !scene->wanted || !scene->chunks) {
+        fprintf(stderr, "Failed to allocate the chunks\n");
+        return -1;
+    }
+    for (int dz = -viewRadius; dz <= viewRadius; dz++) {
+        for (int dx = -viewRadius; dx <= viewRadius; dx++) {
+            if (dx * dx + dz * dz <= viewRadius * viewRadius) {
+                scene->offsets[scene->offsetCount * 2] = dx;
+                scene->offsets[scene->offsetCount * 2 + 1] = dz;
+                scene->offsetCount++;
+            }
+        }
+    }
+    qsort(scene->offsets, (size_t)scene->offsetCount, 2 * sizeof(int), compareOffsets);
+
+    // The columns of every chunk have the same faces, so they share their
+    // indices.
+    unsigned short indices[CHUNK_INDICES];
+    for (int quad = 0; quad < CHUNK_VERTICES / 4; quad++) {
+        static const int pattern[6] = { 0, 1, 2, 0, 2, 3 };
+        for (int i = 0; i < 6; i++) {
+            indices[quad * 6 + i] = (unsigned short)(quad * 4 + pattern[i]);
+        }
+    }
+    glGenBuffers(1, &scene->indexBuffer);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, scene->indexBuffer);
+    GL_CHECK(glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW));
+    gpu_memory_track(GPU_MEMORY_BUFFER, scene->indexBuffer, sizeof(indices));
+    gl_debug_label(GL_BUFFER, scene->indexBuffer, "Chunk indices");
+
+    if (shader_finish(&program, 1) > 0) {
+        return -1;
+    }
+    scene->program = program.program;
+    scene->viewProjLocation = glGetUniformLocation(scene->program, "mViewProj");
+    scene->focusLocation = glGetUniformLocation(scene->program, "focus");
+    scene->fogRangeLocation = glGetUniformLocation(scene->program, "fogRange");
+    glUseProgram(scene->program);
+    glUniform1i(glGetUniformLocation(scene->program, "chunkTexture"), 0);
+    float range = (float)viewRadius * CHUNK_SIZE;
+    glUniform2f(scene->fogRangeLocation, range * 0.6f, range);
+    glUseProgram(0);
+
+    glEnable(GL_DEPTH_TEST);
+    glEnable(GL_CULL_FACE);
+    return 0;
+}
+
+static void deleteScene(scene* scene) {
+    gpu_memory_untrack(GPU_MEMORY_BUFFER, scene->indexBuffer);
+    glDeleteBuffers(1, &scene->indexBuffer);
+    glDeleteProgram(scene->program);
+    free(scene->offsets);
+    free(scene->wanted);
+    free(scene->chunks);
+}
+
+// The chunks around the focus point, nearest first.
+static void gatherWanted(scene* scene, float focusX, float focusZ) {
+    int centerX = (int)floorf(focusX / CHUNK_SIZE);
+    int centerZ = (int)floorf(focusZ / CHUNK_SIZE);
+    scene->wantedCount = 0;
+    for (int i = 0; i < scene->offsetCount; i++) {
+        int x = centerX + scene->offsets[i * 2];
+        int z = centerZ + scene->offsets[i * 2 + 1];
+        if (x >= 0 && x < scene->worldSize && z >= 0 && z < scene->worldSize) {
+            scene->wanted[scene->wantedCount++] = z * scene->worldSize + x;
+        }
+    }
+}
+
+// Draw the wanted chunks that are resident. Returns the number of draw calls.
+static int drawChunks(scene* scene, chunk_stream* stream) {
+    int draws = 0;
+    glActiveTexture(GL_TEXTURE0);
+    #if SAMPLE_OPENGL_API == SAMPLE_API_GLES && SAMPLE_OPENGL_VERSION_MAJOR == 2
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, scene->indexBuffer);
+        glEnableVertexAttribArray(ATTRIB_POSITION);
+        glEnableVertexAttribArray(ATTRIB_NORMAL);
+        glEnableVertexAttribArray(ATTRIB_TEXCOORD);
+    #endif
+    for (int i = 0; i < scene->wantedCount; i++) {
+        int chunk = scene->wanted[i];
+        if (!chunk_stream_is_resident(stream, chunk)) {
+            continue;
+        }
+        const gpu_chunk* gpu = &scene->chunks[chunk];
+        glBindTexture(GL_TEXTURE_2D, gpu->texture);
+        #if SAMPLE_OPENGL_API == SAMPLE_API_GL || SAMPLE_OPENGL_VERSION_MAJOR >= 3
+            glBindVertexArray(gpu->vao);
+        #else
+            glBindBuffer(GL_ARRAY_BUFFER, gpu->buffer);
+            glVertexAttribPointer(ATTRIB_POSITION, 3, GL_FLOAT, GL_FALSE, sizeof(world_vertex),
+                (void*)offsetof(world_vertex, position));
+            glVertexAttribPointer(ATTRIB_NORMAL, 3, GL_FLOAT, GL_FALSE, sizeof(world_vertex),
+                (void*)offsetof(world_vertex, normal));
+            glVertexAttribPointer(ATTRIB_TEXCOORD, 2, GL_FLOAT, GL_FALSE, sizeof(world_vertex),
+                (void*)offsetof(world_vertex, texCoord));
+        #endif
+        glDrawElements(GL_TRIANGLES, CHUNK_INDICES, GL_UNSIGNED_SHORT, 0);
+        draws++;
+    }
+    #if SAMPLE_OPENGL_API == SAMPLE_API_GL || SAMPLE_OPENGL_VERSION_MAJOR >= 3
+        glBindVertexArray(0);
+    #endif
+    return draws;
+}
+
+static int compareDoubles(const void* a, const void* b) {
+    double x = *(const double*)a;
+    double y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+static void recordFrame(run_stats* stats, double milliseconds) {
+    if ((size_t)stats->frames == stats->frameCapacity) {
+        size_t capacity = stats->frameCapacity ? stats->frameCapacity * 2 : 1024;
+        double* frameTimes = realloc(stats->frameTimes, capacity * sizeof(double));
+        if (!frameTimes) {
+            return;
+        }
+        stats->frameTimes = frameTimes;
+        stats->frameCapacity = capacity;
+    }
+    stats->frameTimes[stats->frames++] = milliseconds;
+}
+
+// Median and worst frame times, and the hitches against the median.
+static void summarizeFrames(run_stats* stats) {
+    if (stats->frames == 0) {
+        return;
+    }
+    size_t count = (size_t)stats->frames;
+    double* sorted = malloc(count * sizeof(double));
+    if (!sorted) {
+        return;
+    }
+    memcpy(sorted, stats->frameTimes, count * sizeof(double));
+    qsort(sorted, count, sizeof(double), compareDoubles);
+    stats->medianMilliseconds = sorted[count / 2];
+    stats->worstMilliseconds = sorted[count - 1];
+    for (size_t i = 0; i < count; i++) {
+        if (stats->frameTimes[i] > HITCH_FACTOR * stats->medianMilliseconds) {
+            stats->hitches++;
+        }
+    }
+    free(sorted);
+}
+
+// Fly around the world for a while, starting from an empty cache. The camera
+// follows a circle around the center of the world at --speed chunks per
+// second, and every frame is waited for so the frame times include the
+// uploads.
+static int runMode(scene* scene, const chunk_stream_config* config, int m, double duration, float speed,
+                   GLFWwindow* window, EGLDisplay display, EGLSurface surface, run_stats* stats) {
+    memset(stats, 0, sizeof(run_stats));
+    chunk_stream* stream = chunk_stream_open(config);
+    if (!stream) {
+        fprintf(stderr, "Failed to open %s\n", config->path);
+        return -1;
+    }
+
+    const float pi = 3.14159265358979323846f;
+    mat4 proj, view, viewProj;
+    mat4_perspective(proj, 60.0f * pi / 180.0f, 640.0f / 480.0f, 0.5f, (float)scene->viewRadius * CHUNK_SIZE + 60.0f);
+    float extent = (float)scene->worldSize * CHUNK_SIZE;
+    float radius = extent * 0.3f;
+
+    double start = timer_now();
+    double end = start + duration;
+    double previous = start;
+    while (timer_now() < end && !(window && glfwWindowShouldClose(window))) {
+        PROFILE_ZONE_BEGIN("frame");
+        PROFILE_GPU_ZONE_BEGIN("frame");
+
+        float angle = speed * CHUNK_SIZE * (float)(timer_now() - start) / radius;
+        float focusX = extent * 0.5f + cosf(angle) * radius;
+        float focusZ = extent * 0.5f + sinf(angle) * radius;
+        float directionX = -sinf(angle);
+        float directionZ = cosf(angle);
+        mat4_look_at(view,
+            focusX - directionX * 20.0f, 22.0f, focusZ - directionZ * 20.0f,
+            focusX + directionX * 12.0f, 0.0f, focusZ + directionZ * 12.0f,
+            0, 1, 0
+        );
+        mat4_multiply(viewProj, proj, view);
+
+        gatherWanted(scene, focusX, focusZ);
+        chunk_stream_stats frame;
+        chunk_stream_update(stream, scene->wanted, scene->wantedCount, &frame);
+
+        glClearColor(0.55f, 0.65f, 0.75f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+        PROFILE_GPU_ZONE_BEGIN("draw");
+        gl_debug_push_group(modes[m].name);
+        glUseProgram(scene->program);
+        glUniformMatrix4fv(scene->viewProjLocation, 1, GL_FALSE, viewProj);
+        glUniform2f(scene->focusLocation, focusX, focusZ);
+        int draws = drawChunks(scene, stream);
+        gl_debug_pop_group();
+        PROFILE_GPU_ZONE_END();
+
+        if (scene->hud) {
+            hud_printf(scene->hud, "Mode: %s", modes[m].name);
+            hud_printf(scene->hud, "Upload: %.0f KiB", (double)frame.uploadedBytes / 1024.0);
+            hud_printf(scene->hud, "Resident: %d chunks, %.1f MiB", frame.residentCount,
+                (double)frame.residentBytes / (1024.0 * 1024.0));
+            hud_printf(scene->hud, "Missing: %d of %d", frame.missing, scene->wantedCount);
+            // The duration of the previous frame, swap and wait included.
+            double frameSeconds = stats->frames > 0 ? stats->frameTimes[stats->frames - 1] / 1000.0 : 0.0;
+            hud_draw(scene->hud, frameSeconds, draws);
+        }
+
+        PROFILE_GPU_ZONE_END();
+        PROFILE_ZONE_BEGIN("eglSwapBuffers");
+        eglSwapBuffers(display, surface);
+        PROFILE_ZONE_END();
+        glFinish();
+        profiler_gpu_collect();
+        PROFILE_ZONE_END();
+
+        double now = timer_now();
+        recordFrame(stats, (now - previous) * 1000.0);
+        previous = now;
+        stats->uploadedBytes += (double)frame.uploadedBytes;
+        if (frame.uploadedBytes > stats->maxUploadedBytes) {
+            stats->maxUploadedBytes = frame.uploadedBytes;
+        }
+        stats->uploads += frame.uploads;
+        stats->evictions += frame.evictions;
+        stats->missing += frame.missing;
+        stats->residentBytes = frame.residentBytes;
+        stats->residentCount = frame.residentCount;
+        if (frame.residentBytes > stats->peakResidentBytes) {
+            stats->peakResidentBytes = frame.residentBytes;
+        }
+
+        if (window) {
+            glfwPollEvents();
+        }
+    }
+    stats->seconds = timer_now() - start;
+    summarizeFrames(stats);
+    chunk_stream_close(stream);
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    int worldSize = option_int(argc, argv, "--world", 32);
+    int textureSize = option_int(argc, argv, "--texture-size", 64);
+    int viewRadius = option_int(argc, argv, "--view", 6);
+    int budgetKb = option_int(argc, argv, "--budget", 256);
+    int capMb = option_int(argc, argv, "--cap", 8);
+    int loaders = option_int(argc, argv, "--loaders", 2);
+    int staging = option_int(argc, argv, "--staging", 64);
+    double speed = option_double(argc, argv, "--speed", 4.0);
+    double duration = option_double(argc, argv, "--seconds", 4.0);
+    const char* packPath = option_string(argc, argv, "--pack", "world.pack");
+    int useWindow = option_flag(argc, argv, "--window");
+    int useHud = option_flag(argc, argv, "--hud");
+    const char* reportPath = option_string(argc, argv, "--json", NULL);
+    const char* tracePath = option_string(argc, argv, "--trace", NULL);
+
+    if (worldSize < 1 || worldSize > 256) {
+        fprintf(stderr, "The size of the world must be between 1 and 256 chunks\n");
+        return -1;
+    }
+    if (textureSize < 4 || textureSize > 1024 || (textureSize & (textureSize - 1)) != 0) {
+        fprintf(stderr, "The texture size must be a power of two between 4 and 1024\n");
+        return -1;
+    }
+    if (viewRadius < 1 || viewRadius > 64) {
+        fprintf(stderr, "The view radius must be between 1 and 64 chunks\n");
+        return -1;
+    }
+    if (budgetKb < 1 || capMb < 1) {
+        fprintf(stderr, "The upload budget and the memory cap must be positive\n");
+        return -1;
+    }
+    if (loaders < 1 || loaders > CHUNK_STREAM_MAX_LOADERS) {
+        fprintf(stderr, "The number of loaders must be between 1 and %d\n", CHUNK_STREAM_MAX_LOADERS);
+        return -1;
+    }
+    if (staging < 1) {
+        fprintf(stderr, "The number of staging buffers must be positive\n");
+        return -1;
+    }
+
+    PROFILE_THREAD_NAME("main");
+
+    GLFWwindow* window = NULL;
+    EGLDisplay display;
+    EGLConfig config;
+    EGLContext context;
+    EGLSurface surface;
+    if (useWindow) {
+        if (initializeWindow(&window, &display, &context, &surface, 640, 480, "Erlangsters - World Streaming") != 0) {
+            return -1;
+        }
+    } else if (initializeHeadless(&display, &config, &context, &surface, 640, 480) != 0) {
+        return -1;
+    }
+    gl_debug_install();
+    profiler_gpu_init();
+
+    static scene scene;
+    scene.worldSize = worldSize;
+    scene.viewRadius = viewRadius;
+    scene.textureSize = textureSize;
+    scene.packPath = packPath;
+    if (createScene(&scene) != 0) {
+        return -1;
+    }
+    static hud overlay;
+    if (useHud && hud_init(&overlay, 640, 480) == 0) {
+        scene.hud = &overlay;
+    }
+
+    chunk_stream_config streamConfig = {
+        .path = packPath,
+        .key = scene.packKey,
+        .loaderCount = loaders,
+        .stagingCount = staging,
+        .residentCap = (size_t)capMb * 1024 * 1024,
+        .upload = uploadChunk,
+        .evict = evictChunk,
+        .arg = &scene
+    };
+
+    // The pack is generated the first time, or again when the parameters
+    // changed.
+    chunk_stream* probe = chunk_stream_open(&streamConfig);
+    if (probe) {
+        chunk_stream_close(probe);
+    } else if (writePack(&scene) != 0) {
+        fprintf(stderr, "Failed to write %s\n", packPath);
+        return -1;
+    }
+
+    size_t chunkBytes = scene.vertexBytes + scene.textureBytes;
+    double packMb = (double)chunkBytes * worldSize * worldSize / (1024.0 * 1024.0);
+    printf("Streaming %dx%d chunks of %.1f KiB (%.1f MiB) from %s with %d loaders, %d chunks in view\n",
+        worldSize, worldSize, (double)chunkBytes / 1024.0, packMb, packPath, loaders, scene.offsetCount);
+    printf("Upload budget: %d KiB/frame, memory cap: %d MiB\n", budgetKb, capMb);
+
+    report* report = report_open(reportPath);
+    report_string(report, "sample", "world-streaming");
+    report_integer(report, "world", worldSize);
+    report_integer(report, "chunk_bytes", (long long)chunkBytes);
+    report_integer(report, "view_chunks", scene.offsetCount);
+    report_integer(report, "loaders", loaders);
+    report_integer(report, "budget_bytes", (long long)budgetKb * 1024);
+    report_integer(report, "cap_bytes", (long long)capMb * 1024 * 1024);
+    report_begin_array(report, "modes");
+
+    for (int m = 0; m < MODE_COUNT; m++) {
+        run_stats stats;
+        streamConfig.uploadBudget = modes[m].budgeted ? (size_t)budgetKb * 1024 : 0;
+        int failed = runMode(&scene, &streamConfig, m, duration, (float)speed, window, display, surface, &stats);
+        if (failed || stats.frames == 0) {
+            free(stats.frameTimes);
+            break;
+        }
+
+        double frames = (double)stats.frames;
+        double uploadKb = stats.uploadedBytes / frames / 1024.0;
+        double residentMb = (double)stats.residentBytes / (1024.0 * 1024.0);
+        double peakMb = (double)stats.peakResidentBytes / (1024.0 * 1024.0);
+        printf("%-10s upload: %6.1f KiB/frame (max %7.1f)  hitches: %3d (worst %6.2f ms, median %5.2f ms)  "
+            "resident: %5.2f MiB (peak %5.2f)  evictions: %5lld  missing: %6.2f/frame  %6.1f frames/s\n",
+            modes[m].name, uploadKb, (double)stats.maxUploadedBytes / 1024.0, stats.hitches,
+            stats.worstMilliseconds, stats.medianMilliseconds, residentMb, peakMb, stats.evictions,
+            (double)stats.missing / frames, frames / stats.seconds);
+
+        report_begin_object(report, NULL);
+        report_string(report, "mode", modes[m].name);
+        report_integer(report, "frames", stats.frames);
+        report_number(report, "frames_per_second", frames / stats.seconds);
+        report_number(report, "upload_bytes_per_frame", stats.uploadedBytes / frames);
+        report_integer(report, "max_upload_bytes_per_frame", (long long)stats.maxUploadedBytes);
+        report_integer(report, "uploads", stats.uploads);
+        report_integer(report, "evictions", stats.evictions);
+        report_integer(report, "hitches", stats.hitches);
+        report_number(report, "median_frame_milliseconds", stats.medianMilliseconds);
+        report_number(report, "worst_frame_milliseconds", stats.worstMilliseconds);
+        report_integer(report, "resident_bytes", (long long)stats.residentBytes);
+        report_integer(report, "peak_resident_bytes", (long long)stats.peakResidentBytes);
+        report_number(report, "missing_per_frame", (double)stats.missing / frames);
+        report_end_object(report);
+        free(stats.frameTimes);
+    }
+
+    report_end_array(report);
+    if (scene.hud) {
+        printf("HUD: %.3f ms/frame on the CPU\n", hud_average_cost(scene.hud));
+        report_number(report, "hud_milliseconds_per_frame", hud_average_cost(scene.hud));
+    }
+    gpu_memory_print();
+    gpu_memory_report(report);
+    report_close(report);
+
+    if (scene.hud) {
+        hud_destroy(scene.hud);
+    }
+    deleteScene(&scene);
+    gl_debug_summary();
+    profiler_gpu_shutdown();
+    if (tracePath) {
+        profiler_write_trace(tracePath);
+    }
+    if (window) {
+        terminateWindow(window);
+    } else {
+        terminateHeadless(display, context, surface);
+    }
+
+    return 0;
+}